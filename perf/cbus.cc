@@ -0,0 +1,151 @@
+#include "memory.h"
+#include "fiber.h"
+#include "cbus.h"
+
+#include <stdlib.h>
+#include <benchmark/benchmark.h>
+
+/*
+ * Compares delivering a batch of requests through a cbus pipe as
+ * separate messages, the way iproto sends requests to tx, with
+ * delivering the same batch wrapped in a single message. Used for
+ * estimating what coalescing iproto messages could save, see the
+ * comment to iproto_enqueue_batch().
+ *
+ * The producer and the consumer share a cord so that the results
+ * don't depend on thread wakeups: there is one flush per batch in
+ * both cases, just like in iproto. The request handler does almost
+ * nothing, so the difference is an upper bound of the savings.
+ */
+
+const size_t MAX_BATCH_SIZE = 1024;
+
+struct request {
+	struct cmsg base;
+	uint64_t *counter;
+};
+
+struct batch {
+	struct cmsg base;
+	struct request *requests;
+	size_t size;
+};
+
+static void
+request_process(struct request *request)
+{
+	++*request->counter;
+}
+
+static void
+request_process_f(struct cmsg *msg)
+{
+	request_process((struct request *)msg);
+}
+
+static void
+batch_process_f(struct cmsg *msg)
+{
+	struct batch *batch = (struct batch *)msg;
+	for (size_t i = 0; i < batch->size; i++)
+		request_process(&batch->requests[i]);
+}
+
+static const struct cmsg_hop request_route[] = {
+	{request_process_f, NULL},
+};
+
+static const struct cmsg_hop batch_route[] = {
+	{batch_process_f, NULL},
+};
+
+class Bus {
+public:
+	static Bus &instance()
+	{
+		static Bus instance;
+		return instance;
+	}
+	struct cpipe pipe;
+	struct cbus_endpoint endpoint;
+	struct request requests[MAX_BATCH_SIZE];
+	uint64_t counter;
+private:
+	Bus()
+	{
+		memory_init();
+		fiber_init(fiber_c_invoke);
+		cbus_init();
+		cbus_endpoint_create(&endpoint, "consumer", fiber_schedule_cb,
+				     fiber());
+		cpipe_create(&pipe, "consumer");
+		counter = 0;
+		for (size_t i = 0; i < MAX_BATCH_SIZE; i++)
+			requests[i].counter = &counter;
+	}
+	~Bus()
+	{
+		cpipe_destroy(&pipe);
+		cbus_endpoint_destroy(&endpoint, cbus_process);
+		cbus_free();
+		fiber_free();
+		memory_free();
+	}
+};
+
+/*
+ * Argument: the number of requests in a batch. Each request is
+ * a message of its own.
+ */
+static void
+bench_messages(benchmark::State &state)
+{
+	size_t batch_size = state.range(0);
+	Bus &bus = Bus::instance();
+	size_t total_count = 0;
+	for (auto _ : state) {
+		for (size_t i = 0; i < batch_size; i++) {
+			struct request *request = &bus.requests[i];
+			cmsg_init(&request->base, request_route);
+			cpipe_push_input(&bus.pipe, &request->base);
+		}
+		cpipe_deliver_now(&bus.pipe);
+		cbus_process(&bus.endpoint);
+		total_count += batch_size;
+	}
+	if (bus.counter != total_count)
+		abort();
+	bus.counter = 0;
+	state.SetItemsProcessed(total_count);
+}
+
+/*
+ * Argument: the number of requests in a batch. All requests are
+ * delivered in one message.
+ */
+static void
+bench_batch(benchmark::State &state)
+{
+	size_t batch_size = state.range(0);
+	Bus &bus = Bus::instance();
+	size_t total_count = 0;
+	for (auto _ : state) {
+		struct batch batch;
+		cmsg_init(&batch.base, batch_route);
+		batch.requests = bus.requests;
+		batch.size = batch_size;
+		cpipe_push_input(&bus.pipe, &batch.base);
+		cpipe_deliver_now(&bus.pipe);
+		cbus_process(&bus.endpoint);
+		total_count += batch_size;
+	}
+	if (bus.counter != total_count)
+		abort();
+	bus.counter = 0;
+	state.SetItemsProcessed(total_count);
+}
+
+BENCHMARK(bench_messages)->RangeMultiplier(4)->Range(1, MAX_BATCH_SIZE);
+BENCHMARK(bench_batch)->RangeMultiplier(4)->Range(1, MAX_BATCH_SIZE);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,97 @@
+#!/usr/bin/env tarantool
+--
+-- Measures the throughput of small iproto requests and the CPU time
+-- spent per request by the server (tx and iproto threads). The net.box
+-- clients run in a separate process so that their CPU time isn't
+-- accounted.
+--
+-- Usage:
+--   tarantool iproto_rps.lua [iproto_io_collect_interval] [iproto_threads]
+--
+-- Run it with iproto_io_collect_interval set to 0 (the default) and to
+-- a small value like 0.0001 to compare the number of requests per CPU
+-- second.
+--
+local clock = require('clock')
+local fiber = require('fiber')
+local fio = require('fio')
+local net = require('net.box')
+local popen = require('popen')
+
+local CONNECTIONS = 50
+local FIBERS_PER_CONNECTION = 20
+local DURATION = 10
+
+-- Client mode: tarantool iproto_rps.lua --client <uri>
+-- Prints the number of completed requests and the time spent.
+if arg[1] == '--client' then
+    local count = 0
+    local stop = false
+    local fibers = {}
+    for _ = 1, CONNECTIONS do
+        local conn = net.connect(arg[2])
+        for _ = 1, FIBERS_PER_CONNECTION do
+            local f = fiber.new(function()
+                local space = conn.space.test
+                while not stop do
+                    space:get(1)
+                    count = count + 1
+                end
+            end)
+            f:set_joinable(true)
+            table.insert(fibers, f)
+        end
+    end
+    local time = clock.monotonic()
+    fiber.sleep(DURATION)
+    stop = true
+    time = clock.monotonic() - time
+    for _, f in ipairs(fibers) do
+        f:join()
+    end
+    print(count, time)
+    os.exit(0)
+end
+
+local iproto_io_collect_interval = tonumber(arg[1]) or 0
+local iproto_threads = tonumber(arg[2]) or 1
+
+local workdir = fio.tempdir()
+local sock = fio.pathjoin(workdir, 'iproto.sock')
+box.cfg{
+    work_dir = workdir,
+    listen = sock,
+    iproto_threads = iproto_threads,
+    iproto_io_collect_interval = iproto_io_collect_interval,
+    log_level = 2,
+}
+box.schema.user.grant('guest', 'super')
+box.schema.space.create('test')
+box.space.test:create_index('pk')
+box.space.test:replace({1, 'x'})
+
+local cpu = clock.proc()
+local client = popen.new({arg[-1], arg[0], '--client', sock},
+                         {stdout = popen.opts.PIPE})
+local output = ''
+while true do
+    local data = assert(client:read())
+    if data == '' then
+        break
+    end
+    output = output .. data
+end
+client:wait()
+client:close()
+cpu = clock.proc() - cpu
+local count, time = output:match('^(%S+)%s+(%S+)')
+count = assert(tonumber(count))
+time = assert(tonumber(time))
+
+print(string.format('iproto_io_collect_interval = %g, iproto_threads = %d',
+                    iproto_io_collect_interval, iproto_threads))
+print(string.format('requests/sec:            %d', count / time))
+print(string.format('requests/server-cpu-sec: %d', count / cpu))
+
+fio.rmtree(workdir)
+os.exit(0)
@@ -0,0 +1,364 @@
+#include "memory.h"
+#include "fiber.h"
+#include "tuple.h"
+#include "key_def.h"
+#include "normalized_key.h"
+#include "salad/art.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <benchmark/benchmark.h>
+
+/*
+ * Benchmarks of adaptive radix trees laid out the same way as
+ * memtx ART indexes (a tuple pointer with a normalized key) versus
+ * BPS trees laid out the same way as memtx hinted tree indexes.
+ */
+
+const size_t NUM_TEST_TUPLES = 1 << 20;
+const size_t EXTENT_SIZE = 16 * 1024;
+/** Number of tuples read by a range lookup. */
+const size_t RANGE_SIZE = 16;
+
+struct tree_elem {
+	struct tuple *tuple;
+	hint_t hint;
+};
+
+struct tree_key {
+	const char *key;
+	uint32_t part_count;
+	hint_t hint;
+};
+
+#define BPS_TREE_NAME perf_tree
+#define BPS_TREE_BLOCK_SIZE (512)
+#define BPS_TREE_EXTENT_SIZE EXTENT_SIZE
+#define BPS_TREE_COMPARE(a, b, arg)\
+	tuple_compare((a).tuple, (a).hint, (b).tuple, (b).hint, arg)
+#define BPS_TREE_COMPARE_KEY(a, b, arg)\
+	tuple_compare_with_key((a).tuple, (a).hint, (b)->key,\
+			       (b)->part_count, (b)->hint, arg)
+#define BPS_TREE_IS_IDENTICAL(a, b) ((a).tuple == (b).tuple)
+#define BPS_TREE_NO_DEBUG 1
+#define bps_tree_elem_t struct tree_elem
+#define bps_tree_key_t struct tree_key *
+#define bps_tree_arg_t struct key_def *
+
+#include "salad/bps_tree.h"
+
+struct art_elem {
+	struct tuple *tuple;
+	/** Normalized key, allocated on malloc. */
+	char *nkey;
+};
+
+static const unsigned char *
+art_elem_key(const void *value, uint32_t *len)
+{
+	const struct art_elem *elem = (const struct art_elem *)value;
+	*len = normalized_key_size(elem->nkey) - NORMALIZED_KEY_HEADER_SIZE;
+	return (const unsigned char *)elem->nkey + NORMALIZED_KEY_HEADER_SIZE;
+}
+
+static void *
+extent_alloc(void *ctx)
+{
+	(void)ctx;
+	return malloc(EXTENT_SIZE);
+}
+
+static void
+extent_free(void *ctx, void *extent)
+{
+	(void)ctx;
+	free(extent);
+}
+
+static void *
+art_node_alloc(void *ctx, size_t size)
+{
+	(void)ctx;
+	return malloc(size);
+}
+
+static void
+art_node_free(void *ctx, void *ptr, size_t size)
+{
+	(void)ctx;
+	(void)size;
+	free(ptr);
+}
+
+static char *
+normalized_key_dup(const char *nkey)
+{
+	uint32_t size = normalized_key_size(nkey);
+	char *copy = (char *)malloc(size);
+	memcpy(copy, nkey, size);
+	return copy;
+}
+
+/*
+ * Test tuples have two fields: a random unsigned integer and
+ * a string with a long common prefix, which can't be compared
+ * by hints. Normalized keys are built for both fields.
+ */
+class TestData {
+public:
+	static TestData &instance()
+	{
+		static TestData instance;
+		return instance;
+	}
+	struct key_def *uint_def;
+	struct key_def *str_def;
+	struct tuple *tuples[NUM_TEST_TUPLES];
+	char *uint_keys[NUM_TEST_TUPLES];
+	char *str_keys[NUM_TEST_TUPLES];
+	struct art_elem uint_elems[NUM_TEST_TUPLES];
+	struct art_elem str_elems[NUM_TEST_TUPLES];
+private:
+	TestData()
+	{
+		memory_init();
+		fiber_init(fiber_c_invoke);
+		tuple_init(NULL);
+
+		struct key_part_def part = key_part_def_default;
+		part.fieldno = 0;
+		part.type = FIELD_TYPE_UNSIGNED;
+		uint_def = key_def_new(&part, 1, false);
+		part.fieldno = 1;
+		part.type = FIELD_TYPE_STRING;
+		str_def = key_def_new(&part, 1, false);
+
+		struct region *region = &fiber()->gc;
+		struct tuple_format *format = box_tuple_format_default();
+		for (size_t i = 0; i < NUM_TEST_TUPLES; i++) {
+			uint64_t u = (uint64_t)rand() << 32 | i;
+			char str[32];
+			int len = snprintf(str, sizeof(str),
+					   "user:%020llu",
+					   (unsigned long long)u);
+			char data[64];
+			char *end = mp_encode_array(data, 2);
+			end = mp_encode_uint(end, u);
+			end = mp_encode_str(end, str, len);
+			tuples[i] = box_tuple_new(format, data, end);
+			tuple_ref(tuples[i]);
+			uint_keys[i] = (char *)malloc(mp_sizeof_uint(u));
+			mp_encode_uint(uint_keys[i], u);
+			str_keys[i] = (char *)malloc(mp_sizeof_str(len));
+			mp_encode_str(str_keys[i], str, len);
+			uint_elems[i].tuple = tuples[i];
+			uint_elems[i].nkey = normalized_key_dup(
+				tuple_normalized_key(tuples[i], uint_def,
+						     region));
+			str_elems[i].tuple = tuples[i];
+			str_elems[i].nkey = normalized_key_dup(
+				tuple_normalized_key(tuples[i], str_def,
+						     region));
+			region_truncate(region, 0);
+		}
+	}
+	~TestData()
+	{
+		for (size_t i = 0; i < NUM_TEST_TUPLES; i++) {
+			tuple_unref(tuples[i]);
+			free(uint_keys[i]);
+			free(str_keys[i]);
+			free(uint_elems[i].nkey);
+			free(str_elems[i].nkey);
+		}
+		key_def_delete(uint_def);
+		key_def_delete(str_def);
+		tuple_free();
+		fiber_free();
+		memory_free();
+	}
+};
+
+struct bps_traits {
+	typedef struct perf_tree tree_t;
+	static void create(tree_t *tree, struct key_def *def, bool is_str,
+			   size_t count)
+	{
+		(void)is_str;
+		perf_tree_create(tree, def, extent_alloc, extent_free, NULL);
+		struct tuple **tuples = TestData::instance().tuples;
+		for (size_t i = 0; i < count; i++) {
+			struct tree_elem elem;
+			elem.tuple = tuples[i];
+			elem.hint = tuple_hint(tuples[i], def);
+			if (perf_tree_insert(tree, elem, NULL, NULL) != 0)
+				abort();
+		}
+	}
+	static void destroy(tree_t *tree)
+	{
+		perf_tree_destroy(tree);
+	}
+	static struct tuple *find(tree_t *tree, struct key_def *def,
+				  bool is_str, size_t i)
+	{
+		TestData &data = TestData::instance();
+		struct tree_key key;
+		key.key = is_str ? data.str_keys[i] : data.uint_keys[i];
+		key.part_count = 1;
+		key.hint = key_hint(key.key, 1, def);
+		struct tree_elem *elem = perf_tree_find(tree, &key);
+		return elem != NULL ? elem->tuple : NULL;
+	}
+	static size_t range(tree_t *tree, struct key_def *def,
+			    bool is_str, size_t i)
+	{
+		TestData &data = TestData::instance();
+		struct tree_key key;
+		key.key = is_str ? data.str_keys[i] : data.uint_keys[i];
+		key.part_count = 1;
+		key.hint = key_hint(key.key, 1, def);
+		bool exact;
+		struct perf_tree_iterator it =
+			perf_tree_lower_bound(tree, &key, &exact);
+		size_t n = 0;
+		struct tree_elem *elem;
+		while (n < RANGE_SIZE &&
+		       (elem = perf_tree_iterator_get_elem(tree, &it)) != NULL) {
+			benchmark::DoNotOptimize(elem->tuple);
+			perf_tree_iterator_next(tree, &it);
+			n++;
+		}
+		return n;
+	}
+};
+
+struct art_traits {
+	typedef struct art tree_t;
+	static void create(tree_t *tree, struct key_def *def, bool is_str,
+			   size_t count)
+	{
+		(void)def;
+		art_create(tree, art_elem_key, art_node_alloc, art_node_free,
+			   NULL);
+		TestData &data = TestData::instance();
+		struct art_elem *elems = is_str ? data.str_elems :
+					 data.uint_elems;
+		for (size_t i = 0; i < count; i++) {
+			void *replaced;
+			if (art_insert(tree, &elems[i], &replaced) != 0)
+				abort();
+		}
+	}
+	static void destroy(tree_t *tree)
+	{
+		art_destroy(tree);
+	}
+	/*
+	 * Build a normalized key for each lookup like a memtx ART
+	 * index does so that the cost of key conversion is counted.
+	 */
+	static struct tuple *find(tree_t *tree, struct key_def *def,
+				  bool is_str, size_t i)
+	{
+		TestData &data = TestData::instance();
+		struct region *region = &fiber()->gc;
+		const char *key = is_str ? data.str_keys[i] : data.uint_keys[i];
+		const char *nkey = key_normalized_key(key, 1, def, region);
+		struct art_elem *elem = (struct art_elem *)art_find(tree,
+			(const unsigned char *)nkey + NORMALIZED_KEY_HEADER_SIZE,
+			normalized_key_size(nkey) - NORMALIZED_KEY_HEADER_SIZE);
+		region_truncate(region, 0);
+		return elem != NULL ? elem->tuple : NULL;
+	}
+	static size_t range(tree_t *tree, struct key_def *def,
+			    bool is_str, size_t i)
+	{
+		TestData &data = TestData::instance();
+		struct region *region = &fiber()->gc;
+		const char *key = is_str ? data.str_keys[i] : data.uint_keys[i];
+		const char *nkey = key_normalized_key(key, 1, def, region);
+		const unsigned char *k = (const unsigned char *)nkey +
+					 NORMALIZED_KEY_HEADER_SIZE;
+		uint32_t len = normalized_key_size(nkey) -
+			       NORMALIZED_KEY_HEADER_SIZE;
+		size_t n = 0;
+		struct art_elem *elem = (struct art_elem *)
+			art_succ(tree, k, len, true);
+		while (n < RANGE_SIZE && elem != NULL) {
+			benchmark::DoNotOptimize(elem->tuple);
+			/* Step to the next key like a memtx ART iterator. */
+			k = art_elem_key(elem, &len);
+			elem = (struct art_elem *)art_succ(tree, k, len, false);
+			n++;
+		}
+		region_truncate(region, 0);
+		return n;
+	}
+};
+
+static struct key_def *
+test_key_def(bool is_str)
+{
+	TestData &data = TestData::instance();
+	return is_str ? data.str_def : data.uint_def;
+}
+
+/*
+ * Arguments: the number of tuples, whether the key is a string.
+ */
+template <class Traits>
+static void
+bench_find(benchmark::State &state)
+{
+	size_t count = state.range(0);
+	bool is_str = state.range(1);
+	struct key_def *def = test_key_def(is_str);
+	typename Traits::tree_t tree;
+	Traits::create(&tree, def, is_str, count);
+	size_t i = 0;
+	size_t total_count = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(Traits::find(&tree, def, is_str, i));
+		/* Visit keys in a pseudo-random order. */
+		i = (i + 7919) % count;
+		total_count++;
+	}
+	Traits::destroy(&tree);
+	state.SetItemsProcessed(total_count);
+}
+
+template <class Traits>
+static void
+bench_range(benchmark::State &state)
+{
+	size_t count = state.range(0);
+	bool is_str = state.range(1);
+	struct key_def *def = test_key_def(is_str);
+	typename Traits::tree_t tree;
+	Traits::create(&tree, def, is_str, count);
+	size_t i = 0;
+	size_t total_count = 0;
+	for (auto _ : state) {
+		total_count += Traits::range(&tree, def, is_str, i);
+		i = (i + 7919) % count;
+	}
+	Traits::destroy(&tree);
+	state.SetItemsProcessed(total_count);
+}
+
+static void
+bench_args(benchmark::internal::Benchmark *b)
+{
+	for (int64_t count : {1 << 14, 1 << 20}) {
+		for (int64_t is_str : {0, 1})
+			b->Args({count, is_str});
+	}
+}
+
+BENCHMARK_TEMPLATE(bench_find, bps_traits)->Apply(bench_args);
+BENCHMARK_TEMPLATE(bench_find, art_traits)->Apply(bench_args);
+BENCHMARK_TEMPLATE(bench_range, bps_traits)->Apply(bench_args);
+BENCHMARK_TEMPLATE(bench_range, art_traits)->Apply(bench_args);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,515 @@
+#include "memory.h"
+#include "fiber.h"
+#include "tuple.h"
+#include "key_def.h"
+#include "normalized_key.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <benchmark/benchmark.h>
+
+/*
+ * Benchmarks of BPS trees laid out the same way as memtx tree
+ * indexes: each element is a tuple pointer with an optional
+ * comparison hint, or a tuple pointer with a normalized key and
+ * an optional inline prefix of the key. Used for tuning the tree
+ * block size and the inline prefix size.
+ */
+
+const size_t NUM_TEST_TUPLES = 1 << 20;
+const size_t EXTENT_SIZE = 16 * 1024;
+
+struct tree_elem {
+	struct tuple *tuple;
+	hint_t hint;
+};
+
+struct tree_key {
+	const char *key;
+	uint32_t part_count;
+	hint_t hint;
+};
+
+#define BPS_TREE_NAME perf_tree
+#define BPS_TREE_EXTENT_SIZE EXTENT_SIZE
+#define BPS_TREE_COMPARE(a, b, arg)\
+	tuple_compare((a).tuple, (a).hint, (b).tuple, (b).hint, arg)
+#define BPS_TREE_COMPARE_KEY(a, b, arg)\
+	tuple_compare_with_key((a).tuple, (a).hint, (b)->key,\
+			       (b)->part_count, (b)->hint, arg)
+#define BPS_TREE_IS_IDENTICAL(a, b) ((a).tuple == (b).tuple)
+#define BPS_TREE_NO_DEBUG 1
+#define bps_tree_elem_t struct tree_elem
+#define bps_tree_key_t struct tree_key *
+#define bps_tree_arg_t struct key_def *
+
+#define BPS_TREE_NAMESPACE block_256
+#define BPS_TREE_BLOCK_SIZE (256)
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
+
+#define BPS_TREE_NAMESPACE block_512
+#define BPS_TREE_BLOCK_SIZE (512)
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
+
+#define BPS_TREE_NAMESPACE block_1024
+#define BPS_TREE_BLOCK_SIZE (1024)
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
+
+#define BPS_TREE_NAMESPACE block_2048
+#define BPS_TREE_BLOCK_SIZE (2048)
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
+
+#undef BPS_TREE_COMPARE
+#undef BPS_TREE_COMPARE_KEY
+#undef BPS_TREE_IS_IDENTICAL
+#undef bps_tree_elem_t
+#undef bps_tree_key_t
+
+/*
+ * Elements of an index with normalized keys, with and without
+ * an inline key prefix, see memtx_tree_data<true, false, true>.
+ */
+enum { NKEY_PREFIX_SIZE = 15 };
+
+struct nkey_elem {
+	struct tuple *tuple;
+	const char *nkey;
+};
+
+struct prefix_elem : nkey_elem {
+	uint8_t prefix_size;
+	char prefix[NKEY_PREFIX_SIZE];
+};
+
+static inline int
+nkey_elem_compare(const struct nkey_elem *a, const struct nkey_elem *b)
+{
+	return normalized_key_compare(a->nkey, b->nkey);
+}
+
+static inline int
+nkey_elem_compare_with_key(const struct nkey_elem *a, const char *nkey)
+{
+	return normalized_key_compare(a->nkey, nkey);
+}
+
+static inline int
+nkey_elem_compare(const struct prefix_elem *a, const struct prefix_elem *b)
+{
+	uint32_t size = MIN(a->prefix_size, b->prefix_size);
+	int rc = memcmp(a->prefix, b->prefix, size);
+	if (rc != 0 || size < NKEY_PREFIX_SIZE)
+		return rc;
+	return normalized_key_compare(a->nkey, b->nkey);
+}
+
+static inline int
+nkey_elem_compare_with_key(const struct prefix_elem *a, const char *nkey)
+{
+	uint32_t size = MIN((uint32_t)a->prefix_size,
+			    normalized_key_size(nkey) -
+			    NORMALIZED_KEY_HEADER_SIZE);
+	int rc = memcmp(a->prefix, nkey + NORMALIZED_KEY_HEADER_SIZE, size);
+	if (rc != 0 || size < NKEY_PREFIX_SIZE)
+		return rc;
+	return normalized_key_compare(a->nkey, nkey);
+}
+
+#define BPS_TREE_COMPARE(a, b, arg) nkey_elem_compare(&(a), &(b))
+#define BPS_TREE_COMPARE_KEY(a, b, arg) nkey_elem_compare_with_key(&(a), b)
+#define BPS_TREE_IS_IDENTICAL(a, b) ((a).tuple == (b).tuple)
+#define bps_tree_key_t const char *
+
+#define bps_tree_elem_t struct nkey_elem
+
+#define BPS_TREE_NAMESPACE nkey_512
+#define BPS_TREE_BLOCK_SIZE (512)
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
+
+#define BPS_TREE_NAMESPACE nkey_1024
+#define BPS_TREE_BLOCK_SIZE (1024)
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
+
+#define BPS_TREE_NAMESPACE nkey_2048
+#define BPS_TREE_BLOCK_SIZE (2048)
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
+
+#undef bps_tree_elem_t
+#define bps_tree_elem_t struct prefix_elem
+
+#define BPS_TREE_NAMESPACE prefix_512
+#define BPS_TREE_BLOCK_SIZE (512)
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
+
+#define BPS_TREE_NAMESPACE prefix_1024
+#define BPS_TREE_BLOCK_SIZE (1024)
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
+
+#define BPS_TREE_NAMESPACE prefix_2048
+#define BPS_TREE_BLOCK_SIZE (2048)
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
+
+static void *
+extent_alloc(void *ctx)
+{
+	(void)ctx;
+	return malloc(EXTENT_SIZE);
+}
+
+static void
+extent_free(void *ctx, void *extent)
+{
+	(void)ctx;
+	free(extent);
+}
+
+#define TREE_TRAITS(ns, elem_type, key_type)				\
+struct ns##_traits {							\
+	typedef ns::perf_tree tree_t;					\
+	typedef elem_type elem_t;					\
+	static void create(tree_t *tree, struct key_def *def)		\
+	{								\
+		ns::perf_tree_create(tree, def, extent_alloc,		\
+				     extent_free, NULL);		\
+	}								\
+	static void destroy(tree_t *tree)				\
+	{								\
+		ns::perf_tree_destroy(tree);				\
+	}								\
+	static void insert(tree_t *tree, elem_type elem)		\
+	{								\
+		if (ns::perf_tree_insert(tree, elem, NULL, NULL) != 0)	\
+			abort();					\
+	}								\
+	static elem_type *find(tree_t *tree, key_type key)		\
+	{								\
+		return ns::perf_tree_find(tree, key);			\
+	}								\
+}
+
+TREE_TRAITS(block_256, struct tree_elem, struct tree_key *);
+TREE_TRAITS(block_512, struct tree_elem, struct tree_key *);
+TREE_TRAITS(block_1024, struct tree_elem, struct tree_key *);
+TREE_TRAITS(block_2048, struct tree_elem, struct tree_key *);
+TREE_TRAITS(nkey_512, struct nkey_elem, const char *);
+TREE_TRAITS(nkey_1024, struct nkey_elem, const char *);
+TREE_TRAITS(nkey_2048, struct nkey_elem, const char *);
+TREE_TRAITS(prefix_512, struct prefix_elem, const char *);
+TREE_TRAITS(prefix_1024, struct prefix_elem, const char *);
+TREE_TRAITS(prefix_2048, struct prefix_elem, const char *);
+
+/*
+ * Test tuples have two fields: a random unsigned integer and
+ * a string with a long common prefix, which can't be compared
+ * by hints.
+ */
+class TestData {
+public:
+	static TestData &instance()
+	{
+		static TestData instance;
+		return instance;
+	}
+	struct key_def *uint_def;
+	struct key_def *str_def;
+	struct tuple *tuples[NUM_TEST_TUPLES];
+	char *uint_keys[NUM_TEST_TUPLES];
+	char *str_keys[NUM_TEST_TUPLES];
+	/* Normalized keys of the tuples, used as search keys, too. */
+	char *uint_nkeys[NUM_TEST_TUPLES];
+	char *str_nkeys[NUM_TEST_TUPLES];
+private:
+	static char *
+	normalized_key_dup(struct tuple *tuple, struct key_def *def)
+	{
+		struct region *region = &fiber()->gc;
+		size_t region_svp = region_used(region);
+		const char *nkey = tuple_normalized_key(tuple, def, region);
+		if (nkey == NULL)
+			abort();
+		uint32_t size = normalized_key_size(nkey);
+		char *copy = (char *)malloc(size);
+		memcpy(copy, nkey, size);
+		region_truncate(region, region_svp);
+		return copy;
+	}
+
+	TestData()
+	{
+		memory_init();
+		fiber_init(fiber_c_invoke);
+		tuple_init(NULL);
+
+		struct key_part_def part = key_part_def_default;
+		part.fieldno = 0;
+		part.type = FIELD_TYPE_UNSIGNED;
+		uint_def = key_def_new(&part, 1, false);
+		part.fieldno = 1;
+		part.type = FIELD_TYPE_STRING;
+		str_def = key_def_new(&part, 1, false);
+		struct key_def *uint_ndef = normalized_key_def_new(uint_def);
+		struct key_def *str_ndef = normalized_key_def_new(str_def);
+
+		struct tuple_format *format = box_tuple_format_default();
+		for (size_t i = 0; i < NUM_TEST_TUPLES; i++) {
+			uint64_t u = (uint64_t)rand() << 32 | i;
+			char str[32];
+			int len = snprintf(str, sizeof(str),
+					   "user:%020llu",
+					   (unsigned long long)u);
+			char data[64];
+			char *end = mp_encode_array(data, 2);
+			end = mp_encode_uint(end, u);
+			end = mp_encode_str(end, str, len);
+			tuples[i] = box_tuple_new(format, data, end);
+			tuple_ref(tuples[i]);
+			uint_keys[i] = (char *)malloc(mp_sizeof_uint(u));
+			mp_encode_uint(uint_keys[i], u);
+			str_keys[i] = (char *)malloc(mp_sizeof_str(len));
+			mp_encode_str(str_keys[i], str, len);
+			uint_nkeys[i] = normalized_key_dup(tuples[i],
+							   uint_ndef);
+			str_nkeys[i] = normalized_key_dup(tuples[i], str_ndef);
+		}
+		key_def_delete(uint_ndef);
+		key_def_delete(str_ndef);
+	}
+	~TestData()
+	{
+		for (size_t i = 0; i < NUM_TEST_TUPLES; i++) {
+			tuple_unref(tuples[i]);
+			free(uint_keys[i]);
+			free(str_keys[i]);
+			free(uint_nkeys[i]);
+			free(str_nkeys[i]);
+		}
+		key_def_delete(uint_def);
+		key_def_delete(str_def);
+		tuple_free();
+		fiber_free();
+		memory_free();
+	}
+};
+
+static struct key_def *
+test_key_def(bool is_str)
+{
+	TestData &data = TestData::instance();
+	return is_str ? data.str_def : data.uint_def;
+}
+
+static struct tree_elem
+test_elem(size_t i, struct key_def *def, bool use_hint)
+{
+	struct tuple *tuple = TestData::instance().tuples[i];
+	struct tree_elem elem;
+	elem.tuple = tuple;
+	elem.hint = use_hint ? tuple_hint(tuple, def) : HINT_NONE;
+	return elem;
+}
+
+static struct tree_key
+test_key(size_t i, struct key_def *def, bool is_str, bool use_hint)
+{
+	TestData &data = TestData::instance();
+	struct tree_key key;
+	key.key = is_str ? data.str_keys[i] : data.uint_keys[i];
+	key.part_count = 1;
+	key.hint = use_hint ? key_hint(key.key, 1, def) : HINT_NONE;
+	return key;
+}
+
+static const char *
+test_nkey(size_t i, bool is_str)
+{
+	TestData &data = TestData::instance();
+	return is_str ? data.str_nkeys[i] : data.uint_nkeys[i];
+}
+
+static void
+test_elem_init(struct nkey_elem *elem, size_t i, bool is_str)
+{
+	elem->tuple = TestData::instance().tuples[i];
+	elem->nkey = test_nkey(i, is_str);
+}
+
+static void
+test_elem_init(struct prefix_elem *elem, size_t i, bool is_str)
+{
+	test_elem_init((struct nkey_elem *)elem, i, is_str);
+	elem->prefix_size = MIN(normalized_key_size(elem->nkey) -
+				NORMALIZED_KEY_HEADER_SIZE,
+				(uint32_t)NKEY_PREFIX_SIZE);
+	memcpy(elem->prefix, elem->nkey + NORMALIZED_KEY_HEADER_SIZE,
+	       elem->prefix_size);
+}
+
+/*
+ * Arguments: the number of tuples, whether the key is a string,
+ * whether hints are used.
+ */
+template <class Traits>
+static void
+bench_insert(benchmark::State &state)
+{
+	size_t count = state.range(0);
+	bool is_str = state.range(1);
+	bool use_hint = state.range(2);
+	struct key_def *def = test_key_def(is_str);
+	size_t total_count = 0;
+	for (auto _ : state) {
+		typename Traits::tree_t tree;
+		Traits::create(&tree, def);
+		for (size_t i = 0; i < count; i++)
+			Traits::insert(&tree, test_elem(i, def, use_hint));
+		state.PauseTiming();
+		Traits::destroy(&tree);
+		state.ResumeTiming();
+		total_count += count;
+	}
+	state.SetItemsProcessed(total_count);
+}
+
+template <class Traits>
+static void
+bench_find(benchmark::State &state)
+{
+	size_t count = state.range(0);
+	bool is_str = state.range(1);
+	bool use_hint = state.range(2);
+	struct key_def *def = test_key_def(is_str);
+	typename Traits::tree_t tree;
+	Traits::create(&tree, def);
+	for (size_t i = 0; i < count; i++)
+		Traits::insert(&tree, test_elem(i, def, use_hint));
+	size_t i = 0;
+	size_t total_count = 0;
+	for (auto _ : state) {
+		struct tree_key key = test_key(i, def, is_str, use_hint);
+		benchmark::DoNotOptimize(Traits::find(&tree, &key));
+		/* Visit keys in a pseudo-random order. */
+		i = (i + 7919) % count;
+		total_count++;
+	}
+	Traits::destroy(&tree);
+	state.SetItemsProcessed(total_count);
+}
+
+/*
+ * Benchmarks of indexes with normalized keys. Arguments: the number
+ * of tuples, whether the key is a string.
+ */
+template <class Traits>
+static void
+bench_nkey_insert(benchmark::State &state)
+{
+	size_t count = state.range(0);
+	bool is_str = state.range(1);
+	struct key_def *def = test_key_def(is_str);
+	size_t total_count = 0;
+	for (auto _ : state) {
+		typename Traits::tree_t tree;
+		Traits::create(&tree, def);
+		for (size_t i = 0; i < count; i++) {
+			typename Traits::elem_t elem;
+			test_elem_init(&elem, i, is_str);
+			Traits::insert(&tree, elem);
+		}
+		state.PauseTiming();
+		Traits::destroy(&tree);
+		state.ResumeTiming();
+		total_count += count;
+	}
+	state.SetItemsProcessed(total_count);
+}
+
+template <class Traits>
+static void
+bench_nkey_find(benchmark::State &state)
+{
+	size_t count = state.range(0);
+	bool is_str = state.range(1);
+	struct key_def *def = test_key_def(is_str);
+	typename Traits::tree_t tree;
+	Traits::create(&tree, def);
+	for (size_t i = 0; i < count; i++) {
+		typename Traits::elem_t elem;
+		test_elem_init(&elem, i, is_str);
+		Traits::insert(&tree, elem);
+	}
+	size_t i = 0;
+	size_t total_count = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(Traits::find(&tree,
+						      test_nkey(i, is_str)));
+		/* Visit keys in a pseudo-random order. */
+		i = (i + 7919) % count;
+		total_count++;
+	}
+	Traits::destroy(&tree);
+	state.SetItemsProcessed(total_count);
+}
+
+static void
+bench_args(benchmark::internal::Benchmark *b)
+{
+	for (int64_t count : {1 << 14, 1 << 20}) {
+		for (int64_t is_str : {0, 1}) {
+			for (int64_t use_hint : {0, 1})
+				b->Args({count, is_str, use_hint});
+		}
+	}
+}
+
+BENCHMARK_TEMPLATE(bench_insert, block_256_traits)->Apply(bench_args);
+BENCHMARK_TEMPLATE(bench_insert, block_512_traits)->Apply(bench_args);
+BENCHMARK_TEMPLATE(bench_insert, block_1024_traits)->Apply(bench_args);
+BENCHMARK_TEMPLATE(bench_insert, block_2048_traits)->Apply(bench_args);
+BENCHMARK_TEMPLATE(bench_find, block_256_traits)->Apply(bench_args);
+BENCHMARK_TEMPLATE(bench_find, block_512_traits)->Apply(bench_args);
+BENCHMARK_TEMPLATE(bench_find, block_1024_traits)->Apply(bench_args);
+BENCHMARK_TEMPLATE(bench_find, block_2048_traits)->Apply(bench_args);
+
+static void
+nkey_args(benchmark::internal::Benchmark *b)
+{
+	for (int64_t count : {1 << 14, 1 << 20}) {
+		for (int64_t is_str : {0, 1})
+			b->Args({count, is_str});
+	}
+}
+
+BENCHMARK_TEMPLATE(bench_nkey_insert, nkey_512_traits)->Apply(nkey_args);
+BENCHMARK_TEMPLATE(bench_nkey_insert, nkey_1024_traits)->Apply(nkey_args);
+BENCHMARK_TEMPLATE(bench_nkey_insert, nkey_2048_traits)->Apply(nkey_args);
+BENCHMARK_TEMPLATE(bench_nkey_insert, prefix_512_traits)->Apply(nkey_args);
+BENCHMARK_TEMPLATE(bench_nkey_insert, prefix_1024_traits)->Apply(nkey_args);
+BENCHMARK_TEMPLATE(bench_nkey_insert, prefix_2048_traits)->Apply(nkey_args);
+BENCHMARK_TEMPLATE(bench_nkey_find, nkey_512_traits)->Apply(nkey_args);
+BENCHMARK_TEMPLATE(bench_nkey_find, nkey_1024_traits)->Apply(nkey_args);
+BENCHMARK_TEMPLATE(bench_nkey_find, nkey_2048_traits)->Apply(nkey_args);
+BENCHMARK_TEMPLATE(bench_nkey_find, prefix_512_traits)->Apply(nkey_args);
+BENCHMARK_TEMPLATE(bench_nkey_find, prefix_1024_traits)->Apply(nkey_args);
+BENCHMARK_TEMPLATE(bench_nkey_find, prefix_2048_traits)->Apply(nkey_args);
+
+BENCHMARK_MAIN();
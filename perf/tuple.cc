@@ -9,6 +9,7 @@
 
 const size_t NUM_TEST_TUPLES = 4096;
 const size_t MAX_TUPLE_DATA_SIZE = 512;
+const size_t FIXED_FIELD_COUNT = 8;
 
 // Class that creates and destroys tuple format for private memtx engine.
 class MemtxEngine {
@@ -19,6 +20,7 @@ public:
 		return instance;
 	}
 	struct tuple_format *format() { return fmt; }
+	struct tuple_format *fixed_format() { return fixed_fmt; }
 	struct key_def *key_def() { return kd; }
 private:
 	MemtxEngine()
@@ -56,13 +58,27 @@ private:
 		kdp.type = FIELD_TYPE_UNSIGNED;
 		kd = key_def_new(&kdp, 1, false);
 		fmt = tuple_format_new(&memtx_tuple_format_vtab, &memtx, &kd, 1,
-					  NULL, 0, 0, NULL, false, false);
+					  NULL, 0, 0, NULL, false, false, false);
 		tuple_format_ref(fmt);
+
+		struct field_def fields[FIXED_FIELD_COUNT];
+		for (size_t i = 0; i < FIXED_FIELD_COUNT; i++) {
+			fields[i] = field_def_default;
+			fields[i].type = FIELD_TYPE_UNSIGNED;
+			fields[i].nullable_action = ON_CONFLICT_ACTION_ABORT;
+		}
+		fixed_fmt = tuple_format_new(&memtx_tuple_format_vtab, &memtx,
+					     &kd, 1, fields, FIXED_FIELD_COUNT,
+					     0, NULL, false, false, true);
+		if (fixed_fmt == NULL)
+			abort();
+		tuple_format_ref(fixed_fmt);
 	}
 	~MemtxEngine()
 	{
 		key_def_delete(kd);
 		tuple_format_unref(fmt);
+		tuple_format_unref(fixed_fmt);
 		tuple_free();
 		SmallAlloc::destroy();
 		slab_cache_destroy(&memtx.slab_cache);
@@ -74,6 +90,7 @@ private:
 	struct memtx_engine memtx;
 	struct key_def *kd;
 	struct tuple_format *fmt;
+	struct tuple_format *fixed_fmt;
 };
 
 // Generator of random msgpack array.
@@ -372,6 +389,44 @@ tuple_access_indexed_field(benchmark::State& state)
 
 BENCHMARK(tuple_access_indexed_field);
 
+// benchmark of access of the last field of a tuple that consists of
+// unsigned integers, stored with the default or fixed layout.
+template <bool IS_FIXED>
+static void
+tuple_access_uint_field(benchmark::State& state)
+{
+	MemtxEngine &engine = MemtxEngine::instance();
+	struct tuple_format *format = IS_FIXED ? engine.fixed_format() :
+				      engine.format();
+	struct tuple *tuples[NUM_TEST_TUPLES];
+	for (size_t i = 0; i < NUM_TEST_TUPLES; i++) {
+		char data[MAX_TUPLE_DATA_SIZE];
+		char *data_end = mp_encode_array(data, FIXED_FIELD_COUNT);
+		for (size_t k = 0; k < FIXED_FIELD_COUNT; k++)
+			data_end = mp_encode_uint(data_end, rand());
+		tuples[i] = box_tuple_new(format, data, data_end);
+		tuple_ref(tuples[i]);
+	}
+	size_t i = 0;
+	size_t total_count = 0;
+	for (auto _ : state) {
+		if (i == NUM_TEST_TUPLES) {
+			total_count += i;
+			i = 0;
+		}
+		struct tuple *t = tuples[i++];
+		benchmark::DoNotOptimize(
+			*tuple_field(t, FIXED_FIELD_COUNT - 1));
+	}
+	total_count += i;
+	state.SetItemsProcessed(total_count);
+	for (size_t k = 0; k < NUM_TEST_TUPLES; k++)
+		tuple_unref(tuples[k]);
+}
+
+BENCHMARK_TEMPLATE(tuple_access_uint_field, false);
+BENCHMARK_TEMPLATE(tuple_access_uint_field, true);
+
 // benchmark of tuple compare.
 static void
 tuple_tuple_compare(benchmark::State& state)
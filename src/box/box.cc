@@ -272,6 +272,31 @@ box_check_memtx_min_tuple_size(ssize_t memtx_min_tuple_size)
 		  "specified value is out of bounds");
 }
 
+static int
+box_check_memtx_defrag(void)
+{
+	double threshold = cfg_getd("memtx_defrag_threshold");
+	if (threshold < 0 || threshold >= 1) {
+		diag_set(ClientError, ER_CFG, "memtx_defrag_threshold",
+			 "the value must be >= 0 and < 1");
+		return -1;
+	}
+	if (cfg_getd("memtx_defrag_rate") <= 0) {
+		diag_set(ClientError, ER_CFG, "memtx_defrag_rate",
+			 "the value must be greater than 0");
+		return -1;
+	}
+	return 0;
+}
+
+static void
+box_check_memtx_numa_node(int memtx_numa_node)
+{
+	if (memtx_numa_node < -1 || memtx_numa_node >= MEMTX_NUMA_NODES_MAX)
+		tnt_raise(ClientError, ER_CFG, "memtx_numa_node",
+			  "specified value is out of bounds");
+}
+
 int
 box_process_rw(struct request *request, struct space *space,
 	       struct tuple **result)
@@ -1131,6 +1156,30 @@ box_check_memory_quota(const char *quota_name)
 	return -1;
 }
 
+static int
+box_check_vinyl_max_subcompactions(void)
+{
+	int count = cfg_geti("vinyl_max_subcompactions");
+	if (count < 1) {
+		diag_set(ClientError, ER_CFG, "vinyl_max_subcompactions",
+			 "must be greater than or equal to 1");
+		return -1;
+	}
+	return count;
+}
+
+static int
+box_check_vinyl_readahead_pages(void)
+{
+	int pages = cfg_geti("vinyl_readahead_pages");
+	if (pages < 0) {
+		diag_set(ClientError, ER_CFG, "vinyl_readahead_pages",
+			 "must be greater than or equal to 0");
+		return -1;
+	}
+	return pages;
+}
+
 static void
 box_check_vinyl_options(void)
 {
@@ -1170,6 +1219,10 @@ box_check_vinyl_options(void)
 		tnt_raise(ClientError, ER_CFG, "vinyl_bloom_fpr",
 			  "must be greater than 0 and less than or equal to 1");
 	}
+	if (box_check_vinyl_max_subcompactions() < 0)
+		diag_raise();
+	if (box_check_vinyl_readahead_pages() < 0)
+		diag_raise();
 }
 
 static int
@@ -1234,6 +1287,18 @@ box_check_iproto_options(void)
 	return 0;
 }
 
+static double
+box_check_iproto_io_collect_interval(void)
+{
+	double interval = cfg_getd("iproto_io_collect_interval");
+	if (interval < 0) {
+		diag_set(ClientError, ER_CFG, "iproto_io_collect_interval",
+			 "the value must be greater than or equal to 0");
+		return -1;
+	}
+	return interval;
+}
+
 static double
 box_check_txn_timeout(void)
 {
@@ -1283,12 +1348,17 @@ box_check_config(void)
 	if (box_check_memory_quota("memtx_memory") < 0)
 		diag_raise();
 	box_check_memtx_min_tuple_size(cfg_geti64("memtx_min_tuple_size"));
+	box_check_memtx_numa_node(cfg_geti("memtx_numa_node"));
+	if (box_check_memtx_defrag() != 0)
+		diag_raise();
 	if (box_check_allocator() != 0)
 		diag_raise();
 	box_check_small_alloc_options();
 	box_check_vinyl_options();
 	if (box_check_iproto_options() != 0)
 		diag_raise();
+	if (box_check_iproto_io_collect_interval() < 0)
+		diag_raise();
 	if (box_check_sql_cache_size(cfg_geti("sql_cache_size")) != 0)
 		diag_raise();
 	if (box_check_txn_timeout() < 0)
@@ -2006,6 +2076,19 @@ box_set_memtx_max_tuple_size(void)
 			cfg_geti("memtx_max_tuple_size"));
 }
 
+int
+box_set_memtx_defrag(void)
+{
+	if (box_check_memtx_defrag() != 0)
+		return -1;
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_defrag(memtx, cfg_getd("memtx_defrag_threshold"),
+				cfg_getd("memtx_defrag_rate"));
+	return 0;
+}
+
 void
 box_set_too_long_threshold(void)
 {
@@ -2109,6 +2192,30 @@ box_set_vinyl_timeout(void)
 	vinyl_engine_set_timeout(vinyl,	cfg_getd("vinyl_timeout"));
 }
 
+int
+box_set_vinyl_max_subcompactions(void)
+{
+	int count = box_check_vinyl_max_subcompactions();
+	if (count < 0)
+		return -1;
+	struct engine *vinyl = engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_max_subcompactions(vinyl, count);
+	return 0;
+}
+
+int
+box_set_vinyl_readahead_pages(void)
+{
+	int pages = box_check_vinyl_readahead_pages();
+	if (pages < 0)
+		return -1;
+	struct engine *vinyl = engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_readahead_pages(vinyl, pages);
+	return 0;
+}
+
 void
 box_set_net_msg_max(void)
 {
@@ -2147,6 +2254,16 @@ box_set_crash(void)
 	return 0;
 }
 
+int
+box_set_iproto_io_collect_interval(void)
+{
+	double interval = box_check_iproto_io_collect_interval();
+	if (interval < 0)
+		return -1;
+	iproto_set_io_collect_interval(interval);
+	return 0;
+}
+
 int
 box_set_txn_timeout(void)
 {
@@ -2319,53 +2436,73 @@ box_process1(struct request *request, box_tuple_t **result)
 	return box_process_rw(request, space, result);
 }
 
-API_EXPORT int
-box_select(uint32_t space_id, uint32_t index_id,
-	   int iterator, uint32_t offset, uint32_t limit,
-	   const char *key, const char *key_end,
-	   struct port *port)
+/**
+ * Check a select request and open an iterator for it in a read-only
+ * statement. On success the caller must delete the iterator and end
+ * the statement. Returns NULL and sets diag on error.
+ */
+static struct iterator *
+box_select_create_iterator(uint32_t space_id, uint32_t index_id,
+			   int iterator, const char *key,
+			   struct space **space, struct txn **txn,
+			   struct txn_ro_savepoint *svp)
 {
-	(void)key_end;
-
 	rmean_collect(rmean_box, IPROTO_SELECT, 1);
 
 	if (iterator < 0 || iterator >= iterator_type_MAX) {
 		diag_set(ClientError, ER_ILLEGAL_PARAMS,
 			 "Invalid iterator type");
 		diag_log();
-		return -1;
+		return NULL;
 	}
 
-	struct space *space = space_cache_find(space_id);
-	if (space == NULL)
-		return -1;
-	if (access_check_space(space, PRIV_R) != 0)
-		return -1;
-	struct index *index = index_find(space, index_id);
+	*space = space_cache_find(space_id);
+	if (*space == NULL)
+		return NULL;
+	if (access_check_space(*space, PRIV_R) != 0)
+		return NULL;
+	struct index *index = index_find(*space, index_id);
 	if (index == NULL)
-		return -1;
+		return NULL;
 
 	enum iterator_type type = (enum iterator_type) iterator;
 	uint32_t part_count = key ? mp_decode_array(&key) : 0;
 	if (key_validate(index->def, type, key, part_count))
-		return -1;
+		return NULL;
 
 	ERROR_INJECT(ERRINJ_TESTING, {
 		diag_set(ClientError, ER_INJECTION, "ERRINJ_TESTING");
-		return -1;
+		return NULL;
 	});
 
-	struct txn *txn;
-	struct txn_ro_savepoint svp;
-	if (txn_begin_ro_stmt(space, &txn, &svp) != 0)
-		return -1;
+	if (txn_begin_ro_stmt(*space, txn, svp) != 0)
+		return NULL;
 
 	struct iterator *it = index_create_iterator(index, type,
 						    key, part_count);
 	if (it == NULL) {
-		txn_rollback_stmt(txn);
-		return -1;
+		txn_rollback_stmt(*txn);
+		return NULL;
 	}
+	return it;
+}
+
+API_EXPORT int
+box_select(uint32_t space_id, uint32_t index_id,
+	   int iterator, uint32_t offset, uint32_t limit,
+	   const char *key, const char *key_end,
+	   struct port *port)
+{
+	(void)key_end;
+
+	struct space *space;
+	struct txn *txn;
+	struct txn_ro_savepoint svp;
+	struct iterator *it = box_select_create_iterator(space_id, index_id,
+							 iterator, key, &space,
+							 &txn, &svp);
+	if (it == NULL)
+		return -1;
 
 	int rc = 0;
 	uint32_t found = 0;
@@ -2395,6 +2532,60 @@ box_select(uint32_t space_id, uint32_t index_id,
 	return 0;
 }
 
+int
+box_select_to_obuf(uint32_t space_id, uint32_t index_id,
+		   int iterator, uint32_t offset, uint32_t limit,
+		   const char *key, const char *key_end,
+		   struct obuf *out, uint32_t *count)
+{
+	(void)key_end;
+
+	struct space *space;
+	struct txn *txn;
+	struct txn_ro_savepoint svp;
+	struct iterator *it = box_select_create_iterator(space_id, index_id,
+							 iterator, key, &space,
+							 &txn, &svp);
+	if (it == NULL)
+		return -1;
+	/*
+	 * Tuples aren't referenced, so nothing may yield until they
+	 * are copied. Memtx iterators never yield.
+	 */
+	assert(space_is_memtx(space));
+
+	int rc = 0;
+	uint32_t found = 0;
+	struct tuple *tuple;
+	while (found < limit) {
+		rc = iterator_next(it, &tuple);
+		if (rc != 0 || tuple == NULL)
+			break;
+		if (offset > 0) {
+			offset--;
+			continue;
+		}
+		rc = tuple_to_obuf(tuple, out);
+		ERROR_INJECT(ERRINJ_PORT_DUMP, {
+			diag_set(OutOfMemory, tuple_size(tuple), "obuf_dup",
+				 "data");
+			rc = -1;
+		});
+		if (rc != 0)
+			break;
+		found++;
+	}
+	iterator_delete(it);
+
+	if (rc != 0) {
+		txn_rollback_stmt(txn);
+		return -1;
+	}
+	txn_commit_ro_stmt(txn, &svp);
+	*count = found;
+	return 0;
+}
+
 API_EXPORT int
 box_insert(uint32_t space_id, const char *tuple, const char *tuple_end,
 	   box_tuple_t **result)
@@ -3198,7 +3389,11 @@ engine_init()
 				    cfg_gets("memtx_allocator"),
 				    cfg_getd("slab_alloc_factor"));
 	engine_register((struct engine *)memtx);
+	memtx_engine_set_arena_policy(memtx, cfg_geti("memtx_use_hugepages"),
+				      cfg_geti("memtx_numa_node"));
 	box_set_memtx_max_tuple_size();
+	if (box_set_memtx_defrag() != 0)
+		diag_raise();
 
 	struct sysview_engine *sysview = sysview_engine_new_xc();
 	engine_register((struct engine *)sysview);
@@ -3216,9 +3411,14 @@ engine_init()
 				    cfg_geti("vinyl_write_threads"),
 				    cfg_geti("force_recovery"));
 	engine_register((struct engine *)vinyl);
+	vinyl_engine_set_direct_io(vinyl, cfg_geti("vinyl_direct_io"));
 	box_set_vinyl_max_tuple_size();
 	box_set_vinyl_cache();
 	box_set_vinyl_timeout();
+	if (box_set_vinyl_max_subcompactions() != 0)
+		diag_raise();
+	if (box_set_vinyl_readahead_pages() != 0)
+		diag_raise();
 }
 
 /**
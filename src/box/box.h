@@ -260,10 +260,13 @@ int box_set_wal_queue_max_size(void);
 int box_set_wal_cleanup_delay(void);
 void box_set_memtx_memory(void);
 void box_set_memtx_max_tuple_size(void);
+int box_set_memtx_defrag(void);
 void box_set_vinyl_memory(void);
 void box_set_vinyl_max_tuple_size(void);
 void box_set_vinyl_cache(void);
 void box_set_vinyl_timeout(void);
+int box_set_vinyl_max_subcompactions(void);
+int box_set_vinyl_readahead_pages(void);
 int box_set_election_mode(void);
 int box_set_election_timeout(void);
 void box_set_replication_timeout(void);
@@ -277,6 +280,7 @@ void box_set_replication_sync_timeout(void);
 void box_set_replication_skip_conflict(void);
 void box_set_replication_anon(void);
 void box_set_net_msg_max(void);
+int box_set_iproto_io_collect_interval(void);
 int box_set_crash(void);
 int box_set_txn_timeout(void);
 
@@ -307,6 +311,20 @@ box_select(uint32_t space_id, uint32_t index_id,
 	   const char *key, const char *key_end,
 	   struct port *port);
 
+/**
+ * Same as box_select(), but write the MsgPack of the found tuples
+ * right to @a out instead of collecting references to them in
+ * a port. The space must belong to the memtx engine, because the
+ * tuples are copied while the space is iterated. The number of
+ * the written tuples is returned in @a count. On error, the output
+ * may contain some of the tuples and must be rolled back.
+ */
+int
+box_select_to_obuf(uint32_t space_id, uint32_t index_id,
+		   int iterator, uint32_t offset, uint32_t limit,
+		   const char *key, const char *key_end,
+		   struct obuf *out, uint32_t *count);
+
 /** \cond public */
 
 /*
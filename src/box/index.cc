@@ -29,6 +29,7 @@
  * SUCH DAMAGE.
  */
 #include "index.h"
+#include <math.h>
 #include "tuple.h"
 #include "say.h"
 #include "schema.h"
@@ -72,11 +73,12 @@ key_validate(const struct index_def *index_def, enum iterator_type type,
 	if (part_count == 0) {
 		/*
 		 * Zero key parts are allowed:
-		 * - for TREE index, all iterator types,
+		 * - for TREE and ART indexes, all iterator types,
 		 * - ITER_ALL iterator type, all index types
 		 * - ITER_GT iterator in HASH index (legacy)
 		 */
-		if (index_def->type == TREE || type == ITER_ALL ||
+		if (index_def->type == TREE || index_def->type == ART ||
+		    type == ITER_ALL ||
 		    (index_def->type == HASH && type == ITER_GT))
 			return 0;
 		/* Fall through. */
@@ -119,8 +121,9 @@ key_validate(const struct index_def *index_def, enum iterator_type type,
 			return -1;
 		}
 
-		/* Partial keys are allowed only for TREE index type. */
-		if (index_def->type != TREE && part_count < index_def->key_def->part_count) {
+		/* Partial keys are allowed only for TREE and ART index types. */
+		if (index_def->type != TREE && index_def->type != ART &&
+		    part_count < index_def->key_def->part_count) {
 			diag_set(ClientError, ER_PARTIAL_KEY,
 				 index_type_strs[index_def->type],
 				 index_def->key_def->part_count,
@@ -265,7 +268,7 @@ box_index_min(uint32_t space_id, uint32_t index_id, const char *key,
 	struct index *index;
 	if (check_index(space_id, index_id, &space, &index) != 0)
 		return -1;
-	if (index->def->type != TREE) {
+	if (index->def->type != TREE && index->def->type != ART) {
 		/* Show nice error messages in Lua. */
 		diag_set(UnsupportedIndexFeature, index->def, "min()");
 		return -1;
@@ -298,7 +301,7 @@ box_index_max(uint32_t space_id, uint32_t index_id, const char *key,
 	struct index *index;
 	if (check_index(space_id, index_id, &space, &index) != 0)
 		return -1;
-	if (index->def->type != TREE) {
+	if (index->def->type != TREE && index->def->type != ART) {
 		/* Show nice error messages in Lua. */
 		diag_set(UnsupportedIndexFeature, index->def, "max()");
 		return -1;
@@ -437,6 +440,165 @@ box_index_compact(uint32_t space_id, uint32_t index_id)
 	return 0;
 }
 
+/** Decode a number from MsgPack as a double, possibly losing precision. */
+static double
+index_aggregate_decode_double(const char *data)
+{
+	switch (mp_typeof(*data)) {
+	case MP_UINT:
+		return mp_decode_uint(&data);
+	case MP_INT:
+		return mp_decode_int(&data);
+	case MP_FLOAT:
+		return mp_decode_float(&data);
+	case MP_DOUBLE:
+		return mp_decode_double(&data);
+	default:
+		unreachable();
+	}
+	return 0;
+}
+
+/**
+ * Compare two numbers encoded in MsgPack. An integer is compared with
+ * a floating point number after conversion to double.
+ */
+static int
+index_aggregate_cmp(const char *a, const char *b)
+{
+	enum mp_type a_type = mp_typeof(*a);
+	enum mp_type b_type = mp_typeof(*b);
+	if (a_type == MP_UINT && b_type == MP_UINT) {
+		uint64_t a_val = mp_decode_uint(&a);
+		uint64_t b_val = mp_decode_uint(&b);
+		return a_val < b_val ? -1 : a_val > b_val;
+	}
+	if (a_type == MP_INT && b_type == MP_INT) {
+		int64_t a_val = mp_decode_int(&a);
+		int64_t b_val = mp_decode_int(&b);
+		return a_val < b_val ? -1 : a_val > b_val;
+	}
+	/* MP_INT may also hold a non-negative value. */
+	if (a_type == MP_INT && b_type == MP_UINT) {
+		int64_t a_val = mp_decode_int(&a);
+		uint64_t b_val = mp_decode_uint(&b);
+		if (a_val < 0)
+			return -1;
+		return (uint64_t)a_val < b_val ? -1 : (uint64_t)a_val > b_val;
+	}
+	if (a_type == MP_UINT && b_type == MP_INT)
+		return -index_aggregate_cmp(b, a);
+	double a_val = index_aggregate_decode_double(a);
+	double b_val = index_aggregate_decode_double(b);
+	return a_val < b_val ? -1 : a_val > b_val;
+}
+
+/** Account a tuple field in aggregates. */
+static int
+index_aggregate_add(struct index_aggregate *agg, const char *field,
+		    uint32_t fieldno)
+{
+	const char *data = field;
+	struct int96_num num;
+	switch (mp_typeof(*field)) {
+	case MP_NIL:
+		return 0;
+	case MP_UINT:
+		int96_set_unsigned(&num, mp_decode_uint(&data));
+		int96_add(&agg->int_sum, &num);
+		break;
+	case MP_INT:
+		int96_set_signed(&num, mp_decode_int(&data));
+		int96_add(&agg->int_sum, &num);
+		break;
+	case MP_FLOAT:
+		agg->has_double = true;
+		agg->double_sum += mp_decode_float(&data);
+		break;
+	case MP_DOUBLE:
+		agg->has_double = true;
+		agg->double_sum += mp_decode_double(&data);
+		break;
+	default:
+		diag_set(ClientError, ER_FIELD_TYPE,
+			 int2str(fieldno + TUPLE_INDEX_BASE),
+			 field_type_strs[FIELD_TYPE_NUMBER],
+			 mp_type_strs[mp_typeof(*field)]);
+		return -1;
+	}
+	size_t size = data - field;
+	assert(size <= sizeof(agg->min));
+	if (agg->count == 0 || index_aggregate_cmp(field, agg->min) < 0)
+		memcpy(agg->min, field, size);
+	if (agg->count == 0 || index_aggregate_cmp(field, agg->max) > 0)
+		memcpy(agg->max, field, size);
+	agg->count++;
+	return 0;
+}
+
+int
+box_index_aggregate(uint32_t space_id, uint32_t index_id, int type,
+		    const char *key, const char *key_end, uint32_t fieldno,
+		    struct index_aggregate *result)
+{
+	assert(key != NULL && key_end != NULL && result != NULL);
+	mp_tuple_assert(key, key_end);
+	if (type < 0 || type >= iterator_type_MAX) {
+		diag_set(ClientError, ER_ILLEGAL_PARAMS,
+			 "Invalid iterator type");
+		return -1;
+	}
+	enum iterator_type itype = (enum iterator_type) type;
+	struct space *space;
+	struct index *index;
+	if (check_index(space_id, index_id, &space, &index) != 0)
+		return -1;
+	uint32_t part_count = mp_decode_array(&key);
+	if (key_validate(index->def, itype, key, part_count))
+		return -1;
+	memset(result, 0, sizeof(*result));
+	/* Start transaction in the engine. */
+	struct txn *txn;
+	struct txn_ro_savepoint svp;
+	if (txn_begin_ro_stmt(space, &txn, &svp) != 0)
+		return -1;
+	struct iterator *it = index_create_iterator(index, itype,
+						    key, part_count);
+	if (it == NULL)
+		goto fail;
+	struct tuple *tuple;
+	while (true) {
+		if (iterator_next(it, &tuple) != 0)
+			goto fail_free;
+		if (tuple == NULL)
+			break;
+		/*
+		 * The tuple is only valid until the next iteration so
+		 * the field is accounted right away.
+		 */
+		const char *field = tuple_field(tuple, fieldno);
+		if (field != NULL &&
+		    index_aggregate_add(result, field, fieldno) != 0)
+			goto fail_free;
+	}
+	iterator_delete(it);
+	txn_commit_ro_stmt(txn, &svp);
+	return 0;
+fail_free:
+	iterator_delete(it);
+fail:
+	txn_rollback_stmt(txn);
+	return -1;
+}
+
+double
+index_aggregate_sum_double(const struct index_aggregate *agg)
+{
+	double sum = ldexp((int64_t)agg->int_sum.high64, 32) +
+		     agg->int_sum.low32;
+	return sum + agg->double_sum;
+}
+
 /* }}} */
 
 /* {{{ Internal API */
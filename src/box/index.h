@@ -34,6 +34,7 @@
 #include "trivia/util.h"
 #include "iterator_type.h"
 #include "index_def.h"
+#include "bit/int96.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -236,6 +237,49 @@ box_index_stat(uint32_t space_id, uint32_t index_id,
 int
 box_index_compact(uint32_t space_id, uint32_t index_id);
 
+/** Aggregates of a numeric field computed by box_index_aggregate(). */
+struct index_aggregate {
+	/** Number of tuples where the field is set and isn't null. */
+	uint64_t count;
+	/** Set if any of the aggregated values is a floating point number. */
+	bool has_double;
+	/** Sum of integer values. */
+	struct int96_num int_sum;
+	/** Sum of floating point values. */
+	double double_sum;
+	/** MsgPack of the minimal value, valid if count > 0. */
+	char min[16];
+	/** MsgPack of the maximal value, valid if count > 0. */
+	char max[16];
+};
+
+/**
+ * Compute the number of values, the sum, the minimum and the maximum
+ * of a numeric field over tuples selected from an index by a key
+ * (index:aggregate()). Tuples are scanned in a single pass without
+ * creating any Lua objects. Tuples where the field is missing or null
+ * are skipped. Values other than integers and floating point numbers
+ * aren't allowed.
+ *
+ * \param space_id space identifier
+ * \param index_id index identifier
+ * \param type iterator type - enum \link iterator_type \endlink
+ * \param key encoded key in MsgPack Array format ([part1, part2, ...]).
+ * \param key_end the end of encoded \a key.
+ * \param fieldno zero-based number of the aggregated field
+ * \param[out] result aggregates
+ * \retval -1 on error (check box_error_last())
+ * \retval 0 on success
+ */
+int
+box_index_aggregate(uint32_t space_id, uint32_t index_id, int type,
+		    const char *key, const char *key_end, uint32_t fieldno,
+		    struct index_aggregate *result);
+
+/** Return the sum of aggregated values as a double. */
+double
+index_aggregate_sum_double(const struct index_aggregate *agg);
+
 struct iterator {
         /**
          * Same as next(), but returns a tuple as it is stored in the index,
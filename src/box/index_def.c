@@ -35,7 +35,7 @@
 #include "json/json.h"
 #include "fiber.h"
 
-const char *index_type_strs[] = { "HASH", "TREE", "BITSET", "RTREE" };
+const char *index_type_strs[] = { "HASH", "TREE", "BITSET", "RTREE", "ART" };
 
 const char *rtree_index_distance_type_strs[] = { "EUCLID", "MANHATTAN" };
 
@@ -48,10 +48,15 @@ const struct index_opts index_opts_default = {
 	/* .run_count_per_level = */ 2,
 	/* .run_size_ratio      = */ 3.5,
 	/* .bloom_fpr           = */ 0.05,
+	/* .ttl                 = */ 0,
 	/* .lsn                 = */ 0,
 	/* .stat                = */ NULL,
 	/* .func                = */ 0,
 	/* .hint                = */ true,
+	/* .normalized_keys     = */ false,
+	/* .compact_pointers    = */ false,
+	/* .block_size          = */ 512,
+	/* .inline_prefix       = */ false,
 };
 
 const struct opt_def index_opts_reg[] = {
@@ -64,10 +69,17 @@ const struct opt_def index_opts_reg[] = {
 	OPT_DEF("run_count_per_level", OPT_INT64, struct index_opts, run_count_per_level),
 	OPT_DEF("run_size_ratio", OPT_FLOAT, struct index_opts, run_size_ratio),
 	OPT_DEF("bloom_fpr", OPT_FLOAT, struct index_opts, bloom_fpr),
+	OPT_DEF("ttl", OPT_FLOAT, struct index_opts, ttl),
 	OPT_DEF("lsn", OPT_INT64, struct index_opts, lsn),
 	OPT_DEF("func", OPT_UINT32, struct index_opts, func_id),
 	OPT_DEF_LEGACY("sql"),
 	OPT_DEF("hint", OPT_BOOL, struct index_opts, hint),
+	OPT_DEF("normalized_keys", OPT_BOOL, struct index_opts,
+		normalized_keys),
+	OPT_DEF("compact_pointers", OPT_BOOL, struct index_opts,
+		compact_pointers),
+	OPT_DEF("block_size", OPT_UINT32, struct index_opts, block_size),
+	OPT_DEF("inline_prefix", OPT_BOOL, struct index_opts, inline_prefix),
 	OPT_END,
 };
 
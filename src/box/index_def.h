@@ -44,6 +44,7 @@ enum index_type {
 	TREE,     /* TREE Index */
 	BITSET,   /* BITSET Index */
 	RTREE,    /* R-Tree Index */
+	ART,      /* Adaptive Radix Tree Index */
 	index_type_MAX,
 };
 
@@ -153,6 +154,13 @@ struct index_opts {
 	double run_size_ratio;
 	/* Bloom filter false positive rate. */
 	double bloom_fpr;
+	/**
+	 * Time to live of tuples stored in a vinyl space, in seconds.
+	 * The first part of the primary key is supposed to store the
+	 * Unix time of a tuple. Tuples older than this are dropped on
+	 * major compaction. Zero means that tuples never expire.
+	 */
+	double ttl;
 	/**
 	 * LSN from the time of index creation.
 	 */
@@ -169,6 +177,28 @@ struct index_opts {
 	 * Use hint optimization for tree index.
 	 */
 	bool hint;
+	/**
+	 * Store a memcmp-comparable normalized key for each tuple
+	 * in a memtx tree index, see normalized_key.h.
+	 */
+	bool normalized_keys;
+	/**
+	 * Store 32-bit tuple offsets in the memtx arena instead of
+	 * tuple pointers in a memtx tree index, see memtx_tuple_offset().
+	 */
+	bool compact_pointers;
+	/**
+	 * Size of a memtx tree index block, in bytes. A bigger block
+	 * makes the tree shallower at the cost of more comparisons
+	 * and a longer memmove per insertion.
+	 */
+	uint32_t block_size;
+	/**
+	 * Inline a prefix of the normalized key into each memtx tree
+	 * index entry so that most comparisons don't dereference the
+	 * normalized key.
+	 */
+	bool inline_prefix;
 };
 
 extern const struct index_opts index_opts_default;
@@ -213,10 +243,20 @@ index_opts_cmp(const struct index_opts *o1, const struct index_opts *o2)
 		return o1->run_size_ratio < o2->run_size_ratio ? -1 : 1;
 	if (o1->bloom_fpr != o2->bloom_fpr)
 		return o1->bloom_fpr < o2->bloom_fpr ? -1 : 1;
+	if (o1->ttl != o2->ttl)
+		return o1->ttl < o2->ttl ? -1 : 1;
 	if (o1->func_id != o2->func_id)
 		return o1->func_id - o2->func_id;
 	if (o1->hint != o2->hint)
 		return o1->hint - o2->hint;
+	if (o1->normalized_keys != o2->normalized_keys)
+		return o1->normalized_keys - o2->normalized_keys;
+	if (o1->compact_pointers != o2->compact_pointers)
+		return o1->compact_pointers - o2->compact_pointers;
+	if (o1->block_size != o2->block_size)
+		return o1->block_size < o2->block_size ? -1 : 1;
+	if (o1->inline_prefix != o2->inline_prefix)
+		return o1->inline_prefix - o2->inline_prefix;
 	return 0;
 }
 
@@ -33,6 +33,8 @@
 
 #include <stddef.h>
 
+#include "latency.h"
+
 struct uri_set;
 
 #if defined(__cplusplus)
@@ -71,6 +73,8 @@ struct iproto_stats {
 	size_t requests_in_progress;
 	/** Count of requests currently pending in stream queue. */
 	size_t requests_in_stream_queue;
+	/** Size of memory allocated for connection input buffers. */
+	size_t input_buffers;
 };
 
 extern unsigned iproto_readahead;
@@ -119,6 +123,31 @@ iproto_rmean_foreach(void *cb, void *cb_ctx);
 int
 iproto_thread_rmean_foreach(int thread_id, void *cb, void *cb_ctx);
 
+/** Phases of request processing latency is collected for. */
+enum iproto_latency_phase {
+	/** From reading a request till the tx thread accepts it. */
+	IPROTO_LATENCY_WAIT,
+	/** Execution in the tx thread, including WAL write. */
+	IPROTO_LATENCY_EXECUTE,
+	/**
+	 * From reading a request till its reply gets back to the
+	 * iproto thread. Collected by the iproto thread, so must
+	 * be the last one.
+	 */
+	IPROTO_LATENCY_TOTAL,
+	iproto_latency_phase_MAX,
+};
+
+extern const char *iproto_latency_phase_strs[];
+
+/**
+ * Add latency of requests collected by all iproto threads to
+ * @a latency, indexed by request type (see iproto_type_strs)
+ * and phase. The array must have IPROTO_TYPE_STAT_MAX rows.
+ */
+void
+iproto_latency_get(struct latency (*latency)[iproto_latency_phase_MAX]);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 
@@ -131,6 +160,15 @@ iproto_listen(const struct uri_set *uri_set);
 void
 iproto_set_msg_max(int iproto_msg_max);
 
+/**
+ * Set io_collect_interval of iproto thread event loops. While
+ * an iproto thread sleeps, events of many connections pile up
+ * so that they are handled in one loop iteration, with fewer
+ * epoll_wait() calls and bigger batches sent to tx.
+ */
+void
+iproto_set_io_collect_interval(double interval);
+
 void
 iproto_free(void);
 
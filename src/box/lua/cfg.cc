@@ -210,6 +210,14 @@ lbox_cfg_set_memtx_max_tuple_size(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_memtx_defrag(struct lua_State *L)
+{
+	if (box_set_memtx_defrag() != 0)
+		luaT_error(L);
+	return 0;
+}
+
 static int
 lbox_cfg_set_vinyl_memory(struct lua_State *L)
 {
@@ -254,6 +262,22 @@ lbox_cfg_set_vinyl_timeout(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_vinyl_max_subcompactions(struct lua_State *L)
+{
+	if (box_set_vinyl_max_subcompactions() != 0)
+		luaT_error(L);
+	return 0;
+}
+
+static int
+lbox_cfg_set_vinyl_readahead_pages(struct lua_State *L)
+{
+	if (box_set_vinyl_readahead_pages() != 0)
+		luaT_error(L);
+	return 0;
+}
+
 static int
 lbox_cfg_set_net_msg_max(struct lua_State *L)
 {
@@ -396,6 +420,14 @@ lbox_cfg_set_crash(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_iproto_io_collect_interval(struct lua_State *L)
+{
+	if (box_set_iproto_io_collect_interval() != 0)
+		luaT_error(L);
+	return 0;
+}
+
 static int
 lbox_cfg_set_txn_timeout(struct lua_State *L)
 {
@@ -425,10 +457,13 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_read_only", lbox_cfg_set_read_only},
 		{"cfg_set_memtx_memory", lbox_cfg_set_memtx_memory},
 		{"cfg_set_memtx_max_tuple_size", lbox_cfg_set_memtx_max_tuple_size},
+		{"cfg_set_memtx_defrag", lbox_cfg_set_memtx_defrag},
 		{"cfg_set_vinyl_memory", lbox_cfg_set_vinyl_memory},
 		{"cfg_set_vinyl_max_tuple_size", lbox_cfg_set_vinyl_max_tuple_size},
 		{"cfg_set_vinyl_cache", lbox_cfg_set_vinyl_cache},
 		{"cfg_set_vinyl_timeout", lbox_cfg_set_vinyl_timeout},
+		{"cfg_set_vinyl_max_subcompactions", lbox_cfg_set_vinyl_max_subcompactions},
+		{"cfg_set_vinyl_readahead_pages", lbox_cfg_set_vinyl_readahead_pages},
 		{"cfg_set_election_mode", lbox_cfg_set_election_mode},
 		{"cfg_set_election_timeout", lbox_cfg_set_election_timeout},
 		{"cfg_set_replication_timeout", lbox_cfg_set_replication_timeout},
@@ -441,6 +476,8 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_replication_skip_conflict", lbox_cfg_set_replication_skip_conflict},
 		{"cfg_set_replication_anon", lbox_cfg_set_replication_anon},
 		{"cfg_set_net_msg_max", lbox_cfg_set_net_msg_max},
+		{"cfg_set_iproto_io_collect_interval",
+		 lbox_cfg_set_iproto_io_collect_interval},
 		{"cfg_set_sql_cache_size", lbox_set_prepared_stmt_cache_size},
 		{"cfg_set_crash", lbox_cfg_set_crash},
 		{"cfg_set_txn_timeout", lbox_cfg_set_txn_timeout},
@@ -226,6 +226,71 @@ lbox_index_count(lua_State *L)
 	return 1;
 }
 
+/** Push a number encoded in MsgPack to the Lua stack. */
+static void
+lbox_push_mp_number(lua_State *L, const char *data)
+{
+	switch (mp_typeof(*data)) {
+	case MP_UINT:
+		luaL_pushuint64(L, mp_decode_uint(&data));
+		break;
+	case MP_INT:
+		luaL_pushint64(L, mp_decode_int(&data));
+		break;
+	case MP_FLOAT:
+		lua_pushnumber(L, mp_decode_float(&data));
+		break;
+	case MP_DOUBLE:
+		lua_pushnumber(L, mp_decode_double(&data));
+		break;
+	default:
+		unreachable();
+	}
+}
+
+static int
+lbox_index_aggregate(lua_State *L)
+{
+	if (lua_gettop(L) != 5 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
+	    !lua_isnumber(L, 3) || !lua_isnumber(L, 5)) {
+		return luaL_error(L, "usage index.aggregate(space_id, index_id, "
+		       "iterator, key, fieldno)");
+	}
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	uint32_t index_id = lua_tonumber(L, 2);
+	uint32_t iterator = lua_tonumber(L, 3);
+	size_t key_len;
+	const char *key = lbox_encode_tuple_on_gc(L, 4, &key_len);
+	uint32_t fieldno = lua_tonumber(L, 5);
+
+	struct index_aggregate agg;
+	if (box_index_aggregate(space_id, index_id, iterator, key,
+				key + key_len, fieldno, &agg) != 0)
+		return luaT_error(L);
+	lua_createtable(L, 0, 4);
+	luaL_pushuint64(L, agg.count);
+	lua_setfield(L, -2, "count");
+	if (agg.count == 0)
+		return 1;
+	if (agg.has_double) {
+		lua_pushnumber(L, index_aggregate_sum_double(&agg));
+	} else if (int96_is_uint64(&agg.int_sum)) {
+		luaL_pushuint64(L, int96_extract_uint64(&agg.int_sum));
+	} else if (int96_is_neg_int64(&agg.int_sum)) {
+		luaL_pushint64(L, int96_extract_neg_int64(&agg.int_sum));
+	} else {
+		/* The sum doesn't fit in a 64-bit integer. */
+		lua_pushnumber(L, index_aggregate_sum_double(&agg));
+	}
+	lua_setfield(L, -2, "sum");
+	lbox_push_mp_number(L, agg.min);
+	lua_setfield(L, -2, "min");
+	lbox_push_mp_number(L, agg.max);
+	lua_setfield(L, -2, "max");
+	return 1;
+}
+
 static void
 box_index_init_iterator_types(struct lua_State *L, int idx)
 {
@@ -360,6 +425,7 @@ box_lua_index_init(struct lua_State *L)
 		{"min", lbox_index_min},
 		{"max", lbox_index_max},
 		{"count", lbox_index_count},
+		{"aggregate", lbox_index_aggregate},
 		{"iterator", lbox_index_iterator},
 		{"iterator_next", lbox_iterator_next},
 		{"truncate", lbox_truncate},
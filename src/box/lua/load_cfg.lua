@@ -45,7 +45,12 @@ local default_cfg = {
     slab_alloc_granularity = 8,
     slab_alloc_factor   = 1.05,
     iproto_threads      = 1,
+    iproto_io_collect_interval = 0,
     memtx_allocator     = "small",
+    memtx_use_hugepages = false,
+    memtx_numa_node     = -1,
+    memtx_defrag_threshold = 0,
+    memtx_defrag_rate   = 10000,
     work_dir            = nil,
     memtx_dir           = ".",
     wal_dir             = ".",
@@ -62,6 +67,9 @@ local default_cfg = {
     vinyl_range_size          = nil, -- set automatically
     vinyl_page_size           = 8 * 1024,
     vinyl_bloom_fpr           = 0.05,
+    vinyl_max_subcompactions  = 1,
+    vinyl_readahead_pages     = 0,
+    vinyl_direct_io           = false,
 
     -- logging options are covered by
     -- a separate log module; they are
@@ -156,7 +164,12 @@ local template_cfg = {
     slab_alloc_granularity = 'number',
     slab_alloc_factor   = 'number',
     iproto_threads      = 'number',
+    iproto_io_collect_interval = 'number',
     memtx_allocator     = 'string',
+    memtx_use_hugepages = 'boolean',
+    memtx_numa_node     = 'number',
+    memtx_defrag_threshold = 'number',
+    memtx_defrag_rate   = 'number',
     work_dir            = 'string',
     memtx_dir            = 'string',
     wal_dir             = 'string',
@@ -172,6 +185,9 @@ local template_cfg = {
     vinyl_range_size          = 'number',
     vinyl_page_size           = 'number',
     vinyl_bloom_fpr           = 'number',
+    vinyl_max_subcompactions  = 'number',
+    vinyl_readahead_pages     = 'number',
+    vinyl_direct_io           = 'boolean',
 
     log                 = 'module',
     log_nonblock        = 'module',
@@ -297,10 +313,14 @@ local dynamic_cfg = {
     read_only               = private.cfg_set_read_only,
     memtx_memory            = private.cfg_set_memtx_memory,
     memtx_max_tuple_size    = private.cfg_set_memtx_max_tuple_size,
+    memtx_defrag_threshold  = private.cfg_set_memtx_defrag,
+    memtx_defrag_rate       = private.cfg_set_memtx_defrag,
     vinyl_memory            = private.cfg_set_vinyl_memory,
     vinyl_max_tuple_size    = private.cfg_set_vinyl_max_tuple_size,
     vinyl_cache             = private.cfg_set_vinyl_cache,
     vinyl_timeout           = private.cfg_set_vinyl_timeout,
+    vinyl_max_subcompactions = private.cfg_set_vinyl_max_subcompactions,
+    vinyl_readahead_pages   = private.cfg_set_vinyl_readahead_pages,
     checkpoint_count        = private.cfg_set_checkpoint_count,
     checkpoint_interval     = private.cfg_set_checkpoint_interval,
     checkpoint_wal_threshold = private.cfg_set_checkpoint_wal_threshold,
@@ -331,6 +351,7 @@ local dynamic_cfg = {
     instance_uuid           = check_instance_uuid,
     replicaset_uuid         = check_replicaset_uuid,
     net_msg_max             = private.cfg_set_net_msg_max,
+    iproto_io_collect_interval = private.cfg_set_iproto_io_collect_interval,
     sql_cache_size          = private.cfg_set_sql_cache_size,
     txn_timeout             = private.cfg_set_txn_timeout,
 }
@@ -406,10 +427,14 @@ local dynamic_cfg_skip_at_load = {
     listen                  = true,
     memtx_memory            = true,
     memtx_max_tuple_size    = true,
+    memtx_defrag_threshold  = true,
+    memtx_defrag_rate       = true,
     vinyl_memory            = true,
     vinyl_max_tuple_size    = true,
     vinyl_cache             = true,
     vinyl_timeout           = true,
+    vinyl_max_subcompactions = true,
+    vinyl_readahead_pages   = true,
     too_long_threshold      = true,
     election_mode           = true,
     election_timeout        = true,
@@ -3,6 +3,7 @@
 local ffi = require('ffi')
 local msgpack = require('msgpack')
 local fun = require('fun')
+local fiber = require('fiber')
 local log = require('log')
 local buffer = require('buffer')
 local session = box.session
@@ -443,6 +444,8 @@ box.schema.space.create = function(name, options)
         is_local = 'boolean',
         temporary = 'boolean',
         is_sync = 'boolean',
+        iproto_read = 'boolean',
+        fixed_layout = 'boolean',
     }
     local options_defaults = {
         engine = 'memtx',
@@ -487,7 +490,9 @@ box.schema.space.create = function(name, options)
     local space_options = setmap({
         group_id = options.is_local and 1 or nil,
         temporary = options.temporary and true or nil,
-        is_sync = options.is_sync
+        is_sync = options.is_sync,
+        iproto_read = options.iproto_read,
+        fixed_layout = options.fixed_layout,
     })
     _space:insert{id, uid, name, options.engine, options.field_count,
         space_options, format}
@@ -580,6 +585,8 @@ local alter_space_template = {
     format = 'table',
     temporary = 'boolean',
     is_sync = 'boolean',
+    iproto_read = 'boolean',
+    fixed_layout = 'boolean',
     name = 'string',
 }
 
@@ -616,6 +623,14 @@ box.schema.space.alter = function(space_id, options)
         flags.is_sync = options.is_sync
     end
 
+    if options.iproto_read ~= nil then
+        flags.iproto_read = options.iproto_read
+    end
+
+    if options.fixed_layout ~= nil then
+        flags.fixed_layout = options.fixed_layout
+    end
+
     local format
     if options.format ~= nil then
         format = update_format(options.format)
@@ -1085,8 +1100,13 @@ local index_options = {
     range_size = 'number',
     page_size = 'number',
     bloom_fpr = 'number',
+    ttl = 'number',
     func = 'number, string',
     hint = 'boolean',
+    normalized_keys = 'boolean',
+    compact_pointers = 'boolean',
+    block_size = 'number',
+    inline_prefix = 'boolean',
 }
 
 local function jsonpaths_from_idx_parts(parts)
@@ -1194,6 +1214,10 @@ box.schema.index.create = function(space_id, name, options)
         box.error(box.error.MODIFY_INDEX, name, space.name,
                 "functional index can't use hints")
     end
+    if options.hint and options.compact_pointers then
+        box.error(box.error.MODIFY_INDEX, name, space.name,
+                "index with compact pointers can't use hints")
+    end
 
     local _index = box.space[box.schema.INDEX_ID]
     local _vindex = box.space[box.schema.VINDEX_ID]
@@ -1232,8 +1256,13 @@ box.schema.index.create = function(space_id, name, options)
             run_count_per_level = options.run_count_per_level,
             run_size_ratio = options.run_size_ratio,
             bloom_fpr = options.bloom_fpr,
+            ttl = options.ttl,
             func = options.func,
             hint = options.hint,
+            normalized_keys = options.normalized_keys,
+            compact_pointers = options.compact_pointers,
+            block_size = options.block_size,
+            inline_prefix = options.inline_prefix,
     }
     local field_type_aliases = {
         num = 'unsigned'; -- Deprecated since 1.7.2
@@ -1391,6 +1420,11 @@ box.schema.index.alter = function(space_id, index_id, options)
                                           space.name,
                 "functional index can't use hints")
     end
+    if options.hint and options.compact_pointers then
+        box.error(box.error.MODIFY_INDEX, space.index[index_id].name,
+                                          space.name,
+                "index with compact pointers can't use hints")
+    end
     if options.parts then
         local parts_can_be_simplified
         parts, parts_can_be_simplified =
@@ -1937,6 +1971,33 @@ base_index_mt.count_luac = function(index, key, opts)
     return internal.count(index.space_id, index.id, itype, key);
 end
 
+-- count, sum, min and max of a numeric field
+base_index_mt.aggregate = function(index, field, key, opts)
+    check_index_arg(index, 'aggregate')
+    local fieldno
+    if type(field) == 'number' and field >= 1 then
+        fieldno = field - 1
+    elseif type(field) == 'string' then
+        local space = box.space[index.space_id]
+        for i, f in ipairs(space:format()) do
+            if f.name == field then
+                fieldno = i - 1
+                break
+            end
+        end
+        if fieldno == nil then
+            box.error(box.error.NO_SUCH_FIELD_NAME_IN_SPACE, field,
+                      space.name)
+        end
+    else
+        box.error(box.error.ILLEGAL_PARAMS,
+                  "field should be a positive number or a string")
+    end
+    key = keify(key)
+    local itype = check_iterator_type(opts, #key == 0);
+    return internal.aggregate(index.space_id, index.id, itype, key, fieldno)
+end
+
 base_index_mt.get_ffi = function(index, key)
     check_index_arg(index, 'get')
     local ibuf = cord_ibuf_take()
@@ -2068,6 +2129,14 @@ space_mt.count = function(space, key, opts)
     end
     return pk:count(key, opts)
 end
+space_mt.aggregate = function(space, field, key, opts)
+    check_space_arg(space, 'aggregate')
+    local pk = space.index[0]
+    if pk == nil then
+        return {count = 0} -- empty space without indexes
+    end
+    return pk:aggregate(field, key, opts)
+end
 space_mt.bsize = function(space)
     check_space_arg(space, 'bsize')
     local s = builtin.space_by_id(space.id)
@@ -2162,6 +2231,53 @@ space_mt.truncate = function(space)
     check_space_arg(space, 'truncate')
     return internal.truncate(space.id)
 end
+space_mt.bulk_load = function(space, tuples)
+    check_space_arg(space, 'bulk_load')
+    if type(tuples) ~= 'table' and type(tuples) ~= 'function' then
+        box.error(box.error.ILLEGAL_PARAMS,
+                  "tuples should be a table or an iterator function")
+    end
+    local loader = box.internal.space.bulk_load(space.id)
+    local ok, err = pcall(function()
+        -- Indexes can only be built from scratch if they have never
+        -- been modified, so recreate them.
+        internal.truncate(space.id)
+        if type(tuples) == 'table' then
+            for _, tuple in ipairs(tuples) do
+                loader:add(tuple)
+            end
+        else
+            for tuple in tuples do
+                loader:add(tuple)
+            end
+        end
+        loader:commit()
+    end)
+    if not ok then
+        loader:close()
+        error(err)
+    end
+    -- Loaded tuples bypass WAL, make them durable. A checkpoint that
+    -- is already running may have been started before the load, so
+    -- wait for it to complete and make another one. On any other error
+    -- remove the tuples, because they would be lost on restart while
+    -- changes depending on them would be recovered from WAL.
+    if not space.temporary then
+        while true do
+            ok, err = pcall(box.snapshot)
+            if ok then
+                break
+            end
+            if err.code ~= box.error.CHECKPOINT_IN_PROGRESS then
+                pcall(internal.truncate, space.id)
+                error(err)
+            end
+            while box.info.gc().checkpoint_is_in_progress do
+                fiber.sleep(0.01)
+            end
+        end
+    end
+end
 space_mt.format = function(space, format)
     check_space_arg(space, 'format')
     return box.schema.space.format(space.id, format)
@@ -92,6 +92,37 @@ lbox_session_type(struct lua_State *L)
 	return 1;
 }
 
+/**
+ * Return the priority of requests of the current session:
+ * "normal" or "low".
+ */
+static int
+lbox_session_priority(struct lua_State *L)
+{
+	struct session *session = current_session();
+	lua_pushstring(L, session_priority_strs[session->meta.priority]);
+	return 1;
+}
+
+/**
+ * Set the priority of requests of the current session. Takes
+ * effect for requests read from the connection after the
+ * current one is completed.
+ */
+static int
+lbox_session_set_priority(struct lua_State *L)
+{
+	if (lua_gettop(L) != 1 || lua_type(L, 1) != LUA_TSTRING)
+		luaL_error(L, "session.set_priority(priority): bad arguments");
+	enum session_priority priority =
+		STR2ENUM(session_priority, lua_tostring(L, 1));
+	if (priority == session_priority_MAX)
+		luaL_error(L, "session.set_priority(): unknown priority '%s'",
+			   lua_tostring(L, 1));
+	current_session()->meta.priority = priority;
+	return 0;
+}
+
 /**
  * Return the id of currently executed request.
  * Many requests share the same session so this is only
@@ -559,6 +590,8 @@ box_lua_session_init(struct lua_State *L)
 	static const struct luaL_Reg sessionlib[] = {
 		{"id", lbox_session_id},
 		{"type", lbox_session_type},
+		{"priority", lbox_session_priority},
+		{"set_priority", lbox_session_set_priority},
 		{"sync", lbox_session_sync},
 		{"uid", lbox_session_uid},
 		{"euid", lbox_session_euid},
@@ -231,6 +231,32 @@ lbox_slab_info(struct lua_State *L)
 	return 1;
 }
 
+static int
+lbox_slab_defrag_info(struct lua_State *L)
+{
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+
+	lua_newtable(L);
+
+	/** Set while the defragmenter walks over memtx spaces. */
+	lua_pushstring(L, "in_progress");
+	lua_pushboolean(L, memtx->defrag.in_progress);
+	lua_settable(L, -3);
+
+	/** Number of completed defragmentation passes. */
+	lua_pushstring(L, "passes");
+	luaL_pushuint64(L, memtx->defrag.passes);
+	lua_settable(L, -3);
+
+	/** Number of tuples moved to a lower address. */
+	lua_pushstring(L, "moved");
+	luaL_pushuint64(L, memtx->defrag.moved);
+	lua_settable(L, -3);
+
+	return 1;
+}
+
 static int
 lbox_runtime_info(struct lua_State *L)
 {
@@ -277,6 +303,10 @@ box_lua_slab_init(struct lua_State *L)
 	lua_pushcfunction(L, lbox_slab_stats);
 	lua_settable(L, -3);
 
+	lua_pushstring(L, "defrag_info");
+	lua_pushcfunction(L, lbox_slab_defrag_info);
+	lua_settable(L, -3);
+
 	lua_pushstring(L, "check");
 	lua_pushcfunction(L, lbox_slab_check);
 	lua_settable(L, -3);
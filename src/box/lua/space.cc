@@ -31,6 +31,7 @@
 #include "box/ck_constraint.h"
 #include "box/lua/space.h"
 #include "box/lua/tuple.h"
+#include "box/lua/misc.h" /* lbox_encode_tuple_on_gc() */
 #include "box/lua/key_def.h"
 #include "box/sql/sqlLimit.h"
 #include "lua/utils.h"
@@ -51,6 +52,7 @@ extern "C" {
 #include "box/tuple.h"
 #include "box/txn.h"
 #include "box/sequence.h"
+#include "box/memtx_bulk_load.h"
 #include "box/coll_id_cache.h"
 #include "box/replication.h" /* GROUP_LOCAL */
 #include "box/iproto_constants.h" /* iproto_type_name */
@@ -278,6 +280,16 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 	lua_pushboolean(L, space->def->opts.is_sync);
 	lua_settable(L, i);
 
+	/* space.iproto_read */
+	lua_pushstring(L, "iproto_read");
+	lua_pushboolean(L, space->def->opts.iproto_read);
+	lua_settable(L, i);
+
+	/* space.fixed_layout */
+	lua_pushstring(L, "fixed_layout");
+	lua_pushboolean(L, space->def->opts.fixed_layout);
+	lua_settable(L, i);
+
 	lua_pushstring(L, "enabled");
 	lua_pushboolean(L, space_index(space, 0) != 0);
 	lua_settable(L, i);
@@ -356,7 +368,8 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 			assert(! lua_isnil(L, -1));
 		}
 
-		if (index_def->type == HASH || index_def->type == TREE) {
+		if (index_def->type == HASH || index_def->type == TREE ||
+		    index_def->type == ART) {
 			lua_pushboolean(L, index_opts->is_unique);
 			lua_setfield(L, -2, "unique");
 		} else if (index_def->type == RTREE) {
@@ -364,12 +377,41 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 			lua_setfield(L, -2, "dimension");
 		}
 		if (space_is_memtx(space) && index_def->type == TREE) {
-			lua_pushboolean(L, index_opts->hint);
+			lua_pushboolean(L, index_opts->hint &&
+					   !index_opts->compact_pointers);
 			lua_setfield(L, -2, "hint");
 		} else {
 			lua_pushnil(L);
 			lua_setfield(L, -2, "hint");
 		}
+		if (index_opts->normalized_keys) {
+			lua_pushboolean(L, true);
+			lua_setfield(L, -2, "normalized_keys");
+		} else {
+			lua_pushnil(L);
+			lua_setfield(L, -2, "normalized_keys");
+		}
+		if (index_opts->compact_pointers) {
+			lua_pushboolean(L, true);
+			lua_setfield(L, -2, "compact_pointers");
+		} else {
+			lua_pushnil(L);
+			lua_setfield(L, -2, "compact_pointers");
+		}
+		if (index_opts->block_size != index_opts_default.block_size) {
+			lua_pushnumber(L, index_opts->block_size);
+			lua_setfield(L, -2, "block_size");
+		} else {
+			lua_pushnil(L);
+			lua_setfield(L, -2, "block_size");
+		}
+		if (index_opts->inline_prefix) {
+			lua_pushboolean(L, true);
+			lua_setfield(L, -2, "inline_prefix");
+		} else {
+			lua_pushnil(L);
+			lua_setfield(L, -2, "inline_prefix");
+		}
 
 		if (index_opts->func_id > 0) {
 			lua_pushstring(L, "func");
@@ -458,6 +500,11 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 			lua_pushnumber(L, index_opts->bloom_fpr);
 			lua_setfield(L, -2, "bloom_fpr");
 
+			if (index_opts->ttl > 0) {
+				lua_pushnumber(L, index_opts->ttl);
+				lua_setfield(L, -2, "ttl");
+			}
+
 			lua_settable(L, -3);
 		}
 		lua_setfield(L, -2, index_def->name);
@@ -627,6 +674,90 @@ usage_error:
 	return luaL_error(L, "Usage: space:frommap(map, opts)");
 }
 
+static const char lbox_bulk_load_typename[] = "box.bulk_load";
+
+static struct memtx_bulk_load **
+lbox_check_bulk_load(struct lua_State *L, int idx)
+{
+	return (struct memtx_bulk_load **)
+		luaL_checkudata(L, idx, lbox_bulk_load_typename);
+}
+
+/**
+ * Create a bulk loader for a space.
+ * Usage: box.internal.space.bulk_load(space_id)
+ */
+static int
+lbox_space_bulk_load(struct lua_State *L)
+{
+	if (lua_gettop(L) != 1 || !lua_isnumber(L, 1))
+		return luaL_error(L, "Usage: bulk_load(space_id)");
+	uint32_t space_id = lua_tointeger(L, 1);
+	struct memtx_bulk_load **load = (struct memtx_bulk_load **)
+		lua_newuserdata(L, sizeof(*load));
+	*load = NULL;
+	luaL_getmetatable(L, lbox_bulk_load_typename);
+	lua_setmetatable(L, -2);
+	*load = memtx_bulk_load_new(space_id);
+	if (*load == NULL)
+		return luaT_error(L);
+	return 1;
+}
+
+/** Usage: loader:add(tuple) */
+static int
+lbox_bulk_load_add(struct lua_State *L)
+{
+	struct memtx_bulk_load **load = lbox_check_bulk_load(L, 1);
+	if (lua_gettop(L) != 2 || *load == NULL)
+		return luaL_error(L, "Usage: loader:add(tuple)");
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	const char *data, *data_end;
+	struct tuple *tuple = luaT_istuple(L, 2);
+	if (tuple != NULL) {
+		uint32_t bsize;
+		data = tuple_data_range(tuple, &bsize);
+		data_end = data + bsize;
+	} else {
+		size_t size;
+		data = lbox_encode_tuple_on_gc(L, 2, &size);
+		data_end = data + size;
+	}
+	int rc = memtx_bulk_load_add(*load, data, data_end);
+	region_truncate(region, region_svp);
+	if (rc != 0)
+		return luaT_error(L);
+	return 0;
+}
+
+/** Usage: loader:commit() */
+static int
+lbox_bulk_load_commit(struct lua_State *L)
+{
+	struct memtx_bulk_load **load = lbox_check_bulk_load(L, 1);
+	if (*load == NULL)
+		return luaL_error(L, "Usage: loader:commit()");
+	int rc = memtx_bulk_load_commit(*load);
+	memtx_bulk_load_delete(*load);
+	*load = NULL;
+	if (rc != 0)
+		return luaT_error(L);
+	return 0;
+}
+
+/** Usage: loader:close(). Drops the loaded tuples if not committed. */
+static int
+lbox_bulk_load_close(struct lua_State *L)
+{
+	struct memtx_bulk_load **load = lbox_check_bulk_load(L, 1);
+	if (*load != NULL) {
+		memtx_bulk_load_delete(*load);
+		*load = NULL;
+	}
+	return 0;
+}
+
 void
 box_lua_space_init(struct lua_State *L)
 {
@@ -726,8 +857,18 @@ box_lua_space_init(struct lua_State *L)
 
 	static const struct luaL_Reg space_internal_lib[] = {
 		{"frommap", lbox_space_frommap},
+		{"bulk_load", lbox_space_bulk_load},
 		{NULL, NULL}
 	};
 	luaL_register(L, "box.internal.space", space_internal_lib);
 	lua_pop(L, 1);
+
+	static const struct luaL_Reg lbox_bulk_load_meta[] = {
+		{"__gc", lbox_bulk_load_close},
+		{"add", lbox_bulk_load_add},
+		{"commit", lbox_bulk_load_commit},
+		{"close", lbox_bulk_load_close},
+		{NULL, NULL}
+	};
+	luaL_register_type(L, lbox_bulk_load_typename, lbox_bulk_load_meta);
 }
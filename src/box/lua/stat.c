@@ -40,6 +40,7 @@
 
 #include "box/box.h"
 #include "box/iproto.h"
+#include "box/iproto_constants.h"
 #include "box/engine.h"
 #include "box/vinyl.h"
 #include "box/sql.h"
@@ -67,6 +68,19 @@ inject_current_stat(struct lua_State *L, const char *name, size_t val)
 	lua_pop(L, 1);
 }
 
+/**
+ * Add a metric that has only the current value, i.e. isn't backed
+ * by an rmean counter, to the table on the top of a Lua stack.
+ */
+static void
+inject_gauge_stat(struct lua_State *L, const char *name, size_t val)
+{
+	lua_newtable(L);
+	lua_pushnumber(L, val);
+	lua_setfield(L, -2, "current");
+	lua_setfield(L, -2, name);
+}
+
 static void
 inject_iproto_stats(struct lua_State *L, struct iproto_stats *stats)
 {
@@ -77,6 +91,7 @@ inject_iproto_stats(struct lua_State *L, struct iproto_stats *stats)
 			    stats->requests_in_progress);
 	inject_current_stat(L, "REQUESTS_IN_STREAM_QUEUE",
 			    stats->requests_in_stream_queue);
+	inject_gauge_stat(L, "INPUT_BUFFERS", stats->input_buffers);
 }
 
 static void
@@ -174,10 +189,17 @@ static int
 lbox_stat_net_index(struct lua_State *L)
 {
 	const char *key = luaL_checkstring(L, -1);
+	struct iproto_stats stats;
+	if (strcmp(key, "INPUT_BUFFERS") == 0) {
+		iproto_stats_get(&stats);
+		lua_newtable(L);
+		lua_pushnumber(L, stats.input_buffers);
+		lua_setfield(L, -2, "current");
+		return 1;
+	}
 	if (iproto_rmean_foreach(seek_stat_item, L) == 0)
 		return 0;
 
-	struct iproto_stats stats;
 	iproto_stats_get(&stats);
 	if (strcmp(key, "CONNECTIONS") == 0) {
 		lua_pushstring(L, "current");
@@ -214,7 +236,11 @@ lbox_stat_net_index(struct lua_State *L)
  * - STREAMS: total, rps, current;
  * - REQUESTS: total, rps, current;
  * - REQUESTS_IN_PROGRESS: total, rps, current;
- * - REQUESTS_IN_STREAM_QUEUE: total, rps, current.
+ * - REQUESTS_IN_STREAM_QUEUE: total, rps, current;
+ * - SELECTS_IN_NET: total, rps;
+ * - READAHEAD_RESIZES: total, rps;
+ * - INPUT_BUFFERS: current;
+ * - REQUESTS_LOW_PRIORITY: total, rps.
  *
  * These fields have the following meaning:
  *
@@ -222,6 +248,10 @@ lbox_stat_net_index(struct lua_State *L)
  * - rps -- amount of events per second, mean over last 5 seconds;
  * - current -- amount of resources currently hold (say, number of
  *   open connections).
+ *
+ * READAHEAD_RESIZES events are changes of connection readahead.
+ * INPUT_BUFFERS is the size of memory allocated for connection input
+ * buffers, in bytes.
  */
 static int
 lbox_stat_net_call(struct lua_State *L)
@@ -279,6 +309,80 @@ lbox_stat_sql(struct lua_State *L)
 	return 1;
 }
 
+/** Push a table with statistics of a latency counter to a Lua stack. */
+static void
+push_latency(struct lua_State *L, struct latency *latency)
+{
+	lua_newtable(L);
+	lua_pushnumber(L, latency_count(latency));
+	lua_setfield(L, -2, "count");
+	static const int pcts[] = {50, 90, 99};
+	for (size_t i = 0; i < lengthof(pcts); i++) {
+		lua_pushnumber(L, latency_get(latency, pcts[i]));
+		lua_setfield(L, -2, tt_sprintf("p%d", pcts[i]));
+	}
+	lua_newtable(L);
+	for (int i = 0; i < latency_bucket_count(latency); i++) {
+		double bound;
+		size_t count = latency_bucket_get(latency, i, &bound);
+		lua_newtable(L);
+		lua_pushnumber(L, bound);
+		lua_setfield(L, -2, "le");
+		lua_pushnumber(L, count);
+		lua_setfield(L, -2, "count");
+		lua_rawseti(L, -2, i + 1);
+	}
+	lua_setfield(L, -2, "buckets");
+}
+
+/**
+ * Push a table of latency of requests processed by iproto to
+ * a Lua stack, by request type and processing phase:
+ *
+ * - wait -- from reading a request till the tx thread accepts it;
+ * - execute -- execution in the tx thread, including WAL write;
+ * - total -- from reading a request till its reply is ready.
+ *
+ * Each phase has the number of observations (count), percentiles
+ * (p50, p90, p99) and cumulative histogram buckets ready to be
+ * exported as a Prometheus histogram: each bucket has an upper
+ * bound (le) and the number of observations not greater than it.
+ * Latency is in seconds. Types of requests that were never
+ * executed are omitted.
+ */
+static int
+lbox_stat_latency(struct lua_State *L)
+{
+	struct latency latency[IPROTO_TYPE_STAT_MAX][iproto_latency_phase_MAX];
+	struct latency *first = &latency[0][0];
+	int count = IPROTO_TYPE_STAT_MAX * iproto_latency_phase_MAX;
+	for (int i = 0; i < count; i++) {
+		if (latency_create(&first[i]) != 0) {
+			while (--i >= 0)
+				latency_destroy(&first[i]);
+			diag_set(OutOfMemory, sizeof(struct histogram *),
+				 "latency_create", "struct latency");
+			return luaT_error(L);
+		}
+	}
+	iproto_latency_get(latency);
+	lua_newtable(L);
+	for (int type = 0; type < IPROTO_TYPE_STAT_MAX; type++) {
+		if (iproto_type_strs[type] == NULL ||
+		    latency_count(&latency[type][IPROTO_LATENCY_TOTAL]) == 0)
+			continue;
+		lua_newtable(L);
+		for (int phase = 0; phase < iproto_latency_phase_MAX; phase++) {
+			push_latency(L, &latency[type][phase]);
+			lua_setfield(L, -2, iproto_latency_phase_strs[phase]);
+		}
+		lua_setfield(L, -2, iproto_type_strs[type]);
+	}
+	for (int i = 0; i < count; i++)
+		latency_destroy(&first[i]);
+	return 1;
+}
+
 static const struct luaL_Reg lbox_stat_meta [] = {
 	{"__index", lbox_stat_index},
 	{"__call",  lbox_stat_call},
@@ -305,6 +409,7 @@ box_lua_stat_init(struct lua_State *L)
 		{"vinyl", lbox_stat_vinyl},
 		{"reset", lbox_stat_reset},
 		{"sql", lbox_stat_sql},
+		{"latency", lbox_stat_latency},
 		{NULL, NULL}
 	};
 
@@ -52,6 +52,8 @@ public:
 	{
 		struct memtx_tuple *memtx_tuple = (struct memtx_tuple *) item;
 		struct tuple *tuple = &memtx_tuple->base;
+		if (tuple->has_external_offset)
+			memtx_tuple_offset_release(tuple);
 		size_t total = tuple_size(tuple) +
 			       offsetof(struct memtx_tuple, base);
 		Allocator::free((void *) memtx_tuple, total);
@@ -0,0 +1,1167 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2021, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "memtx_art.h"
+
+#include <small/mempool.h>
+#include <small/region.h>
+
+#include "fiber.h"
+#include "index.h"
+#include "memtx_engine.h"
+#include "memtx_tx.h"
+#include "normalized_key.h"
+#include "salad/art.h"
+#include "schema.h" /* space_by_id(), space_cache_find() */
+#include "space.h"
+#include "trivia/util.h"
+#include "tuple.h"
+#include "txn.h"
+
+/**
+ * An entry of an ART index: a tuple and its normalized key. The
+ * entry is allocated with memtx_alloc(), which guarantees only
+ * 4-byte alignment, hence the packed attribute.
+ */
+struct PACKED memtx_art_entry {
+	struct tuple *tuple;
+	/** Normalized key, see normalized_key.h. */
+	char key[0];
+};
+
+/** Get the key of an entry stored in the tree. */
+static const unsigned char *
+memtx_art_entry_key(const void *value, uint32_t *len)
+{
+	const struct memtx_art_entry *entry =
+		(const struct memtx_art_entry *)value;
+	*len = normalized_key_size(entry->key) - NORMALIZED_KEY_HEADER_SIZE;
+	return (const unsigned char *)entry->key + NORMALIZED_KEY_HEADER_SIZE;
+}
+
+/**
+ * Check if the key of an entry starts with a normalized key,
+ * i.e. the entry's tuple matches a possibly partial key.
+ */
+static inline bool
+memtx_art_entry_matches(const struct memtx_art_entry *entry, const char *nkey)
+{
+	return normalized_key_size(entry->key) >= normalized_key_size(nkey) &&
+	       normalized_key_compare(entry->key, nkey) == 0;
+}
+
+struct memtx_art_index {
+	struct index base;
+	struct art tree;
+	/** Allocators of tree nodes, one per node type. */
+	struct mempool node_pool[ART_NODE_TYPE_COUNT];
+	/**
+	 * Key definition used for building normalized keys, see
+	 * memtx_art_index_update_def().
+	 */
+	struct key_def *cmp_def;
+	/** Memory used by index entries. */
+	size_t entry_size;
+	/**
+	 * Entries deleted from the index while there were open
+	 * snapshot iterators, which may still read them. They are
+	 * freed when the last snapshot iterator is destroyed.
+	 */
+	struct memtx_art_entry **garbage;
+	/** Number of entries in the garbage array. */
+	size_t garbage_count;
+	/** Capacity of the garbage array. */
+	size_t garbage_capacity;
+	/** Set if the tuples must be unreferenced on destruction. */
+	bool gc_unref_tuples;
+	struct memtx_gc_task gc_task;
+};
+
+static void *
+memtx_art_index_node_alloc(void *ctx, size_t size)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)ctx;
+	for (unsigned i = 0; i < ART_NODE_TYPE_COUNT; i++) {
+		if (art_node_size(i) == size)
+			return mempool_alloc(&index->node_pool[i]);
+	}
+	unreachable();
+	return NULL;
+}
+
+static void
+memtx_art_index_node_free(void *ctx, void *ptr, size_t size)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)ctx;
+	for (unsigned i = 0; i < ART_NODE_TYPE_COUNT; i++) {
+		if (art_node_size(i) == size) {
+			mempool_free(&index->node_pool[i], ptr);
+			return;
+		}
+	}
+	unreachable();
+}
+
+/**
+ * Look up an entry with a normalized key as a tree iterator of
+ * the given type would. If @a nkey is NULL, the key is empty.
+ */
+static struct memtx_art_entry *
+memtx_art_index_seek(struct memtx_art_index *index, enum iterator_type type,
+		     const char *nkey)
+{
+	struct art *tree = &index->tree;
+	if (nkey == NULL) {
+		return (struct memtx_art_entry *)
+			(iterator_type_is_reverse(type) ?
+			 art_last(tree) : art_first(tree));
+	}
+	const unsigned char *key =
+		(const unsigned char *)nkey + NORMALIZED_KEY_HEADER_SIZE;
+	uint32_t len = normalized_key_size(nkey) - NORMALIZED_KEY_HEADER_SIZE;
+	/*
+	 * ART considers keys starting with the search key equal
+	 * to it so a partial key works as expected.
+	 */
+	switch (type) {
+	case ITER_EQ:
+	case ITER_GE:
+		return (struct memtx_art_entry *)art_succ(tree, key, len, true);
+	case ITER_GT:
+		return (struct memtx_art_entry *)art_succ(tree, key, len, false);
+	case ITER_REQ:
+	case ITER_LE:
+		return (struct memtx_art_entry *)art_pred(tree, key, len, true);
+	case ITER_LT:
+		return (struct memtx_art_entry *)art_pred(tree, key, len, false);
+	default:
+		unreachable();
+		return NULL;
+	}
+}
+
+/* {{{ MemtxArt Iterators *****************************************/
+
+struct art_iterator {
+	struct iterator base;
+	/** Iterator type, GE or LE if the key is empty. */
+	enum iterator_type type;
+	/** Search key, used for tracking reads by MVCC. */
+	const char *key;
+	uint32_t part_count;
+	/** Normalized search key, allocated on malloc. */
+	char *nkey;
+	/** Tuple at the current position. */
+	struct tuple *current;
+	/**
+	 * Copy of the normalized key at the current position. The
+	 * iterator looks up the next entry by this key on each
+	 * step so it doesn't need to be notified of index changes.
+	 */
+	char *current_key;
+	/** Size of the current_key buffer. */
+	uint32_t current_key_capacity;
+	/** Memory pool the iterator was allocated from. */
+	struct mempool *pool;
+};
+
+static_assert(sizeof(struct art_iterator) <= MEMTX_ITERATOR_SIZE,
+	      "sizeof(struct art_iterator) must be less than or equal "
+	      "to MEMTX_ITERATOR_SIZE");
+
+static void
+art_iterator_free(struct iterator *iterator);
+
+static inline struct art_iterator *
+get_art_iterator(struct iterator *it)
+{
+	assert(it->free == art_iterator_free);
+	return (struct art_iterator *)it;
+}
+
+static inline void
+art_iterator_set_current_tuple(struct art_iterator *it, struct tuple *tuple)
+{
+	if (it->current != NULL)
+		tuple_unref(it->current);
+	it->current = tuple;
+	if (tuple != NULL)
+		tuple_ref(tuple);
+}
+
+/**
+ * Remember the entry the iterator is positioned at. Returns -1 and
+ * sets diag on memory allocation error, in which case the iterator
+ * position is left unchanged.
+ */
+static inline int
+art_iterator_set_current(struct art_iterator *it,
+			 struct memtx_art_entry *entry)
+{
+	if (entry == NULL) {
+		art_iterator_set_current_tuple(it, NULL);
+		return 0;
+	}
+	uint32_t size = normalized_key_size(entry->key);
+	if (size > it->current_key_capacity) {
+		char *key = (char *)malloc(size);
+		if (key == NULL) {
+			diag_set(OutOfMemory, size, "malloc", "iterator key");
+			return -1;
+		}
+		free(it->current_key);
+		it->current_key = key;
+		it->current_key_capacity = size;
+	}
+	art_iterator_set_current_tuple(it, entry->tuple);
+	memcpy(it->current_key, entry->key, size);
+	return 0;
+}
+
+static void
+art_iterator_free(struct iterator *iterator)
+{
+	struct art_iterator *it = get_art_iterator(iterator);
+	art_iterator_set_current_tuple(it, NULL);
+	free(it->current_key);
+	free(it->nkey);
+	mempool_free(it->pool, it);
+}
+
+static int
+art_iterator_dummie(struct iterator *iterator, struct tuple **ret)
+{
+	(void)iterator;
+	*ret = NULL;
+	return 0;
+}
+
+template <bool UNCHANGED>
+static void
+art_iterator_set_dummie(struct iterator *iterator)
+{
+	iterator->next_raw = art_iterator_dummie;
+	if (UNCHANGED)
+		iterator->next = art_iterator_dummie;
+}
+
+template <bool UNCHANGED>
+static int
+art_iterator_next_raw_base(struct iterator *iterator, struct tuple **ret)
+{
+	struct memtx_art_index *index =
+		(struct memtx_art_index *)iterator->index;
+	struct art_iterator *it = get_art_iterator(iterator);
+	assert(it->current != NULL);
+	struct memtx_art_entry *entry =
+		memtx_art_index_seek(index, ITER_GT, it->current_key);
+	if (art_iterator_set_current(it, entry) != 0)
+		return -1;
+	*ret = it->current;
+	if (*ret == NULL)
+		art_iterator_set_dummie<UNCHANGED>(iterator);
+	struct space *space = space_by_id(iterator->space_id);
+
+/********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND START*********/
+	/*
+	 * Pass no key because any write to the gap between that
+	 * two tuples must lead to conflict.
+	 */
+	memtx_tx_track_gap(in_txn(), space, iterator->index, *ret, ITER_GE,
+			   NULL, 0);
+/*********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND END**********/
+
+	return 0;
+}
+
+template <bool UNCHANGED>
+static int
+art_iterator_prev_raw_base(struct iterator *iterator, struct tuple **ret)
+{
+	struct memtx_art_index *index =
+		(struct memtx_art_index *)iterator->index;
+	struct art_iterator *it = get_art_iterator(iterator);
+	assert(it->current != NULL);
+	struct memtx_art_entry *entry =
+		memtx_art_index_seek(index, ITER_LT, it->current_key);
+	struct tuple *successor = it->current;
+	tuple_ref(successor);
+	if (art_iterator_set_current(it, entry) != 0) {
+		tuple_unref(successor);
+		return -1;
+	}
+	*ret = it->current;
+	if (*ret == NULL)
+		art_iterator_set_dummie<UNCHANGED>(iterator);
+	struct space *space = space_by_id(iterator->space_id);
+
+/********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND START*********/
+	/*
+	 * Pass no key because any write to the gap between that
+	 * two tuples must lead to conflict.
+	 */
+	memtx_tx_track_gap(in_txn(), space, iterator->index, successor,
+			   ITER_LE, NULL, 0);
+/*********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND END**********/
+
+	tuple_unref(successor);
+	return 0;
+}
+
+template <bool UNCHANGED>
+static int
+art_iterator_next_equal_raw_base(struct iterator *iterator, struct tuple **ret)
+{
+	struct memtx_art_index *index =
+		(struct memtx_art_index *)iterator->index;
+	struct art_iterator *it = get_art_iterator(iterator);
+	assert(it->current != NULL);
+	struct memtx_art_entry *entry =
+		memtx_art_index_seek(index, ITER_GT, it->current_key);
+	struct space *space = space_by_id(iterator->space_id);
+	if (entry == NULL || !memtx_art_entry_matches(entry, it->nkey)) {
+		art_iterator_set_current(it, NULL);
+		art_iterator_set_dummie<UNCHANGED>(iterator);
+		*ret = NULL;
+		/*
+		 * Got end of key. Store gap from the previous tuple to the
+		 * key boundary in nearby tuple.
+		 */
+		struct tuple *nearby_tuple = entry == NULL ? NULL : entry->tuple;
+
+/********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND START*********/
+		memtx_tx_track_gap(in_txn(), space, iterator->index,
+				   nearby_tuple, ITER_EQ, it->key,
+				   it->part_count);
+/*********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND END**********/
+	} else {
+		if (art_iterator_set_current(it, entry) != 0)
+			return -1;
+		*ret = entry->tuple;
+
+/********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND START*********/
+		/*
+		 * Pass no key because any write to the gap between that
+		 * two tuples must lead to conflict.
+		 */
+		memtx_tx_track_gap(in_txn(), space, iterator->index, *ret,
+				   ITER_GE, NULL, 0);
+/*********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND END**********/
+	}
+	return 0;
+}
+
+template <bool UNCHANGED>
+static int
+art_iterator_prev_equal_raw_base(struct iterator *iterator, struct tuple **ret)
+{
+	struct memtx_art_index *index =
+		(struct memtx_art_index *)iterator->index;
+	struct art_iterator *it = get_art_iterator(iterator);
+	assert(it->current != NULL);
+	struct memtx_art_entry *entry =
+		memtx_art_index_seek(index, ITER_LT, it->current_key);
+	struct tuple *successor = it->current;
+	tuple_ref(successor);
+	struct space *space = space_by_id(iterator->space_id);
+	if (entry == NULL || !memtx_art_entry_matches(entry, it->nkey)) {
+		art_iterator_set_current(it, NULL);
+		art_iterator_set_dummie<UNCHANGED>(iterator);
+		*ret = NULL;
+
+/********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND START*********/
+		/*
+		 * Got end of key. Store gap from the key boundary to the
+		 * previous tuple in nearby tuple.
+		 */
+		memtx_tx_track_gap(in_txn(), space, iterator->index,
+				   successor, ITER_REQ, it->key,
+				   it->part_count);
+/*********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND END**********/
+	} else {
+		if (art_iterator_set_current(it, entry) != 0) {
+			tuple_unref(successor);
+			return -1;
+		}
+		*ret = entry->tuple;
+
+/********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND START*********/
+		/*
+		 * Pass no key because any write to the gap between that
+		 * two tuples must lead to conflict.
+		 */
+		memtx_tx_track_gap(in_txn(), space, iterator->index,
+				   successor, ITER_LE, NULL, 0);
+/*********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND END**********/
+	}
+	tuple_unref(successor);
+	return 0;
+}
+
+#define WRAP_ITERATOR_METHOD(name)						\
+template <bool UNCHANGED>							\
+static int									\
+name(struct iterator *iterator, struct tuple **ret)				\
+{										\
+	struct txn *txn = in_txn();						\
+	struct space *space = space_by_id(iterator->space_id);			\
+	bool is_rw = txn != NULL;						\
+	do {									\
+		int rc = name##_base<UNCHANGED>(iterator, ret);			\
+		if (rc != 0 || *ret == NULL)					\
+			return rc;						\
+		*ret = memtx_tx_tuple_clarify(txn, space, *ret,			\
+					      iterator->index, 0, is_rw);	\
+	} while (*ret == NULL);							\
+	art_iterator_set_current_tuple(get_art_iterator(iterator), *ret);	\
+	return 0;								\
+}										\
+struct forgot_to_add_semicolon
+
+WRAP_ITERATOR_METHOD(art_iterator_next_raw);
+WRAP_ITERATOR_METHOD(art_iterator_prev_raw);
+WRAP_ITERATOR_METHOD(art_iterator_next_equal_raw);
+WRAP_ITERATOR_METHOD(art_iterator_prev_equal_raw);
+
+#undef WRAP_ITERATOR_METHOD
+
+template <bool UNCHANGED>
+static void
+art_iterator_set_next_method(struct art_iterator *it)
+{
+	switch (it->type) {
+	case ITER_EQ:
+		it->base.next_raw = art_iterator_next_equal_raw<UNCHANGED>;
+		break;
+	case ITER_REQ:
+		it->base.next_raw = art_iterator_prev_equal_raw<UNCHANGED>;
+		break;
+	case ITER_LT:
+	case ITER_LE:
+		it->base.next_raw = art_iterator_prev_raw<UNCHANGED>;
+		break;
+	case ITER_GE:
+	case ITER_GT:
+		it->base.next_raw = art_iterator_next_raw<UNCHANGED>;
+		break;
+	default:
+		/* The type was checked in create_iterator. */
+		unreachable();
+	}
+	it->base.next = UNCHANGED ? it->base.next_raw : memtx_iterator_next;
+}
+
+template <bool UNCHANGED>
+static int
+art_iterator_start_raw(struct iterator *iterator, struct tuple **ret)
+{
+	*ret = NULL;
+	struct memtx_art_index *index =
+		(struct memtx_art_index *)iterator->index;
+	struct art_iterator *it = get_art_iterator(iterator);
+	art_iterator_set_dummie<UNCHANGED>(iterator);
+	enum iterator_type type = it->type;
+	struct txn *txn = in_txn();
+	struct space *space = space_by_id(iterator->space_id);
+	struct index *idx = iterator->index;
+	/*
+	 * If the key is full, EQ and REQ queries can return no more
+	 * than one tuple.
+	 */
+	bool key_is_full = it->part_count == index->cmp_def->part_count;
+	bool is_eq = type == ITER_EQ || type == ITER_REQ;
+	struct memtx_art_entry *entry = memtx_art_index_seek(index, type,
+							      it->nkey);
+	bool equals = entry != NULL &&
+		      (it->nkey == NULL ||
+		       memtx_art_entry_matches(entry, it->nkey));
+
+	if (is_eq && key_is_full && !equals) {
+		memtx_tx_track_point(txn, space, idx, it->key);
+	} else if ((!key_is_full || !is_eq) &&
+		   memtx_tx_manager_use_mvcc_engine) {
+		/*
+		 * The gap is stored in the tuple following the scanned
+		 * range. For reverse iterators it's not the found one.
+		 */
+		struct memtx_art_entry *successor = entry;
+		if (iterator_type_is_reverse(type)) {
+			successor = it->nkey == NULL ? NULL :
+				    memtx_art_index_seek(index,
+					type == ITER_LT ? ITER_GE : ITER_GT,
+					it->nkey);
+		}
+
+/********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND START*********/
+		memtx_tx_track_gap(txn, space, idx,
+				   successor == NULL ? NULL : successor->tuple,
+				   type, it->key, it->part_count);
+/*********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND END**********/
+	}
+
+	if (entry == NULL || (is_eq && !equals))
+		return 0;
+	if (art_iterator_set_current(it, entry) != 0)
+		return -1;
+	art_iterator_set_next_method<UNCHANGED>(it);
+	bool is_rw = txn != NULL;
+	*ret = memtx_tx_tuple_clarify(txn, space, entry->tuple, idx, 0, is_rw);
+	if (*ret == NULL)
+		return iterator->next_raw(iterator, ret);
+	art_iterator_set_current_tuple(it, *ret);
+	return 0;
+}
+
+/* }}} */
+
+/* {{{ MemtxArt -- implementation of all ART indexes. *************/
+
+/**
+ * Build an index entry for a tuple. Returns NULL and sets diag
+ * on error.
+ */
+static struct memtx_art_entry *
+memtx_art_index_new_entry(struct memtx_art_index *index, struct tuple *tuple)
+{
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	struct memtx_art_entry *entry = NULL;
+	const char *nkey = tuple_normalized_key(tuple, index->cmp_def, region);
+	if (nkey == NULL)
+		goto out;
+	uint32_t size;
+	size = sizeof(*entry) + normalized_key_size(nkey);
+	entry = (struct memtx_art_entry *)memtx_alloc(size);
+	if (entry == NULL) {
+		diag_set(OutOfMemory, size, "MemtxAllocator::alloc",
+			 "ART index entry");
+		goto out;
+	}
+	entry->tuple = tuple;
+	memcpy(entry->key, nkey, normalized_key_size(nkey));
+	index->entry_size += size;
+out:
+	region_truncate(region, region_svp);
+	return entry;
+}
+
+static void
+memtx_art_index_delete_entry(struct memtx_art_index *index,
+			     struct memtx_art_entry *entry)
+{
+	uint32_t size = memtx_alloc_size(entry);
+	assert(index->entry_size >= size);
+	index->entry_size -= size;
+	if (art_view_count(&index->tree) == 0) {
+		memtx_free(entry);
+		return;
+	}
+	/* See memtx_art_index_reserve_garbage(). */
+	assert(index->garbage_count < index->garbage_capacity);
+	index->garbage[index->garbage_count++] = entry;
+}
+
+/**
+ * Make sure an entry can be deleted without allocating memory
+ * while there are open snapshot iterators. Returns -1 and sets
+ * diag on memory allocation error.
+ */
+static int
+memtx_art_index_reserve_garbage(struct memtx_art_index *index)
+{
+	if (art_view_count(&index->tree) == 0 ||
+	    index->garbage_count < index->garbage_capacity)
+		return 0;
+	size_t capacity = MAX(index->garbage_capacity * 2, (size_t)64);
+	size_t size = capacity * sizeof(*index->garbage);
+	struct memtx_art_entry **garbage = (struct memtx_art_entry **)
+		realloc(index->garbage, size);
+	if (garbage == NULL) {
+		diag_set(OutOfMemory, size, "realloc", "garbage");
+		return -1;
+	}
+	index->garbage = garbage;
+	index->garbage_capacity = capacity;
+	return 0;
+}
+
+/** Free entries deleted while there were open snapshot iterators. */
+static void
+memtx_art_index_collect_garbage(struct memtx_art_index *index)
+{
+	assert(art_view_count(&index->tree) == 0);
+	for (size_t i = 0; i < index->garbage_count; i++)
+		memtx_free(index->garbage[i]);
+	free(index->garbage);
+	index->garbage = NULL;
+	index->garbage_count = 0;
+	index->garbage_capacity = 0;
+}
+
+static void
+memtx_art_index_free(struct memtx_art_index *index)
+{
+	assert(art_size(&index->tree) == 0);
+	assert(index->garbage_count == 0);
+	art_destroy(&index->tree);
+	for (unsigned i = 0; i < ART_NODE_TYPE_COUNT; i++)
+		mempool_destroy(&index->node_pool[i]);
+	free(index);
+}
+
+static void
+memtx_art_index_gc_run(struct memtx_gc_task *task, bool *done)
+{
+	/*
+	 * Yield every 1K tuples to keep latency < 0.1 ms.
+	 * Yield more often in debug mode.
+	 */
+#ifdef NDEBUG
+	enum { YIELD_LOOPS = 1000 };
+#else
+	enum { YIELD_LOOPS = 10 };
+#endif
+
+	struct memtx_art_index *index = container_of(task,
+			struct memtx_art_index, gc_task);
+	struct art *tree = &index->tree;
+
+	struct memtx_art_entry *entry;
+	unsigned int loops = 0;
+	while ((entry = (struct memtx_art_entry *)art_first(tree)) != NULL) {
+		uint32_t len;
+		const unsigned char *key = memtx_art_entry_key(entry, &len);
+		art_delete(tree, key, len);
+		if (index->gc_unref_tuples)
+			tuple_unref(entry->tuple);
+		memtx_art_index_delete_entry(index, entry);
+		if (++loops >= YIELD_LOOPS) {
+			*done = false;
+			return;
+		}
+	}
+	*done = true;
+}
+
+static void
+memtx_art_index_gc_free(struct memtx_gc_task *task)
+{
+	struct memtx_art_index *index = container_of(task,
+			struct memtx_art_index, gc_task);
+	memtx_art_index_free(index);
+}
+
+static const struct memtx_gc_task_vtab memtx_art_index_gc_vtab = {
+	.run = memtx_art_index_gc_run,
+	.free = memtx_art_index_gc_free,
+};
+
+static void
+memtx_art_index_destroy(struct index *base)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)base;
+	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
+	if (art_size(&index->tree) == 0) {
+		memtx_art_index_free(index);
+		return;
+	}
+	/*
+	 * We need to free all entries stored in the index and,
+	 * if it's the primary index, all tuples, which may take
+	 * a while. Schedule a background task in order not to
+	 * block tx thread.
+	 */
+	index->gc_unref_tuples = base->def->iid == 0;
+	index->gc_task.vtab = &memtx_art_index_gc_vtab;
+	memtx_engine_schedule_gc(memtx, &index->gc_task);
+}
+
+static void
+memtx_art_index_update_def(struct index *base)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)base;
+	struct index_def *def = base->def;
+	/*
+	 * Like in TREE index, we use extended key def for non-unique
+	 * and nullable indexes. Changes that affect normalized keys
+	 * require an index rebuild so the encoding stays the same.
+	 */
+	index->cmp_def = def->opts.is_unique && !def->key_def->is_nullable ?
+			 def->key_def : def->cmp_def;
+}
+
+static bool
+memtx_art_index_depends_on_pk(struct index *base)
+{
+	struct index_def *def = base->def;
+	/* See comment to memtx_art_index_update_def(). */
+	return !def->opts.is_unique || def->key_def->is_nullable;
+}
+
+static ssize_t
+memtx_art_index_size(struct index *base)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)base;
+	struct space *space = space_by_id(base->def->space_id);
+	/* Substract invisible count. */
+	return art_size(&index->tree) -
+	       memtx_tx_index_invisible_count(in_txn(), space, base);
+}
+
+static ssize_t
+memtx_art_index_bsize(struct index *base)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)base;
+	return art_mem_used(&index->tree) + index->entry_size;
+}
+
+static int
+memtx_art_index_random(struct index *base, uint32_t rnd, struct tuple **result)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)base;
+	struct memtx_art_entry *entry =
+		(struct memtx_art_entry *)art_random(&index->tree, rnd);
+	*result = entry != NULL ? entry->tuple : NULL;
+	return memtx_prepare_result_tuple(result);
+}
+
+static ssize_t
+memtx_art_index_count(struct index *base, enum iterator_type type,
+		      const char *key, uint32_t part_count)
+{
+	if (type == ITER_ALL)
+		return memtx_art_index_size(base); /* optimization */
+	return generic_index_count(base, type, key, part_count);
+}
+
+static int
+memtx_art_index_get_raw(struct index *base, const char *key,
+			uint32_t part_count, struct tuple **result)
+{
+	assert(base->def->opts.is_unique &&
+	       part_count == base->def->key_def->part_count);
+	struct memtx_art_index *index = (struct memtx_art_index *)base;
+	struct txn *txn = in_txn();
+	struct space *space = space_by_id(base->def->space_id);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	const char *nkey = key_normalized_key(key, part_count,
+					      index->cmp_def, region);
+	if (nkey == NULL)
+		return -1;
+	struct memtx_art_entry *entry;
+	if (index->cmp_def == base->def->key_def) {
+		uint32_t len = normalized_key_size(nkey) -
+			       NORMALIZED_KEY_HEADER_SIZE;
+		entry = (struct memtx_art_entry *)art_find(&index->tree,
+			(const unsigned char *)nkey + NORMALIZED_KEY_HEADER_SIZE,
+			len);
+	} else {
+		/*
+		 * Keys of a unique nullable index containing NULL
+		 * are extended with primary key parts.
+		 */
+		entry = memtx_art_index_seek(index, ITER_EQ, nkey);
+		if (entry != NULL && !memtx_art_entry_matches(entry, nkey))
+			entry = NULL;
+	}
+	region_truncate(region, region_svp);
+	if (entry == NULL) {
+		*result = NULL;
+		memtx_tx_track_point(txn, space, base, key);
+		return 0;
+	}
+	bool is_rw = txn != NULL;
+	*result = memtx_tx_tuple_clarify(txn, space, entry->tuple, base,
+					 0, is_rw);
+	return 0;
+}
+
+static int
+memtx_art_index_replace(struct index *base, struct tuple *old_tuple,
+			struct tuple *new_tuple, enum dup_replace_mode mode,
+			struct tuple **result, struct tuple **successor)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)base;
+	struct art *tree = &index->tree;
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	int rc = -1;
+	*successor = NULL;
+	/*
+	 * At most one entry is deleted below: either the new one
+	 * on failure or the replaced one on success.
+	 */
+	if (memtx_art_index_reserve_garbage(index) != 0)
+		return -1;
+	/*
+	 * Build the key to look up the old tuple in advance so
+	 * as not to fail after inserting the new tuple.
+	 */
+	const char *old_nkey = NULL;
+	if (old_tuple != NULL) {
+		old_nkey = tuple_normalized_key(old_tuple, index->cmp_def,
+						region);
+		if (old_nkey == NULL)
+			goto out;
+		/*
+		 * Nodes shared with snapshot iterators are copied on
+		 * write, so deleting the old tuple may need memory.
+		 */
+		uint32_t len = normalized_key_size(old_nkey) -
+			       NORMALIZED_KEY_HEADER_SIZE;
+		if (art_prepare_delete(tree, (const unsigned char *)old_nkey +
+				       NORMALIZED_KEY_HEADER_SIZE, len) != 0) {
+			diag_set(OutOfMemory, art_node_size(0),
+				 "memtx_art_index", "replace");
+			goto out;
+		}
+	}
+	if (new_tuple != NULL) {
+		struct memtx_art_entry *new_entry =
+			memtx_art_index_new_entry(index, new_tuple);
+		if (new_entry == NULL)
+			goto out;
+		void *replaced;
+		if (art_insert(tree, new_entry, &replaced) != 0) {
+			memtx_art_index_delete_entry(index, new_entry);
+			diag_set(OutOfMemory, art_node_size(0),
+				 "memtx_art_index", "replace");
+			goto out;
+		}
+		struct memtx_art_entry *dup_entry =
+			(struct memtx_art_entry *)replaced;
+		struct tuple *dup_tuple =
+			dup_entry != NULL ? dup_entry->tuple : NULL;
+		uint32_t errcode = replace_check_dup(old_tuple, dup_tuple, mode);
+		if (errcode) {
+			if (dup_entry != NULL) {
+				/* Replacing an entry never fails. */
+				art_insert(tree, dup_entry, &replaced);
+			} else {
+				uint32_t len;
+				const unsigned char *key =
+					memtx_art_entry_key(new_entry, &len);
+				art_delete(tree, key, len);
+			}
+			memtx_art_index_delete_entry(index, new_entry);
+			struct space *sp = space_cache_find(base->def->space_id);
+			if (sp != NULL) {
+				if (errcode == ER_TUPLE_FOUND) {
+					diag_set(ClientError, errcode,
+						 base->def->name,
+						 space_name(sp),
+						 tuple_str(dup_tuple),
+						 tuple_str(new_tuple));
+				} else {
+					diag_set(ClientError, errcode,
+						 base->def->name,
+						 space_name(sp));
+				}
+			}
+			goto out;
+		}
+		if (memtx_tx_manager_use_mvcc_engine) {
+			struct memtx_art_entry *next = memtx_art_index_seek(
+				index, ITER_GT, new_entry->key);
+			*successor = next != NULL ? next->tuple : NULL;
+		}
+		if (dup_entry != NULL) {
+			memtx_art_index_delete_entry(index, dup_entry);
+			*result = dup_tuple;
+			rc = 0;
+			goto out;
+		}
+	}
+	if (old_tuple != NULL) {
+		uint32_t len = normalized_key_size(old_nkey) -
+			       NORMALIZED_KEY_HEADER_SIZE;
+		const unsigned char *key = (const unsigned char *)old_nkey +
+					   NORMALIZED_KEY_HEADER_SIZE;
+		struct memtx_art_entry *entry =
+			(struct memtx_art_entry *)art_find(tree, key, len);
+		if (entry != NULL && entry->tuple == old_tuple) {
+			art_delete(tree, key, len);
+			memtx_art_index_delete_entry(index, entry);
+		}
+	}
+	*result = old_tuple;
+	rc = 0;
+out:
+	region_truncate(region, region_svp);
+	return rc;
+}
+
+template <bool UNCHANGED>
+static struct iterator *
+memtx_art_index_create_iterator(struct index *base, enum iterator_type type,
+				const char *key, uint32_t part_count)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)base;
+	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
+
+	assert(part_count == 0 || key != NULL);
+	if (type > ITER_GT) {
+		diag_set(UnsupportedIndexFeature, base->def,
+			 "requested iterator type");
+		return NULL;
+	}
+	if (type == ITER_ALL)
+		type = ITER_GE;
+	if (part_count == 0) {
+		/*
+		 * If no key is specified, downgrade equality
+		 * iterators to a full range.
+		 */
+		type = iterator_type_is_reverse(type) ? ITER_LE : ITER_GE;
+		key = NULL;
+	}
+
+	char *nkey_copy = NULL;
+	if (key != NULL) {
+		/*
+		 * The iterator may outlive the fiber region so copy
+		 * the key to malloc. It's freed with the iterator.
+		 */
+		struct region *region = &fiber()->gc;
+		size_t region_svp = region_used(region);
+		const char *nkey = key_normalized_key(key, part_count,
+						      index->cmp_def, region);
+		if (nkey == NULL) {
+			region_truncate(region, region_svp);
+			return NULL;
+		}
+		uint32_t nkey_size = normalized_key_size(nkey);
+		nkey_copy = (char *)malloc(nkey_size);
+		if (nkey_copy == NULL) {
+			diag_set(OutOfMemory, nkey_size, "malloc",
+				 "normalized key");
+			region_truncate(region, region_svp);
+			return NULL;
+		}
+		memcpy(nkey_copy, nkey, nkey_size);
+		region_truncate(region, region_svp);
+	}
+
+	struct art_iterator *it = (struct art_iterator *)
+		mempool_alloc(&memtx->iterator_pool);
+	if (it == NULL) {
+		free(nkey_copy);
+		diag_set(OutOfMemory, sizeof(struct art_iterator),
+			 "memtx_art_index", "iterator");
+		return NULL;
+	}
+	iterator_create(&it->base, base);
+	it->pool = &memtx->iterator_pool;
+	it->base.next_raw = art_iterator_start_raw<UNCHANGED>;
+	it->base.next = UNCHANGED ? it->base.next_raw : memtx_iterator_next;
+	it->base.free = art_iterator_free;
+	it->type = type;
+	it->key = key;
+	it->part_count = part_count;
+	it->nkey = nkey_copy;
+	it->current = NULL;
+	it->current_key = NULL;
+	it->current_key_capacity = 0;
+	return (struct iterator *)it;
+}
+
+struct art_snapshot_iterator {
+	struct snapshot_iterator base;
+	struct memtx_art_index *index;
+	/** Frozen state of the index. */
+	struct art_view view;
+	/** Last returned entry or NULL if the iteration hasn't started. */
+	struct memtx_art_entry *last;
+	/** Set if the iteration is over. */
+	bool is_eof;
+	struct memtx_tx_snapshot_cleaner cleaner;
+};
+
+/**
+ * Destroy read view and free snapshot iterator.
+ * Virtual method of snapshot iterator.
+ * @sa index_vtab::create_snapshot_iterator.
+ */
+static void
+art_snapshot_iterator_free(struct snapshot_iterator *iterator)
+{
+	assert(iterator->free == art_snapshot_iterator_free);
+	struct art_snapshot_iterator *it =
+		(struct art_snapshot_iterator *)iterator;
+	struct memtx_art_index *index = it->index;
+	art_view_destroy(&index->tree, &it->view);
+	if (art_view_count(&index->tree) == 0)
+		memtx_art_index_collect_garbage(index);
+	memtx_leave_delayed_free_mode((struct memtx_engine *)
+				      index->base.engine);
+	index_unref(&index->base);
+	memtx_tx_snapshot_cleaner_destroy(&it->cleaner);
+	free(iterator);
+}
+
+/**
+ * Get next tuple from snapshot iterator.
+ * Virtual method of snapshot iterator.
+ * @sa index_vtab::create_snapshot_iterator.
+ */
+static int
+art_snapshot_iterator_next(struct snapshot_iterator *iterator,
+			   const char **data, uint32_t *size)
+{
+	assert(iterator->free == art_snapshot_iterator_free);
+	struct art_snapshot_iterator *it =
+		(struct art_snapshot_iterator *)iterator;
+	struct art *tree = &it->index->tree;
+	while (!it->is_eof) {
+		if (it->last == NULL) {
+			it->last = (struct memtx_art_entry *)
+				art_view_first(tree, &it->view);
+		} else {
+			uint32_t len;
+			const unsigned char *key =
+				memtx_art_entry_key(it->last, &len);
+			it->last = (struct memtx_art_entry *)
+				art_view_succ(tree, &it->view, key, len);
+		}
+		if (it->last == NULL) {
+			it->is_eof = true;
+			break;
+		}
+		struct tuple *tuple = memtx_tx_snapshot_clarify(&it->cleaner,
+								it->last->tuple);
+		if (tuple != NULL) {
+			*data = tuple_data_range(tuple, size);
+			return 0;
+		}
+	}
+	*data = NULL;
+	return 0;
+}
+
+/**
+ * Create an ALL iterator with personal read view so further
+ * index modifications will not affect the iteration results.
+ * Must be destroyed by iterator->free after usage.
+ *
+ * The read view is an ART view: nodes shared with it are copied
+ * on write while entries and tuples deleted from the index are
+ * freed only after the iterator is destroyed.
+ */
+static struct snapshot_iterator *
+memtx_art_index_create_snapshot_iterator(struct index *base)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)base;
+	struct art_snapshot_iterator *it = (struct art_snapshot_iterator *)
+		calloc(1, sizeof(*it));
+	if (it == NULL) {
+		diag_set(OutOfMemory, sizeof(struct art_snapshot_iterator),
+			 "memtx_art_index", "create_snapshot_iterator");
+		return NULL;
+	}
+
+	struct space *space = space_cache_find(base->def->space_id);
+	memtx_tx_snapshot_cleaner_create(&it->cleaner, space);
+
+	it->base.free = art_snapshot_iterator_free;
+	it->base.next = art_snapshot_iterator_next;
+	it->index = index;
+	art_view_create(&index->tree, &it->view);
+	index_ref(base);
+	memtx_enter_delayed_free_mode((struct memtx_engine *)base->engine);
+	return (struct snapshot_iterator *)it;
+}
+
+/**
+ * Get index vtab by @a UNCHANGED, template version.
+ * If UNCHANGED == true iterator->next and index->get
+ * functions are the same as it's raw versions.
+ */
+template <bool UNCHANGED>
+static const struct index_vtab *
+get_memtx_art_index_vtab(void)
+{
+	static const struct index_vtab vtab = {
+		/* .destroy = */ memtx_art_index_destroy,
+		/* .commit_create = */ generic_index_commit_create,
+		/* .abort_create = */ generic_index_abort_create,
+		/* .commit_modify = */ generic_index_commit_modify,
+		/* .commit_drop = */ generic_index_commit_drop,
+		/* .update_def = */ memtx_art_index_update_def,
+		/* .depends_on_pk = */ memtx_art_index_depends_on_pk,
+		/* .def_change_requires_rebuild = */
+			memtx_index_def_change_requires_rebuild,
+		/* .size = */ memtx_art_index_size,
+		/* .bsize = */ memtx_art_index_bsize,
+		/* .min = */ generic_index_min,
+		/* .max = */ generic_index_max,
+		/* .random = */ memtx_art_index_random,
+		/* .count = */ memtx_art_index_count,
+		/* .get_raw = */ memtx_art_index_get_raw,
+		/* .get = */ UNCHANGED ? memtx_art_index_get_raw :
+			memtx_index_get,
+		/* .replace = */ memtx_art_index_replace,
+		/* .create_iterator = */
+			memtx_art_index_create_iterator<UNCHANGED>,
+		/* .create_snapshot_iterator = */
+			memtx_art_index_create_snapshot_iterator,
+		/* .stat = */ generic_index_stat,
+		/* .compact = */ generic_index_compact,
+		/* .reset_stat = */ generic_index_reset_stat,
+		/* .begin_build = */ generic_index_begin_build,
+		/* .reserve = */ generic_index_reserve,
+		/* .build_next = */ generic_index_build_next,
+		/* .end_build = */ generic_index_end_build,
+	};
+	return &vtab;
+}
+
+/**
+ * Get index vtab by @a unchanged, argument version.
+ */
+static const struct index_vtab *
+get_memtx_art_index_vtab(bool unchanged)
+{
+	static const index_vtab *choice[2] = {
+		get_memtx_art_index_vtab<false>(),
+		get_memtx_art_index_vtab<true>()
+	};
+	return choice[unchanged];
+}
+
+struct index *
+memtx_art_index_new(struct memtx_engine *memtx, struct index_def *def)
+{
+	struct memtx_art_index *index =
+		(struct memtx_art_index *)calloc(1, sizeof(*index));
+	if (index == NULL) {
+		diag_set(OutOfMemory, sizeof(*index),
+			 "malloc", "struct memtx_art_index");
+		return NULL;
+	}
+	const struct index_vtab *vtab = get_memtx_art_index_vtab(true);
+	if (index_create(&index->base, (struct engine *)memtx,
+			 vtab, def) != 0) {
+		free(index);
+		return NULL;
+	}
+	for (unsigned i = 0; i < ART_NODE_TYPE_COUNT; i++) {
+		mempool_create(&index->node_pool[i], &memtx->index_slab_cache,
+			       art_node_size(i));
+	}
+	art_create(&index->tree, memtx_art_entry_key,
+		   memtx_art_index_node_alloc, memtx_art_index_node_free,
+		   index);
+	memtx_art_index_update_def(&index->base);
+	return &index->base;
+}
+
+void
+memtx_art_index_set_vtab(struct index *index, bool unchanged)
+{
+	index->vtab = get_memtx_art_index_vtab(unchanged);
+}
+
+/* }}} */
@@ -0,0 +1,36 @@
+#pragma once
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2021, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include <stdbool.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct index;
+struct index_def;
+struct memtx_engine;
+
+/**
+ * Create an adaptive radix tree index. Tuples are indexed by
+ * their normalized keys (see normalized_key.h) so only key part
+ * types supported by normalized keys may be used.
+ */
+struct index *
+memtx_art_index_new(struct memtx_engine *memtx, struct index_def *def);
+
+/**
+ * Change @a index vtab according to @a unchanged argument.
+ * If @a unchanged is false it's mean that tuple in index should
+ * be transformed before return it to user, so we need special
+ * `index_get` and `iterator_next` functions version.
+ */
+void
+memtx_art_index_set_vtab(struct index *index, bool unchanged);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
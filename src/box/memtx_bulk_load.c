@@ -0,0 +1,371 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "memtx_bulk_load.h"
+
+#include <stdlib.h>
+#include <qsort_arg.h>
+
+#include "box.h"
+#include "diag.h"
+#include "errcode.h"
+#include "key_def.h"
+#include "memtx_engine.h"
+#include "memtx_space.h"
+#include "memtx_tuple_compression.h"
+#include "memtx_tx.h"
+#include "replication.h"
+#include "schema.h"
+#include "space.h"
+#include "tuple.h"
+#include "txn.h"
+#include "user_def.h"
+#include "trivia/util.h"
+
+struct memtx_bulk_load {
+	/** ID of the loaded space. */
+	uint32_t space_id;
+	/**
+	 * Format of the loaded tuples. Set when the first tuple is
+	 * added. The space must have the same format on commit.
+	 */
+	struct tuple_format *format;
+	/** Referenced tuples added to the loader. */
+	struct tuple **tuples;
+	/** Number of tuples in the tuples array. */
+	size_t tuple_count;
+	/** Capacity of the tuples array. */
+	size_t tuple_capacity;
+	/** Set when the loader is committed. */
+	bool is_committed;
+};
+
+int
+memtx_space_replace_bulk_load(struct space *space, struct tuple *old_tuple,
+			      struct tuple *new_tuple,
+			      enum dup_replace_mode mode,
+			      struct tuple **result)
+{
+	(void)old_tuple;
+	(void)new_tuple;
+	(void)mode;
+	(void)result;
+	diag_set(ClientError, ER_ALTER_SPACE, space_name(space),
+		 "the space is being bulk loaded");
+	return -1;
+}
+
+/**
+ * Find a space locked by a loader. Fails if the space was dropped or
+ * its primary key was rebuilt.
+ */
+static struct space *
+memtx_bulk_load_find_space(struct memtx_bulk_load *load)
+{
+	struct space *space = space_cache_find(load->space_id);
+	if (space == NULL)
+		return NULL;
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	if (!space_is_memtx(space) ||
+	    memtx_space->replace != memtx_space_replace_bulk_load) {
+		diag_set(ClientError, ER_ALTER_SPACE, space_name(space),
+			 "the space was altered during bulk load");
+		return NULL;
+	}
+	return space;
+}
+
+/**
+ * Check that a space doesn't have triggers, constraints, or a sequence.
+ * They're run on every insert, so they would be bypassed by the load.
+ */
+static int
+memtx_bulk_load_check_space(struct space *space)
+{
+	const char *err = NULL;
+	if (!rlist_empty(&space->before_replace) ||
+	    !rlist_empty(&space->on_replace) || space->sql_triggers != NULL)
+		err = "spaces with triggers";
+	else if (!rlist_empty(&space->ck_constraint) ||
+		 !rlist_empty(&space->parent_fk_constraint) ||
+		 !rlist_empty(&space->child_fk_constraint))
+		err = "spaces with constraints";
+	else if (space->sequence != NULL)
+		err = "spaces with a sequence";
+	if (err != NULL) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Bulk load", err);
+		return -1;
+	}
+	return 0;
+}
+
+/** Unlock a space locked by a loader if it still exists. */
+static void
+memtx_bulk_load_unlock_space(struct memtx_bulk_load *load)
+{
+	struct space *space = space_by_id(load->space_id);
+	if (space == NULL || !space_is_memtx(space))
+		return;
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	if (memtx_space->replace == memtx_space_replace_bulk_load)
+		memtx_space->replace = memtx_space_replace_all_keys;
+}
+
+struct memtx_bulk_load *
+memtx_bulk_load_new(uint32_t space_id)
+{
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		return NULL;
+	if (!space_is_memtx(space)) {
+		diag_set(ClientError, ER_UNSUPPORTED, space->engine->name,
+			 "bulk load");
+		return NULL;
+	}
+	if (space_is_system(space)) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Bulk load",
+			 "system spaces");
+		return NULL;
+	}
+	if (access_check_space(space, PRIV_W) != 0)
+		return NULL;
+	if (in_txn() != NULL) {
+		diag_set(ClientError, ER_ACTIVE_TRANSACTION);
+		return NULL;
+	}
+	if (memtx_tx_manager_use_mvcc_engine) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Bulk load",
+			 "transactional memtx manager");
+		return NULL;
+	}
+	/*
+	 * Loaded tuples bypass WAL, so they can't be replicated.
+	 * Replicas that join later get them from the checkpoint.
+	 */
+	if (!space_is_temporary(space) &&
+	    space_group_id(space) != GROUP_LOCAL) {
+		if (box_is_ro()) {
+			diag_set(ClientError, ER_READONLY);
+			return NULL;
+		}
+		if (replicaset.registered_count > 1 ||
+		    replicaset.anon_count > 0) {
+			diag_set(ClientError, ER_UNSUPPORTED, "Bulk load",
+				 "spaces replicated to other instances");
+			return NULL;
+		}
+	}
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	if (memtx_space->replace != memtx_space_replace_all_keys) {
+		diag_set(ClientError, ER_ALTER_SPACE, space_name(space),
+			 memtx_space->replace == memtx_space_replace_bulk_load ?
+			 "the space is being bulk loaded" :
+			 "the space isn't fully built");
+		return NULL;
+	}
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		struct index *index = space->index[i];
+		if (index->def->key_def->is_multikey ||
+		    index->def->key_def->for_func_index) {
+			diag_set(ClientError, ER_UNSUPPORTED, "Bulk load",
+				 "multikey and functional indexes");
+			return NULL;
+		}
+	}
+	if (memtx_bulk_load_check_space(space) != 0)
+		return NULL;
+	if (space_bsize(space) != 0) {
+		diag_set(ClientError, ER_ALTER_SPACE, space_name(space),
+			 "the space isn't empty");
+		return NULL;
+	}
+	struct memtx_bulk_load *load = xmalloc(sizeof(*load));
+	load->space_id = space_id;
+	load->format = NULL;
+	load->tuples = NULL;
+	load->tuple_count = 0;
+	load->tuple_capacity = 0;
+	load->is_committed = false;
+	memtx_space->replace = memtx_space_replace_bulk_load;
+	return load;
+}
+
+int
+memtx_bulk_load_add(struct memtx_bulk_load *load, const char *data,
+		    const char *data_end)
+{
+	assert(!load->is_committed);
+	struct space *space = memtx_bulk_load_find_space(load);
+	if (space == NULL)
+		return -1;
+	if (load->format == NULL) {
+		load->format = space->format;
+		tuple_format_ref(load->format);
+	} else if (load->format != space->format) {
+		diag_set(ClientError, ER_ALTER_SPACE, space_name(space),
+			 "the space was altered during bulk load");
+		return -1;
+	}
+	struct tuple *tuple = tuple_new(space->format, data, data_end);
+	if (tuple == NULL)
+		return -1;
+	if (space->format->is_compressed) {
+		tuple_ref(tuple);
+		struct tuple *compressed = memtx_tuple_compress(tuple);
+		tuple_unref(tuple);
+		if (compressed == NULL)
+			return -1;
+		tuple = compressed;
+	}
+	if (load->tuple_count == load->tuple_capacity) {
+		load->tuple_capacity = MAX(load->tuple_capacity * 2, 1024);
+		load->tuples = xrealloc(load->tuples, load->tuple_capacity *
+					sizeof(*load->tuples));
+	}
+	tuple_ref(tuple);
+	load->tuples[load->tuple_count++] = tuple;
+	return 0;
+}
+
+/** Compare tuples by the key definition passed in the argument. */
+static int
+memtx_bulk_load_tuple_cmp(const void *a, const void *b, void *arg)
+{
+	struct tuple *tuple_a = *(struct tuple **)a;
+	struct tuple *tuple_b = *(struct tuple **)b;
+	struct key_def *key_def = arg;
+	return tuple_compare(tuple_a, HINT_NONE, tuple_b, HINT_NONE, key_def);
+}
+
+/**
+ * Check that the loaded tuples don't violate a unique index. Sorts
+ * the tuple array by the index key definition.
+ */
+static int
+memtx_bulk_load_check_unique(struct memtx_bulk_load *load,
+			     struct space *space, struct index *index)
+{
+	struct key_def *key_def = index->def->key_def;
+	qsort_arg(load->tuples, load->tuple_count, sizeof(*load->tuples),
+		  memtx_bulk_load_tuple_cmp, key_def);
+	for (size_t i = 1; i < load->tuple_count; i++) {
+		struct tuple *prev = load->tuples[i - 1];
+		struct tuple *curr = load->tuples[i];
+		if (tuple_compare(prev, HINT_NONE, curr, HINT_NONE,
+				  key_def) != 0)
+			continue;
+		/* Multiple nulls are allowed in a unique index. */
+		if (key_def->is_nullable &&
+		    tuple_key_contains_null(curr, key_def, MULTIKEY_NONE))
+			continue;
+		diag_set(ClientError, ER_TUPLE_FOUND, index->def->name,
+			 space_name(space), tuple_str(prev), tuple_str(curr));
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Build an empty index from the loaded tuples. On failure, all tuples
+ * that were added to the index are deleted from it.
+ */
+static int
+memtx_bulk_load_build_index(struct memtx_bulk_load *load,
+			    struct index *index)
+{
+	assert(index_size(index) == 0);
+	index_begin_build(index);
+	int rc = index_reserve(index, load->tuple_count);
+	for (size_t i = 0; rc == 0 && i < load->tuple_count; i++)
+		rc = index_build_next(index, load->tuples[i]);
+	index_end_build(index);
+	return rc;
+}
+
+/** Delete the loaded tuples from an index. Must not fail. */
+static void
+memtx_bulk_load_clear_index(struct memtx_bulk_load *load,
+			    struct index *index)
+{
+	for (size_t i = 0; i < load->tuple_count; i++) {
+		struct tuple *unused;
+		if (index_replace(index, load->tuples[i], NULL,
+				  DUP_REPLACE_OR_INSERT, &unused,
+				  &unused) != 0)
+			panic("failed to rollback bulk load");
+	}
+}
+
+int
+memtx_bulk_load_commit(struct memtx_bulk_load *load)
+{
+	assert(!load->is_committed);
+	struct space *space = memtx_bulk_load_find_space(load);
+	if (space == NULL)
+		return -1;
+	if (load->format != NULL && load->format != space->format) {
+		diag_set(ClientError, ER_ALTER_SPACE, space_name(space),
+			 "the space was altered during bulk load");
+		return -1;
+	}
+	/* Triggers could be set while the tuples were added. */
+	if (memtx_bulk_load_check_space(space) != 0)
+		return -1;
+	struct memtx_engine *memtx = (struct memtx_engine *)space->engine;
+	if (memtx->delayed_free_mode > 0) {
+		/* Trees can't be built while a snapshot is written. */
+		diag_set(ClientError, ER_ALTER_SPACE, space_name(space),
+			 "a checkpoint or a replica join is in progress");
+		return -1;
+	}
+	/*
+	 * A tree can only be built from a sorted array if it has never
+	 * been modified. The indexes are recreated by space:truncate().
+	 */
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		if (index_size(space->index[i]) != 0) {
+			diag_set(ClientError, ER_ALTER_SPACE,
+				 space_name(space), "the space isn't empty");
+			return -1;
+		}
+	}
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		struct index *index = space->index[i];
+		if (index->def->opts.is_unique &&
+		    memtx_bulk_load_check_unique(load, space, index) != 0)
+			return -1;
+	}
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		if (memtx_bulk_load_build_index(load,
+						space->index[i]) == 0)
+			continue;
+		for (uint32_t j = 0; j <= i; j++)
+			memtx_bulk_load_clear_index(load, space->index[j]);
+		return -1;
+	}
+	/* The space takes over the references of the loaded tuples. */
+	for (size_t i = 0; i < load->tuple_count; i++) {
+		memtx_space_update_bsize(space, NULL, load->tuples[i]);
+		memtx_space_update_compressed_tuples(space, NULL,
+						     load->tuples[i]);
+	}
+	load->tuple_count = 0;
+	load->is_committed = true;
+	memtx_bulk_load_unlock_space(load);
+	return 0;
+}
+
+void
+memtx_bulk_load_delete(struct memtx_bulk_load *load)
+{
+	for (size_t i = 0; i < load->tuple_count; i++)
+		tuple_unref(load->tuples[i]);
+	if (!load->is_committed)
+		memtx_bulk_load_unlock_space(load);
+	if (load->format != NULL)
+		tuple_format_unref(load->format);
+	free(load->tuples);
+	free(load);
+}
@@ -0,0 +1,76 @@
+#pragma once
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include <stdint.h>
+
+#include "index.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct space;
+struct tuple;
+
+/**
+ * Bulk load of tuples into an empty memtx space (space:bulk_load()).
+ *
+ * Tuples are accumulated by a loader without being inserted into
+ * the space indexes. When all tuples are added, the indexes are built
+ * from them in one go, the same way as on recovery from a snapshot:
+ * tuples are sorted and a tree is built from the sorted array.
+ *
+ * The tuples aren't written to WAL, so a checkpoint must be made after
+ * the load to make them durable. Since they aren't replicated either,
+ * only spaces that aren't replicated to any other instance may be
+ * loaded.
+ *
+ * The space is locked for writes while a loader is active and its
+ * indexes must be new (see space:truncate()) when the loader commits.
+ */
+struct memtx_bulk_load;
+
+/**
+ * Create a loader for a memtx space and lock the space for writes.
+ * Returns NULL and sets diag on error.
+ */
+struct memtx_bulk_load *
+memtx_bulk_load_new(uint32_t space_id);
+
+/**
+ * Add a tuple to a loader. The tuple is validated against the space
+ * format, but isn't inserted into indexes until the loader commits.
+ * Returns -1 and sets diag on error.
+ */
+int
+memtx_bulk_load_add(struct memtx_bulk_load *load, const char *data,
+		    const char *data_end);
+
+/**
+ * Build the space indexes from the added tuples and unlock the space.
+ * The loader must be deleted after this function returns. On error,
+ * the space is left empty. Returns -1 and sets diag on error.
+ */
+int
+memtx_bulk_load_commit(struct memtx_bulk_load *load);
+
+/**
+ * Delete a loader. If it wasn't committed, all added tuples are
+ * dropped and the space is unlocked.
+ */
+void
+memtx_bulk_load_delete(struct memtx_bulk_load *load);
+
+/** A version of replace() for a space locked by a bulk loader. */
+int
+memtx_space_replace_bulk_load(struct space *space, struct tuple *old_tuple,
+			      struct tuple *new_tuple,
+			      enum dup_replace_mode mode,
+			      struct tuple **result);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
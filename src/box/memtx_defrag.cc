@@ -0,0 +1,280 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "memtx_defrag.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocator.h"
+#include "diag.h"
+#include "fiber.h"
+#include "index.h"
+#include "key_def.h"
+#include "memtx_engine.h"
+#include "memtx_space.h"
+#include "memtx_tx.h"
+#include "msgpuck.h"
+#include "schema.h"
+#include "space.h"
+#include "tuple.h"
+#include "trivia/util.h"
+
+/** Max number of tuples checked in one step. */
+static const int MEMTX_DEFRAG_BATCH_SIZE = 100;
+
+/**
+ * How often to check if the tuple arena needs defragmentation
+ * when no pass is in progress, in seconds.
+ */
+static const double MEMTX_DEFRAG_CHECK_INTERVAL = 1;
+
+/** Min delay between two defragmentation passes, in seconds. */
+static const double MEMTX_DEFRAG_PASS_INTERVAL = 10;
+
+void
+memtx_defrag_create(struct memtx_defrag *defrag)
+{
+	memset(defrag, 0, sizeof(*defrag));
+}
+
+void
+memtx_defrag_destroy(struct memtx_defrag *defrag)
+{
+	free(defrag->key);
+}
+
+/** Return the ratio of free memory in the tuple slabs. */
+static double
+memtx_defrag_fragmentation(void)
+{
+	struct allocator_stats stats;
+	memset(&stats, 0, sizeof(stats));
+	allocators_stats(&stats);
+	if (stats.small.total == 0)
+		return 0;
+	return 1 - (double)stats.small.used / stats.small.total;
+}
+
+/**
+ * Check if tuples of a space can be moved by the defragmenter.
+ * The space must be fully built and scanned in the primary key order.
+ * Functional and multikey indexes store tuples under keys that can't
+ * be looked up without recomputing them, so such spaces are skipped.
+ */
+static bool
+memtx_defrag_space_is_eligible(struct space *space)
+{
+	if (!space_is_memtx(space) || space_is_system(space))
+		return false;
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	if (memtx_space->replace != memtx_space_replace_all_keys)
+		return false;
+	struct index *pk = space_index(space, 0);
+	if (pk == NULL || pk->def->type != TREE)
+		return false;
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		struct key_def *key_def = space->index[i]->def->key_def;
+		if (key_def->is_multikey || key_def->for_func_index)
+			return false;
+	}
+	return true;
+}
+
+struct memtx_defrag_next_space_arg {
+	/** Look for a space with ID greater than this. */
+	uint32_t after;
+	/** Min ID of a suitable space or UINT32_MAX. */
+	uint32_t found;
+};
+
+static int
+memtx_defrag_next_space_cb(struct space *space, void *data)
+{
+	struct memtx_defrag_next_space_arg *arg =
+		(struct memtx_defrag_next_space_arg *)data;
+	uint32_t id = space_id(space);
+	if (id > arg->after && id < arg->found &&
+	    memtx_defrag_space_is_eligible(space))
+		arg->found = id;
+	return 0;
+}
+
+/**
+ * Switch to the next space in the space ID order. Returns false if
+ * there are no more spaces to defragment.
+ */
+static bool
+memtx_defrag_next_space(struct memtx_defrag *defrag)
+{
+	struct memtx_defrag_next_space_arg arg;
+	arg.after = defrag->space_id;
+	arg.found = UINT32_MAX;
+	if (space_foreach(memtx_defrag_next_space_cb, &arg) != 0)
+		diag_log();
+	free(defrag->key);
+	defrag->key = NULL;
+	defrag->space_id = arg.found;
+	return arg.found != UINT32_MAX;
+}
+
+/**
+ * Move a tuple referenced only by the space to a lower address.
+ * Returns -1 and sets diag if index memory can't be reserved.
+ */
+static int
+memtx_defrag_move_tuple(struct memtx_engine *memtx, struct space *space,
+			struct tuple *old_tuple)
+{
+	assert(tuple_has_single_ref(old_tuple));
+	/* Index replacement mustn't fail on rollback. */
+	if (memtx_index_extent_reserve(memtx,
+				       RESERVE_EXTENTS_BEFORE_REPLACE) != 0)
+		return -1;
+	struct tuple *new_tuple = memtx_tuple_move_down(old_tuple);
+	if (new_tuple == NULL)
+		return 0;
+	tuple_ref(new_tuple);
+	uint32_t i;
+	for (i = 0; i < space->index_count; i++) {
+		struct tuple *unused;
+		enum dup_replace_mode mode = i == 0 ? DUP_REPLACE : DUP_INSERT;
+		if (index_replace(space->index[i], old_tuple, new_tuple, mode,
+				  &unused, &unused) != 0)
+			goto rollback;
+	}
+	tuple_unref(old_tuple);
+	memtx->defrag.moved++;
+	return 0;
+rollback:
+	for (; i > 0; i--) {
+		struct tuple *unused;
+		enum dup_replace_mode mode = i == 1 ? DUP_REPLACE : DUP_INSERT;
+		if (index_replace(space->index[i - 1], new_tuple, old_tuple,
+				  mode, &unused, &unused) != 0) {
+			diag_log();
+			unreachable();
+			panic("failed to rollback tuple move");
+		}
+	}
+	tuple_unref(new_tuple);
+	return -1;
+}
+
+/**
+ * Check the next batch of tuples of a space in the primary key order
+ * and move those that can be moved. Sets @a done if there are no more
+ * tuples to check in the space. Returns the number of checked tuples.
+ */
+static int
+memtx_defrag_check_space(struct memtx_engine *memtx, struct space *space,
+			 bool *done)
+{
+	struct memtx_defrag *defrag = &memtx->defrag;
+	struct index *pk = space->index[0];
+	const char *key = defrag->key;
+	uint32_t part_count = 0;
+	if (key != NULL)
+		part_count = mp_decode_array(&key);
+	*done = true;
+	struct iterator *it = index_create_iterator(
+		pk, key != NULL ? ITER_GT : ITER_ALL, key, part_count);
+	if (it == NULL) {
+		diag_log();
+		return 0;
+	}
+	/*
+	 * The iterator references the tuple it returned last, so first
+	 * collect a batch, then delete the iterator, and only then move
+	 * the tuples. Nothing yields in between so the tuples stay alive.
+	 */
+	struct tuple *batch[MEMTX_DEFRAG_BATCH_SIZE];
+	int count = 0;
+	struct tuple *tuple;
+	while (count < MEMTX_DEFRAG_BATCH_SIZE &&
+	       iterator_next_raw(it, &tuple) == 0 && tuple != NULL)
+		batch[count++] = tuple;
+	iterator_delete(it);
+	if (count == 0)
+		return 0;
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint32_t key_size;
+	const char *last_key = tuple_extract_key(batch[count - 1],
+						 pk->def->key_def,
+						 MULTIKEY_NONE, &key_size);
+	if (last_key == NULL) {
+		diag_log();
+		region_truncate(region, region_svp);
+		return count;
+	}
+	defrag->key = (char *)xrealloc(defrag->key, key_size);
+	memcpy(defrag->key, last_key, key_size);
+	region_truncate(region, region_svp);
+	*done = count < MEMTX_DEFRAG_BATCH_SIZE;
+	for (int i = 0; i < count; i++) {
+		if (!tuple_has_single_ref(batch[i]))
+			continue;
+		if (memtx_defrag_move_tuple(memtx, space, batch[i]) != 0) {
+			diag_log();
+			break;
+		}
+	}
+	return count;
+}
+
+/** Finish a defragmentation pass. Returns the delay before the next one. */
+static double
+memtx_defrag_complete_pass(struct memtx_defrag *defrag, double now)
+{
+	say_verbose("memtx tuple arena defragmentation completed, "
+		    "%llu tuples moved since startup",
+		    (unsigned long long)defrag->moved);
+	defrag->in_progress = false;
+	defrag->passes++;
+	defrag->next_step_time = now + MEMTX_DEFRAG_PASS_INTERVAL;
+	return MEMTX_DEFRAG_PASS_INTERVAL;
+}
+
+double
+memtx_defrag_step(struct memtx_engine *memtx)
+{
+	struct memtx_defrag *defrag = &memtx->defrag;
+	if (defrag->threshold == 0)
+		return TIMEOUT_INFINITY;
+	double now = fiber_clock();
+	if (now < defrag->next_step_time)
+		return defrag->next_step_time - now;
+	/*
+	 * Tuples can't be moved while a read view may see them or
+	 * the transaction manager may keep pointers to them.
+	 */
+	if (memtx->state != MEMTX_OK || memtx->delayed_free_mode > 0 ||
+	    memtx_tx_manager_use_mvcc_engine) {
+		defrag->next_step_time = now + MEMTX_DEFRAG_CHECK_INTERVAL;
+		return MEMTX_DEFRAG_CHECK_INTERVAL;
+	}
+	if (!defrag->in_progress) {
+		if (memtx_defrag_fragmentation() < defrag->threshold) {
+			defrag->next_step_time =
+				now + MEMTX_DEFRAG_CHECK_INTERVAL;
+			return MEMTX_DEFRAG_CHECK_INTERVAL;
+		}
+		say_verbose("memtx tuple arena defragmentation started");
+		defrag->in_progress = true;
+		defrag->space_id = 0;
+		if (!memtx_defrag_next_space(defrag))
+			return memtx_defrag_complete_pass(defrag, now);
+	}
+	int checked = 0;
+	bool space_done = true;
+	struct space *space = space_by_id(defrag->space_id);
+	if (space != NULL && memtx_defrag_space_is_eligible(space))
+		checked = memtx_defrag_check_space(memtx, space, &space_done);
+	if (space_done && !memtx_defrag_next_space(defrag))
+		return memtx_defrag_complete_pass(defrag, now);
+	defrag->next_step_time = now + checked / defrag->rate;
+	return defrag->next_step_time - now;
+}
@@ -0,0 +1,77 @@
+#pragma once
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct memtx_engine;
+
+/**
+ * Online defragmentation of the memtx tuple arena.
+ *
+ * If tuples of different sizes are inserted and deleted for a long
+ * time, slabs of the tuple allocator become sparse: each of them holds
+ * a few live tuples, so it can't be reused for objects of other sizes.
+ *
+ * The defragmenter runs in the memtx garbage collection fiber when
+ * there's no other garbage to collect. It walks over memtx spaces in
+ * small batches and moves tuples referenced only by the space to a new
+ * location. A copy is kept only if the allocator places it at a lower
+ * address, so tuples are packed into the first slabs of each size class
+ * and the rest of the slabs are freed.
+ */
+struct memtx_defrag {
+	/**
+	 * Ratio of free memory in the tuple slabs that triggers
+	 * a defragmentation pass, box.cfg.memtx_defrag_threshold.
+	 * Zero if defragmentation is disabled.
+	 */
+	double threshold;
+	/**
+	 * Max number of tuples checked per second,
+	 * box.cfg.memtx_defrag_rate.
+	 */
+	double rate;
+	/** Set if a defragmentation pass is in progress. */
+	bool in_progress;
+	/** ID of the space being defragmented. */
+	uint32_t space_id;
+	/**
+	 * Primary key of the last checked tuple of the space or NULL
+	 * if the space hasn't been checked yet. Allocated with malloc.
+	 */
+	char *key;
+	/** Monotonic time when the next step may be run. */
+	double next_step_time;
+	/** Number of tuples moved since startup. */
+	uint64_t moved;
+	/** Number of passes completed since startup. */
+	uint64_t passes;
+};
+
+/** Initialize the defragmenter state. Defragmentation is disabled. */
+void
+memtx_defrag_create(struct memtx_defrag *defrag);
+
+/** Free the defragmenter state. */
+void
+memtx_defrag_destroy(struct memtx_defrag *defrag);
+
+/**
+ * Run one step of defragmentation if it's enabled and the tuple
+ * arena is fragmented. Never yields. Returns how long to wait before
+ * the next step, in seconds.
+ */
+double
+memtx_defrag_step(struct memtx_engine *memtx);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
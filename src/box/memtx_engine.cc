@@ -31,6 +31,13 @@
 #include "memtx_engine.h"
 #include "memtx_space.h"
 
+#include "trivia/config.h"
+#include <sys/mman.h>
+#if defined(TARGET_OS_LINUX)
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#endif /* defined(TARGET_OS_LINUX) */
 #include <small/quota.h>
 #include <small/small.h>
 #include <small/mempool.h>
@@ -52,9 +59,11 @@
 #include "raft.h"
 #include "txn_limbo.h"
 #include "memtx_allocator.h"
+#include "memtx_net_read.h"
 #include "index.h"
 #include "memtx_tuple_compression.h"
 #include "memtx_space.h"
+#include "assoc.h"
 
 #include <type_traits>
 
@@ -84,6 +93,10 @@ void
 struct tuple *
 (*memtx_tuple_new_raw)(struct tuple_format *format, const char *data,
 		       const char *end, bool validate);
+void
+(*memtx_tuple_free)(struct tuple *tuple);
+struct tuple *
+(*memtx_tuple_move_down)(struct tuple *tuple);
 
 template <class ALLOC>
 static void *
@@ -111,6 +124,14 @@ static inline struct tuple *
 memtx_tuple_new_raw_impl(struct tuple_format *format, const char *data,
 			 const char *end, bool validate);
 
+template <class ALLOC>
+static void
+memtx_tuple_free_impl(struct tuple *tuple);
+
+template <class ALLOC>
+static struct tuple *
+memtx_tuple_move_down_impl(struct tuple *tuple);
+
 template <class ALLOC>
 static void
 memtx_alloc_init(void)
@@ -118,6 +139,8 @@ memtx_alloc_init(void)
 	memtx_alloc = memtx_alloc_impl<ALLOC>;
 	memtx_free = memtx_free_impl<ALLOC>;
 	memtx_tuple_new_raw = memtx_tuple_new_raw_impl<ALLOC>;
+	memtx_tuple_free = memtx_tuple_free_impl<ALLOC>;
+	memtx_tuple_move_down = memtx_tuple_move_down_impl<ALLOC>;
 }
 
 static int
@@ -236,6 +259,7 @@ memtx_engine_shutdown(struct engine *engine)
 	memtx_allocators_destroy();
 	slab_cache_destroy(&memtx->slab_cache);
 	tuple_arena_destroy(&memtx->arena);
+	memtx_defrag_destroy(&memtx->defrag);
 
 	xdir_destroy(&memtx->snap_dir);
 	free(memtx);
@@ -753,6 +777,25 @@ replica_join_cancel(struct cord *replica_join_cord)
 	tt_pthread_join(replica_join_cord->id, NULL);
 }
 
+/**
+ * Create a snapshot iterator over the primary index of @a space.
+ * Compressed fields are stored in snapshots decompressed so that
+ * they can be loaded regardless of the space format.
+ */
+static struct snapshot_iterator *
+memtx_space_create_snapshot_iterator(struct space *space)
+{
+	struct index *pk = space_index(space, 0);
+	assert(pk != NULL);
+	struct snapshot_iterator *it = index_create_snapshot_iterator(pk);
+	if (it == NULL)
+		return NULL;
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	if (memtx_space->compressed_tuples > 0)
+		it = memtx_decompress_snapshot_iterator_new(it);
+	return it;
+}
+
 static int
 checkpoint_add_space(struct space *sp, void *data)
 {
@@ -775,7 +818,7 @@ checkpoint_add_space(struct space *sp, void *data)
 
 	entry->space_id = space_id(sp);
 	entry->group_id = space_group_id(sp);
-	entry->iterator = index_create_snapshot_iterator(pk);
+	entry->iterator = memtx_space_create_snapshot_iterator(sp);
 	if (entry->iterator == NULL)
 		return -1;
 
@@ -1024,7 +1067,7 @@ memtx_join_add_space(struct space *space, void *arg)
 		return -1;
 	}
 	entry->space_id = space_id(space);
-	entry->iterator = index_create_snapshot_iterator(pk);
+	entry->iterator = memtx_space_create_snapshot_iterator(space);
 	if (entry->iterator == NULL) {
 		free(entry);
 		return -1;
@@ -1202,7 +1245,11 @@ memtx_engine_gc_f(va_list va)
 		ERROR_INJECT_YIELD(ERRINJ_MEMTX_DELAY_GC);
 		memtx_engine_run_gc(memtx, &stop);
 		if (stop) {
-			fiber_yield_timeout(TIMEOUT_INFINITY);
+			/*
+			 * Defragment the tuple arena only when there's
+			 * no other garbage to collect.
+			 */
+			fiber_yield_timeout(memtx_defrag_step(memtx));
 			continue;
 		}
 		/*
@@ -1294,6 +1341,7 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 	}
 
 	stailq_create(&memtx->gc_queue);
+	memtx_defrag_create(&memtx->defrag);
 	memtx->gc_fiber = fiber_new("memtx.gc", memtx_engine_gc_f);
 	if (memtx->gc_fiber == NULL)
 		goto fail;
@@ -1325,6 +1373,21 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 				&actual_alloc_factor, &memtx->quota);
 	memtx_allocators_init(memtx, &alloc_settings);
 	memtx_set_tuple_format_vtab(allocator);
+	if (strncmp(allocator, "small", strlen("small")) == 0) {
+		/*
+		 * Tuples allocated from slabs are aligned by the
+		 * allocation granularity, which is a power of two.
+		 * The upper half of offsets is reserved for tuples
+		 * allocated outside of the arena.
+		 */
+		memtx_tuple_offset_shift = __builtin_ctz(granularity);
+		memtx_tuple_offset_base = (char *)memtx->arena.arena +
+					  offsetof(struct memtx_tuple, base);
+		memtx_tuple_offset_limit =
+			MIN(memtx->arena.prealloc,
+			    (size_t)MEMTX_TUPLE_OFFSET_EXTERNAL <<
+			    memtx_tuple_offset_shift);
+	}
 
 	say_info("Actual slab_alloc_factor calculated on the basis of desired "
 		 "slab_alloc_factor = %f", actual_alloc_factor);
@@ -1377,6 +1440,16 @@ memtx_engine_set_memory(struct memtx_engine *memtx, size_t size)
 			 "cannot decrease memory size at runtime");
 		return -1;
 	}
+	/*
+	 * Memory mapped beyond the preallocated arena can't be
+	 * addressed by tuple offsets.
+	 */
+	if (memtx->compact_index_count > 0 && size > memtx->arena.prealloc) {
+		diag_set(ClientError, ER_CFG, "memtx_memory",
+			 "cannot increase memory size at runtime while "
+			 "there are indexes with compact pointers");
+		return -1;
+	}
 	quota_set(&memtx->quota, size);
 	return 0;
 }
@@ -1387,6 +1460,59 @@ memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size)
 	memtx->max_tuple_size = max_size;
 }
 
+void
+memtx_engine_set_defrag(struct memtx_engine *memtx, double threshold,
+			double rate)
+{
+	memtx->defrag.threshold = threshold;
+	memtx->defrag.rate = rate;
+	memtx->defrag.next_step_time = 0;
+	fiber_wakeup(memtx->gc_fiber);
+}
+
+void
+memtx_engine_set_arena_policy(struct memtx_engine *memtx, bool use_hugepages,
+			      int numa_node)
+{
+	void *addr = memtx->arena.arena;
+	size_t size = memtx->arena.prealloc;
+	if (addr == NULL || size == 0)
+		return;
+	if (use_hugepages) {
+#ifdef MADV_HUGEPAGE
+		/*
+		 * The arena is mapped by the slab allocator, so explicit
+		 * hugetlb pages can't be used. Transparent huge pages are
+		 * used instead. It isn't an error if they're disabled.
+		 */
+		if (madvise(addr, size, MADV_HUGEPAGE) != 0)
+			say_syserror("failed to enable huge pages for "
+				     "the memtx arena");
+#else
+		say_warn("huge pages aren't supported on this platform");
+#endif
+	}
+	if (numa_node >= 0) {
+		assert(numa_node < MEMTX_NUMA_NODES_MAX);
+#if defined(TARGET_OS_LINUX) && defined(SYS_mbind)
+		unsigned long mask[MEMTX_NUMA_NODES_MAX / (8 * sizeof(long))];
+		memset(mask, 0, sizeof(mask));
+		mask[numa_node / (8 * sizeof(long))] |=
+			1UL << (numa_node % (8 * sizeof(long)));
+		/*
+		 * The kernel ignores the last bit of the mask, hence + 1.
+		 */
+		if (syscall(SYS_mbind, addr, size, MPOL_BIND, mask,
+			    MEMTX_NUMA_NODES_MAX + 1, 0) != 0)
+			say_syserror("failed to bind the memtx arena "
+				     "to NUMA node %d", numa_node);
+#else
+		say_warn("NUMA memory policy isn't supported "
+			 "on this platform");
+#endif
+	}
+}
+
 void
 memtx_enter_delayed_free_mode(struct memtx_engine *memtx)
 {
@@ -1407,6 +1533,35 @@ memtx_leave_delayed_free_mode(struct memtx_engine *memtx)
 	}
 }
 
+/**
+ * Tuples of net-readable formats store the generation of the last set
+ * of read views published to iproto threads at the time of allocation
+ * between the tuple header and the field map, see memtx_tuple_delete().
+ */
+static inline char *
+memtx_tuple_net_read_generation_ptr(struct tuple *tuple)
+{
+	assert(tuple_format(tuple)->is_net_readable);
+	return (char *)tuple + sizeof(struct tuple) -
+	       (tuple_is_compact(tuple) ? TUPLE_COMPACT_SAVINGS : 0);
+}
+
+static inline uint64_t
+memtx_tuple_net_read_generation(struct tuple *tuple)
+{
+	uint64_t generation;
+	memcpy(&generation, memtx_tuple_net_read_generation_ptr(tuple),
+	       sizeof(generation));
+	return generation;
+}
+
+static inline void
+memtx_tuple_set_net_read_generation(struct tuple *tuple, uint64_t generation)
+{
+	memcpy(memtx_tuple_net_read_generation_ptr(tuple), &generation,
+	       sizeof(generation));
+}
+
 template<class ALLOC>
 static struct tuple *
 memtx_tuple_new_raw_impl(struct tuple_format *format, const char *data,
@@ -1431,12 +1586,15 @@ memtx_tuple_new_raw_impl(struct tuple_format *format, const char *data,
 	 * tuple is not the first field of the memtx_tuple.
 	 */
 	data_offset = sizeof(struct tuple) + field_map_size;
+	if (format->is_net_readable)
+		data_offset += sizeof(uint64_t);
 	if (tuple_check_data_offset(data_offset) != 0)
 		goto end;
 
-	tuple_len = end - data;
+	tuple_len = format->is_fixed_layout ? format->fixed_data_size :
+		    end - data;
 	assert(tuple_len <= UINT32_MAX); /* bsize is UINT32_MAX */
-	total = sizeof(struct memtx_tuple) + field_map_size + tuple_len;
+	total = offsetof(struct memtx_tuple, base) + data_offset + tuple_len;
 
 	make_compact = tuple_can_be_compact(data_offset, tuple_len);
 	if (make_compact) {
@@ -1470,10 +1628,16 @@ memtx_tuple_new_raw_impl(struct tuple_format *format, const char *data,
 	tuple_create(tuple, 0, tuple_format_id(format),
 		     data_offset, tuple_len, make_compact);
 	memtx_tuple->version = memtx->snapshot_version;
+	if (format->is_net_readable)
+		memtx_tuple_set_net_read_generation(tuple,
+						    memtx->net_read_generation);
 	tuple_format_ref(format);
 	raw = (char *) tuple + data_offset;
 	field_map_build(&builder, raw - field_map_size);
-	memcpy(raw, data, tuple_len);
+	if (format->is_fixed_layout)
+		tuple_format_fixed_encode(format, data, raw);
+	else
+		memcpy(raw, data, tuple_len);
 	say_debug("%s(%zu) = %p", __func__, tuple_len, memtx_tuple);
 end:
 	region_truncate(region, region_svp);
@@ -1489,13 +1653,12 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 
 template<class ALLOC>
 static void
-memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple)
+memtx_tuple_free_impl(struct tuple *tuple)
 {
+	struct tuple_format *format = tuple_format(tuple);
 	struct memtx_engine *memtx = (struct memtx_engine *)format->engine;
-	assert(tuple_is_unreferenced(tuple));
 	struct memtx_tuple *memtx_tuple =
 		container_of(tuple, struct memtx_tuple, base);
-	say_debug("%s(%p)", __func__, memtx_tuple);
 	if (memtx->free_mode != MEMTX_ENGINE_DELAYED_FREE ||
 	    memtx_tuple->version == memtx->snapshot_version ||
 	    format->is_temporary) {
@@ -1506,8 +1669,173 @@ memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 	tuple_format_unref(format);
 }
 
+template<class ALLOC>
+static struct tuple *
+memtx_tuple_move_down_impl(struct tuple *tuple)
+{
+	/* The system allocator doesn't pack objects by address. */
+	if (std::is_same<ALLOC, SysAlloc>::value)
+		return NULL;
+	struct tuple_format *format = tuple_format(tuple);
+	struct memtx_engine *memtx = (struct memtx_engine *)format->engine;
+	struct memtx_tuple *memtx_tuple =
+		container_of(tuple, struct memtx_tuple, base);
+	size_t total = tuple_size(tuple) + offsetof(struct memtx_tuple, base);
+	struct memtx_tuple *copy = (struct memtx_tuple *)
+		MemtxAllocator<ALLOC>::alloc(total);
+	if (copy == NULL)
+		return NULL;
+	if ((uintptr_t)copy > (uintptr_t)memtx_tuple) {
+		MemtxAllocator<ALLOC>::free(copy, total);
+		return NULL;
+	}
+	memcpy(copy, memtx_tuple, total);
+	copy->version = memtx->snapshot_version;
+	tuple_create(&copy->base, 0, tuple_format_id(format),
+		     tuple_data_offset(tuple), tuple_bsize(tuple),
+		     tuple_is_compact(tuple));
+	if (format->is_net_readable)
+		memtx_tuple_set_net_read_generation(&copy->base,
+						    memtx->net_read_generation);
+	tuple_format_ref(format);
+	return &copy->base;
+}
+
+template<class ALLOC>
+static void
+memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple)
+{
+	struct memtx_engine *memtx = (struct memtx_engine *)format->engine;
+	assert(tuple_is_unreferenced(tuple));
+	struct memtx_tuple *memtx_tuple =
+		container_of(tuple, struct memtx_tuple, base);
+	say_debug("%s(%p)", __func__, memtx_tuple);
+	/*
+	 * Only tuples of spaces with the iproto_read option that
+	 * were allocated before the last read view creation may be
+	 * accessed from iproto threads.
+	 */
+	if (format->is_net_readable &&
+	    memtx_net_read_postpone_tuple_delete(tuple,
+			memtx_tuple_net_read_generation(tuple)))
+		return;
+	memtx_tuple_free_impl<ALLOC>(tuple);
+}
+
 struct tuple_format_vtab memtx_tuple_format_vtab;
 
+char *memtx_tuple_offset_base;
+size_t memtx_tuple_offset_limit;
+unsigned memtx_tuple_offset_shift;
+struct tuple **memtx_tuple_offset_external;
+
+/** Number of entries allocated in memtx_tuple_offset_external. */
+static uint32_t memtx_tuple_offset_external_size;
+/**
+ * Head of the list of free entries of memtx_tuple_offset_external or
+ * UINT32_MAX if there are no free entries. A free entry stores the
+ * index of the next free entry shifted left by one bit with the lowest
+ * bit set so that it can't be confused with a tuple pointer.
+ */
+static uint32_t memtx_tuple_offset_external_free = UINT32_MAX;
+/** Map: tuple pointer => external tuple offset. */
+static struct mh_i64ptr_t *memtx_tuple_offset_external_map;
+
+int
+memtx_tuple_offset_reserve(struct tuple *tuple)
+{
+	uintptr_t pos = (uintptr_t)tuple - (uintptr_t)memtx_tuple_offset_base;
+	if (pos < memtx_tuple_offset_limit &&
+	    (pos & ((1 << memtx_tuple_offset_shift) - 1)) == 0)
+		return 0;
+	if (tuple->has_external_offset)
+		return 0;
+	if (memtx_tuple_offset_external_map == NULL)
+		memtx_tuple_offset_external_map = mh_i64ptr_new();
+	uint32_t slot = memtx_tuple_offset_external_free;
+	if (slot == UINT32_MAX) {
+		/* The last offset is reserved for NULL. */
+		uint32_t max_size = UINT32_MAX - MEMTX_TUPLE_OFFSET_EXTERNAL;
+		uint32_t size = memtx_tuple_offset_external_size;
+		if (size == max_size) {
+			diag_set(OutOfMemory, sizeof(struct tuple *),
+				 "memtx", "external tuple offset");
+			return -1;
+		}
+		uint32_t new_size = size < max_size / 2 ?
+				    MAX(size * 2, 1024U) : max_size;
+		struct tuple **array = (struct tuple **)realloc(
+			memtx_tuple_offset_external,
+			(size_t)new_size * sizeof(*array));
+		if (array == NULL) {
+			diag_set(OutOfMemory,
+				 (size_t)new_size * sizeof(*array),
+				 "realloc", "external tuple offsets");
+			return -1;
+		}
+		for (uint32_t i = new_size; i > size; i--) {
+			array[i - 1] = (struct tuple *)(uintptr_t)
+				(((uintptr_t)memtx_tuple_offset_external_free
+				  << 1) | 1);
+			memtx_tuple_offset_external_free = i - 1;
+		}
+		memtx_tuple_offset_external = array;
+		memtx_tuple_offset_external_size = new_size;
+		slot = memtx_tuple_offset_external_free;
+	}
+	struct mh_i64ptr_node_t node = {
+		(uint64_t)(uintptr_t)tuple, (void *)(uintptr_t)slot
+	};
+	if (mh_i64ptr_put(memtx_tuple_offset_external_map, &node,
+			  NULL, NULL) == mh_end(memtx_tuple_offset_external_map)) {
+		diag_set(OutOfMemory, sizeof(node), "mh_i64ptr_put",
+			 "external tuple offset");
+		return -1;
+	}
+	uintptr_t next = (uintptr_t)memtx_tuple_offset_external[slot];
+	assert((next & 1) != 0);
+	memtx_tuple_offset_external_free = next >> 1;
+	memtx_tuple_offset_external[slot] = tuple;
+	tuple->has_external_offset = true;
+	return 0;
+}
+
+uint32_t
+memtx_tuple_offset_lookup(struct tuple *tuple)
+{
+	assert(tuple->has_external_offset);
+	mh_int_t k = mh_i64ptr_find(memtx_tuple_offset_external_map,
+				    (uint64_t)(uintptr_t)tuple, NULL);
+	assert(k != mh_end(memtx_tuple_offset_external_map));
+	uint32_t slot = (uintptr_t)mh_i64ptr_node(
+		memtx_tuple_offset_external_map, k)->val;
+	return MEMTX_TUPLE_OFFSET_EXTERNAL + slot;
+}
+
+void
+memtx_tuple_offset_release(struct tuple *tuple)
+{
+	assert(tuple->has_external_offset);
+	mh_int_t k = mh_i64ptr_find(memtx_tuple_offset_external_map,
+				    (uint64_t)(uintptr_t)tuple, NULL);
+	assert(k != mh_end(memtx_tuple_offset_external_map));
+	uint32_t slot = (uintptr_t)mh_i64ptr_node(
+		memtx_tuple_offset_external_map, k)->val;
+	mh_i64ptr_del(memtx_tuple_offset_external_map, k, NULL);
+	memtx_tuple_offset_external[slot] = (struct tuple *)(uintptr_t)
+		(((uintptr_t)memtx_tuple_offset_external_free << 1) | 1);
+	memtx_tuple_offset_external_free = slot;
+	tuple->has_external_offset = false;
+}
+
+bool
+memtx_engine_arena_is_addressable(struct memtx_engine *memtx)
+{
+	return memtx_tuple_offset_base != NULL &&
+	       memtx->arena.prealloc <= memtx_tuple_offset_limit &&
+	       quota_total(&memtx->quota) <= memtx->arena.prealloc;
+}
+
 template <class ALLOC>
 static inline void
 create_memtx_tuple_format_vtab(struct tuple_format_vtab *vtab)
@@ -1610,6 +1938,22 @@ memtx_index_def_change_requires_rebuild(struct index *index,
 		return true;
 	if (old_def->opts.hint != new_def->opts.hint)
 		return true;
+	if (old_def->opts.normalized_keys != new_def->opts.normalized_keys)
+		return true;
+	if (old_def->opts.compact_pointers != new_def->opts.compact_pointers)
+		return true;
+	if (old_def->opts.block_size != new_def->opts.block_size)
+		return true;
+	if (old_def->opts.inline_prefix != new_def->opts.inline_prefix)
+		return true;
+	/*
+	 * Normalized keys depend on uniqueness (whether primary key
+	 * parts are included), field types, and nullability.
+	 */
+	bool is_normalized = new_def->opts.normalized_keys ||
+			     new_def->type == ART;
+	if (is_normalized && old_def->opts.is_unique != new_def->opts.is_unique)
+		return true;
 
 	const struct key_def *old_cmp_def, *new_cmp_def;
 	if (index_depends_on_pk(index)) {
@@ -1641,6 +1985,10 @@ memtx_index_def_change_requires_rebuild(struct index *index,
 			return true;
 		if (old_part->exclude_null != new_part->exclude_null)
 			return true;
+		if (is_normalized && (old_part->type != new_part->type ||
+				      key_part_is_nullable(old_part) !=
+				      key_part_is_nullable(new_part)))
+			return true;
 	}
 	assert(old_cmp_def->is_multikey == new_cmp_def->is_multikey);
 	return false;
@@ -38,6 +38,7 @@
 #include <small/mempool.h>
 
 #include "engine.h"
+#include "memtx_defrag.h"
 #include "xlog.h"
 #include "salad/stailq.h"
 #include "sysalloc.h"
@@ -118,7 +119,7 @@ enum memtx_reserve_extents_num {
  * allocated for each iterator (except rtree index iterator that
  * is significantly bigger so has own pool).
  */
-#define MEMTX_ITERATOR_SIZE (184)
+#define MEMTX_ITERATOR_SIZE (200)
 
 struct memtx_engine {
 	struct engine base;
@@ -165,6 +166,18 @@ struct memtx_engine {
 	size_t max_tuple_size;
 	/** Incremented with each next snapshot. */
 	uint32_t snapshot_version;
+	/**
+	 * Generation of the last set of read views published to
+	 * iproto threads, see memtx_net_read.h. Stored in tuples of
+	 * spaces with the iproto_read option on allocation.
+	 */
+	uint64_t net_read_generation;
+	/**
+	 * Number of tree indexes with compact pointers. While there's
+	 * at least one, memtx_memory can't be increased beyond the part
+	 * of the arena addressable by tuple offsets.
+	 */
+	uint32_t compact_index_count;
 	/**
 	 * Unless zero, freeing of tuples allocated before the last
 	 * call to memtx_enter_delayed_free_mode() is delayed until
@@ -193,6 +206,11 @@ struct memtx_engine {
 	 * Free mode, determines a strategy for freeing up memory
 	 */
 	enum memtx_engine_free_mode free_mode;
+	/**
+	 * Tuple arena defragmentation state. Defragmentation is
+	 * done by the garbage collection fiber.
+	 */
+	struct memtx_defrag defrag;
 };
 
 struct memtx_gc_task;
@@ -243,6 +261,30 @@ memtx_engine_set_memory(struct memtx_engine *memtx, size_t size);
 void
 memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size);
 
+/**
+ * Configure tuple arena defragmentation: a pass is started when the
+ * ratio of free memory in the tuple slabs exceeds threshold (0 disables
+ * defragmentation), at most rate tuples are checked per second.
+ */
+void
+memtx_engine_set_defrag(struct memtx_engine *memtx, double threshold,
+			double rate);
+
+/** Max number of NUMA nodes the memtx arena can be bound to. */
+enum { MEMTX_NUMA_NODES_MAX = 1024 };
+
+/**
+ * Set the memory policy of the memtx arena. If use_hugepages is set,
+ * the kernel is advised to back the preallocated arena memory with
+ * transparent huge pages. If numa_node isn't negative, the arena memory
+ * is bound to the given NUMA node. Should be called before the arena
+ * memory is touched, because already allocated pages aren't migrated.
+ * Failures are logged: the arena works without the policy then.
+ */
+void
+memtx_engine_set_arena_policy(struct memtx_engine *memtx, bool use_hugepages,
+			      int numa_node);
+
 /**
  * Enter tuple delayed free mode: tuple allocated before the call
  * won't be freed until memtx_leave_delayed_free_mode() is called.
@@ -289,6 +331,23 @@ extern struct tuple *
 (*memtx_tuple_new_raw)(struct tuple_format *format, const char *data,
 		       const char *end, bool validate);
 
+/**
+ * Free a memtx tuple the deletion of which was postponed by
+ * memtx_net_read_postpone_tuple_delete(). Respects the delayed
+ * free mode.
+ */
+extern void
+(*memtx_tuple_free)(struct tuple *tuple);
+
+/**
+ * Copy a memtx tuple to a new location, but only if the allocator
+ * places the copy at a lower address than the original. The copy has
+ * no references. Returns NULL if the tuple can't be moved down or the
+ * allocation fails. Doesn't set diag.
+ */
+extern struct tuple *
+(*memtx_tuple_move_down)(struct tuple *tuple);
+
 /**
  * Returns the size of an allocation done with memtx_alloc.
  * (The size is stored before the data.)
@@ -299,6 +358,86 @@ memtx_alloc_size(void *ptr)
 	return *((uint32_t *)ptr - 1);
 }
 
+/**
+ * Memtx tuples allocated from the memory preallocated for the memtx
+ * arena can be referenced by 32-bit offsets instead of pointers, see
+ * memtx_tuple_offset(). The base address is shifted by the size of
+ * the memtx tuple header so that a tuple allocated at the beginning
+ * of the arena has offset 0. It's NULL if memtx tuples aren't
+ * allocated from the arena, i.e. the system allocator is used.
+ */
+extern char *memtx_tuple_offset_base;
+/** Size of memory that can be addressed by tuple offsets. */
+extern size_t memtx_tuple_offset_limit;
+/** Tuple offset unit, binary logarithm of the allocation granularity. */
+extern unsigned memtx_tuple_offset_shift;
+
+/**
+ * Offsets starting from this one refer to tuples allocated outside of
+ * the arena, e.g. big tuples that don't fit in a slab. Such tuples are
+ * looked up in memtx_tuple_offset_external, see memtx_tuple_offset_reserve().
+ * Offsets of arena tuples are always less than this value.
+ */
+#define MEMTX_TUPLE_OFFSET_EXTERNAL (1U << 31)
+
+/**
+ * Tuples allocated outside of the arena that were assigned an offset,
+ * indexed by the offset minus MEMTX_TUPLE_OFFSET_EXTERNAL.
+ */
+extern struct tuple **memtx_tuple_offset_external;
+
+/**
+ * Make sure that a memtx tuple can be referenced by an offset. Tuples
+ * allocated from the arena always can. A tuple allocated outside of
+ * the arena is assigned an external offset, which is released when
+ * the tuple is freed. Returns -1 and sets diag on memory allocation
+ * error.
+ */
+int
+memtx_tuple_offset_reserve(struct tuple *tuple);
+
+/** Release the external offset assigned to a tuple being freed. */
+void
+memtx_tuple_offset_release(struct tuple *tuple);
+
+/** Look up the external offset assigned to a tuple. */
+uint32_t
+memtx_tuple_offset_lookup(struct tuple *tuple);
+
+/**
+ * Get the offset of a memtx tuple. The tuple must be allocated from
+ * the arena or passed to memtx_tuple_offset_reserve() before.
+ */
+static inline uint32_t
+memtx_tuple_offset(struct tuple *tuple)
+{
+	assert(memtx_tuple_offset_base != NULL);
+	uintptr_t pos = (uintptr_t)tuple - (uintptr_t)memtx_tuple_offset_base;
+	if (likely(pos < memtx_tuple_offset_limit &&
+		   (pos & ((1 << memtx_tuple_offset_shift) - 1)) == 0))
+		return pos >> memtx_tuple_offset_shift;
+	return memtx_tuple_offset_lookup(tuple);
+}
+
+/** Get a memtx tuple by its offset, see memtx_tuple_offset(). */
+static inline struct tuple *
+memtx_tuple_by_offset(uint32_t offset)
+{
+	if (unlikely(offset >= MEMTX_TUPLE_OFFSET_EXTERNAL))
+		return memtx_tuple_offset_external[offset -
+						   MEMTX_TUPLE_OFFSET_EXTERNAL];
+	return (struct tuple *)(memtx_tuple_offset_base +
+				((uintptr_t)offset << memtx_tuple_offset_shift));
+}
+
+/**
+ * Return true if all tuples allocated from the memtx arena can be
+ * referenced by offsets without using external offsets, which is
+ * required by tree indexes with compact pointers.
+ */
+bool
+memtx_engine_arena_is_addressable(struct memtx_engine *memtx);
+
 /**
  * Allocate a block of size MEMTX_EXTENT_SIZE for memtx index
  * @ctx must point to memtx engine
@@ -79,6 +79,11 @@ struct memtx_hash_index {
 	struct light_index_core hash_table;
 	struct memtx_gc_task gc_task;
 	struct light_index_iterator gc_iterator;
+	/**
+	 * Incremented on each modification of the hash table.
+	 * Used to find out if a read view is outdated.
+	 */
+	uint64_t version;
 };
 
 /* {{{ MemtxHash Iterators ****************************************/
@@ -353,6 +358,7 @@ memtx_hash_index_replace(struct index *base, struct tuple *old_tuple,
 
 	/* HASH index doesn't support ordering. */
 	*successor = NULL;
+	index->version++;
 
 	if (new_tuple) {
 		uint32_t h = tuple_hash(new_tuple, base->def->key_def);
@@ -564,6 +570,55 @@ memtx_hash_index_create_snapshot_iterator(struct index *base)
 	return (struct snapshot_iterator *) it;
 }
 
+/* {{{ MemtxHash read view ****************************************/
+
+struct memtx_hash_read_view {
+	struct memtx_hash_index *index;
+	struct light_index_view view;
+	/** Version of the index at the time of the view creation. */
+	uint64_t version;
+};
+
+struct memtx_hash_read_view *
+memtx_hash_read_view_new(struct index *base)
+{
+	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
+	struct memtx_hash_read_view *rv = (struct memtx_hash_read_view *)
+		xmalloc(sizeof(*rv));
+	rv->index = index;
+	rv->version = index->version;
+	index_ref(base);
+	light_index_view_create(&index->hash_table, &rv->view);
+	return rv;
+}
+
+void
+memtx_hash_read_view_delete(struct memtx_hash_read_view *rv)
+{
+	light_index_view_destroy(&rv->index->hash_table, &rv->view);
+	index_unref(&rv->index->base);
+	free(rv);
+}
+
+bool
+memtx_hash_read_view_is_outdated(struct memtx_hash_read_view *rv)
+{
+	return rv->version != rv->index->version;
+}
+
+struct tuple *
+memtx_hash_read_view_get(struct memtx_hash_read_view *rv,
+			 struct key_def *key_def, const char *key)
+{
+	uint32_t h = key_hash(key, key_def);
+	struct tuple **res = light_index_view_find_key(&rv->index->hash_table,
+						       &rv->view, h, key,
+						       key_def);
+	return res != NULL ? *res : NULL;
+}
+
+/* }}} */
+
 /**
  * Get index vtab by @a UNCHANGED, template version.
  * If UNCHANGED == true iterator->next and index->get
@@ -37,7 +37,10 @@ extern "C" {
 
 struct index;
 struct index_def;
+struct key_def;
 struct memtx_engine;
+struct memtx_hash_read_view;
+struct tuple;
 
 struct index *
 memtx_hash_index_new(struct memtx_engine *memtx, struct index_def *def);
@@ -51,6 +54,42 @@ memtx_hash_index_new(struct memtx_engine *memtx, struct index_def *def);
 void
 memtx_hash_index_set_vtab(struct index *index, bool unchanged);
 
+/**
+ * Create a read view of a hash index. Lookups in the view may be
+ * done from any thread, but the view must be created and deleted
+ * in the tx thread. The caller is responsible for keeping tuples
+ * stored in the view alive until it is deleted.
+ *
+ * Never fails.
+ */
+struct memtx_hash_read_view *
+memtx_hash_read_view_new(struct index *index);
+
+/** Delete a read view created with memtx_hash_read_view_new(). */
+void
+memtx_hash_read_view_delete(struct memtx_hash_read_view *rv);
+
+/**
+ * Return true if the index was modified after the read view
+ * creation.
+ */
+bool
+memtx_hash_read_view_is_outdated(struct memtx_hash_read_view *rv);
+
+/**
+ * Look up a tuple by a full key in a read view. Thread-safe
+ * provided @a key_def isn't used by other threads concurrently:
+ * comparators cache field offsets in key parts.
+ *
+ * @param rv Read view.
+ * @param key_def Copy of the index key definition.
+ * @param key MsgPack key parts, without the array header.
+ * @retval Found tuple or NULL.
+ */
+struct tuple *
+memtx_hash_read_view_get(struct memtx_hash_read_view *rv,
+			 struct key_def *key_def, const char *key);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -0,0 +1,625 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "memtx_net_read.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "diag.h"
+#include "fiber.h"
+#include "index.h"
+#include "key_def.h"
+#include "memtx_engine.h"
+#include "memtx_hash.h"
+#include "memtx_space.h"
+#include "memtx_tx.h"
+#include "msgpuck.h"
+#include "schema.h"
+#include "space.h"
+#include "tuple.h"
+#include "user.h"
+#include "salad/stailq.h"
+#include "trivia/util.h"
+
+/**
+ * How long to wait before checking if retired tables can be
+ * reclaimed if the tx thread has nothing else to do, in seconds.
+ */
+static const double MEMTX_NET_READ_RECLAIM_TIMEOUT = 0.001;
+
+/**
+ * Read view of the primary key of a published space. Shared by
+ * consecutive tables until the index is modified.
+ */
+struct memtx_net_read_view {
+	/** Number of tables using the view. */
+	uint32_t refs;
+	struct memtx_hash_read_view *rv;
+};
+
+/**
+ * Copies of the primary key definition of a published space, one
+ * per iproto thread, because comparators cache field offsets in
+ * key parts. Shared by consecutive tables until the schema changes.
+ */
+struct memtx_net_read_key_defs {
+	/** Number of tables using the key definitions. */
+	uint32_t refs;
+	struct key_def *defs[0];
+};
+
+/** Primary key of a space published to iproto threads. */
+struct memtx_net_read_space {
+	uint32_t space_id;
+	/**
+	 * Bitmap of authentication tokens of users that have read
+	 * access to the space.
+	 */
+	uint32_t readers;
+	struct memtx_net_read_view *view;
+	struct memtx_net_read_key_defs *key_defs;
+};
+
+/**
+ * A consistent set of read views published to iproto threads.
+ * Immutable once published.
+ */
+struct memtx_net_read_table {
+	/** Sequence number of the table, see net_read.generation. */
+	uint64_t generation;
+	/** Schema version at the time of the table creation. */
+	uint32_t schema_version;
+	/**
+	 * Ids of users that owned authentication tokens at the time
+	 * of the table creation, used to find out if a token cached
+	 * by a connection has been reused by another user.
+	 */
+	uint32_t token_uids[BOX_USER_MAX];
+	/**
+	 * Value of the global epoch at the time the table was
+	 * replaced with a newer one.
+	 */
+	uint64_t retire_epoch;
+	/** Link in the list of retired tables. */
+	struct stailq_entry in_retired;
+	/**
+	 * Tuples deleted in tx while the table was current. Freed
+	 * when the table is reclaimed.
+	 */
+	struct tuple **garbage;
+	uint32_t garbage_count;
+	uint32_t garbage_capacity;
+	/** Published spaces, sorted by id. */
+	uint32_t space_count;
+	struct memtx_net_read_space spaces[0];
+};
+
+/** State of an iproto thread. Accessed by tx, too. */
+struct memtx_net_read_reader {
+	/**
+	 * Value of the global epoch when the thread entered the
+	 * read section or 0 if it isn't in the read section.
+	 */
+	alignas(CACHELINE_SIZE) uint64_t epoch;
+	/**
+	 * Table used by the thread in the current read section.
+	 * Accessed only by the owner thread.
+	 */
+	struct memtx_net_read_table *table;
+};
+
+static struct {
+	/** Iproto threads. */
+	struct memtx_net_read_reader *readers;
+	int reader_count;
+	/**
+	 * Global epoch. Incremented by tx each time it replaces
+	 * the current table. Never 0.
+	 */
+	uint64_t epoch;
+	/**
+	 * Incremented each time tx publishes changes. Used to make
+	 * sure that a request isn't served from a table that doesn't
+	 * reflect changes made by preceding requests of the same
+	 * connection.
+	 */
+	uint64_t generation;
+	/** Current table or NULL if there are no published spaces. */
+	struct memtx_net_read_table *current;
+	/** Tables that may still be in use, oldest first. */
+	struct stailq retired;
+	/** Ids of spaces eligible for publishing. */
+	uint32_t *space_ids;
+	uint32_t space_count;
+	/** Schema version when space_ids was last updated. */
+	uint32_t schema_version;
+	/** User access version at the time of the last publish. */
+	uint32_t user_access_version;
+	/** Publishes and reclaims tables at the end of each iteration. */
+	struct ev_prepare prepare;
+	/** Wakes up tx to reclaim retired tables. */
+	struct ev_timer timer;
+} net_read;
+
+/**
+ * Check if a space can be read from iproto threads: the user
+ * requested it, and lookups in the primary key don't need
+ * anything that isn't thread-safe.
+ */
+static bool
+memtx_net_read_space_is_eligible(struct space *space)
+{
+	if (!space->def->opts.iproto_read || !space_is_memtx(space))
+		return false;
+	struct index *pk = space_index(space, 0);
+	if (pk == NULL || pk->def->type != HASH)
+		return false;
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	if (memtx_space->compressed_tuples != 0 ||
+	    space->format->is_compressed)
+		return false;
+	struct key_def *def = pk->def->key_def;
+	return !def->has_json_paths && !def->is_nullable &&
+	       !key_def_has_collation(def);
+}
+
+static int
+memtx_net_read_collect_space(struct space *space, void *arg)
+{
+	(void)arg;
+	if (!space->def->opts.iproto_read)
+		return 0;
+	net_read.space_ids = (uint32_t *)xrealloc(net_read.space_ids,
+		(net_read.space_count + 1) * sizeof(*net_read.space_ids));
+	net_read.space_ids[net_read.space_count++] = space->def->id;
+	return 0;
+}
+
+static int
+memtx_net_read_cmp_space_id(const void *a, const void *b)
+{
+	uint32_t id_a = *(const uint32_t *)a;
+	uint32_t id_b = *(const uint32_t *)b;
+	return id_a < id_b ? -1 : id_a > id_b;
+}
+
+/**
+ * Update the list of spaces created with the iproto_read option
+ * if the schema has changed.
+ */
+static int
+memtx_net_read_update_space_ids(void)
+{
+	if (net_read.schema_version == schema_version)
+		return 0;
+	net_read.space_count = 0;
+	if (space_foreach(memtx_net_read_collect_space, NULL) != 0)
+		return -1;
+	qsort(net_read.space_ids, net_read.space_count,
+	      sizeof(*net_read.space_ids), memtx_net_read_cmp_space_id);
+	net_read.schema_version = schema_version;
+	return 0;
+}
+
+/** Compute the bitmap of tokens of users that can read a space. */
+static uint32_t
+memtx_net_read_space_readers(struct space *space)
+{
+	uint32_t readers = 0;
+	for (uint8_t token = 0; token < BOX_USER_MAX; token++) {
+		struct user *user = user_find_by_token(token);
+		if (user->def == NULL)
+			continue;
+		struct credentials cr;
+		cr.auth_token = token;
+		cr.universal_access = universe.access[token].effective;
+		cr.uid = user->def->uid;
+		if (space_access_is_granted(space, &cr, PRIV_R))
+			readers |= 1U << token;
+	}
+	return readers;
+}
+
+static struct memtx_net_read_view *
+memtx_net_read_view_new(struct index *pk)
+{
+	struct memtx_net_read_view *view = (struct memtx_net_read_view *)
+		xmalloc(sizeof(*view));
+	view->refs = 1;
+	view->rv = memtx_hash_read_view_new(pk);
+	return view;
+}
+
+static void
+memtx_net_read_view_unref(struct memtx_net_read_view *view)
+{
+	assert(view->refs > 0);
+	if (--view->refs > 0)
+		return;
+	memtx_hash_read_view_delete(view->rv);
+	free(view);
+}
+
+static struct memtx_net_read_key_defs *
+memtx_net_read_key_defs_new(struct index *pk)
+{
+	struct memtx_net_read_key_defs *key_defs =
+		(struct memtx_net_read_key_defs *)xmalloc(sizeof(*key_defs) +
+			net_read.reader_count * sizeof(key_defs->defs[0]));
+	key_defs->refs = 1;
+	for (int i = 0; i < net_read.reader_count; i++)
+		key_defs->defs[i] = key_def_dup(pk->def->key_def);
+	return key_defs;
+}
+
+static void
+memtx_net_read_key_defs_unref(struct memtx_net_read_key_defs *key_defs)
+{
+	assert(key_defs->refs > 0);
+	if (--key_defs->refs > 0)
+		return;
+	for (int i = 0; i < net_read.reader_count; i++)
+		key_def_delete(key_defs->defs[i]);
+	free(key_defs);
+}
+
+/** Binary search for a space in a table. */
+static struct memtx_net_read_space *
+memtx_net_read_table_find(struct memtx_net_read_table *table,
+			  uint32_t space_id)
+{
+	uint32_t begin = 0, end = table->space_count;
+	while (begin < end) {
+		uint32_t mid = begin + (end - begin) / 2;
+		struct memtx_net_read_space *entry = &table->spaces[mid];
+		if (entry->space_id == space_id)
+			return entry;
+		if (entry->space_id < space_id)
+			begin = mid + 1;
+		else
+			end = mid;
+	}
+	return NULL;
+}
+
+/**
+ * Create a table of read views of all eligible spaces. Entries of
+ * @a old_table (may be NULL) that are still valid are reused: the
+ * key definitions unless the schema has changed, the access bitmaps
+ * unless user privileges have changed, and the read views unless
+ * the indexes have been modified. So publishing a change of one
+ * space costs a new read view of this space only.
+ */
+static struct memtx_net_read_table *
+memtx_net_read_table_new(struct memtx_net_read_table *old_table)
+{
+	bool schema_changed = old_table == NULL ||
+			      old_table->schema_version != schema_version;
+	bool access_changed = schema_changed ||
+			      net_read.user_access_version !=
+			      user_access_version;
+	struct memtx_net_read_table *table = (struct memtx_net_read_table *)
+		xmalloc(sizeof(*table) + net_read.space_count *
+			sizeof(struct memtx_net_read_space));
+	table->schema_version = schema_version;
+	for (uint8_t token = 0; token < BOX_USER_MAX; token++) {
+		struct user *user = user_find_by_token(token);
+		table->token_uids[token] = user->def != NULL ?
+					   user->def->uid : BOX_ID_NIL;
+	}
+	table->generation = 0;
+	table->retire_epoch = 0;
+	table->garbage = NULL;
+	table->garbage_count = 0;
+	table->garbage_capacity = 0;
+	table->space_count = 0;
+	for (uint32_t i = 0; i < net_read.space_count; i++) {
+		struct space *space = space_by_id(net_read.space_ids[i]);
+		if (space == NULL || !memtx_net_read_space_is_eligible(space))
+			continue;
+		struct index *pk = space_index(space, 0);
+		struct memtx_net_read_space *old_entry = schema_changed ? NULL :
+			memtx_net_read_table_find(old_table, space->def->id);
+		struct memtx_net_read_space *entry =
+			&table->spaces[table->space_count++];
+		entry->space_id = space->def->id;
+		if (old_entry == NULL) {
+			entry->readers = memtx_net_read_space_readers(space);
+			entry->view = memtx_net_read_view_new(pk);
+			entry->key_defs = memtx_net_read_key_defs_new(pk);
+			continue;
+		}
+		entry->readers = access_changed ?
+				 memtx_net_read_space_readers(space) :
+				 old_entry->readers;
+		if (memtx_hash_read_view_is_outdated(old_entry->view->rv)) {
+			entry->view = memtx_net_read_view_new(pk);
+		} else {
+			entry->view = old_entry->view;
+			entry->view->refs++;
+		}
+		entry->key_defs = old_entry->key_defs;
+		entry->key_defs->refs++;
+	}
+	return table;
+}
+
+/** Destroy a table and free tuples deleted while it was current. */
+static void
+memtx_net_read_table_delete(struct memtx_net_read_table *table)
+{
+	for (uint32_t i = 0; i < table->space_count; i++) {
+		struct memtx_net_read_space *entry = &table->spaces[i];
+		memtx_net_read_view_unref(entry->view);
+		memtx_net_read_key_defs_unref(entry->key_defs);
+	}
+	for (uint32_t i = 0; i < table->garbage_count; i++)
+		memtx_tuple_free(table->garbage[i]);
+	free(table->garbage);
+	free(table);
+}
+
+/**
+ * Check if the current table doesn't reflect changes made in tx:
+ * the schema or user privileges have changed or any of published
+ * indexes has been modified.
+ */
+static bool
+memtx_net_read_is_outdated(void)
+{
+	struct memtx_net_read_table *table = net_read.current;
+	if (table == NULL)
+		return net_read.schema_version != schema_version;
+	if (table->schema_version != schema_version ||
+	    net_read.user_access_version != user_access_version)
+		return true;
+	for (uint32_t i = 0; i < table->space_count; i++) {
+		if (memtx_hash_read_view_is_outdated(table->spaces[i].view->rv))
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Replace the current table with a new one if it's outdated or
+ * has garbage to free. The old table is retired.
+ */
+static void
+memtx_net_read_publish(void)
+{
+	struct memtx_net_read_table *old_table = net_read.current;
+	if (!memtx_net_read_is_outdated() &&
+	    (old_table == NULL || old_table->garbage_count == 0))
+		return;
+	struct memtx_engine *memtx =
+		(struct memtx_engine *)engine_by_name("memtx");
+	if (memtx == NULL || memtx->state != MEMTX_OK)
+		return;
+	if (memtx_net_read_update_space_ids() != 0) {
+		diag_log();
+		diag_clear(diag_get());
+		return;
+	}
+	struct memtx_net_read_table *new_table = NULL;
+	if (!memtx_tx_manager_use_mvcc_engine && net_read.space_count > 0)
+		new_table = memtx_net_read_table_new(old_table);
+	net_read.user_access_version = user_access_version;
+	net_read.generation++;
+	if (new_table == NULL && old_table == NULL)
+		return;
+	if (new_table != NULL) {
+		new_table->generation = net_read.generation;
+		/*
+		 * Tuples allocated after this point can't be accessed
+		 * from iproto threads so there's no need to postpone
+		 * their deletion, see memtx_tuple_delete().
+		 */
+		memtx->net_read_generation = net_read.generation;
+	}
+	__atomic_store_n(&net_read.current, new_table, __ATOMIC_SEQ_CST);
+	if (old_table != NULL) {
+		old_table->retire_epoch = net_read.epoch;
+		__atomic_store_n(&net_read.epoch, net_read.epoch + 1,
+				 __ATOMIC_SEQ_CST);
+		stailq_add_tail_entry(&net_read.retired, old_table,
+				      in_retired);
+	}
+}
+
+/**
+ * Check if none of iproto threads may be using a table retired
+ * at the given epoch.
+ */
+static bool
+memtx_net_read_can_reclaim(uint64_t retire_epoch)
+{
+	for (int i = 0; i < net_read.reader_count; i++) {
+		uint64_t epoch = __atomic_load_n(&net_read.readers[i].epoch,
+						 __ATOMIC_SEQ_CST);
+		if (epoch != 0 && epoch <= retire_epoch)
+			return false;
+	}
+	return true;
+}
+
+/** Delete retired tables that aren't used by iproto threads. */
+static void
+memtx_net_read_reclaim(void)
+{
+	while (!stailq_empty(&net_read.retired)) {
+		struct memtx_net_read_table *table =
+			stailq_first_entry(&net_read.retired,
+					   struct memtx_net_read_table,
+					   in_retired);
+		if (!memtx_net_read_can_reclaim(table->retire_epoch))
+			break;
+		stailq_shift(&net_read.retired);
+		memtx_net_read_table_delete(table);
+	}
+}
+
+static void
+memtx_net_read_on_prepare(ev_loop *loop, struct ev_prepare *watcher,
+			  int revents)
+{
+	(void)watcher;
+	(void)revents;
+	memtx_net_read_publish();
+	memtx_net_read_reclaim();
+	if (!stailq_empty(&net_read.retired) &&
+	    !ev_is_active(&net_read.timer)) {
+		ev_timer_set(&net_read.timer, MEMTX_NET_READ_RECLAIM_TIMEOUT,
+			     0);
+		ev_timer_start(loop, &net_read.timer);
+	}
+}
+
+static void
+memtx_net_read_on_timer(ev_loop *loop, struct ev_timer *watcher,
+			int revents)
+{
+	/* Retired tables are reclaimed by the prepare watcher. */
+	(void)loop;
+	(void)watcher;
+	(void)revents;
+}
+
+void
+memtx_net_read_init(int reader_count)
+{
+	net_read.readers = (struct memtx_net_read_reader *)
+		xcalloc(reader_count, sizeof(*net_read.readers));
+	net_read.reader_count = reader_count;
+	net_read.epoch = 1;
+	net_read.generation = 0;
+	net_read.current = NULL;
+	stailq_create(&net_read.retired);
+	net_read.space_ids = NULL;
+	net_read.space_count = 0;
+	/* The schema version is 0 only before bootstrap. */
+	net_read.schema_version = 0;
+	net_read.user_access_version = 0;
+	ev_prepare_init(&net_read.prepare, memtx_net_read_on_prepare);
+	ev_prepare_start(loop(), &net_read.prepare);
+	ev_timer_init(&net_read.timer, memtx_net_read_on_timer, 0, 0);
+}
+
+void
+memtx_net_read_free(void)
+{
+	ev_prepare_stop(loop(), &net_read.prepare);
+	ev_timer_stop(loop(), &net_read.timer);
+	if (net_read.current != NULL) {
+		stailq_add_tail_entry(&net_read.retired, net_read.current,
+				      in_retired);
+		net_read.current = NULL;
+	}
+	while (!stailq_empty(&net_read.retired)) {
+		struct memtx_net_read_table *table =
+			stailq_shift_entry(&net_read.retired,
+					   struct memtx_net_read_table,
+					   in_retired);
+		memtx_net_read_table_delete(table);
+	}
+	free(net_read.space_ids);
+	net_read.space_ids = NULL;
+	free(net_read.readers);
+	net_read.readers = NULL;
+	net_read.reader_count = 0;
+}
+
+uint64_t
+memtx_net_read_min_generation(void)
+{
+	return net_read.generation + (memtx_net_read_is_outdated() ? 1 : 0);
+}
+
+bool
+memtx_net_read_postpone_tuple_delete(struct tuple *tuple, uint64_t generation)
+{
+	struct memtx_net_read_table *table = net_read.current;
+	if (table == NULL) {
+		/*
+		 * The tuple may still be accessed through the last
+		 * retired table.
+		 */
+		if (stailq_empty(&net_read.retired))
+			return false;
+		table = stailq_last_entry(&net_read.retired,
+					  struct memtx_net_read_table,
+					  in_retired);
+	}
+	/* The tuple was allocated after the table was published. */
+	if (generation >= table->generation)
+		return false;
+	if (table->garbage_count == table->garbage_capacity) {
+		table->garbage_capacity = MAX(table->garbage_capacity * 2,
+					      (uint32_t)16);
+		table->garbage = (struct tuple **)xrealloc(table->garbage,
+			table->garbage_capacity * sizeof(*table->garbage));
+	}
+	table->garbage[table->garbage_count++] = tuple;
+	return true;
+}
+
+void
+memtx_net_read_begin(int reader_id)
+{
+	assert(reader_id < net_read.reader_count);
+	struct memtx_net_read_reader *reader = &net_read.readers[reader_id];
+	assert(reader->epoch == 0);
+	/*
+	 * The order is important: tx must see the epoch before we
+	 * load the table, otherwise it may reclaim the table while
+	 * we're using it.
+	 */
+	__atomic_store_n(&reader->epoch,
+			 __atomic_load_n(&net_read.epoch, __ATOMIC_SEQ_CST),
+			 __ATOMIC_SEQ_CST);
+	reader->table = __atomic_load_n(&net_read.current, __ATOMIC_SEQ_CST);
+}
+
+void
+memtx_net_read_end(int reader_id)
+{
+	assert(reader_id < net_read.reader_count);
+	struct memtx_net_read_reader *reader = &net_read.readers[reader_id];
+	assert(reader->epoch != 0);
+	reader->table = NULL;
+	__atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+}
+
+int
+memtx_net_read_get(int reader_id, uint64_t min_generation,
+		   uint8_t auth_token, uint32_t uid, uint32_t space_id,
+		   const char *key, uint32_t *schema_version,
+		   struct tuple **result)
+{
+	struct memtx_net_read_table *table =
+		net_read.readers[reader_id].table;
+	if (table == NULL || table->generation < min_generation ||
+	    auth_token >= BOX_USER_MAX ||
+	    table->token_uids[auth_token] != uid)
+		return -1;
+	struct memtx_net_read_space *entry =
+		memtx_net_read_table_find(table, space_id);
+	if (entry == NULL || (entry->readers & (1U << auth_token)) == 0)
+		return -1;
+	struct key_def *key_def = entry->key_defs->defs[reader_id];
+	if (key == NULL || mp_typeof(*key) != MP_ARRAY)
+		return -1;
+	uint32_t part_count = mp_decode_array(&key);
+	const char *key_end;
+	if (part_count != key_def->part_count ||
+	    key_validate_parts(key_def, key, part_count, false,
+			       &key_end) != 0) {
+		diag_clear(diag_get());
+		return -1;
+	}
+	*schema_version = table->schema_version;
+	*result = memtx_hash_read_view_get(entry->view->rv, key_def, key);
+	return 0;
+}
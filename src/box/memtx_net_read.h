@@ -0,0 +1,109 @@
+#pragma once
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct tuple;
+
+/**
+ * Lookups in memtx spaces done right in iproto threads.
+ *
+ * Primary keys of memtx spaces created with the iproto_read option
+ * are published to iproto threads as hash index read views (see
+ * memtx_hash_read_view_new()). A new set of read views is published
+ * at the end of each tx event loop iteration during which any of
+ * the published indexes was modified, so a lookup in an iproto
+ * thread may miss changes made during the current iteration only.
+ *
+ * A replaced set of read views is destroyed when all iproto threads
+ * that could have seen it leave the read section (epoch-based
+ * reclamation). Tuples deleted in tx while they may be accessed in
+ * iproto threads aren't freed until then, see
+ * memtx_net_read_postpone_tuple_delete().
+ */
+
+/**
+ * Initialize the subsystem for @a reader_count iproto threads.
+ * Must be called in the tx thread before the threads are started.
+ */
+void
+memtx_net_read_init(int reader_count);
+
+/**
+ * Free the subsystem. Must be called in the tx thread after all
+ * iproto threads are stopped.
+ */
+void
+memtx_net_read_free(void);
+
+/**
+ * Postpone deletion of a memtx tuple until it can't be accessed
+ * from iproto threads. @a generation is the generation of the last
+ * published set of read views at the time of the tuple allocation
+ * (memtx_engine::net_read_generation). Returns false if there are
+ * no published read views or the tuple was allocated after the last
+ * of them was published, in which case the tuple may be freed
+ * immediately. The tuple is freed with memtx_tuple_free(). Called in
+ * tx for tuples of formats with tuple_format::is_net_readable set.
+ */
+bool
+memtx_net_read_postpone_tuple_delete(struct tuple *tuple, uint64_t generation);
+
+/**
+ * Return the generation of the first set of read views that will
+ * reflect all changes made in tx so far. Called in tx upon request
+ * completion. Passing the value to memtx_net_read_get() guarantees
+ * that a client sees the results of its own requests.
+ */
+uint64_t
+memtx_net_read_min_generation(void);
+
+/**
+ * Enter a read section in iproto thread @a reader_id. Tuples
+ * returned by memtx_net_read_get() may only be accessed until
+ * memtx_net_read_end() is called.
+ */
+void
+memtx_net_read_begin(int reader_id);
+
+/** Leave a read section in iproto thread @a reader_id. */
+void
+memtx_net_read_end(int reader_id);
+
+/**
+ * Look up a tuple in the primary key of a published space.
+ * Must be called in a read section.
+ *
+ * @param reader_id Iproto thread id.
+ * @param min_generation Minimal generation of the read views, see
+ *                       memtx_net_read_min_generation().
+ * @param auth_token Authentication token of the session user.
+ * @param uid Id of the session user.
+ * @param space_id Space id.
+ * @param key MsgPack array of key parts.
+ * @param[out] schema_version Schema version of the read view.
+ * @param[out] result Found tuple or NULL.
+ *
+ * @retval 0 Success.
+ * @retval -1 The request must be processed in tx: the space isn't
+ *            published, the read views are too old, the user may
+ *            lack read access to the space, or the key isn't a
+ *            valid full key. Diag isn't set.
+ */
+int
+memtx_net_read_get(int reader_id, uint64_t min_generation,
+		   uint8_t auth_token, uint32_t uid, uint32_t space_id,
+		   const char *key, uint32_t *schema_version,
+		   struct tuple **result);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
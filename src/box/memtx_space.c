@@ -37,6 +37,7 @@
 #include "xrow_update.h"
 #include "xrow.h"
 #include "memtx_hash.h"
+#include "memtx_art.h"
 #include "memtx_tree.h"
 #include "memtx_rtree.h"
 #include "memtx_bitset.h"
@@ -44,6 +45,7 @@
 #include "column_mask.h"
 #include "sequence.h"
 #include "memtx_tuple_compression.h"
+#include "normalized_key.h"
 #include "schema.h"
 
 /*
@@ -723,13 +725,91 @@ memtx_space_check_index_def(struct space *space, struct index_def *index_def)
 {
 	struct key_def *key_def = index_def->key_def;
 
+	if (index_def->opts.ttl != 0) {
+		diag_set(ClientError, ER_MODIFY_INDEX,
+			 index_def->name, space_name(space),
+			 "ttl is only supported by vinyl");
+		return -1;
+	}
+	if (index_def->opts.normalized_keys) {
+		const char *err = NULL;
+		if (index_def->type != TREE)
+			err = "normalized keys are only supported by TREE index";
+		else if (key_def->is_multikey)
+			err = "multikey index can't use normalized keys";
+		else if (key_def->for_func_index)
+			err = "functional index can't use normalized keys";
+		/* Primary key parts are normalized, too. */
+		struct key_def *cmp_def = index_def->cmp_def;
+		for (uint32_t i = 0; err == NULL && i < cmp_def->part_count;
+		     i++) {
+			struct key_part *part = &cmp_def->parts[i];
+			if (!key_part_is_normalizable(part)) {
+				err = tt_sprintf("field type '%s' is not "
+						 "supported by normalized keys",
+						 field_type_strs[part->type]);
+			}
+		}
+		if (err != NULL) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space), err);
+			return -1;
+		}
+	}
+	if (index_def->opts.compact_pointers) {
+		const char *err = NULL;
+		if (index_def->type != TREE)
+			err = "compact pointers are only supported by TREE index";
+		else if (key_def->is_multikey)
+			err = "multikey index can't use compact pointers";
+		else if (key_def->for_func_index)
+			err = "functional index can't use compact pointers";
+		else if (index_def->opts.normalized_keys)
+			err = "index with normalized keys can't use compact "
+			      "pointers";
+		else if (memtx_tuple_offset_base == NULL)
+			err = "compact pointers require the small allocator";
+		else if (!memtx_engine_arena_is_addressable(
+				(struct memtx_engine *)space->engine))
+			err = "compact pointers require memtx_memory to be "
+			      "addressable by 32-bit offsets";
+		if (err != NULL) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space), err);
+			return -1;
+		}
+	}
+	if (index_def->opts.block_size != MEMTX_TREE_BLOCK_SIZE_DEFAULT) {
+		const char *err = NULL;
+		if (index_def->type != TREE)
+			err = "block size is only supported by TREE index";
+		else if (key_def->is_multikey)
+			err = "multikey index can't change block size";
+		else if (key_def->for_func_index)
+			err = "functional index can't change block size";
+		else if (!memtx_tree_block_size_is_valid(
+				index_def->opts.block_size))
+			err = "block size must be 512, 1024 or 2048";
+		if (err != NULL) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space), err);
+			return -1;
+		}
+	}
+	if (index_def->opts.inline_prefix &&
+	    !index_def->opts.normalized_keys) {
+		diag_set(ClientError, ER_MODIFY_INDEX,
+			 index_def->name, space_name(space),
+			 "inline prefix requires normalized keys");
+		return -1;
+	}
 	if (key_def->is_nullable) {
 		if (index_def->iid == 0) {
 			diag_set(ClientError, ER_NULLABLE_PRIMARY,
 				 space_name(space));
 			return -1;
 		}
-		if (index_def->type != TREE) {
+		if (index_def->type != TREE && index_def->type != ART) {
 			diag_set(ClientError, ER_UNSUPPORTED,
 				 index_type_strs[index_def->type],
 				 "nullable parts");
@@ -829,6 +909,32 @@ memtx_space_check_index_def(struct space *space, struct index_def *index_def)
 		}
 		/* no furter checks of parts needed */
 		return 0;
+	case ART:
+		if (key_def->is_multikey) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space),
+				 "ART index cannot be multikey");
+			return -1;
+		}
+		if (key_def->for_func_index) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space),
+				 "ART index can not use a function");
+			return -1;
+		}
+		/* Primary key parts are indexed, too. */
+		for (uint32_t i = 0; i < index_def->cmp_def->part_count; i++) {
+			struct key_part *part = &index_def->cmp_def->parts[i];
+			if (!key_part_is_normalizable(part)) {
+				diag_set(ClientError, ER_MODIFY_INDEX,
+					 index_def->name, space_name(space),
+					 tt_sprintf("field type '%s' is not "
+						    "supported by ART index",
+						    field_type_strs[part->type]));
+				return -1;
+			}
+		}
+		return 0;
 	default:
 		diag_set(ClientError, ER_INDEX_TYPE,
 			 index_def->name, space_name(space));
@@ -902,6 +1008,8 @@ memtx_space_update_index_vtab(struct space *space, struct index *index)
 		return memtx_rtree_index_set_vtab(index, unchanged);
 	case BITSET:
 		return memtx_bitset_index_set_vtab(index, unchanged);
+	case ART:
+		return memtx_art_index_set_vtab(index, unchanged);
 	default:
 		unreachable();
 	}
@@ -937,6 +1045,9 @@ memtx_space_create_index(struct space *space, struct index_def *index_def)
 	case BITSET:
 		index = memtx_bitset_index_new(memtx, index_def);
 		break;
+	case ART:
+		index = memtx_art_index_new(memtx, index_def);
+		break;
 	default:
 		unreachable();
 		return NULL;
@@ -1414,6 +1525,18 @@ memtx_space_prepare_alter(struct space *old_space, struct space *new_space)
 			 "can not switch temporary flag on a non-empty space");
 		return -1;
 	}
+	/*
+	 * Tuples of a space without the iproto_read option are freed
+	 * without checking if they are accessed from iproto threads,
+	 * see memtx_tuple_delete().
+	 */
+	if (old_memtx_space->bsize != 0 &&
+	    !old_space->def->opts.iproto_read &&
+	    new_space->def->opts.iproto_read) {
+		diag_set(ClientError, ER_ALTER_SPACE, old_space->def->name,
+			 "can not enable iproto_read on a non-empty space");
+		return -1;
+	}
 
 	new_memtx_space->replace = old_memtx_space->replace;
 	new_memtx_space->bsize = old_memtx_space->bsize;
@@ -1450,6 +1573,19 @@ struct space *
 memtx_space_new(struct memtx_engine *memtx,
 		struct space_def *def, struct rlist *key_list)
 {
+	/*
+	 * Hash functions hash integers as they are encoded in MsgPack
+	 * so they don't work with integers stored in the fixed layout.
+	 */
+	struct index_def *index_def;
+	rlist_foreach_entry(index_def, key_list, link) {
+		if (def->opts.fixed_layout && index_def->type == HASH) {
+			diag_set(ClientError, ER_ALTER_SPACE, def->name,
+				 "fixed_layout can't be used with HASH index");
+			return NULL;
+		}
+	}
+
 	struct memtx_space *memtx_space = malloc(sizeof(*memtx_space));
 	if (memtx_space == NULL) {
 		diag_set(OutOfMemory, sizeof(*memtx_space),
@@ -1468,11 +1604,13 @@ memtx_space_new(struct memtx_engine *memtx,
 		tuple_format_new(&memtx_tuple_format_vtab, memtx, keys, key_count,
 				 def->fields, def->field_count,
 				 def->exact_field_count, def->dict,
-				 def->opts.is_temporary, def->opts.is_ephemeral);
+				 def->opts.is_temporary, def->opts.is_ephemeral,
+				 def->opts.fixed_layout);
 	if (format == NULL) {
 		free(memtx_space);
 		return NULL;
 	}
+	format->is_net_readable = def->opts.iproto_read;
 	tuple_format_ref(format);
 
 	if (space_create((struct space *)memtx_space, (struct engine *)memtx,
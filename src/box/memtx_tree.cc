@@ -36,6 +36,7 @@
 #include "memory.h"
 #include "fiber.h"
 #include "key_list.h"
+#include "normalized_key.h"
 #include "tuple.h"
 #include "txn.h"
 #include "memtx_tx.h"
@@ -77,22 +78,101 @@ struct memtx_tree_data_common {
 	struct tuple *tuple;
 };
 
-template <bool USE_HINT>
+/**
+ * Tuple pointer stored as a 32-bit offset in the memtx arena, see
+ * memtx_tuple_offset(). It's converted to and from a tuple pointer
+ * implicitly so that tree elements of indexes with compact pointers
+ * can be accessed the same way as elements of other indexes.
+ */
+struct memtx_tree_tuple_offset {
+	/** Offset of the tuple or UINT32_MAX for NULL. */
+	uint32_t offset;
+
+	operator struct tuple *() const
+	{
+		if (offset == UINT32_MAX)
+			return NULL;
+		return memtx_tuple_by_offset(offset);
+	}
+
+	memtx_tree_tuple_offset &operator=(struct tuple *tuple)
+	{
+		if (tuple == NULL) {
+			offset = UINT32_MAX;
+			return *this;
+		}
+		/* Reserved by memtx_tree_index_check_tuple(). */
+		offset = memtx_tuple_offset(tuple);
+		return *this;
+	}
+};
+
+template <bool USE_HINT, bool COMPACT, bool PREFIX = false>
 struct memtx_tree_data;
 
 template <>
-struct memtx_tree_data<false> : memtx_tree_data_common {
+struct memtx_tree_data<false, false> : memtx_tree_data_common {
 	static constexpr hint_t hint = HINT_NONE;
 	void set_hint(hint_t) { assert(false); }
 };
 
 template <>
-struct memtx_tree_data<true> :  memtx_tree_data<false> {
+struct memtx_tree_data<true, false> :  memtx_tree_data<false, false> {
 	/** Comparison hint, see key_hint(). */
 	hint_t hint;
 	void set_hint(hint_t h) { hint = h; }
 };
 
+/**
+ * Element of an index with compact pointers. It's half the size
+ * of a plain element and a quarter of a hinted one.
+ */
+template <>
+struct memtx_tree_data<false, true> {
+	/* Tuple that this node is represents. */
+	struct memtx_tree_tuple_offset tuple;
+	static constexpr hint_t hint = HINT_NONE;
+	void set_hint(hint_t) { assert(false); }
+};
+
+/**
+ * Max size of a normalized key prefix stored in an element of
+ * an index with inline prefixes. Chosen so that the element
+ * takes 32 bytes and two elements share a cache line.
+ */
+enum { MEMTX_TREE_PREFIX_SIZE = 15 };
+
+/**
+ * Element of an index with normalized keys and inline prefixes.
+ * The hint points to the normalized key, the same as in other
+ * indexes with normalized keys, and the first bytes of the key
+ * are copied to the element so that most comparisons done by
+ * the tree don't need to access the key, see
+ * memtx_tree_data_compare().
+ */
+template <>
+struct memtx_tree_data<true, false, true> : memtx_tree_data<true, false> {
+	/** Size of the prefix, at most MEMTX_TREE_PREFIX_SIZE. */
+	uint8_t prefix_size;
+	/** First bytes of the normalized key, without its header. */
+	char prefix[MEMTX_TREE_PREFIX_SIZE];
+	void set_hint(hint_t h)
+	{
+		hint = h;
+		prefix_size = 0;
+		if (h == HINT_NONE)
+			return;
+		const char *nkey = (const char *)h;
+		prefix_size = MIN(normalized_key_size(nkey) -
+				  NORMALIZED_KEY_HEADER_SIZE,
+				  (uint32_t)MEMTX_TREE_PREFIX_SIZE);
+		memcpy(prefix, nkey + NORMALIZED_KEY_HEADER_SIZE, prefix_size);
+	}
+};
+
+static_assert(sizeof(struct memtx_tree_data<true, false, true>) == 32,
+	      "memtx tree elements with inline prefixes must be 32 bytes");
+
 /**
  * Test whether BPS tree elements are identical i.e. represent
  * the same tuple at the same position in the tree.
@@ -108,98 +188,265 @@ memtx_tree_data_is_equal(const struct memtx_tree_data_common *a,
 	return a->tuple == b->tuple;
 }
 
+static bool
+memtx_tree_data_is_equal(const struct memtx_tree_data<false, true> *a,
+			 const struct memtx_tree_data<false, true> *b)
+{
+	return a->tuple.offset == b->tuple.offset;
+}
+
+/** Compare two BPS tree elements. */
+template <class DATA>
+static inline int
+memtx_tree_data_compare(const DATA *a, const DATA *b, struct key_def *def)
+{
+	return tuple_compare(a->tuple, a->hint, b->tuple, b->hint, def);
+}
+
+/** Compare a BPS tree element with a key. */
+template <class DATA, class KEY>
+static inline int
+memtx_tree_data_compare_with_key(const DATA *a, const KEY *b,
+				 struct key_def *def)
+{
+	return tuple_compare_with_key(a->tuple, a->hint, b->key,
+				      b->part_count, b->hint, def);
+}
+
+/**
+ * Compare elements with inline prefixes. Normalized keys compare
+ * with memcmp() and are equal if one is a prefix of the other,
+ * see normalized_key_compare(), so the keys only need to be
+ * accessed if both prefixes are full and equal.
+ */
+static inline int
+memtx_tree_data_compare(const struct memtx_tree_data<true, false, true> *a,
+			const struct memtx_tree_data<true, false, true> *b,
+			struct key_def *def)
+{
+	uint32_t size = MIN(a->prefix_size, b->prefix_size);
+	int rc = memcmp(a->prefix, b->prefix, size);
+	if (rc != 0 || size < MEMTX_TREE_PREFIX_SIZE)
+		return rc;
+	return tuple_compare(a->tuple, a->hint, b->tuple, b->hint, def);
+}
+
+/**
+ * Compare an element with an inline prefix with a key. The key's
+ * normalized key is at hand so there's no need to copy its prefix.
+ */
+static inline int
+memtx_tree_data_compare_with_key(
+	const struct memtx_tree_data<true, false, true> *a,
+	const struct memtx_tree_key_data<true> *b, struct key_def *def)
+{
+	const char *nkey = (const char *)b->hint;
+	uint32_t size = MIN((uint32_t)a->prefix_size,
+			    normalized_key_size(nkey) -
+			    NORMALIZED_KEY_HEADER_SIZE);
+	int rc = memcmp(a->prefix, nkey + NORMALIZED_KEY_HEADER_SIZE, size);
+	if (rc != 0 || size < MEMTX_TREE_PREFIX_SIZE)
+		return rc;
+	return tuple_compare_with_key(a->tuple, a->hint, b->key,
+				      b->part_count, b->hint, def);
+}
+
 #define BPS_TREE_NAME memtx_tree
-#define BPS_TREE_BLOCK_SIZE (512)
 #define BPS_TREE_EXTENT_SIZE MEMTX_EXTENT_SIZE
-#define BPS_TREE_COMPARE(a, b, arg)\
-	tuple_compare((&a)->tuple, (&a)->hint, (&b)->tuple, (&b)->hint, arg)
+#define BPS_TREE_COMPARE(a, b, arg) memtx_tree_data_compare(&a, &b, arg)
 #define BPS_TREE_COMPARE_KEY(a, b, arg)\
-	tuple_compare_with_key((&a)->tuple, (&a)->hint, (b)->key,\
-			       (b)->part_count, (b)->hint, arg)
+	memtx_tree_data_compare_with_key(&a, b, arg)
 #define BPS_TREE_IS_IDENTICAL(a, b) memtx_tree_data_is_equal(&a, &b)
 #define BPS_TREE_NO_DEBUG 1
 #define bps_tree_arg_t struct key_def *
 
-#define BPS_TREE_NAMESPACE NS_NO_HINT
-#define bps_tree_elem_t struct memtx_tree_data<false>
+/*
+ * Each element layout is instantiated for every block size
+ * allowed by the block_size index option. Bigger blocks make
+ * the tree lower at the cost of a longer binary search in each
+ * block, which pays off if elements are big or the search is
+ * mostly resolved without accessing tuples, see
+ * perf/memtx_tree.cc.
+ */
+#define bps_tree_elem_t struct memtx_tree_data<false, false>
 #define bps_tree_key_t struct memtx_tree_key_data<false> *
 
+#define BPS_TREE_NAMESPACE NS_NO_HINT_512
+#define BPS_TREE_BLOCK_SIZE (512)
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
+
+#define BPS_TREE_NAMESPACE NS_NO_HINT_1024
+#define BPS_TREE_BLOCK_SIZE (1024)
 #include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
 
+#define BPS_TREE_NAMESPACE NS_NO_HINT_2048
+#define BPS_TREE_BLOCK_SIZE (2048)
+#include "salad/bps_tree.h"
 #undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
+
 #undef bps_tree_elem_t
 #undef bps_tree_key_t
 
-#define BPS_TREE_NAMESPACE NS_USE_HINT
-#define bps_tree_elem_t struct memtx_tree_data<true>
+#define bps_tree_elem_t struct memtx_tree_data<true, false>
 #define bps_tree_key_t struct memtx_tree_key_data<true> *
 
+#define BPS_TREE_NAMESPACE NS_USE_HINT_512
+#define BPS_TREE_BLOCK_SIZE (512)
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
+
+#define BPS_TREE_NAMESPACE NS_USE_HINT_1024
+#define BPS_TREE_BLOCK_SIZE (1024)
 #include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
 
+#define BPS_TREE_NAMESPACE NS_USE_HINT_2048
+#define BPS_TREE_BLOCK_SIZE (2048)
+#include "salad/bps_tree.h"
 #undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
+
 #undef bps_tree_elem_t
 #undef bps_tree_key_t
 
-#undef BPS_TREE_NAME
+#define bps_tree_elem_t struct memtx_tree_data<false, true>
+#define bps_tree_key_t struct memtx_tree_key_data<false> *
+
+#define BPS_TREE_NAMESPACE NS_COMPACT_512
+#define BPS_TREE_BLOCK_SIZE (512)
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
 #undef BPS_TREE_BLOCK_SIZE
-#undef BPS_TREE_EXTENT_SIZE
-#undef BPS_TREE_COMPARE
-#undef BPS_TREE_COMPARE_KEY
-#undef BPS_TREE_IS_IDENTICAL
-#undef BPS_TREE_NO_DEBUG
-#undef bps_tree_arg_t
 
-using namespace NS_NO_HINT;
-using namespace NS_USE_HINT;
+#define BPS_TREE_NAMESPACE NS_COMPACT_1024
+#define BPS_TREE_BLOCK_SIZE (1024)
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
 
-template <bool USE_HINT>
-struct memtx_tree_selector;
+#define BPS_TREE_NAMESPACE NS_COMPACT_2048
+#define BPS_TREE_BLOCK_SIZE (2048)
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
 
-template <>
-struct memtx_tree_selector<false> : NS_NO_HINT::memtx_tree {};
+#undef bps_tree_elem_t
+#undef bps_tree_key_t
 
-template <>
-struct memtx_tree_selector<true> : NS_USE_HINT::memtx_tree {};
+#define bps_tree_elem_t struct memtx_tree_data<true, false, true>
+#define bps_tree_key_t struct memtx_tree_key_data<true> *
 
-template <bool USE_HINT>
-using memtx_tree_t = struct memtx_tree_selector<USE_HINT>;
+#define BPS_TREE_NAMESPACE NS_PREFIX_512
+#define BPS_TREE_BLOCK_SIZE (512)
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
 
-template <bool USE_HINT>
-struct memtx_tree_iterator_selector;
+#define BPS_TREE_NAMESPACE NS_PREFIX_1024
+#define BPS_TREE_BLOCK_SIZE (1024)
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
 
-template <>
-struct memtx_tree_iterator_selector<false> {
-	using type = NS_NO_HINT::memtx_tree_iterator;
-};
+#define BPS_TREE_NAMESPACE NS_PREFIX_2048
+#define BPS_TREE_BLOCK_SIZE (2048)
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAMESPACE
+#undef BPS_TREE_BLOCK_SIZE
 
-template <>
-struct memtx_tree_iterator_selector<true> {
-	using type = NS_USE_HINT::memtx_tree_iterator;
-};
+#undef bps_tree_elem_t
+#undef bps_tree_key_t
 
-template <bool USE_HINT>
-using memtx_tree_iterator_t = typename memtx_tree_iterator_selector<USE_HINT>::type;
+#undef BPS_TREE_NAME
+#undef BPS_TREE_EXTENT_SIZE
+#undef BPS_TREE_COMPARE
+#undef BPS_TREE_COMPARE_KEY
+#undef BPS_TREE_IS_IDENTICAL
+#undef BPS_TREE_NO_DEBUG
+#undef bps_tree_arg_t
 
-static void
-invalidate_tree_iterator(NS_NO_HINT::memtx_tree_iterator *itr)
-{
-	*itr = NS_NO_HINT::memtx_tree_invalid_iterator();
-}
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
+struct memtx_tree_selector;
 
-static void
-invalidate_tree_iterator(NS_USE_HINT::memtx_tree_iterator *itr)
-{
-	*itr = NS_USE_HINT::memtx_tree_invalid_iterator();
-}
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
+struct memtx_tree_iterator_selector;
 
-template <bool USE_HINT>
+/**
+ * Bind a BPS tree instantiation to the template arguments of
+ * memtx tree index functions.
+ */
+#define MEMTX_TREE_SELECT(ns, use_hint, compact, prefix, block_size)	\
+using namespace ns;							\
+template <>								\
+struct memtx_tree_selector<use_hint, compact, prefix, block_size> :	\
+	ns::memtx_tree {};						\
+template <>								\
+struct memtx_tree_iterator_selector<use_hint, compact, prefix,		\
+				    block_size> {			\
+	using type = ns::memtx_tree_iterator;				\
+};									\
+static void								\
+invalidate_tree_iterator(ns::memtx_tree_iterator *itr)			\
+{									\
+	*itr = ns::memtx_tree_invalid_iterator();			\
+}									\
+struct forgot_to_add_semicolon
+
+MEMTX_TREE_SELECT(NS_NO_HINT_512, false, false, false, 512);
+MEMTX_TREE_SELECT(NS_NO_HINT_1024, false, false, false, 1024);
+MEMTX_TREE_SELECT(NS_NO_HINT_2048, false, false, false, 2048);
+MEMTX_TREE_SELECT(NS_USE_HINT_512, true, false, false, 512);
+MEMTX_TREE_SELECT(NS_USE_HINT_1024, true, false, false, 1024);
+MEMTX_TREE_SELECT(NS_USE_HINT_2048, true, false, false, 2048);
+MEMTX_TREE_SELECT(NS_COMPACT_512, false, true, false, 512);
+MEMTX_TREE_SELECT(NS_COMPACT_1024, false, true, false, 1024);
+MEMTX_TREE_SELECT(NS_COMPACT_2048, false, true, false, 2048);
+MEMTX_TREE_SELECT(NS_PREFIX_512, true, false, true, 512);
+MEMTX_TREE_SELECT(NS_PREFIX_1024, true, false, true, 1024);
+MEMTX_TREE_SELECT(NS_PREFIX_2048, true, false, true, 2048);
+
+#undef MEMTX_TREE_SELECT
+
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
+using memtx_tree_t =
+	struct memtx_tree_selector<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE>;
+
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
+using memtx_tree_iterator_t =
+	typename memtx_tree_iterator_selector<USE_HINT, COMPACT, PREFIX,
+					      BLOCK_SIZE>::type;
+
+template <bool USE_HINT, bool COMPACT, bool PREFIX = false,
+	  int BLOCK_SIZE = MEMTX_TREE_BLOCK_SIZE_DEFAULT>
 struct memtx_tree_index {
 	struct index base;
-	memtx_tree_t<USE_HINT> tree;
-	struct memtx_tree_data<USE_HINT> *build_array;
+	memtx_tree_t<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> tree;
+	struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *build_array;
 	size_t build_array_size, build_array_alloc_size;
 	struct memtx_gc_task gc_task;
-	memtx_tree_iterator_t<USE_HINT> gc_iterator;
+	memtx_tree_iterator_t<USE_HINT, COMPACT, PREFIX,
+			      BLOCK_SIZE> gc_iterator;
+	/**
+	 * Set if the garbage collection task must unreference
+	 * tuples, i.e. the index is primary. The index definition
+	 * may already be freed when the task runs.
+	 */
+	bool gc_unref_tuples;
+	/**
+	 * For indexes with normalized keys only: the tree key
+	 * definition with comparators that take normalized keys
+	 * stored in hints, see normalized_key.h.
+	 */
+	struct key_def *normalized_def;
+	/** Size of memory allocated for normalized keys. */
+	size_t normalized_key_size;
 };
 
 /* {{{ Utilities. *************************************************/
@@ -211,21 +458,21 @@ memtx_tree_cmp_def(TREE *tree)
 	return tree->arg;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX>
 static int
 memtx_tree_qcompare(const void* a, const void *b, void *c)
 {
-	const struct memtx_tree_data<USE_HINT> *data_a =
-		(struct memtx_tree_data<USE_HINT> *)a;
-	const struct memtx_tree_data<USE_HINT> *data_b =
-		(struct memtx_tree_data<USE_HINT> *)b;
+	const struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *data_a =
+		(struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *)a;
+	const struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *data_b =
+		(struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *)b;
 	struct key_def *key_def = (struct key_def *)c;
-	return tuple_compare(data_a->tuple, data_a->hint, data_b->tuple,
-			     data_b->hint, key_def);
+	return memtx_tree_data_compare(data_a, data_b, key_def);
 }
 
 /* {{{ MemtxTree Iterators ****************************************/
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX = false,
+	  int BLOCK_SIZE = MEMTX_TREE_BLOCK_SIZE_DEFAULT>
 struct tree_iterator {
 	struct iterator base;
 
@@ -249,18 +496,19 @@ struct tree_iterator {
 	 * One need not care about the iterator's position: it will
 	 * automatically get adjusted on iterator->next call.
 	 */
-	memtx_tree_iterator_t<USE_HINT> tree_iterator;
+	memtx_tree_iterator_t<USE_HINT, COMPACT, PREFIX,
+			      BLOCK_SIZE> tree_iterator;
 	enum iterator_type type;
 	struct memtx_tree_key_data<USE_HINT> key_data;
-	struct memtx_tree_data<USE_HINT> current;
+	struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> current;
 	/**
-	 * For functional indexes only: copy of the functional index key at the
-	 * current iterator position. Allocated from current_func_key_buf or on
-	 * malloc.
+	 * For functional indexes and indexes with normalized keys only: copy
+	 * of the key at the current iterator position. Allocated from
+	 * current_func_key_buf or on malloc.
 	 *
-	 * Since pinning a tuple doesn't prevent its functional keys from being
-	 * deleted, we need to copy it so that we can use it to restore the
-	 * iterator position.
+	 * Since pinning a tuple doesn't prevent its functional or normalized
+	 * keys from being deleted, we need to copy it so that we can use it to
+	 * restore the iterator position.
 	 */
 	void *current_func_key;
 	char current_func_key_buf[32];
@@ -268,17 +516,28 @@ struct tree_iterator {
 	struct mempool *pool;
 };
 
-static_assert(sizeof(struct tree_iterator<false>) <= MEMTX_ITERATOR_SIZE,
-	      "sizeof(struct tree_iterator<false>) must be less than or equal "
-	      "to MEMTX_ITERATOR_SIZE");
-static_assert(sizeof(struct tree_iterator<true>) <= MEMTX_ITERATOR_SIZE,
-	      "sizeof(struct tree_iterator<true>) must be less than or equal "
-	      "to MEMTX_ITERATOR_SIZE");
-
-template <bool USE_HINT>
+static_assert(sizeof(struct tree_iterator<false, false>) <=
+	      MEMTX_ITERATOR_SIZE,
+	      "sizeof(struct tree_iterator<false, false>) must be less than "
+	      "or equal to MEMTX_ITERATOR_SIZE");
+static_assert(sizeof(struct tree_iterator<true, false>) <=
+	      MEMTX_ITERATOR_SIZE,
+	      "sizeof(struct tree_iterator<true, false>) must be less than "
+	      "or equal to MEMTX_ITERATOR_SIZE");
+static_assert(sizeof(struct tree_iterator<false, true>) <=
+	      MEMTX_ITERATOR_SIZE,
+	      "sizeof(struct tree_iterator<false, true>) must be less than "
+	      "or equal to MEMTX_ITERATOR_SIZE");
+static_assert(sizeof(struct tree_iterator<true, false, true>) <=
+	      MEMTX_ITERATOR_SIZE,
+	      "sizeof(struct tree_iterator<true, false, true>) must be less "
+	      "than or equal to MEMTX_ITERATOR_SIZE");
+
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static inline void
-tree_iterator_set_current_tuple(struct tree_iterator<USE_HINT> *it,
-				struct tuple *tuple)
+tree_iterator_set_current_tuple(
+	struct tree_iterator<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *it,
+	struct tuple *tuple)
 {
 	if (it->current.tuple != NULL)
 		tuple_unref(it->current.tuple);
@@ -287,9 +546,11 @@ tree_iterator_set_current_tuple(struct tree_iterator<USE_HINT> *it,
 		tuple_ref(tuple);
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static inline void
-tree_iterator_set_current_hint(struct tree_iterator<USE_HINT> *it, hint_t hint)
+tree_iterator_set_current_hint(
+	struct tree_iterator<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *it,
+	hint_t hint)
 {
 	if (!USE_HINT)
 		return;
@@ -298,9 +559,13 @@ tree_iterator_set_current_hint(struct tree_iterator<USE_HINT> *it, hint_t hint)
 		free(it->current_func_key);
 	}
 	it->current_func_key = NULL;
-	if (hint != HINT_NONE && it->base.index->def->key_def->for_func_index) {
+	struct index_def *def = it->base.index->def;
+	if (hint != HINT_NONE &&
+	    (def->key_def->for_func_index || def->opts.normalized_keys)) {
 		void *key = (void *)hint;
-		uint32_t key_sz = memtx_alloc_size(key);
+		uint32_t key_sz = def->opts.normalized_keys ?
+				  normalized_key_size((const char *)key) :
+				  memtx_alloc_size(key);
 		if (key_sz <= sizeof(it->current_func_key_buf)) {
 			it->current_func_key = it->current_func_key_buf;
 		} else {
@@ -312,10 +577,11 @@ tree_iterator_set_current_hint(struct tree_iterator<USE_HINT> *it, hint_t hint)
 	it->current.set_hint(hint);
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static inline void
-tree_iterator_set_current(struct tree_iterator<USE_HINT> *it,
-			  struct memtx_tree_data<USE_HINT> *cur)
+tree_iterator_set_current(
+	struct tree_iterator<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *it,
+	struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *cur)
 {
 	if (cur != NULL) {
 		tree_iterator_set_current_tuple(it, cur->tuple);
@@ -326,24 +592,31 @@ tree_iterator_set_current(struct tree_iterator<USE_HINT> *it,
 	}
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static void
 tree_iterator_free(struct iterator *iterator);
 
-template <bool USE_HINT>
-static inline struct tree_iterator<USE_HINT> *
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
+static inline struct tree_iterator<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *
 get_tree_iterator(struct iterator *it)
 {
-	assert(it->free == &tree_iterator_free<USE_HINT>);
-	return (struct tree_iterator<USE_HINT> *) it;
+	assert((it->free == &tree_iterator_free<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>));
+	return (struct tree_iterator<USE_HINT, COMPACT, PREFIX,
+				     BLOCK_SIZE> *) it;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static void
 tree_iterator_free(struct iterator *iterator)
 {
-	struct tree_iterator<USE_HINT> *it = get_tree_iterator<USE_HINT>(iterator);
-	tree_iterator_set_current<USE_HINT>(it, NULL);
+	struct tree_iterator<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *it =
+		get_tree_iterator<USE_HINT, COMPACT, PREFIX,
+				  BLOCK_SIZE>(iterator);
+	tree_iterator_set_current<USE_HINT, COMPACT, PREFIX,
+				  BLOCK_SIZE>(it, NULL);
+	if (it->base.index->def->opts.normalized_keys)
+		free((void *)it->key_data.hint);
 	mempool_free(it->pool, it);
 }
 
@@ -364,15 +637,19 @@ tree_iterator_set_dummie(struct iterator *iterator)
 		iterator->next = tree_iterator_dummie;
 }
 
-template <bool UNCHANGED, bool USE_HINT>
+template <bool UNCHANGED, bool USE_HINT, bool COMPACT, bool PREFIX,
+	  int BLOCK_SIZE>
 static int
 tree_iterator_next_raw_base(struct iterator *iterator, struct tuple **ret)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)iterator->index;
-	struct tree_iterator<USE_HINT> *it = get_tree_iterator<USE_HINT>(iterator);
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)iterator->index;
+	struct tree_iterator<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *it =
+		get_tree_iterator<USE_HINT, COMPACT, PREFIX,
+				  BLOCK_SIZE>(iterator);
 	assert(it->current.tuple != NULL);
-	struct memtx_tree_data<USE_HINT> *check =
+	struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *check =
 		memtx_tree_iterator_get_elem(&index->tree, &it->tree_iterator);
 	if (check == NULL || !memtx_tree_data_is_equal(check, &it->current)) {
 		it->tree_iterator = memtx_tree_upper_bound_elem(&index->tree,
@@ -380,9 +657,9 @@ tree_iterator_next_raw_base(struct iterator *iterator, struct tuple **ret)
 	} else {
 		memtx_tree_iterator_next(&index->tree, &it->tree_iterator);
 	}
-	struct memtx_tree_data<USE_HINT> *res =
+	struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *res =
 		memtx_tree_iterator_get_elem(&index->tree, &it->tree_iterator);
-	tree_iterator_set_current<USE_HINT>(it, res);
+	tree_iterator_set_current(it, res);
 	*ret = it->current.tuple;
 	if (*ret == NULL)
 		tree_iterator_set_dummie<UNCHANGED>(iterator);
@@ -400,15 +677,19 @@ tree_iterator_next_raw_base(struct iterator *iterator, struct tuple **ret)
 	return 0;
 }
 
-template <bool UNCHANGED, bool USE_HINT>
+template <bool UNCHANGED, bool USE_HINT, bool COMPACT, bool PREFIX,
+	  int BLOCK_SIZE>
 static int
 tree_iterator_prev_raw_base(struct iterator *iterator, struct tuple **ret)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)iterator->index;
-	struct tree_iterator<USE_HINT> *it = get_tree_iterator<USE_HINT>(iterator);
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)iterator->index;
+	struct tree_iterator<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *it =
+		get_tree_iterator<USE_HINT, COMPACT, PREFIX,
+				  BLOCK_SIZE>(iterator);
 	assert(it->current.tuple != NULL);
-	struct memtx_tree_data<USE_HINT> *check =
+	struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *check =
 		memtx_tree_iterator_get_elem(&index->tree, &it->tree_iterator);
 	if (check == NULL || !memtx_tree_data_is_equal(check, &it->current)) {
 		it->tree_iterator = memtx_tree_lower_bound_elem(&index->tree,
@@ -417,9 +698,9 @@ tree_iterator_prev_raw_base(struct iterator *iterator, struct tuple **ret)
 	memtx_tree_iterator_prev(&index->tree, &it->tree_iterator);
 	struct tuple *successor = it->current.tuple;
 	tuple_ref(successor);
-	struct memtx_tree_data<USE_HINT> *res =
+	struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *res =
 		memtx_tree_iterator_get_elem(&index->tree, &it->tree_iterator);
-	tree_iterator_set_current<USE_HINT>(it, res);
+	tree_iterator_set_current(it, res);
 	*ret = it->current.tuple;
 	if (*ret == NULL)
 		tree_iterator_set_dummie<UNCHANGED>(iterator);
@@ -438,15 +719,19 @@ tree_iterator_prev_raw_base(struct iterator *iterator, struct tuple **ret)
 	return 0;
 }
 
-template <bool UNCHANGED, bool USE_HINT>
+template <bool UNCHANGED, bool USE_HINT, bool COMPACT, bool PREFIX,
+	  int BLOCK_SIZE>
 static int
 tree_iterator_next_equal_raw_base(struct iterator *iterator, struct tuple **ret)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)iterator->index;
-	struct tree_iterator<USE_HINT> *it = get_tree_iterator<USE_HINT>(iterator);
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)iterator->index;
+	struct tree_iterator<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *it =
+		get_tree_iterator<USE_HINT, COMPACT, PREFIX,
+				  BLOCK_SIZE>(iterator);
 	assert(it->current.tuple != NULL);
-	struct memtx_tree_data<USE_HINT> *check =
+	struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *check =
 		memtx_tree_iterator_get_elem(&index->tree, &it->tree_iterator);
 	if (check == NULL || !memtx_tree_data_is_equal(check, &it->current)) {
 		it->tree_iterator = memtx_tree_upper_bound_elem(&index->tree,
@@ -454,32 +739,39 @@ tree_iterator_next_equal_raw_base(struct iterator *iterator, struct tuple **ret)
 	} else {
 		memtx_tree_iterator_next(&index->tree, &it->tree_iterator);
 	}
-	struct memtx_tree_data<USE_HINT> *res =
+	struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *res =
 		memtx_tree_iterator_get_elem(&index->tree, &it->tree_iterator);
 	struct index *idx = iterator->index;
 	struct space *space = space_by_id(iterator->space_id);
-	/* Use user key def to save a few loops. */
+	/*
+	 * Use user key def to save a few loops. Normalized keys
+	 * stored in hints can only be compared with the tree one.
+	 */
+	struct key_def *key_def = index->normalized_def != NULL ?
+				  index->normalized_def :
+				  index->base.def->key_def;
 	if (res == NULL ||
 	    tuple_compare_with_key(res->tuple, res->hint,
 				   it->key_data.key,
 				   it->key_data.part_count,
-				   it->key_data.hint,
-				   index->base.def->key_def) != 0) {
-		tree_iterator_set_current<USE_HINT>(it, NULL);
+				   it->key_data.hint, key_def) != 0) {
+		tree_iterator_set_current<USE_HINT, COMPACT, PREFIX,
+					  BLOCK_SIZE>(it, NULL);
 		tree_iterator_set_dummie<UNCHANGED>(iterator);
 		*ret = NULL;
 		/*
 		 * Got end of key. Store gap from the previous tuple to the
 		 * key boundary in nearby tuple.
 		 */
-		struct tuple *nearby_tuple = res == NULL ? NULL : res->tuple;
+		struct tuple *nearby_tuple = res == NULL ? NULL :
+					     (struct tuple *)res->tuple;
 
 /********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND START*********/
 		memtx_tx_track_gap(in_txn(), space, idx, nearby_tuple, ITER_EQ,
 				   it->key_data.key, it->key_data.part_count);
 /*********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND END**********/
 	} else {
-		tree_iterator_set_current<USE_HINT>(it, res);
+		tree_iterator_set_current(it, res);
 		*ret = res->tuple;
 
 /********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND START*********/
@@ -494,15 +786,19 @@ tree_iterator_next_equal_raw_base(struct iterator *iterator, struct tuple **ret)
 	return 0;
 }
 
-template <bool UNCHANGED, bool USE_HINT>
+template <bool UNCHANGED, bool USE_HINT, bool COMPACT, bool PREFIX,
+	  int BLOCK_SIZE>
 static int
 tree_iterator_prev_equal_raw_base(struct iterator *iterator, struct tuple **ret)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)iterator->index;
-	struct tree_iterator<USE_HINT> *it = get_tree_iterator<USE_HINT>(iterator);
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)iterator->index;
+	struct tree_iterator<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *it =
+		get_tree_iterator<USE_HINT, COMPACT, PREFIX,
+				  BLOCK_SIZE>(iterator);
 	assert(it->current.tuple != NULL);
-	struct memtx_tree_data<USE_HINT> *check =
+	struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *check =
 		memtx_tree_iterator_get_elem(&index->tree, &it->tree_iterator);
 	if (check == NULL || !memtx_tree_data_is_equal(check, &it->current)) {
 		it->tree_iterator = memtx_tree_lower_bound_elem(&index->tree,
@@ -511,18 +807,24 @@ tree_iterator_prev_equal_raw_base(struct iterator *iterator, struct tuple **ret)
 	memtx_tree_iterator_prev(&index->tree, &it->tree_iterator);
 	struct tuple *successor = it->current.tuple;
 	tuple_ref(successor);
-	struct memtx_tree_data<USE_HINT> *res =
+	struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *res =
 		memtx_tree_iterator_get_elem(&index->tree, &it->tree_iterator);
 	struct index *idx = iterator->index;
 	struct space *space = space_by_id(iterator->space_id);
-	/* Use user key def to save a few loops. */
+	/*
+	 * Use user key def to save a few loops. Normalized keys
+	 * stored in hints can only be compared with the tree one.
+	 */
+	struct key_def *key_def = index->normalized_def != NULL ?
+				  index->normalized_def :
+				  index->base.def->key_def;
 	if (res == NULL ||
 	    tuple_compare_with_key(res->tuple, res->hint,
 				   it->key_data.key,
 				   it->key_data.part_count,
-				   it->key_data.hint,
-				   index->base.def->key_def) != 0) {
-		tree_iterator_set_current<USE_HINT>(it, NULL);
+				   it->key_data.hint, key_def) != 0) {
+		tree_iterator_set_current<USE_HINT, COMPACT, PREFIX,
+					  BLOCK_SIZE>(it, NULL);
 		tree_iterator_set_dummie<UNCHANGED>(iterator);
 		*ret = NULL;
 
@@ -535,7 +837,7 @@ tree_iterator_prev_equal_raw_base(struct iterator *iterator, struct tuple **ret)
 				   it->key_data.key, it->key_data.part_count);
 /*********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND END**********/
 	} else {
-		tree_iterator_set_current<USE_HINT>(it, res);
+		tree_iterator_set_current(it, res);
 		*ret = res->tuple;
 
 /********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND START*********/
@@ -552,28 +854,34 @@ tree_iterator_prev_equal_raw_base(struct iterator *iterator, struct tuple **ret)
 }
 
 #define WRAP_ITERATOR_METHOD(name)						\
-template <bool UNCHANGED, bool USE_HINT>					\
+template <bool UNCHANGED, bool USE_HINT, bool COMPACT, bool PREFIX,		\
+	  int BLOCK_SIZE>							\
 static int									\
 name(struct iterator *iterator, struct tuple **ret)				\
 {										\
-	memtx_tree_t<USE_HINT> *tree =						\
-		&((struct memtx_tree_index<USE_HINT> *)iterator->index)->tree;	\
-	struct tree_iterator<USE_HINT> *it =   					\
-		get_tree_iterator<USE_HINT>(iterator);				\
-	memtx_tree_iterator_t<USE_HINT> *ti = &it->tree_iterator;		\
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,	\
+						BLOCK_SIZE>;			\
+	memtx_tree_t<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *tree =		\
+		&((index_t *)iterator->index)->tree;				\
+	struct tree_iterator<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *it =	\
+		get_tree_iterator<USE_HINT, COMPACT, PREFIX,			\
+				  BLOCK_SIZE>(iterator);			\
+	memtx_tree_iterator_t<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *ti =	\
+		&it->tree_iterator;						\
 	struct index *idx = iterator->index;					\
 	bool is_multikey = iterator->index->def->key_def->is_multikey;		\
 	struct txn *txn = in_txn();						\
 	struct space *space = space_by_id(iterator->space_id);			\
 	bool is_rw = txn != NULL;						\
 	do {									\
-		int rc = name##_base<UNCHANGED, USE_HINT>(iterator, ret);	\
+		int rc = name##_base<UNCHANGED, USE_HINT, COMPACT, PREFIX,	\
+				     BLOCK_SIZE>(iterator, ret);		\
 		if (rc != 0 || *ret == NULL)					\
 			return rc;						\
 		uint32_t mk_index = 0;						\
 		if (is_multikey) {						\
-			struct memtx_tree_data<USE_HINT> *check =		\
-				memtx_tree_iterator_get_elem(tree, ti);		\
+			struct memtx_tree_data<USE_HINT, COMPACT, PREFIX>	\
+				*check = memtx_tree_iterator_get_elem(tree, ti);\
 			assert(check != NULL);					\
 			mk_index = (uint32_t)check->hint;			\
 		}								\
@@ -592,33 +900,35 @@ WRAP_ITERATOR_METHOD(tree_iterator_prev_equal_raw);
 
 #undef WRAP_ITERATOR_METHOD
 
-template <bool UNCHANGED, bool USE_HINT>
+template <bool UNCHANGED, bool USE_HINT, bool COMPACT, bool PREFIX,
+	  int BLOCK_SIZE>
 static void
-tree_iterator_set_next_method(struct tree_iterator<USE_HINT> *it)
+tree_iterator_set_next_method(
+	struct tree_iterator<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *it)
 {
 	assert(it->current.tuple != NULL);
 	switch (it->type) {
 	case ITER_EQ:
-		it->base.next_raw =
-			tree_iterator_next_equal_raw<UNCHANGED, USE_HINT>;
+		it->base.next_raw = tree_iterator_next_equal_raw<
+			UNCHANGED, USE_HINT, COMPACT, PREFIX, BLOCK_SIZE>;
 		break;
 	case ITER_REQ:
-		it->base.next_raw =
-			tree_iterator_prev_equal_raw<UNCHANGED, USE_HINT>;
+		it->base.next_raw = tree_iterator_prev_equal_raw<
+			UNCHANGED, USE_HINT, COMPACT, PREFIX, BLOCK_SIZE>;
 		break;
 	case ITER_ALL:
-		it->base.next_raw =
-			tree_iterator_next_raw<UNCHANGED, USE_HINT>;
+		it->base.next_raw = tree_iterator_next_raw<
+			UNCHANGED, USE_HINT, COMPACT, PREFIX, BLOCK_SIZE>;
 		break;
 	case ITER_LT:
 	case ITER_LE:
-		it->base.next_raw =
-			tree_iterator_prev_raw<UNCHANGED, USE_HINT>;
+		it->base.next_raw = tree_iterator_prev_raw<
+			UNCHANGED, USE_HINT, COMPACT, PREFIX, BLOCK_SIZE>;
 		break;
 	case ITER_GE:
 	case ITER_GT:
-		it->base.next_raw =
-			tree_iterator_next_raw<UNCHANGED, USE_HINT>;
+		it->base.next_raw = tree_iterator_next_raw<
+			UNCHANGED, USE_HINT, COMPACT, PREFIX, BLOCK_SIZE>;
 		break;
 	default:
 		/* The type was checked in initIterator */
@@ -628,16 +938,21 @@ tree_iterator_set_next_method(struct tree_iterator<USE_HINT> *it)
 			it->base.next_raw : memtx_iterator_next;
 }
 
-template <bool UNCHANGED, bool USE_HINT>
+template <bool UNCHANGED, bool USE_HINT, bool COMPACT, bool PREFIX,
+	  int BLOCK_SIZE>
 static int
 tree_iterator_start_raw(struct iterator *iterator, struct tuple **ret)
 {
 	*ret = NULL;
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)iterator->index;
-	struct tree_iterator<USE_HINT> *it = get_tree_iterator<USE_HINT>(iterator);
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)iterator->index;
+	struct tree_iterator<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *it =
+		get_tree_iterator<USE_HINT, COMPACT, PREFIX,
+				  BLOCK_SIZE>(iterator);
 	tree_iterator_set_dummie<UNCHANGED>(iterator);
-	memtx_tree_t<USE_HINT> *tree = &index->tree;
+	memtx_tree_t<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *tree =
+		&index->tree;
 	enum iterator_type type = it->type;
 	struct txn *txn = in_txn();
 	struct space *space = space_by_id(iterator->space_id);
@@ -703,7 +1018,7 @@ tree_iterator_start_raw(struct iterator *iterator, struct tuple **ret)
 		return 0;
 	}
 
-	struct memtx_tree_data<USE_HINT> *res =
+	struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *res =
 		memtx_tree_iterator_get_elem(tree, &it->tree_iterator);
 	uint32_t mk_index = 0;
 	if (res != NULL) {
@@ -717,7 +1032,8 @@ tree_iterator_start_raw(struct iterator *iterator, struct tuple **ret)
 	if ((!key_is_full || (type != ITER_EQ && type != ITER_REQ)) &&
 	    memtx_tx_manager_use_mvcc_engine) {
 		/* it->tree_iterator is positioned on successor of a key! */
-		struct tuple *successor = res == NULL ? NULL : res->tuple;
+		struct tuple *successor = res == NULL ? NULL :
+					  (struct tuple *)res->tuple;
 
 /********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND START*********/
 		memtx_tx_track_gap(in_txn(), space, idx, successor, type,
@@ -742,16 +1058,72 @@ tree_iterator_start_raw(struct iterator *iterator, struct tuple **ret)
 
 /* {{{ MemtxTree  **********************************************************/
 
-template <bool USE_HINT>
+/**
+ * Build a normalized key of a tuple and copy it to the engine's
+ * memory. Returns NULL and sets diag on error.
+ */
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
+static const char *
+memtx_tree_index_new_normalized_key(
+	struct memtx_tree_index<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *index,
+	struct tuple *tuple)
+{
+	assert(index->normalized_def != NULL);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	char *result = NULL;
+	const char *nkey = tuple_normalized_key(tuple, index->normalized_def,
+						region);
+	if (nkey == NULL)
+		goto out;
+	uint32_t size;
+	size = normalized_key_size(nkey);
+	result = (char *)memtx_alloc(size);
+	if (result == NULL) {
+		diag_set(OutOfMemory, size, "MemtxAllocator::alloc",
+			 "normalized key");
+		goto out;
+	}
+	memcpy(result, nkey, size);
+	index->normalized_key_size += size;
+out:
+	region_truncate(region, region_svp);
+	return result;
+}
+
+/** Free a normalized key allocated for a tree element. */
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static void
-memtx_tree_index_free(struct memtx_tree_index<USE_HINT> *index)
+memtx_tree_index_delete_normalized_key(
+	struct memtx_tree_index<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *index,
+	hint_t hint)
+{
+	const char *nkey = (const char *)hint;
+	uint32_t size = normalized_key_size(nkey);
+	assert(index->normalized_key_size >= size);
+	index->normalized_key_size -= size;
+	memtx_free((void *)nkey);
+}
+
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
+static void
+memtx_tree_index_free(
+	struct memtx_tree_index<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *index)
 {
 	memtx_tree_destroy(&index->tree);
+	if (index->normalized_def != NULL) {
+		/* Release keys of an aborted build. */
+		for (size_t i = 0; i < index->build_array_size; i++) {
+			memtx_tree_index_delete_normalized_key(index,
+					index->build_array[i].hint);
+		}
+		key_def_delete(index->normalized_def);
+	}
 	free(index->build_array);
 	free(index);
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static void
 memtx_tree_index_gc_run(struct memtx_gc_task *task, bool *done)
 {
@@ -765,17 +1137,23 @@ memtx_tree_index_gc_run(struct memtx_gc_task *task, bool *done)
 	enum { YIELD_LOOPS = 10 };
 #endif
 
-	struct memtx_tree_index<USE_HINT> *index = container_of(task,
-			struct memtx_tree_index<USE_HINT>, gc_task);
-	memtx_tree_t<USE_HINT> *tree = &index->tree;
-	memtx_tree_iterator_t<USE_HINT> *itr = &index->gc_iterator;
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = container_of(task, index_t, gc_task);
+	memtx_tree_t<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *tree =
+		&index->tree;
+	memtx_tree_iterator_t<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *itr =
+		&index->gc_iterator;
 
 	unsigned int loops = 0;
 	while (!memtx_tree_iterator_is_invalid(itr)) {
-		struct memtx_tree_data<USE_HINT> *res =
+		struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *res =
 			memtx_tree_iterator_get_elem(tree, itr);
 		memtx_tree_iterator_next(tree, itr);
-		tuple_unref(res->tuple);
+		if (index->normalized_def != NULL)
+			memtx_tree_index_delete_normalized_key(index, res->hint);
+		if (index->gc_unref_tuples)
+			tuple_unref(res->tuple);
 		if (++loops >= YIELD_LOOPS) {
 			*done = false;
 			return;
@@ -784,40 +1162,51 @@ memtx_tree_index_gc_run(struct memtx_gc_task *task, bool *done)
 	*done = true;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static void
 memtx_tree_index_gc_free(struct memtx_gc_task *task)
 {
-	struct memtx_tree_index<USE_HINT> *index = container_of(task,
-			struct memtx_tree_index<USE_HINT>, gc_task);
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = container_of(task, index_t, gc_task);
 	memtx_tree_index_free(index);
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static struct memtx_gc_task_vtab * get_memtx_tree_index_gc_vtab()
 {
 	static memtx_gc_task_vtab tab =
 	{
-		.run = memtx_tree_index_gc_run<USE_HINT>,
-		.free = memtx_tree_index_gc_free<USE_HINT>,
+		.run = memtx_tree_index_gc_run<USE_HINT, COMPACT, PREFIX,
+					       BLOCK_SIZE>,
+		.free = memtx_tree_index_gc_free<USE_HINT, COMPACT, PREFIX,
+						 BLOCK_SIZE>,
 	};
 	return &tab;
 };
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static void
 memtx_tree_index_destroy(struct index *base)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)base;
 	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
-	if (base->def->iid == 0) {
+	if (COMPACT) {
+		assert(memtx->compact_index_count > 0);
+		memtx->compact_index_count--;
+	}
+	if (base->def->iid == 0 || index->normalized_def != NULL) {
 		/*
-		 * Primary index. We need to free all tuples stored
-		 * in the index, which may take a while. Schedule a
+		 * Primary index or index with normalized keys. We
+		 * need to free all tuples or keys stored in the
+		 * index, which may take a while. Schedule a
 		 * background task in order not to block tx thread.
 		 */
-		index->gc_task.vtab = get_memtx_tree_index_gc_vtab<USE_HINT>();
+		index->gc_unref_tuples = base->def->iid == 0;
+		index->gc_task.vtab = get_memtx_tree_index_gc_vtab<
+			USE_HINT, COMPACT, PREFIX, BLOCK_SIZE>();
 		index->gc_iterator = memtx_tree_iterator_first(&index->tree);
 		memtx_engine_schedule_gc(memtx, &index->gc_task);
 	} else {
@@ -829,12 +1218,13 @@ memtx_tree_index_destroy(struct index *base)
 	}
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static void
 memtx_tree_index_update_def(struct index *base)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)base;
 	struct index_def *def = base->def;
 	/*
 	 * We use extended key def for non-unique and nullable
@@ -842,8 +1232,19 @@ memtx_tree_index_update_def(struct index *base)
 	 * NULLs. To correctly compare these NULLs extended key
 	 * def must be used. For details @sa tuple_compare.cc.
 	 */
-	index->tree.arg = def->opts.is_unique && !def->key_def->is_nullable ?
-						def->key_def : def->cmp_def;
+	struct key_def *cmp_def = def->opts.is_unique &&
+				  !def->key_def->is_nullable ?
+				  def->key_def : def->cmp_def;
+	if (index->normalized_def != NULL) {
+		/*
+		 * Changes that affect normalized keys require
+		 * an index rebuild so the key parts must be
+		 * the same.
+		 */
+		normalized_key_def_copy(index->normalized_def, cmp_def);
+		cmp_def = index->normalized_def;
+	}
+	index->tree.arg = cmp_def;
 }
 
 static bool
@@ -854,67 +1255,84 @@ memtx_tree_index_depends_on_pk(struct index *base)
 	return !def->opts.is_unique || def->key_def->is_nullable;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static ssize_t
 memtx_tree_index_size(struct index *base)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)base;
 	struct space *space = space_by_id(base->def->space_id);
 	/* Substract invisible count. */
 	return memtx_tree_size(&index->tree) -
 	       memtx_tx_index_invisible_count(in_txn(), space, base);
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static ssize_t
 memtx_tree_index_bsize(struct index *base)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
-	return memtx_tree_mem_used(&index->tree);
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)base;
+	return memtx_tree_mem_used(&index->tree) + index->normalized_key_size;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static int
 memtx_tree_index_random(struct index *base, uint32_t rnd, struct tuple **result)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
-	struct memtx_tree_data<USE_HINT> *res = memtx_tree_random(&index->tree, rnd);
-	*result = res != NULL ? res->tuple : NULL;
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)base;
+	struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *res =
+		memtx_tree_random(&index->tree, rnd);
+	*result = res != NULL ? (struct tuple *)res->tuple : NULL;
 	return memtx_prepare_result_tuple(result);
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static ssize_t
 memtx_tree_index_count(struct index *base, enum iterator_type type,
 		       const char *key, uint32_t part_count)
 {
 	if (type == ITER_ALL)
-		return memtx_tree_index_size<USE_HINT>(base); /* optimization */
+		/* optimization */
+		return memtx_tree_index_size<USE_HINT, COMPACT, PREFIX,
+					     BLOCK_SIZE>(base);
 	return generic_index_count(base, type, key, part_count);
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static int
 memtx_tree_index_get_raw(struct index *base, const char *key,
 			 uint32_t part_count, struct tuple **result)
 {
 	assert(base->def->opts.is_unique &&
 	       part_count == base->def->key_def->part_count);
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)base;
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 	struct txn *txn = in_txn();
 	struct space *space = space_by_id(base->def->space_id);
 	struct memtx_tree_key_data<USE_HINT> key_data;
 	key_data.key = key;
 	key_data.part_count = part_count;
-	if (USE_HINT)
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	if (index->normalized_def != NULL) {
+		const char *nkey = key_normalized_key(key, part_count,
+						      cmp_def, region);
+		if (nkey == NULL)
+			return -1;
+		key_data.set_hint((hint_t)nkey);
+	} else if (USE_HINT) {
 		key_data.set_hint(key_hint(key, part_count, cmp_def));
-	struct memtx_tree_data<USE_HINT> *res =
+	}
+	struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *res =
 		memtx_tree_find(&index->tree, &key_data);
+	region_truncate(region, region_svp);
 	if (res == NULL) {
 		*result = NULL;
 		if (part_count == cmp_def->part_count)
@@ -929,21 +1347,60 @@ memtx_tree_index_get_raw(struct index *base, const char *key,
 	return 0;
 }
 
-template <bool USE_HINT>
+/**
+ * Set diag for a failed replace_check_dup() in a tree index.
+ */
+static void
+memtx_tree_index_set_dup_error(struct index *base, uint32_t errcode,
+			       struct tuple *dup_tuple, struct tuple *new_tuple)
+{
+	struct space *sp = space_cache_find(base->def->space_id);
+	if (sp == NULL)
+		return;
+	if (errcode == ER_TUPLE_FOUND) {
+		diag_set(ClientError, errcode, base->def->name,
+			 space_name(sp), tuple_str(dup_tuple),
+			 tuple_str(new_tuple));
+	} else {
+		diag_set(ClientError, errcode, base->def->name,
+			 space_name(sp));
+	}
+}
+
+/**
+ * Prepare a tuple to be inserted into an index. A tuple stored in
+ * an index with compact pointers must be referenced by an offset,
+ * see memtx_tuple_offset_reserve().
+ */
+template <bool COMPACT>
+static int
+memtx_tree_index_check_tuple(struct index *base, struct tuple *tuple)
+{
+	(void)base;
+	if (COMPACT && memtx_tuple_offset_reserve(tuple) != 0)
+		return -1;
+	return 0;
+}
+
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static int
 memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 			 struct tuple *new_tuple, enum dup_replace_mode mode,
 			 struct tuple **result, struct tuple **successor)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)base;
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 	if (new_tuple) {
-		struct memtx_tree_data<USE_HINT> new_data;
+		if (memtx_tree_index_check_tuple<COMPACT>(base, new_tuple) != 0)
+			return -1;
+		struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> new_data;
 		new_data.tuple = new_tuple;
 		if (USE_HINT)
 			new_data.set_hint(tuple_hint(new_tuple, cmp_def));
-		struct memtx_tree_data<USE_HINT> dup_data, suc_data;
+		struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> dup_data;
+		struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> suc_data;
 		dup_data.tuple = suc_data.tuple = NULL;
 
 		/* Try to optimistically replace the new_tuple. */
@@ -961,20 +1418,9 @@ memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 			memtx_tree_delete(&index->tree, new_data);
 			if (dup_data.tuple != NULL)
 				memtx_tree_insert(&index->tree, dup_data, NULL, NULL);
-			struct space *sp = space_cache_find(base->def->space_id);
-			if (sp != NULL) {
-				if (errcode == ER_TUPLE_FOUND) {
-					diag_set(ClientError, errcode,
-						 base->def->name,
-						 space_name(sp),
-						 tuple_str(dup_data.tuple),
-						 tuple_str(new_data.tuple));
-				} else {
-					diag_set(ClientError, errcode,
-						 base->def->name,
-						 space_name(sp));
-				}
-			}
+			memtx_tree_index_set_dup_error(base, errcode,
+						       dup_data.tuple,
+						       new_data.tuple);
 			return -1;
 		}
 		*successor = suc_data.tuple;
@@ -984,7 +1430,7 @@ memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 		}
 	}
 	if (old_tuple) {
-		struct memtx_tree_data<USE_HINT> old_data;
+		struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> old_data;
 		old_data.tuple = old_tuple;
 		if (USE_HINT)
 			old_data.set_hint(tuple_hint(old_tuple, cmp_def));
@@ -994,19 +1440,112 @@ memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 	return 0;
 }
 
+/**
+ * Replace function of an index with normalized keys. A normalized
+ * key is allocated in the engine's memory for each inserted tuple
+ * and is stored as the comparison hint. The key is freed when the
+ * tuple is deleted from the index. Iterators copy the key at the
+ * current position so there's no need to delay freeing it.
+ */
+template <bool PREFIX, int BLOCK_SIZE>
+static int
+memtx_tree_normalized_index_replace(struct index *base,
+				    struct tuple *old_tuple,
+				    struct tuple *new_tuple,
+				    enum dup_replace_mode mode,
+				    struct tuple **result,
+				    struct tuple **successor)
+{
+	using index_t = struct memtx_tree_index<true, false, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)base;
+	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	int rc = -1;
+	/*
+	 * Build the key to look up the old tuple in advance so
+	 * as not to fail after inserting the new tuple.
+	 */
+	const char *old_nkey = NULL;
+	if (old_tuple != NULL) {
+		old_nkey = tuple_normalized_key(old_tuple, cmp_def, region);
+		if (old_nkey == NULL)
+			goto out;
+	}
+	if (new_tuple != NULL) {
+		const char *new_nkey = memtx_tree_index_new_normalized_key(
+							index, new_tuple);
+		if (new_nkey == NULL)
+			goto out;
+		struct memtx_tree_data<true, false, PREFIX> new_data;
+		new_data.tuple = new_tuple;
+		new_data.set_hint((hint_t)new_nkey);
+		struct memtx_tree_data<true, false, PREFIX> dup_data, suc_data;
+		dup_data.tuple = suc_data.tuple = NULL;
+		if (memtx_tree_insert(&index->tree, new_data,
+				      &dup_data, &suc_data) != 0) {
+			memtx_tree_index_delete_normalized_key(index,
+							       new_data.hint);
+			diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
+				 "memtx_tree_index", "replace");
+			goto out;
+		}
+		uint32_t errcode = replace_check_dup(old_tuple,
+						     dup_data.tuple, mode);
+		if (errcode) {
+			memtx_tree_delete(&index->tree, new_data);
+			if (dup_data.tuple != NULL)
+				memtx_tree_insert(&index->tree, dup_data, NULL, NULL);
+			memtx_tree_index_set_dup_error(base, errcode,
+						       dup_data.tuple,
+						       new_data.tuple);
+			memtx_tree_index_delete_normalized_key(index,
+							       new_data.hint);
+			goto out;
+		}
+		*successor = suc_data.tuple;
+		if (dup_data.tuple != NULL) {
+			memtx_tree_index_delete_normalized_key(index,
+							       dup_data.hint);
+			*result = dup_data.tuple;
+			rc = 0;
+			goto out;
+		}
+	}
+	if (old_tuple != NULL) {
+		struct memtx_tree_data<true, false, PREFIX> old_data;
+		struct memtx_tree_data<true, false, PREFIX> deleted_data;
+		old_data.tuple = old_tuple;
+		old_data.set_hint((hint_t)old_nkey);
+		deleted_data.tuple = NULL;
+		memtx_tree_delete_value(&index->tree, old_data, &deleted_data);
+		if (deleted_data.tuple != NULL) {
+			memtx_tree_index_delete_normalized_key(index,
+							deleted_data.hint);
+		}
+	}
+	*result = old_tuple;
+	rc = 0;
+out:
+	region_truncate(region, region_svp);
+	return rc;
+}
+
 /**
  * Perform tuple insertion by given multikey index.
  * In case of replacement, all old tuple entries are deleted
  * by all it's multikey indexes.
  */
 static int
-memtx_tree_index_replace_multikey_one(struct memtx_tree_index<true> *index,
+memtx_tree_index_replace_multikey_one(
+			struct memtx_tree_index<true, false> *index,
 			struct tuple *old_tuple, struct tuple *new_tuple,
 			enum dup_replace_mode mode, hint_t hint,
-			struct memtx_tree_data<true> *replaced_data,
+			struct memtx_tree_data<true, false> *replaced_data,
 			bool *is_multikey_conflict)
 {
-	struct memtx_tree_data<true> new_data, dup_data;
+	struct memtx_tree_data<true, false> new_data, dup_data;
 	new_data.tuple = new_tuple;
 	new_data.hint = hint;
 	dup_data.tuple = NULL;
@@ -1062,11 +1601,12 @@ memtx_tree_index_replace_multikey_one(struct memtx_tree_index<true> *index,
  * delete operation is fault-tolerant.
  */
 static void
-memtx_tree_index_replace_multikey_rollback(struct memtx_tree_index<true> *index,
+memtx_tree_index_replace_multikey_rollback(
+			struct memtx_tree_index<true, false> *index,
 			struct tuple *new_tuple, struct tuple *replaced_tuple,
 			int err_multikey_idx)
 {
-	struct memtx_tree_data<true> data;
+	struct memtx_tree_data<true, false> data;
 	if (replaced_tuple != NULL) {
 		/* Restore replaced tuple index occurrences. */
 		struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
@@ -1140,8 +1680,8 @@ memtx_tree_index_replace_multikey(struct index *base, struct tuple *old_tuple,
 			struct tuple *new_tuple, enum dup_replace_mode mode,
 			struct tuple **result, struct tuple **successor)
 {
-	struct memtx_tree_index<true> *index =
-		(struct memtx_tree_index<true> *)base;
+	struct memtx_tree_index<true, false> *index =
+		(struct memtx_tree_index<true, false> *)base;
 
 	/* MUTLIKEY doesn't support successor for now. */
 	*successor = NULL;
@@ -1155,7 +1695,7 @@ memtx_tree_index_replace_multikey(struct index *base, struct tuple *old_tuple,
 		for (; (uint32_t) multikey_idx < multikey_count;
 		     multikey_idx++) {
 			bool is_multikey_conflict;
-			struct memtx_tree_data<true> replaced_data;
+			struct memtx_tree_data<true, false> replaced_data;
 			err = memtx_tree_index_replace_multikey_one(index,
 						old_tuple, new_tuple, mode,
 						multikey_idx, &replaced_data,
@@ -1180,7 +1720,7 @@ memtx_tree_index_replace_multikey(struct index *base, struct tuple *old_tuple,
 		}
 	}
 	if (old_tuple != NULL) {
-		struct memtx_tree_data<true> data;
+		struct memtx_tree_data<true, false> data;
 		data.tuple = old_tuple;
 		uint32_t multikey_count =
 			tuple_multikey_count(old_tuple, cmp_def);
@@ -1230,7 +1770,7 @@ struct func_key_undo {
 	/** A link to organize entries in list. */
 	struct rlist link;
 	/** An inserted record copy. */
-	struct memtx_tree_data<true> key;
+	struct memtx_tree_data<true, false> key;
 };
 
 /** Allocate a new func_key_undo on given region. */
@@ -1253,8 +1793,9 @@ func_key_undo_new(struct region *region)
  * return a given index object in it's original state.
  */
 static void
-memtx_tree_func_index_replace_rollback(struct memtx_tree_index<true> *index,
-				       struct rlist *old_keys,
+memtx_tree_func_index_replace_rollback(
+				struct memtx_tree_index<true, false> *index,
+				struct rlist *old_keys,
 				       struct rlist *new_keys)
 {
 	struct func_key_undo *entry;
@@ -1286,8 +1827,8 @@ memtx_tree_func_index_replace(struct index *base, struct tuple *old_tuple,
 	/* FUNC doesn't support successor for now. */
 	*successor = NULL;
 
-	struct memtx_tree_index<true> *index =
-		(struct memtx_tree_index<true> *)base;
+	struct memtx_tree_index<true, false> *index =
+		(struct memtx_tree_index<true, false> *)base;
 	struct index_def *index_def = index->base.def;
 	assert(index_def->key_def->for_func_index);
 
@@ -1320,7 +1861,7 @@ memtx_tree_func_index_replace(struct index *base, struct tuple *old_tuple,
 			undo->key.hint = (hint_t)key;
 			rlist_add(&new_keys, &undo->link);
 			bool is_multikey_conflict;
-			struct memtx_tree_data<true> old_data;
+			struct memtx_tree_data<true, false> old_data;
 			old_data.tuple = NULL;
 			err = memtx_tree_index_replace_multikey_one(index,
 						old_tuple, new_tuple,
@@ -1382,7 +1923,7 @@ memtx_tree_func_index_replace(struct index *base, struct tuple *old_tuple,
 		if (key_list_iterator_create(&it, old_tuple, index_def, false,
 					     func_index_key_dummy_alloc) != 0)
 			goto end;
-		struct memtx_tree_data<true> data, deleted_data;
+		struct memtx_tree_data<true, false> data, deleted_data;
 		data.tuple = old_tuple;
 		const char *key;
 		while (key_list_iterator_next(&it, &key) == 0 && key != NULL) {
@@ -1407,13 +1948,15 @@ end:
 	return rc;
 }
 
-template <bool UNCHANGED, bool USE_HINT>
+template <bool UNCHANGED, bool USE_HINT, bool COMPACT, bool PREFIX,
+	  int BLOCK_SIZE>
 static struct iterator *
 memtx_tree_index_create_iterator(struct index *base, enum iterator_type type,
 				 const char *key, uint32_t part_count)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)base;
 	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 
@@ -1433,23 +1976,54 @@ memtx_tree_index_create_iterator(struct index *base, enum iterator_type type,
 		key = NULL;
 	}
 
-	struct tree_iterator<USE_HINT> *it = (struct tree_iterator<USE_HINT> *)
-		mempool_alloc(&memtx->iterator_pool);
+	using iterator_t = struct tree_iterator<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	iterator_t *it = (iterator_t *)mempool_alloc(&memtx->iterator_pool);
 	if (it == NULL) {
-		diag_set(OutOfMemory, sizeof(struct tree_iterator<USE_HINT>),
+		diag_set(OutOfMemory, sizeof(iterator_t),
 			 "memtx_tree_index", "iterator");
 		return NULL;
 	}
 	iterator_create(&it->base, base);
 	it->pool = &memtx->iterator_pool;
-	it->base.next_raw = tree_iterator_start_raw<UNCHANGED, USE_HINT>;
+	it->base.next_raw = tree_iterator_start_raw<UNCHANGED, USE_HINT,
+						    COMPACT, PREFIX,
+						    BLOCK_SIZE>;
 	it->base.next = UNCHANGED ? it->base.next_raw : memtx_iterator_next;
-	it->base.free = tree_iterator_free<USE_HINT>;
+	it->base.free = tree_iterator_free<USE_HINT, COMPACT, PREFIX,
+					   BLOCK_SIZE>;
 	it->type = type;
 	it->key_data.key = key;
 	it->key_data.part_count = part_count;
-	if (USE_HINT)
+	if (index->normalized_def != NULL) {
+		/*
+		 * The iterator may outlive the fiber region so copy
+		 * the key to malloc. It's freed with the iterator.
+		 */
+		struct region *region = &fiber()->gc;
+		size_t region_svp = region_used(region);
+		const char *nkey = key_normalized_key(key, part_count,
+						      cmp_def, region);
+		if (nkey == NULL) {
+			region_truncate(region, region_svp);
+			mempool_free(it->pool, it);
+			return NULL;
+		}
+		uint32_t nkey_size = normalized_key_size(nkey);
+		char *nkey_copy = (char *)malloc(nkey_size);
+		if (nkey_copy == NULL) {
+			diag_set(OutOfMemory, nkey_size, "malloc",
+				 "normalized key");
+			region_truncate(region, region_svp);
+			mempool_free(it->pool, it);
+			return NULL;
+		}
+		memcpy(nkey_copy, nkey, nkey_size);
+		region_truncate(region, region_svp);
+		it->key_data.set_hint((hint_t)nkey_copy);
+	} else if (USE_HINT) {
 		it->key_data.set_hint(key_hint(key, part_count, cmp_def));
+	}
 	invalidate_tree_iterator(&it->tree_iterator);
 	it->current.tuple = NULL;
 	if (USE_HINT)
@@ -1458,26 +2032,28 @@ memtx_tree_index_create_iterator(struct index *base, enum iterator_type type,
 	return (struct iterator *)it;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static void
 memtx_tree_index_begin_build(struct index *base)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)base;
 	assert(memtx_tree_size(&index->tree) == 0);
 	(void)index;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static int
 memtx_tree_index_reserve(struct index *base, uint32_t size_hint)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)base;
 	if (size_hint < index->build_array_alloc_size)
 		return 0;
-	struct memtx_tree_data<USE_HINT> *tmp =
-		(struct memtx_tree_data<USE_HINT> *)
+	struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *tmp =
+		(struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *)
 			realloc(index->build_array, size_hint * sizeof(*tmp));
 	if (tmp == NULL) {
 		diag_set(OutOfMemory, size_hint * sizeof(*tmp),
@@ -1489,15 +2065,16 @@ memtx_tree_index_reserve(struct index *base, uint32_t size_hint)
 	return 0;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 /** Initialize the next element of the index build_array. */
 static int
-memtx_tree_index_build_array_append(struct memtx_tree_index<USE_HINT> *index,
-				    struct tuple *tuple, hint_t hint)
+memtx_tree_index_build_array_append(
+	struct memtx_tree_index<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *index,
+	struct tuple *tuple, hint_t hint)
 {
+	using data_t = struct memtx_tree_data<USE_HINT, COMPACT, PREFIX>;
 	if (index->build_array == NULL) {
-		index->build_array =
-			(struct memtx_tree_data<USE_HINT> *)malloc(MEMTX_EXTENT_SIZE);
+		index->build_array = (data_t *)malloc(MEMTX_EXTENT_SIZE);
 		if (index->build_array == NULL) {
 			diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
 				 "memtx_tree_index", "build_next");
@@ -1510,8 +2087,7 @@ memtx_tree_index_build_array_append(struct memtx_tree_index<USE_HINT> *index,
 	if (index->build_array_size == index->build_array_alloc_size) {
 		index->build_array_alloc_size = index->build_array_alloc_size +
 				DIV_ROUND_UP(index->build_array_alloc_size, 2);
-		struct memtx_tree_data<USE_HINT> *tmp =
-			(struct memtx_tree_data<USE_HINT> *)realloc(index->build_array,
+		data_t *tmp = (data_t *)realloc(index->build_array,
 				index->build_array_alloc_size * sizeof(*tmp));
 		if (tmp == NULL) {
 			diag_set(OutOfMemory, index->build_array_alloc_size *
@@ -1520,31 +2096,53 @@ memtx_tree_index_build_array_append(struct memtx_tree_index<USE_HINT> *index,
 		}
 		index->build_array = tmp;
 	}
-	struct memtx_tree_data<USE_HINT> *elem =
-		&index->build_array[index->build_array_size++];
+	data_t *elem = &index->build_array[index->build_array_size++];
 	elem->tuple = tuple;
 	if (USE_HINT)
 		elem->set_hint(hint);
 	return 0;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static int
 memtx_tree_index_build_next(struct index *base, struct tuple *tuple)
 {
 	if (index_filter_tuple(base, tuple) == NULL)
 		return 0;
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	if (memtx_tree_index_check_tuple<COMPACT>(base, tuple) != 0)
+		return -1;
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)base;
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 	return memtx_tree_index_build_array_append(index, tuple,
 						   tuple_hint(tuple, cmp_def));
 }
 
+template <bool PREFIX, int BLOCK_SIZE>
+static int
+memtx_tree_normalized_index_build_next(struct index *base, struct tuple *tuple)
+{
+	if (index_filter_tuple(base, tuple) == NULL)
+		return 0;
+	using index_t = struct memtx_tree_index<true, false, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)base;
+	const char *nkey = memtx_tree_index_new_normalized_key(index, tuple);
+	if (nkey == NULL)
+		return -1;
+	if (memtx_tree_index_build_array_append(index, tuple,
+						(hint_t)nkey) != 0) {
+		memtx_tree_index_delete_normalized_key(index, (hint_t)nkey);
+		return -1;
+	}
+	return 0;
+}
+
 static int
 memtx_tree_index_build_next_multikey(struct index *base, struct tuple *tuple)
 {
-	struct memtx_tree_index<true> *index = (struct memtx_tree_index<true> *)base;
+	struct memtx_tree_index<true, false> *index = (struct memtx_tree_index<true, false> *)base;
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 	uint32_t multikey_count = tuple_multikey_count(tuple, cmp_def);
 	for (uint32_t multikey_idx = 0; multikey_idx < multikey_count;
@@ -1559,7 +2157,7 @@ memtx_tree_index_build_next_multikey(struct index *base, struct tuple *tuple)
 static int
 memtx_tree_func_index_build_next(struct index *base, struct tuple *tuple)
 {
-	struct memtx_tree_index<true> *index = (struct memtx_tree_index<true> *)base;
+	struct memtx_tree_index<true, false> *index = (struct memtx_tree_index<true, false> *)base;
 	struct index_def *index_def = index->base.def;
 	assert(index_def->key_def->for_func_index);
 
@@ -1594,10 +2192,11 @@ error:
  * of equal tuples (in terms of index's cmp_def and have same
  * tuple pointer). The build_array is expected to be sorted.
  */
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static void
-memtx_tree_index_build_array_deduplicate(struct memtx_tree_index<USE_HINT> *index,
-			void (*destroy)(const char *hint))
+memtx_tree_index_build_array_deduplicate(
+	struct memtx_tree_index<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *index,
+	void (*destroy)(const char *hint))
 {
 	if (index->build_array_size == 0)
 		return;
@@ -1629,16 +2228,17 @@ memtx_tree_index_build_array_deduplicate(struct memtx_tree_index<USE_HINT> *inde
 	index->build_array_size = w_idx + 1;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static void
 memtx_tree_index_end_build(struct index *base)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)base;
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 	qsort_arg(index->build_array, index->build_array_size,
 		  sizeof(index->build_array[0]),
-		  memtx_tree_qcompare<USE_HINT>, cmp_def);
+		  memtx_tree_qcompare<USE_HINT, COMPACT, PREFIX>, cmp_def);
 	if (cmp_def->is_multikey) {
 		/*
 		 * Multikey index may have equal(in terms of
@@ -1647,10 +2247,10 @@ memtx_tree_index_end_build(struct index *base)
 		 * the following memtx_tree_build assumes that
 		 * all keys are unique.
 		 */
-		memtx_tree_index_build_array_deduplicate<USE_HINT>(index, NULL);
+		memtx_tree_index_build_array_deduplicate(index, NULL);
 	} else if (cmp_def->for_func_index) {
-		memtx_tree_index_build_array_deduplicate<USE_HINT>(index,
-							 func_index_key_free);
+		memtx_tree_index_build_array_deduplicate(
+			index, func_index_key_free);
 	}
 	memtx_tree_build(&index->tree, index->build_array,
 			 index->build_array_size);
@@ -1661,21 +2261,25 @@ memtx_tree_index_end_build(struct index *base)
 	index->build_array_alloc_size = 0;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 struct tree_snapshot_iterator {
 	struct snapshot_iterator base;
-	struct memtx_tree_index<USE_HINT> *index;
-	memtx_tree_iterator_t<USE_HINT> tree_iterator;
+	struct memtx_tree_index<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *index;
+	memtx_tree_iterator_t<USE_HINT, COMPACT, PREFIX,
+			      BLOCK_SIZE> tree_iterator;
 	struct memtx_tx_snapshot_cleaner cleaner;
 };
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static void
 tree_snapshot_iterator_free(struct snapshot_iterator *iterator)
 {
-	assert(iterator->free == &tree_snapshot_iterator_free<USE_HINT>);
-	struct tree_snapshot_iterator<USE_HINT> *it =
-		(struct tree_snapshot_iterator<USE_HINT> *)iterator;
+	using iterator_t = struct tree_snapshot_iterator<USE_HINT, COMPACT,
+							 PREFIX, BLOCK_SIZE>;
+	assert((iterator->free ==
+		&tree_snapshot_iterator_free<USE_HINT, COMPACT, PREFIX,
+					     BLOCK_SIZE>));
+	iterator_t *it = (iterator_t *)iterator;
 	memtx_leave_delayed_free_mode((struct memtx_engine *)
 				      it->index->base.engine);
 	memtx_tree_iterator_destroy(&it->index->tree, &it->tree_iterator);
@@ -1684,18 +2288,22 @@ tree_snapshot_iterator_free(struct snapshot_iterator *iterator)
 	free(iterator);
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static int
 tree_snapshot_iterator_next(struct snapshot_iterator *iterator,
 			    const char **data, uint32_t *size)
 {
-	assert(iterator->free == &tree_snapshot_iterator_free<USE_HINT>);
-	struct tree_snapshot_iterator<USE_HINT> *it =
-		(struct tree_snapshot_iterator<USE_HINT> *)iterator;
-	memtx_tree_t<USE_HINT> *tree = &it->index->tree;
+	using iterator_t = struct tree_snapshot_iterator<USE_HINT, COMPACT,
+							 PREFIX, BLOCK_SIZE>;
+	assert((iterator->free ==
+		&tree_snapshot_iterator_free<USE_HINT, COMPACT, PREFIX,
+					     BLOCK_SIZE>));
+	iterator_t *it = (iterator_t *)iterator;
+	memtx_tree_t<USE_HINT, COMPACT, PREFIX, BLOCK_SIZE> *tree =
+		&it->index->tree;
 
 	while (true) {
-		struct memtx_tree_data<USE_HINT> *res =
+		struct memtx_tree_data<USE_HINT, COMPACT, PREFIX> *res =
 			memtx_tree_iterator_get_elem(tree, &it->tree_iterator);
 
 		if (res == NULL) {
@@ -1722,18 +2330,18 @@ tree_snapshot_iterator_next(struct snapshot_iterator *iterator,
  * index modifications will not affect the iteration results.
  * Must be destroyed by iterator->free after usage.
  */
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static struct snapshot_iterator *
 memtx_tree_index_create_snapshot_iterator(struct index *base)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
-	struct tree_snapshot_iterator<USE_HINT> *it =
-		(struct tree_snapshot_iterator<USE_HINT> *)
-		calloc(1, sizeof(*it));
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)base;
+	using iterator_t = struct tree_snapshot_iterator<USE_HINT, COMPACT,
+							 PREFIX, BLOCK_SIZE>;
+	iterator_t *it = (iterator_t *)calloc(1, sizeof(*it));
 	if (it == NULL) {
-		diag_set(OutOfMemory,
-			 sizeof(struct tree_snapshot_iterator<USE_HINT>),
+		diag_set(OutOfMemory, sizeof(iterator_t),
 			 "memtx_tree_index", "create_snapshot_iterator");
 		return NULL;
 	}
@@ -1741,8 +2349,10 @@ memtx_tree_index_create_snapshot_iterator(struct index *base)
 	struct space *space = space_cache_find(base->def->space_id);
 	memtx_tx_snapshot_cleaner_create(&it->cleaner, space);
 
-	it->base.free = tree_snapshot_iterator_free<USE_HINT>;
-	it->base.next = tree_snapshot_iterator_next<USE_HINT>;
+	it->base.free = tree_snapshot_iterator_free<USE_HINT, COMPACT, PREFIX,
+						    BLOCK_SIZE>;
+	it->base.next = tree_snapshot_iterator_next<USE_HINT, COMPACT, PREFIX,
+						    BLOCK_SIZE>;
 	it->index = index;
 	index_ref(base);
 	it->tree_iterator = memtx_tree_iterator_first(&index->tree);
@@ -1758,7 +2368,9 @@ memtx_tree_index_create_snapshot_iterator(struct index *base)
  * key defintion is not completely initialized at that moment).
  */
 static const struct index_vtab memtx_tree_disabled_index_vtab = {
-	/* .destroy = */ memtx_tree_index_destroy<true>,
+	/* .destroy = */
+		memtx_tree_index_destroy<true, false, false,
+					 MEMTX_TREE_BLOCK_SIZE_DEFAULT>,
 	/* .commit_create = */ generic_index_commit_create,
 	/* .abort_create = */ generic_index_abort_create,
 	/* .commit_modify = */ generic_index_commit_modify,
@@ -1796,6 +2408,8 @@ enum memtx_tree_vtab_type {
 	MEMTX_TREE_VTAB_MULTIKEY,
 	/** Func index type. */
 	MEMTX_TREE_VTAB_FUNC,
+	/** Index with normalized keys. */
+	MEMTX_TREE_VTAB_NORMALIZED,
 	/** Disabled index type. */
 	MEMTX_TREE_VTAB_DISABLED,
 	/** Count of types. */
@@ -1803,99 +2417,209 @@ enum memtx_tree_vtab_type {
 };
 
 /**
- * Get index vtab by @a TYPE, @a UNCHANGED and @a USE_HINT, template
- * version. USE_HINT == false is only allowed for general index type.
- * If UNCHANGED == true iterator->next and index->get functions are
- * the same as it's raw versions.
+ * Get index vtab by @a TYPE, @a UNCHANGED, @a USE_HINT, @a COMPACT,
+ * @a PREFIX and @a BLOCK_SIZE, template version. USE_HINT == false
+ * is only allowed for general index type. COMPACT == true is only
+ * allowed for general index type without hints. PREFIX == true is
+ * only allowed for indexes with normalized keys. If UNCHANGED == true
+ * iterator->next and index->get functions are the same as it's raw
+ * versions.
  */
-template <memtx_tree_vtab_type TYPE, bool UNCHANGED, bool USE_HINT = true>
+template <memtx_tree_vtab_type TYPE, bool UNCHANGED, bool USE_HINT = true,
+	  bool COMPACT = false, bool PREFIX = false,
+	  int BLOCK_SIZE = MEMTX_TREE_BLOCK_SIZE_DEFAULT>
 static const struct index_vtab *
 get_memtx_tree_index_vtab(void)
 {
 	static_assert(USE_HINT || TYPE == MEMTX_TREE_VTAB_GENERAL,
-		      "Multikey and func indexes must use hints");
+		      "Multikey, func and normalized indexes must use hints");
+	static_assert(!COMPACT || (TYPE == MEMTX_TREE_VTAB_GENERAL &&
+				   !USE_HINT),
+		      "Only general indexes without hints can be compact");
+	static_assert(!PREFIX || TYPE == MEMTX_TREE_VTAB_NORMALIZED,
+		      "Only indexes with normalized keys can inline prefixes");
 
 	if (TYPE == MEMTX_TREE_VTAB_DISABLED)
 		return &memtx_tree_disabled_index_vtab;
 
 	const bool is_mk = TYPE == MEMTX_TREE_VTAB_MULTIKEY;
 	const bool is_func = TYPE == MEMTX_TREE_VTAB_FUNC;
+	const bool is_norm = TYPE == MEMTX_TREE_VTAB_NORMALIZED;
 	static const struct index_vtab vtab = {
-		/* .destroy = */ memtx_tree_index_destroy<USE_HINT>,
+		/* .destroy = */
+			memtx_tree_index_destroy<USE_HINT, COMPACT, PREFIX,
+						 BLOCK_SIZE>,
 		/* .commit_create = */ generic_index_commit_create,
 		/* .abort_create = */ generic_index_abort_create,
 		/* .commit_modify = */ generic_index_commit_modify,
 		/* .commit_drop = */ generic_index_commit_drop,
-		/* .update_def = */ memtx_tree_index_update_def<USE_HINT>,
+		/* .update_def = */
+			memtx_tree_index_update_def<USE_HINT, COMPACT, PREFIX,
+						    BLOCK_SIZE>,
 		/* .depends_on_pk = */ memtx_tree_index_depends_on_pk,
 		/* .def_change_requires_rebuild = */
 			memtx_index_def_change_requires_rebuild,
-		/* .size = */ memtx_tree_index_size<USE_HINT>,
-		/* .bsize = */ memtx_tree_index_bsize<USE_HINT>,
+		/* .size = */
+			memtx_tree_index_size<USE_HINT, COMPACT, PREFIX,
+					      BLOCK_SIZE>,
+		/* .bsize = */
+			memtx_tree_index_bsize<USE_HINT, COMPACT, PREFIX,
+					       BLOCK_SIZE>,
 		/* .min = */ generic_index_min,
 		/* .max = */ generic_index_max,
-		/* .random = */ memtx_tree_index_random<USE_HINT>,
-		/* .count = */ memtx_tree_index_count<USE_HINT>,
-		/* .get_raw */ memtx_tree_index_get_raw<USE_HINT>,
-		/* .get = */ UNCHANGED ? memtx_tree_index_get_raw<USE_HINT> :
+		/* .random = */
+			memtx_tree_index_random<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>,
+		/* .count = */
+			memtx_tree_index_count<USE_HINT, COMPACT, PREFIX,
+					       BLOCK_SIZE>,
+		/* .get_raw */
+			memtx_tree_index_get_raw<USE_HINT, COMPACT, PREFIX,
+						 BLOCK_SIZE>,
+		/* .get = */ UNCHANGED ?
+			memtx_tree_index_get_raw<USE_HINT, COMPACT, PREFIX,
+						 BLOCK_SIZE> :
 			memtx_index_get,
 		/* .replace = */ is_mk ? memtx_tree_index_replace_multikey :
 				 is_func ? memtx_tree_func_index_replace :
-				 memtx_tree_index_replace<USE_HINT>,
+				 is_norm ?
+				 memtx_tree_normalized_index_replace<
+					PREFIX, BLOCK_SIZE> :
+				 memtx_tree_index_replace<USE_HINT, COMPACT,
+							  PREFIX, BLOCK_SIZE>,
 		/* .create_iterator = */
-			memtx_tree_index_create_iterator<UNCHANGED, USE_HINT>,
+			memtx_tree_index_create_iterator<
+				UNCHANGED, USE_HINT, COMPACT, PREFIX, BLOCK_SIZE>,
 		/* .create_snapshot_iterator = */
-			memtx_tree_index_create_snapshot_iterator<USE_HINT>,
+			memtx_tree_index_create_snapshot_iterator<
+				USE_HINT, COMPACT, PREFIX, BLOCK_SIZE>,
 		/* .stat = */ generic_index_stat,
 		/* .compact = */ generic_index_compact,
 		/* .reset_stat = */ generic_index_reset_stat,
-		/* .begin_build = */ memtx_tree_index_begin_build<USE_HINT>,
-		/* .reserve = */ memtx_tree_index_reserve<USE_HINT>,
+		/* .begin_build = */
+			memtx_tree_index_begin_build<USE_HINT, COMPACT, PREFIX,
+						     BLOCK_SIZE>,
+		/* .reserve = */
+			memtx_tree_index_reserve<USE_HINT, COMPACT, PREFIX,
+						 BLOCK_SIZE>,
 		/* .build_next = */ is_mk ? memtx_tree_index_build_next_multikey :
 				    is_func ? memtx_tree_func_index_build_next :
-				    memtx_tree_index_build_next<USE_HINT>,
-		/* .end_build = */ memtx_tree_index_end_build<USE_HINT>,
+				    is_norm ?
+				    memtx_tree_normalized_index_build_next<
+					PREFIX, BLOCK_SIZE> :
+				    memtx_tree_index_build_next<USE_HINT,
+					COMPACT, PREFIX, BLOCK_SIZE>,
+		/* .end_build = */
+			memtx_tree_index_end_build<USE_HINT, COMPACT, PREFIX,
+						   BLOCK_SIZE>,
 	};
 	return &vtab;
 }
 
 /**
- * Get index vtab by @a type and @a use_hint, argument version.
- * @a use_hint is ignored for every type except MEMTX_TREE_VTAB_GENERAL.
+ * Get index vtab of a general or normalized index by @a unchanged,
+ * the rest is template arguments.
+ */
+template <memtx_tree_vtab_type TYPE, bool USE_HINT, bool COMPACT,
+	  bool PREFIX, int BLOCK_SIZE>
+static const struct index_vtab *
+get_memtx_tree_index_vtab(bool unchanged)
+{
+	return unchanged ?
+	       get_memtx_tree_index_vtab<TYPE, true, USE_HINT, COMPACT,
+					 PREFIX, BLOCK_SIZE>() :
+	       get_memtx_tree_index_vtab<TYPE, false, USE_HINT, COMPACT,
+					 PREFIX, BLOCK_SIZE>();
+}
+
+/**
+ * Get index vtab of a general or normalized index by @a unchanged and
+ * @a block_size, the rest is template arguments.
+ */
+template <memtx_tree_vtab_type TYPE, bool USE_HINT, bool COMPACT,
+	  bool PREFIX>
+static const struct index_vtab *
+get_memtx_tree_index_vtab(bool unchanged, uint32_t block_size)
+{
+	switch (block_size) {
+	case 512:
+		return get_memtx_tree_index_vtab<TYPE, USE_HINT, COMPACT,
+						 PREFIX, 512>(unchanged);
+	case 1024:
+		return get_memtx_tree_index_vtab<TYPE, USE_HINT, COMPACT,
+						 PREFIX, 1024>(unchanged);
+	case 2048:
+		return get_memtx_tree_index_vtab<TYPE, USE_HINT, COMPACT,
+						 PREFIX, 2048>(unchanged);
+	default:
+		unreachable();
+	}
+	return NULL;
+}
+
+/**
+ * Get index vtab by @a type, @a use_hint, @a compact, @a prefix and
+ * @a block_size, argument version. @a use_hint and @a compact are
+ * ignored for every type except MEMTX_TREE_VTAB_GENERAL, @a prefix
+ * is ignored for every type except MEMTX_TREE_VTAB_NORMALIZED and
+ * @a block_size is ignored for multikey, func and disabled indexes.
  */
 static const struct index_vtab *
 get_memtx_tree_index_vtab(memtx_tree_vtab_type type, bool unchanged,
-			  bool use_hint)
-{
-	static const index_vtab *choice[MEMTX_TREE_VTAB_TYPE_COUNT][2][2] = {
-		{{get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_GENERAL, false, false>(),
-		  get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_GENERAL, false, true>()},
-		 {get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_GENERAL, true, false>(),
-		  get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_GENERAL, true, true>()}},
-		{{get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_MULTIKEY, false>(),
-		  get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_MULTIKEY, false>()},
-		 {get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_MULTIKEY, true>(),
-		  get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_MULTIKEY, true>()}},
-		{{get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_FUNC, false>(),
-		  get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_FUNC, false>()},
-		 {get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_FUNC, true>(),
-		  get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_FUNC, true>()}},
-		{{get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_DISABLED, false>(),
-		  get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_DISABLED, false>()},
-		 {get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_DISABLED, true>(),
-		  get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_DISABLED, true>()}}
-	};
-	return choice[type][unchanged][use_hint];
+			  bool use_hint, bool compact, bool prefix,
+			  uint32_t block_size)
+{
+	switch (type) {
+	case MEMTX_TREE_VTAB_GENERAL:
+		if (compact) {
+			assert(!use_hint);
+			return get_memtx_tree_index_vtab<
+				MEMTX_TREE_VTAB_GENERAL, false, true, false>(
+					unchanged, block_size);
+		}
+		if (use_hint) {
+			return get_memtx_tree_index_vtab<
+				MEMTX_TREE_VTAB_GENERAL, true, false, false>(
+					unchanged, block_size);
+		}
+		return get_memtx_tree_index_vtab<
+			MEMTX_TREE_VTAB_GENERAL, false, false, false>(
+				unchanged, block_size);
+	case MEMTX_TREE_VTAB_NORMALIZED:
+		if (prefix) {
+			return get_memtx_tree_index_vtab<
+				MEMTX_TREE_VTAB_NORMALIZED, true, false, true>(
+					unchanged, block_size);
+		}
+		return get_memtx_tree_index_vtab<
+			MEMTX_TREE_VTAB_NORMALIZED, true, false, false>(
+				unchanged, block_size);
+	case MEMTX_TREE_VTAB_MULTIKEY:
+		return unchanged ?
+		       get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_MULTIKEY,
+						 true>() :
+		       get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_MULTIKEY,
+						 false>();
+	case MEMTX_TREE_VTAB_FUNC:
+		return unchanged ?
+		       get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_FUNC, true>() :
+		       get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_FUNC, false>();
+	case MEMTX_TREE_VTAB_DISABLED:
+		return &memtx_tree_disabled_index_vtab;
+	default:
+		unreachable();
+	}
+	return NULL;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool COMPACT, bool PREFIX, int BLOCK_SIZE>
 static struct index *
 memtx_tree_index_new_tpl(struct memtx_engine *memtx, struct index_def *def,
 			 const struct index_vtab *vtab)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)
-		calloc(1, sizeof(*index));
+	using index_t = struct memtx_tree_index<USE_HINT, COMPACT, PREFIX,
+						BLOCK_SIZE>;
+	index_t *index = (index_t *)calloc(1, sizeof(*index));
 	if (index == NULL) {
 		diag_set(OutOfMemory, sizeof(*index),
 			 "malloc", "struct memtx_tree_index");
@@ -1911,19 +2635,35 @@ memtx_tree_index_new_tpl(struct memtx_engine *memtx, struct index_def *def,
 	struct key_def *cmp_def;
 	cmp_def = def->opts.is_unique && !def->key_def->is_nullable ?
 			index->base.def->key_def : index->base.def->cmp_def;
+	if (def->opts.normalized_keys) {
+		index->normalized_def = normalized_key_def_new(cmp_def);
+		if (index->normalized_def == NULL) {
+			index_def_delete(index->base.def);
+			free(index);
+			return NULL;
+		}
+		cmp_def = index->normalized_def;
+	}
 
 	memtx_tree_create(&index->tree, cmp_def, memtx_index_extent_alloc,
 			  memtx_index_extent_free, memtx);
+	if (COMPACT)
+		memtx->compact_index_count++;
 	return &index->base;
 }
 
 static void
 memtx_tree_choose_type_and_hint(struct index_def *def,
 				memtx_tree_vtab_type *type,
-				bool *use_hint)
+				bool *use_hint, bool *compact, bool *prefix,
+				uint32_t *block_size)
 {
 	*type = MEMTX_TREE_VTAB_GENERAL;
-	*use_hint = true; /* Force hints for multikey and func indexes. */
+	/* Force hints for multikey, func and normalized indexes. */
+	*use_hint = true;
+	*compact = false;
+	*prefix = false;
+	*block_size = def->opts.block_size;
 	if (def->key_def->for_func_index) {
 		if (def->key_def->func_index_func == NULL)
 			*type = MEMTX_TREE_VTAB_DISABLED;
@@ -1931,30 +2671,82 @@ memtx_tree_choose_type_and_hint(struct index_def *def,
 			*type = MEMTX_TREE_VTAB_FUNC;
 	} else if (def->key_def->is_multikey) {
 		*type = MEMTX_TREE_VTAB_MULTIKEY;
+	} else if (def->opts.normalized_keys) {
+		*type = MEMTX_TREE_VTAB_NORMALIZED;
+		*prefix = def->opts.inline_prefix;
+	} else if (def->opts.compact_pointers) {
+		*use_hint = false;
+		*compact = true;
 	} else {
 		*use_hint = def->opts.hint;
 	}
 }
 
+/**
+ * Allocate a tree index with the given @a BLOCK_SIZE, the rest is
+ * template arguments.
+ */
+template <bool USE_HINT, bool COMPACT, bool PREFIX>
+static struct index *
+memtx_tree_index_new_tpl(struct memtx_engine *memtx, struct index_def *def,
+			 const struct index_vtab *vtab, uint32_t block_size)
+{
+	switch (block_size) {
+	case 512:
+		return memtx_tree_index_new_tpl<USE_HINT, COMPACT, PREFIX,
+						512>(memtx, def, vtab);
+	case 1024:
+		return memtx_tree_index_new_tpl<USE_HINT, COMPACT, PREFIX,
+						1024>(memtx, def, vtab);
+	case 2048:
+		return memtx_tree_index_new_tpl<USE_HINT, COMPACT, PREFIX,
+						2048>(memtx, def, vtab);
+	default:
+		unreachable();
+	}
+	return NULL;
+}
+
 struct index *
 memtx_tree_index_new(struct memtx_engine *memtx, struct index_def *def)
 {
 	const struct index_vtab *vtab;
 	memtx_tree_vtab_type type;
-	bool use_hint;
-	memtx_tree_choose_type_and_hint(def, &type, &use_hint);
-	vtab = get_memtx_tree_index_vtab(type, true, use_hint);
-	if (use_hint)
-		return memtx_tree_index_new_tpl<true>(memtx, def, vtab);
+	bool use_hint, compact, prefix;
+	uint32_t block_size;
+	memtx_tree_choose_type_and_hint(def, &type, &use_hint, &compact,
+					&prefix, &block_size);
+	vtab = get_memtx_tree_index_vtab(type, true, use_hint, compact,
+					 prefix, block_size);
+	/*
+	 * Multikey, func and disabled indexes always use the default
+	 * block size, see memtx_space_check_index_def().
+	 */
+	if (type != MEMTX_TREE_VTAB_GENERAL &&
+	    type != MEMTX_TREE_VTAB_NORMALIZED)
+		block_size = MEMTX_TREE_BLOCK_SIZE_DEFAULT;
+	if (compact)
+		return memtx_tree_index_new_tpl<false, true, false>(
+				memtx, def, vtab, block_size);
+	else if (prefix)
+		return memtx_tree_index_new_tpl<true, false, true>(
+				memtx, def, vtab, block_size);
+	else if (use_hint)
+		return memtx_tree_index_new_tpl<true, false, false>(
+				memtx, def, vtab, block_size);
 	else
-		return memtx_tree_index_new_tpl<false>(memtx, def, vtab);
+		return memtx_tree_index_new_tpl<false, false, false>(
+				memtx, def, vtab, block_size);
 }
 
 void
 memtx_tree_index_set_vtab(struct index *index, bool unchanged)
 {
 	memtx_tree_vtab_type type;
-	bool use_hint;
-	memtx_tree_choose_type_and_hint(index->def, &type, &use_hint);
-	index->vtab = get_memtx_tree_index_vtab(type, unchanged, use_hint);
+	bool use_hint, compact, prefix;
+	uint32_t block_size;
+	memtx_tree_choose_type_and_hint(index->def, &type, &use_hint,
+					&compact, &prefix, &block_size);
+	index->vtab = get_memtx_tree_index_vtab(type, unchanged, use_hint,
+						compact, prefix, block_size);
 }
@@ -30,6 +30,8 @@
  * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
  */
+#include <stdbool.h>
+#include <stdint.h>
 
 #if defined(__cplusplus)
 extern "C" {
@@ -39,6 +41,22 @@ struct index;
 struct index_def;
 struct memtx_engine;
 
+/**
+ * Block size of a memtx tree index if it isn't set explicitly with
+ * the block_size index option.
+ */
+enum { MEMTX_TREE_BLOCK_SIZE_DEFAULT = 512 };
+
+/**
+ * Check if @a block_size is supported by memtx tree indexes.
+ * A tree is instantiated for each of the supported sizes.
+ */
+static inline bool
+memtx_tree_block_size_is_valid(uint32_t block_size)
+{
+	return block_size == 512 || block_size == 1024 || block_size == 2048;
+}
+
 struct index *
 memtx_tree_index_new(struct memtx_engine *memtx, struct index_def *def);
 
@@ -0,0 +1,239 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2021, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "memtx_tuple_compression.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <msgpuck.h>
+#include <small/region.h>
+
+#include "diag.h"
+#include "errcode.h"
+#include "fiber.h"
+#include "index.h"
+#include "memtx_engine.h"
+#include "mp_compression.h"
+#include "trivia/util.h"
+
+struct tuple *
+memtx_tuple_compress(struct tuple *tuple)
+{
+	struct tuple_format *format = tuple_format(tuple);
+	assert(format->is_compressed);
+	uint32_t bsize;
+	const char *data = tuple_data_range(tuple, &bsize);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	/* Compressed fields never get bigger than the original ones. */
+	char *buf = region_alloc(region, bsize);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, bsize, "region_alloc", "buf");
+		return NULL;
+	}
+	const char *pos = data;
+	uint32_t field_count = mp_decode_array(&pos);
+	char *buf_end = mp_encode_array(buf, field_count);
+	uint32_t format_field_count = tuple_format_field_count(format);
+	bool is_compressed = false;
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field = pos;
+		mp_next(&pos);
+		enum compression_type type = COMPRESSION_TYPE_NONE;
+		if (i < format_field_count)
+			type = tuple_format_field(format, i)->compression_type;
+		if (type != COMPRESSION_TYPE_NONE) {
+			char *end = mp_compress(buf_end, field, pos - field,
+						type);
+			if (end != NULL) {
+				buf_end = end;
+				is_compressed = true;
+				continue;
+			}
+		}
+		memcpy(buf_end, field, pos - field);
+		buf_end += pos - field;
+	}
+	assert(pos == data + bsize);
+	struct tuple *result = tuple;
+	if (is_compressed) {
+		/* The data was validated before compression. */
+		result = memtx_tuple_new_raw(format, buf, buf_end, false);
+	}
+	region_truncate(region, region_svp);
+	return result;
+}
+
+/**
+ * Calculate the size of tuple data [@a data, @a data + @a bsize)
+ * with all fields decompressed. Sets @a size to 0 if the tuple
+ * doesn't have compressed fields.
+ */
+static int
+tuple_data_decompressed_size(const char *data, uint32_t bsize,
+			     size_t *size)
+{
+	const char *pos = data;
+	uint32_t field_count = mp_decode_array(&pos);
+	bool is_compressed = false;
+	size_t total = bsize;
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field = pos;
+		mp_next(&pos);
+		if (!mp_is_compression(field))
+			continue;
+		size_t field_size = mp_decompressed_size(field);
+		if (field_size == 0) {
+			diag_set(ClientError, ER_DECOMPRESSION,
+				 "invalid compressed field");
+			return -1;
+		}
+		total = total - (pos - field) + field_size;
+		is_compressed = true;
+	}
+	*size = is_compressed ? total : 0;
+	return 0;
+}
+
+/**
+ * Decompress all fields of tuple data [@a data, @a data + @a bsize)
+ * to @a buf of @a size bytes, as calculated by
+ * tuple_data_decompressed_size(). Returns the end of the
+ * decompressed data.
+ */
+static char *
+tuple_data_decompress(const char *data, uint32_t bsize,
+		      char *buf, size_t size)
+{
+	const char *pos = data;
+	uint32_t field_count = mp_decode_array(&pos);
+	char *buf_end = mp_encode_array(buf, field_count);
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field = pos;
+		if (mp_is_compression(field)) {
+			size_t field_size = mp_decompress(&pos, buf_end,
+							  buf + size - buf_end);
+			if (field_size == 0) {
+				diag_set(ClientError, ER_DECOMPRESSION,
+					 "invalid compressed field");
+				return NULL;
+			}
+			buf_end += field_size;
+			continue;
+		}
+		mp_next(&pos);
+		memcpy(buf_end, field, pos - field);
+		buf_end += pos - field;
+	}
+	assert(pos == data + bsize);
+	(void)bsize;
+	assert(buf_end == buf + size);
+	return buf_end;
+}
+
+struct tuple *
+memtx_tuple_decompress(struct tuple *tuple)
+{
+	uint32_t bsize;
+	const char *data = tuple_data_range(tuple, &bsize);
+	size_t size;
+	if (tuple_data_decompressed_size(data, bsize, &size) != 0)
+		return NULL;
+	if (size == 0)
+		return tuple;
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	struct tuple *result = NULL;
+	char *buf = region_alloc(region, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc", "buf");
+		goto out;
+	}
+	char *buf_end = tuple_data_decompress(data, bsize, buf, size);
+	if (buf_end == NULL)
+		goto out;
+	/* The data was validated before compression. */
+	result = memtx_tuple_new_raw(tuple_format(tuple), buf, buf_end, false);
+out:
+	region_truncate(region, region_svp);
+	return result;
+}
+
+/**
+ * Snapshot iterator that decompresses tuples returned by another
+ * snapshot iterator. Decompressed tuples are stored in a malloc'ed
+ * buffer rather than allocated from memtx, because the iterator
+ * is used from a thread other than tx.
+ */
+struct memtx_decompress_snapshot_iterator {
+	struct snapshot_iterator base;
+	/** Wrapped iterator. */
+	struct snapshot_iterator *it;
+	/** Buffer for the last decompressed tuple. */
+	char *buf;
+	/** Size of the buffer. */
+	size_t buf_size;
+};
+
+static int
+memtx_decompress_snapshot_iterator_next(struct snapshot_iterator *base,
+					const char **data, uint32_t *size)
+{
+	struct memtx_decompress_snapshot_iterator *it =
+		(struct memtx_decompress_snapshot_iterator *)base;
+	int rc = it->it->next(it->it, data, size);
+	if (rc != 0 || *data == NULL)
+		return rc;
+	size_t new_size;
+	if (tuple_data_decompressed_size(*data, *size, &new_size) != 0)
+		return -1;
+	if (new_size == 0)
+		return 0;
+	if (new_size > it->buf_size) {
+		char *buf = realloc(it->buf, new_size);
+		if (buf == NULL) {
+			diag_set(OutOfMemory, new_size, "realloc", "buf");
+			return -1;
+		}
+		it->buf = buf;
+		it->buf_size = new_size;
+	}
+	char *buf_end = tuple_data_decompress(*data, *size, it->buf,
+					      new_size);
+	if (buf_end == NULL)
+		return -1;
+	*data = it->buf;
+	*size = buf_end - it->buf;
+	return 0;
+}
+
+static void
+memtx_decompress_snapshot_iterator_free(struct snapshot_iterator *base)
+{
+	struct memtx_decompress_snapshot_iterator *it =
+		(struct memtx_decompress_snapshot_iterator *)base;
+	it->it->free(it->it);
+	free(it->buf);
+	free(it);
+}
+
+struct snapshot_iterator *
+memtx_decompress_snapshot_iterator_new(struct snapshot_iterator *base)
+{
+	struct memtx_decompress_snapshot_iterator *it =
+		malloc(sizeof(*it));
+	if (it == NULL) {
+		diag_set(OutOfMemory, sizeof(*it), "malloc",
+			 "struct memtx_decompress_snapshot_iterator");
+		base->free(base);
+		return NULL;
+	}
+	it->base.next = memtx_decompress_snapshot_iterator_next;
+	it->base.free = memtx_decompress_snapshot_iterator_free;
+	it->it = base;
+	it->buf = NULL;
+	it->buf_size = 0;
+	return &it->base;
+}
@@ -17,6 +17,8 @@
 extern "C" {
 #endif
 
+struct snapshot_iterator;
+
 static inline struct tuple *
 memtx_tuple_compress(struct tuple *tuple)
 {
@@ -41,6 +43,14 @@ memtx_tuple_maybe_decompress(struct tuple *tuple)
         return memtx_tuple_decompress(tuple);
 }
 
+static inline struct snapshot_iterator *
+memtx_decompress_snapshot_iterator_new(struct snapshot_iterator *it)
+{
+	(void)it;
+	unreachable();
+	return NULL;
+}
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -0,0 +1,53 @@
+#pragma once
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2021, Tarantool AUTHORS, please see AUTHORS file.
+ */
+
+#include "tuple.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct snapshot_iterator;
+
+/**
+ * Compress fields of @a tuple for which compression is enabled
+ * in the tuple format. A field is stored compressed only if it
+ * gets smaller after compression. Returns a new tuple or @a tuple
+ * itself if no field was compressed. On error returns NULL and
+ * sets diag.
+ */
+struct tuple *
+memtx_tuple_compress(struct tuple *tuple);
+
+/**
+ * Decompress all compressed fields of @a tuple. Returns a new
+ * tuple or @a tuple itself if it has no compressed fields.
+ * On error returns NULL and sets diag.
+ */
+struct tuple *
+memtx_tuple_decompress(struct tuple *tuple);
+
+static inline struct tuple *
+memtx_tuple_maybe_decompress(struct tuple *tuple)
+{
+	if (!tuple_is_compressed(tuple))
+		return tuple;
+	return memtx_tuple_decompress(tuple);
+}
+
+/**
+ * Wrap snapshot iterator @a it so that it returns tuple data with
+ * all fields decompressed. Takes ownership of @a it. The returned
+ * iterator may be used from any thread, like the one it wraps.
+ * On error frees @a it, returns NULL and sets diag.
+ */
+struct snapshot_iterator *
+memtx_decompress_snapshot_iterator_new(struct snapshot_iterator *it);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
@@ -0,0 +1,326 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2021, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "normalized_key.h"
+
+#include <msgpuck.h>
+#include <small/region.h>
+
+#include "coll/coll.h"
+#include "diag.h"
+#include "key_def.h"
+#include "tuple.h"
+
+bool
+key_part_is_normalizable(const struct key_part *part)
+{
+	switch (part->type) {
+	case FIELD_TYPE_UNSIGNED:
+	case FIELD_TYPE_INTEGER:
+	case FIELD_TYPE_BOOLEAN:
+	case FIELD_TYPE_STRING:
+	case FIELD_TYPE_VARBINARY:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/** Normalized key being built on a region. */
+struct normalized_key_buf {
+	/** Region the key is allocated on. */
+	struct region *region;
+	/** Key data, starts with the length header. */
+	char *data;
+	/** Number of bytes used, including the header. */
+	size_t size;
+	/** Number of bytes allocated. */
+	size_t capacity;
+};
+
+static int
+normalized_key_buf_create(struct normalized_key_buf *buf,
+			  struct region *region)
+{
+	/* Enough for most keys without reallocation. */
+	const size_t capacity = 64;
+	buf->region = region;
+	buf->data = region_alloc(region, capacity);
+	if (buf->data == NULL) {
+		diag_set(OutOfMemory, capacity, "region_alloc", "key");
+		return -1;
+	}
+	buf->size = NORMALIZED_KEY_HEADER_SIZE;
+	buf->capacity = capacity;
+	return 0;
+}
+
+/**
+ * Make sure that the buffer has at least @a size bytes available
+ * and return a pointer to them.
+ */
+static char *
+normalized_key_buf_reserve(struct normalized_key_buf *buf, size_t size)
+{
+	if (buf->size + size <= buf->capacity)
+		return buf->data + buf->size;
+	size_t capacity = buf->capacity;
+	while (capacity < buf->size + size)
+		capacity *= 2;
+	/* The old buffer is freed when the region is truncated. */
+	char *data = region_alloc(buf->region, capacity);
+	if (data == NULL) {
+		diag_set(OutOfMemory, capacity, "region_alloc", "key");
+		return NULL;
+	}
+	memcpy(data, buf->data, buf->size);
+	buf->data = data;
+	buf->capacity = capacity;
+	return buf->data + buf->size;
+}
+
+/** Append a byte string escaping zero bytes. */
+static int
+normalized_key_buf_put_bin(struct normalized_key_buf *buf,
+			   const char *str, uint32_t len)
+{
+	char *pos = normalized_key_buf_reserve(buf, 2 * (size_t)len + 2);
+	if (pos == NULL)
+		return -1;
+	for (uint32_t i = 0; i < len; i++) {
+		*pos++ = str[i];
+		if (str[i] == '\0')
+			*pos++ = '\xff';
+	}
+	*pos++ = '\0';
+	*pos++ = '\0';
+	buf->size = pos - buf->data;
+	return 0;
+}
+
+/** Append a collation sort key of a string terminated with zero. */
+static int
+normalized_key_buf_put_sort_key(struct normalized_key_buf *buf,
+				const char *str, uint32_t len,
+				struct coll *coll)
+{
+	/* Sort keys are usually not much longer than strings. */
+	size_t avail = 2 * (size_t)len + 1;
+	char *pos = normalized_key_buf_reserve(buf, avail);
+	if (pos == NULL)
+		return -1;
+	size_t key_len = coll->sort_key(str, len, pos, avail - 1, coll);
+	if (key_len > avail - 1) {
+		avail = key_len + 1;
+		pos = normalized_key_buf_reserve(buf, avail);
+		if (pos == NULL)
+			return -1;
+		coll->sort_key(str, len, pos, key_len, coll);
+	}
+	pos[key_len] = '\0';
+	buf->size += key_len + 1;
+	return 0;
+}
+
+/**
+ * Append a normalized key part built from a MsgPack field, which
+ * may be NULL if the field is absent.
+ */
+static int
+normalized_key_buf_put_part(struct normalized_key_buf *buf,
+			    struct key_part *part, const char *field)
+{
+	char *pos;
+	if (key_part_is_nullable(part)) {
+		bool is_null = field == NULL || mp_typeof(*field) == MP_NIL;
+		pos = normalized_key_buf_reserve(buf, 1);
+		if (pos == NULL)
+			return -1;
+		*pos = is_null ? 0 : 1;
+		buf->size++;
+		if (is_null)
+			return 0;
+	}
+	assert(field != NULL);
+	const char *str;
+	uint32_t len;
+	switch (part->type) {
+	case FIELD_TYPE_UNSIGNED:
+		pos = normalized_key_buf_reserve(buf, sizeof(uint64_t));
+		if (pos == NULL)
+			return -1;
+		mp_store_u64(pos, mp_decode_uint(&field));
+		buf->size += sizeof(uint64_t);
+		return 0;
+	case FIELD_TYPE_INTEGER:
+		pos = normalized_key_buf_reserve(buf, 1 + sizeof(uint64_t));
+		if (pos == NULL)
+			return -1;
+		/*
+		 * A non-negative value may be encoded as MP_INT, so
+		 * the sign prefix is chosen by the value, not by the
+		 * MsgPack type.
+		 */
+		if (mp_typeof(*field) == MP_INT) {
+			int64_t value = mp_decode_int(&field);
+			*pos = value < 0 ? 0 : 1;
+			mp_store_u64(pos + 1, (uint64_t)value);
+		} else {
+			*pos = 1;
+			mp_store_u64(pos + 1, mp_decode_uint(&field));
+		}
+		buf->size += 1 + sizeof(uint64_t);
+		return 0;
+	case FIELD_TYPE_BOOLEAN:
+		pos = normalized_key_buf_reserve(buf, 1);
+		if (pos == NULL)
+			return -1;
+		*pos = mp_decode_bool(&field) ? 1 : 0;
+		buf->size++;
+		return 0;
+	case FIELD_TYPE_STRING:
+		str = mp_decode_str(&field, &len);
+		if (part->coll != NULL && part->coll->type == COLL_TYPE_ICU) {
+			return normalized_key_buf_put_sort_key(buf, str, len,
+							       part->coll);
+		}
+		return normalized_key_buf_put_bin(buf, str, len);
+	case FIELD_TYPE_VARBINARY:
+		str = mp_decode_bin(&field, &len);
+		return normalized_key_buf_put_bin(buf, str, len);
+	default:
+		unreachable();
+		return -1;
+	}
+}
+
+/** Store the key length in the header and return the key. */
+static const char *
+normalized_key_buf_finish(struct normalized_key_buf *buf)
+{
+	uint32_t len = buf->size - NORMALIZED_KEY_HEADER_SIZE;
+	memcpy(buf->data, &len, sizeof(len));
+	return buf->data;
+}
+
+const char *
+tuple_normalized_key(struct tuple *tuple, struct key_def *key_def,
+		     struct region *region)
+{
+	assert(!key_def->is_multikey && !key_def->for_func_index);
+	struct normalized_key_buf buf;
+	if (normalized_key_buf_create(&buf, region) != 0)
+		return NULL;
+	/*
+	 * Append primary key parts only if there's a NULL among
+	 * unique parts, see tuple_compare().
+	 */
+	bool was_null_met = false;
+	for (uint32_t i = 0; i < key_def->part_count; i++) {
+		if (i == key_def->unique_part_count && !was_null_met)
+			break;
+		struct key_part *part = &key_def->parts[i];
+		const char *field = tuple_field_by_part(tuple, part,
+							MULTIKEY_NONE);
+		if (field == NULL || mp_typeof(*field) == MP_NIL)
+			was_null_met = true;
+		if (normalized_key_buf_put_part(&buf, part, field) != 0)
+			return NULL;
+	}
+	return normalized_key_buf_finish(&buf);
+}
+
+const char *
+key_normalized_key(const char *key, uint32_t part_count,
+		   struct key_def *key_def, struct region *region)
+{
+	assert(part_count <= key_def->part_count);
+	struct normalized_key_buf buf;
+	if (normalized_key_buf_create(&buf, region) != 0)
+		return NULL;
+	for (uint32_t i = 0; i < part_count; i++) {
+		if (normalized_key_buf_put_part(&buf, &key_def->parts[i],
+						key) != 0)
+			return NULL;
+		mp_next(&key);
+	}
+	return normalized_key_buf_finish(&buf);
+}
+
+static int
+normalized_key_tuple_compare(struct tuple *tuple_a, hint_t tuple_a_hint,
+			     struct tuple *tuple_b, hint_t tuple_b_hint,
+			     struct key_def *key_def)
+{
+	(void)tuple_a;
+	(void)tuple_b;
+	(void)key_def;
+	return normalized_key_compare((const char *)tuple_a_hint,
+				      (const char *)tuple_b_hint);
+}
+
+static int
+normalized_key_tuple_compare_with_key(struct tuple *tuple, hint_t tuple_hint,
+				      const char *key, uint32_t part_count,
+				      hint_t key_hint, struct key_def *key_def)
+{
+	(void)tuple;
+	(void)key;
+	(void)part_count;
+	(void)key_def;
+	return normalized_key_compare((const char *)tuple_hint,
+				      (const char *)key_hint);
+}
+
+/**
+ * Normalized keys can't be built by hint functions, because they
+ * need to be allocated. Callers must build them explicitly.
+ */
+static hint_t
+normalized_key_tuple_hint(struct tuple *tuple, struct key_def *key_def)
+{
+	(void)tuple;
+	(void)key_def;
+	unreachable();
+	return HINT_NONE;
+}
+
+static hint_t
+normalized_key_key_hint(const char *key, uint32_t part_count,
+			struct key_def *key_def)
+{
+	(void)key;
+	(void)part_count;
+	(void)key_def;
+	unreachable();
+	return HINT_NONE;
+}
+
+/** Set comparators that take normalized keys as hints. */
+static void
+normalized_key_def_set_func(struct key_def *def)
+{
+	def->tuple_compare = normalized_key_tuple_compare;
+	def->tuple_compare_with_key = normalized_key_tuple_compare_with_key;
+	def->tuple_hint = normalized_key_tuple_hint;
+	def->key_hint = normalized_key_key_hint;
+}
+
+struct key_def *
+normalized_key_def_new(const struct key_def *key_def)
+{
+	struct key_def *def = key_def_dup(key_def);
+	if (def == NULL)
+		return NULL;
+	normalized_key_def_set_func(def);
+	return def;
+}
+
+void
+normalized_key_def_copy(struct key_def *dest, const struct key_def *src)
+{
+	key_def_copy(dest, src);
+	normalized_key_def_set_func(dest);
+}
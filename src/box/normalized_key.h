@@ -0,0 +1,114 @@
+#pragma once
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2021, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "trivia/util.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct key_def;
+struct key_part;
+struct region;
+struct tuple;
+
+/**
+ * A normalized key is a binary string built from a tuple or
+ * a key so that normalized keys of two tuples (keys) compare
+ * with memcmp() the same way as the original tuples (keys)
+ * compare with the key definition the normalized keys were
+ * built for. Each key part is encoded so that its encoding is
+ * never a prefix of another encoding of the same part:
+ *
+ * - nullable parts are prefixed with 0x00 for NULL and 0x01
+ *   otherwise;
+ * - unsigned is stored as a big-endian 64-bit number;
+ * - integer is stored as 0x00 followed by a big-endian 64-bit
+ *   two's complement number if it's negative, 0x01 followed by
+ *   a big-endian 64-bit number otherwise;
+ * - boolean is stored as a single byte, 0x00 or 0x01;
+ * - a string with an ICU collation is stored as its collation
+ *   sort key terminated with 0x00;
+ * - other strings and varbinary are stored with each 0x00
+ *   replaced with 0x00 0xff and terminated with 0x00 0x00.
+ *
+ * In memory, a normalized key is prefixed with its length
+ * stored as uint32_t.
+ */
+
+/** Size of the normalized key length prefix. */
+enum { NORMALIZED_KEY_HEADER_SIZE = sizeof(uint32_t) };
+
+/** Return the size of a normalized key, including its header. */
+static inline uint32_t
+normalized_key_size(const char *nkey)
+{
+	uint32_t len;
+	memcpy(&len, nkey, sizeof(len));
+	return NORMALIZED_KEY_HEADER_SIZE + len;
+}
+
+/**
+ * Compare two normalized keys. Since encodings of key parts are
+ * prefix-free, two keys are equal if one of them is a prefix of
+ * the other. This happens if one of them is a partial key or if
+ * a key of a unique nullable index doesn't contain NULLs and so
+ * isn't extended with primary key parts (see tuple_compare()).
+ */
+static inline int
+normalized_key_compare(const char *nkey_a, const char *nkey_b)
+{
+	uint32_t len_a, len_b;
+	memcpy(&len_a, nkey_a, sizeof(len_a));
+	memcpy(&len_b, nkey_b, sizeof(len_b));
+	return memcmp(nkey_a + NORMALIZED_KEY_HEADER_SIZE,
+		      nkey_b + NORMALIZED_KEY_HEADER_SIZE, MIN(len_a, len_b));
+}
+
+/** Check if a key part can be used in a normalized key. */
+bool
+key_part_is_normalizable(const struct key_part *part);
+
+/**
+ * Create a copy of the given key definition with comparators
+ * that take normalized keys passed as comparison hints. Returns
+ * NULL and sets diag on memory allocation error.
+ */
+struct key_def *
+normalized_key_def_new(const struct key_def *key_def);
+
+/**
+ * Copy the given key definition to a key definition created with
+ * normalized_key_def_new(). The two must have the same parts.
+ */
+void
+normalized_key_def_copy(struct key_def *dest, const struct key_def *src);
+
+/**
+ * Build a normalized key of a tuple. The key is allocated on
+ * @a region. Returns NULL and sets diag on memory allocation
+ * error.
+ */
+const char *
+tuple_normalized_key(struct tuple *tuple, struct key_def *key_def,
+		     struct region *region);
+
+/**
+ * Build a normalized key of a MsgPack key of @a part_count parts.
+ * The key is allocated on @a region. Returns NULL and sets diag
+ * on memory allocation error.
+ */
+const char *
+key_normalized_key(const char *key, uint32_t part_count,
+		   struct key_def *key_def, struct region *region);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
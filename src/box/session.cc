@@ -50,6 +50,11 @@ const char *session_type_strs[] = {
 	"unknown",
 };
 
+const char *session_priority_strs[] = {
+	"normal",
+	"low",
+};
+
 static struct session_vtab generic_session_vtab = {
 	/* .push = */ generic_session_push,
 	/* .fd = */ generic_session_fd,
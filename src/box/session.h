@@ -68,6 +68,19 @@ enum output_format {
 
 extern const char *session_type_strs[];
 
+/** Scheduling priority of requests of a binary session. */
+enum session_priority {
+	SESSION_PRIORITY_NORMAL = 0,
+	/**
+	 * Requests are handled by the tx fiber pool after normal
+	 * priority ones, see struct fiber_pool.
+	 */
+	SESSION_PRIORITY_LOW,
+	session_priority_MAX,
+};
+
+extern const char *session_priority_strs[];
+
 /**
  * default_flags accumulates flags value from SQL submodules.
  * It is assigned during sql_init(). Lately it is used in each session
@@ -91,6 +104,8 @@ struct session_meta {
 	enum output_format output_format;
 	/** IPROTO client features. */
 	struct iproto_features features;
+	/** Priority of requests sent over an IPROTO connection. */
+	enum session_priority priority;
 };
 
 /**
@@ -50,10 +50,10 @@
 #include "constraint_id.h"
 #include "box.h"
 
-int
-access_check_space(struct space *space, user_access_t access)
+bool
+space_access_is_granted(struct space *space, const struct credentials *cr,
+			user_access_t access)
 {
-	struct credentials *cr = effective_user();
 	/* Any space access also requires global USAGE privilege. */
 	access |= PRIV_U;
 	/*
@@ -70,12 +70,19 @@ access_check_space(struct space *space, user_access_t access)
 	 */
 	space_access &= ~entity_access_get(SC_SPACE)[cr->auth_token].effective;
 
-	if (space_access &&
-	    /* Check for missing USAGE access, ignore owner rights. */
-	    (space_access & PRIV_U ||
-	     /* Check for missing specific access, respect owner rights. */
-	    (space->def->uid != cr->uid &&
-	     space_access & ~space->access[cr->auth_token].effective))) {
+	return !(space_access &&
+		 /* Check for missing USAGE access, ignore owner rights. */
+		 (space_access & PRIV_U ||
+		  /* Check for missing specific access, respect owner rights. */
+		  (space->def->uid != cr->uid &&
+		   space_access & ~space->access[cr->auth_token].effective)));
+}
+
+int
+access_check_space(struct space *space, user_access_t access)
+{
+	struct credentials *cr = effective_user();
+	if (!space_access_is_granted(space, cr, access)) {
 		/*
 		 * Report access violation. Throw "no such user"
 		 * error if there is no user with this id.
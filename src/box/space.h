@@ -387,6 +387,15 @@ index_name_by_id(struct space *space, uint32_t id);
 int
 access_check_space(struct space *space, user_access_t access);
 
+/**
+ * Return true if a user with the given credentials can be
+ * granted the requested access to the space. Unlike
+ * access_check_space() doesn't set diag.
+ */
+bool
+space_access_is_granted(struct space *space, const struct credentials *cr,
+			user_access_t access);
+
 /**
  * Execute a DML request on the given space.
  */
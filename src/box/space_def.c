@@ -42,6 +42,8 @@ const struct space_opts space_opts_default = {
 	/* .is_ephemeral = */ false,
 	/* .view = */ false,
 	/* .is_sync = */ false,
+	/* .iproto_read = */ false,
+	/* .fixed_layout = */ false,
 	/* .sql        = */ NULL,
 };
 
@@ -50,6 +52,8 @@ const struct opt_def space_opts_reg[] = {
 	OPT_DEF("temporary", OPT_BOOL, struct space_opts, is_temporary),
 	OPT_DEF("view", OPT_BOOL, struct space_opts, is_view),
 	OPT_DEF("is_sync", OPT_BOOL, struct space_opts, is_sync),
+	OPT_DEF("iproto_read", OPT_BOOL, struct space_opts, iproto_read),
+	OPT_DEF("fixed_layout", OPT_BOOL, struct space_opts, fixed_layout),
 	OPT_DEF("sql", OPT_STRPTR, struct space_opts, sql),
 	OPT_DEF_LEGACY("checks"),
 	OPT_END,
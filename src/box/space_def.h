@@ -73,6 +73,20 @@ struct space_opts {
 	 * until replicated to a quorum of replicas.
 	 */
 	bool is_sync;
+	/**
+	 * If set, IPROTO_SELECT requests by the full primary key
+	 * are served directly in iproto threads from a read view
+	 * of the primary index, bypassing the tx thread. Only
+	 * supported by memtx spaces with a HASH primary index.
+	 */
+	bool iproto_read;
+	/**
+	 * If set, tuples are stored in the fixed layout, see
+	 * tuple_format::is_fixed_layout. Only supported by memtx
+	 * spaces whose format consists of non-nullable fields of
+	 * fixed size types.
+	 */
+	bool fixed_layout;
 	/** SQL statement that produced this space. */
 	char *sql;
 };
@@ -331,6 +331,12 @@ struct PACKED tuple
 	 * be clarified by transaction engine.
 	 */
 	bool is_dirty : 1;
+	/**
+	 * The memtx tuple was allocated outside of the memtx arena and
+	 * assigned an external offset so that it can be stored in a tree
+	 * index with compact pointers, see memtx_tuple_offset_reserve().
+	 */
+	bool has_external_offset : 1;
 	/** Format identifier. */
 	uint16_t format_id;
 	/**
@@ -423,6 +429,7 @@ tuple_create(struct tuple *tuple, uint8_t refs, uint16_t format_id,
 	tuple->local_refs = refs;
 	tuple->has_uploaded_refs = false;
 	tuple->is_dirty = false;
+	tuple->has_external_offset = false;
 	tuple->format_id = format_id;
 	if (make_compact) {
 		assert(tuple_can_be_compact(data_offset, bsize));
@@ -474,6 +481,17 @@ tuple_is_unreferenced(struct tuple *tuple)
 	return tuple->local_refs == 0;
 }
 
+/**
+ * Check that the tuple has exactly one reference. For a memtx tuple
+ * stored in a space it means that the tuple is referenced only by the
+ * space and may be moved to another location by the space owner.
+ */
+static inline bool
+tuple_has_single_ref(struct tuple *tuple)
+{
+	return tuple->local_refs == 1 && !tuple->has_uploaded_refs;
+}
+
 /** Check that the tuple is in compact mode. */
 static inline bool
 tuple_is_compact(struct tuple *tuple)
@@ -744,6 +762,28 @@ tuple_field_go_to_index(const char **field, uint64_t index);
 int
 tuple_field_go_to_key(const char **field, const char *key, int len);
 
+/**
+ * Get a field of a tuple with the fixed layout by field index,
+ * see tuple_format::is_fixed_layout.
+ * @param format Tuple format.
+ * @param tuple MessagePack tuple's body.
+ * @param fieldno Field index.
+ * @retval Pointer to MessagePack data or NULL if there's no
+ *         such field.
+ */
+static inline const char *
+tuple_field_raw_fixed(struct tuple_format *format, const char *tuple,
+		      uint32_t fieldno)
+{
+	assert(format->is_fixed_layout);
+	if (unlikely(fieldno >= format->exact_field_count))
+		return NULL;
+	struct json_token *token = format->fields.root.children[fieldno];
+	struct tuple_field *field = json_tree_entry(token, struct tuple_field,
+						    token);
+	return tuple + field->fixed_offset;
+}
+
 /**
  * Get tuple field by field index, relative JSON path and
  * multikey_idx.
@@ -770,6 +810,14 @@ tuple_field_raw_by_path(struct tuple_format *format, const char *tuple,
 			int32_t *offset_slot_hint, int multikey_idx)
 {
 	int32_t offset_slot;
+	if (unlikely(format->is_fixed_layout)) {
+		tuple = tuple_field_raw_fixed(format, tuple, fieldno);
+		if (tuple != NULL && path != NULL &&
+		    unlikely(tuple_go_to_path(&tuple, path, path_len,
+					      multikey_idx) != 0))
+			return NULL;
+		return tuple;
+	}
 	if (offset_slot_hint != NULL &&
 	    *offset_slot_hint != TUPLE_OFFSET_SLOT_NIL) {
 		offset_slot = *offset_slot_hint;
@@ -850,6 +898,8 @@ static inline const char *
 tuple_field_raw(struct tuple_format *format, const char *tuple,
 		const uint32_t *field_map, uint32_t field_no)
 {
+	if (unlikely(format->is_fixed_layout))
+		return tuple_field_raw_fixed(format, tuple, field_no);
 	if (likely(field_no < format->index_field_count)) {
 		int32_t offset_slot;
 		uint32_t offset = 0;
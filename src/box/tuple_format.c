@@ -34,6 +34,7 @@
 #include "tuple_format.h"
 #include "coll_id_cache.h"
 #include "tt_static.h"
+#include "mp_uuid.h"
 
 #include <PMurHash.h>
 
@@ -42,6 +43,15 @@ struct tuple_format **tuple_formats;
 static intptr_t recycled_format_ids = FORMAT_ID_NIL;
 
 static uint32_t formats_size = 0, formats_capacity = 0;
+/**
+ * Arrays of tuple formats replaced on growth. Formats may be
+ * looked up by id from iproto threads (see memtx_net_read.h)
+ * so a replaced array is kept until the subsystem is destroyed.
+ * The capacity is doubled on each growth so there can't be
+ * many of them.
+ */
+static struct tuple_format **old_tuple_formats[32];
+static int old_tuple_formats_count = 0;
 static uint64_t formats_epoch = 0;
 
 /**
@@ -79,6 +89,8 @@ tuple_format_cmp(const struct tuple_format *format1,
 	struct tuple_format *b = (struct tuple_format *)format2;
 	if (a->exact_field_count != b->exact_field_count)
 		return a->exact_field_count - b->exact_field_count;
+	if (a->is_fixed_layout != b->is_fixed_layout)
+		return (int)a->is_fixed_layout - (int)b->is_fixed_layout;
 	if (a->total_field_count != b->total_field_count)
 		return a->total_field_count - b->total_field_count;
 
@@ -428,6 +440,133 @@ tuple_format_use_key_part(struct tuple_format *format, uint32_t field_count,
 	return 0;
 }
 
+/**
+ * Return the size of a field of the given type in the fixed tuple
+ * layout or 0 if the type can't be stored in the fixed layout.
+ * Integers are always encoded as 64-bit values, see
+ * tuple_format_fixed_encode(). Booleans, doubles and UUIDs are
+ * always encoded in MsgPack of the same size.
+ */
+static uint32_t
+field_type_fixed_size(enum field_type type)
+{
+	switch (type) {
+	case FIELD_TYPE_UNSIGNED:
+	case FIELD_TYPE_INTEGER:
+		return 1 + sizeof(uint64_t);
+	case FIELD_TYPE_DOUBLE:
+		return mp_sizeof_double(0);
+	case FIELD_TYPE_BOOLEAN:
+		return mp_sizeof_bool(false);
+	case FIELD_TYPE_UUID:
+		return mp_sizeof_uuid();
+	default:
+		return 0;
+	}
+}
+
+/**
+ * Set up the fixed layout of a format: assign constant offsets to
+ * all fields and drop offset slots, which aren't needed anymore.
+ * Returns -1 and sets diag if the format can't have the fixed
+ * layout.
+ */
+static int
+tuple_format_create_fixed_layout(struct tuple_format *format,
+				 uint32_t field_count)
+{
+	const char *what = NULL;
+	uint32_t format_field_count = tuple_format_field_count(format);
+	if (field_count == 0)
+		what = "spaces without format";
+	else if (format_field_count > field_count)
+		what = "indexed fields missing in space format";
+	else if (format->exact_field_count != 0 &&
+		 format->exact_field_count != field_count)
+		what = "field count different from space format";
+	if (what != NULL) {
+		diag_set(ClientError, ER_UNSUPPORTED,
+			 "Fixed tuple layout", what);
+		return -1;
+	}
+	uint32_t offset = mp_sizeof_array(field_count);
+	for (uint32_t i = 0; i < field_count; i++) {
+		struct tuple_field *field = tuple_format_field(format, i);
+		uint32_t size = field_type_fixed_size(field->type);
+		if (size == 0)
+			what = tt_sprintf("field type '%s'",
+					  field_type_strs[field->type]);
+		else if (tuple_field_is_nullable(field))
+			what = "nullable fields";
+		else if (!json_token_is_leaf(&field->token))
+			what = "JSON paths";
+		else if (field->compression_type != COMPRESSION_TYPE_NONE)
+			what = "compressed fields";
+		if (what != NULL) {
+			diag_set(ClientError, ER_UNSUPPORTED,
+				 "Fixed tuple layout", what);
+			return -1;
+		}
+		field->offset_slot = TUPLE_OFFSET_SLOT_NIL;
+		field->fixed_offset = offset;
+		offset += size;
+	}
+	format->is_fixed_layout = true;
+	format->fixed_data_size = offset;
+	format->exact_field_count = field_count;
+	return 0;
+}
+
+void
+tuple_format_fixed_encode(struct tuple_format *format, const char *data,
+			  char *buf)
+{
+	assert(format->is_fixed_layout);
+	uint32_t field_count = mp_decode_array(&data);
+	assert(field_count == format->exact_field_count);
+	char *pos = mp_encode_array(buf, field_count);
+	for (uint32_t i = 0; i < field_count; i++) {
+		struct tuple_field *field = tuple_format_field(format, i);
+		assert(pos == buf + field->fixed_offset);
+		(void)field;
+		const char *end = data;
+		switch (mp_typeof(*data)) {
+		case MP_UINT:
+			pos = mp_store_u8(pos, 0xcf);
+			pos = mp_store_u64(pos, mp_decode_uint(&data));
+			break;
+		case MP_INT: {
+			/*
+			 * A non-negative integer must be encoded as
+			 * MP_UINT, because it's the canonical form
+			 * expected by comparators and hints.
+			 */
+			int64_t value = mp_decode_int(&data);
+			pos = mp_store_u8(pos, value < 0 ? 0xd3 : 0xcf);
+			pos = mp_store_u64(pos, value);
+			break;
+		}
+		case MP_EXT: {
+			/* UUID may be encoded in ext8 by some clients. */
+			struct tt_uuid uuid;
+			MAYBE_UNUSED struct tt_uuid *rc =
+				mp_decode_uuid(&data, &uuid);
+			assert(rc != NULL);
+			pos = mp_encode_uuid(pos, &uuid);
+			break;
+		}
+		default:
+			/* Booleans and doubles have a fixed size. */
+			mp_next(&end);
+			memcpy(pos, data, end - data);
+			pos += end - data;
+			data = end;
+			break;
+		}
+	}
+	assert(pos == buf + format->fixed_data_size);
+}
+
 /**
  * Extract all available type info from keys and field
  * definitions.
@@ -441,6 +580,9 @@ tuple_format_create(struct tuple_format *format, struct key_def * const *keys,
 		tuple_format_min_field_count(keys, key_count, fields,
 					     field_count);
 	if (tuple_format_field_count(format) == 0) {
+		if (format->is_fixed_layout &&
+		    tuple_format_create_fixed_layout(format, 0) != 0)
+			return -1;
 		format->field_map_size = 0;
 		goto out;
 	}
@@ -494,6 +636,11 @@ tuple_format_create(struct tuple_format *format, struct key_def * const *keys,
 
 	assert(tuple_format_field(format, 0)->offset_slot == TUPLE_OFFSET_SLOT_NIL
 	       || json_token_is_multikey(&tuple_format_field(format, 0)->token));
+	if (format->is_fixed_layout) {
+		if (tuple_format_create_fixed_layout(format, field_count) != 0)
+			return -1;
+		current_slot = 0;
+	}
 	size_t field_map_size = -current_slot * sizeof(uint32_t);
 	if (field_map_size > INT16_MAX) {
 		/** tuple->data_offset is 15 bits */
@@ -569,17 +716,25 @@ tuple_format_register(struct tuple_format *format)
 						formats_capacity * 2 : 16;
 			struct tuple_format **formats;
 			formats = (struct tuple_format **)
-				realloc(tuple_formats, new_capacity *
-						       sizeof(tuple_formats[0]));
+				malloc(new_capacity * sizeof(tuple_formats[0]));
 			if (formats == NULL) {
 				diag_set(OutOfMemory,
 					 sizeof(struct tuple_format), "malloc",
 					 "tuple_formats");
 				return -1;
 			}
-
+			if (tuple_formats != NULL) {
+				memcpy(formats, tuple_formats, formats_capacity *
+				       sizeof(tuple_formats[0]));
+				assert(old_tuple_formats_count <
+				       (int)lengthof(old_tuple_formats));
+				old_tuple_formats[old_tuple_formats_count++] =
+					tuple_formats;
+			}
 			formats_capacity = new_capacity;
-			tuple_formats = formats;
+			/* Publish the filled array to other threads. */
+			__atomic_store_n(&tuple_formats, formats,
+					 __ATOMIC_RELEASE);
 		}
 		uint32_t formats_size_max = FORMAT_ID_MAX + 1;
 		struct errinj *inj = errinj(ERRINJ_TUPLE_FORMAT_COUNT,
@@ -763,7 +918,7 @@ tuple_format_new(struct tuple_format_vtab *vtab, void *engine,
 		 const struct field_def *space_fields,
 		 uint32_t space_field_count, uint32_t exact_field_count,
 		 struct tuple_dictionary *dict, bool is_temporary,
-		 bool is_reusable)
+		 bool is_reusable, bool is_fixed_layout)
 {
 	struct tuple_format *format =
 		tuple_format_alloc(keys, key_count, space_field_count, dict);
@@ -775,9 +930,14 @@ tuple_format_new(struct tuple_format_vtab *vtab, void *engine,
 		memset(&format->vtab, 0, sizeof(format->vtab));
 	format->engine = engine;
 	format->is_temporary = is_temporary;
+	/* Set by the engine if needed. */
+	format->is_net_readable = false;
 	format->is_reusable = is_reusable;
 	/* This flag is set in `tuple_format_create` function. */
 	format->is_compressed = false;
+	/* Checked in `tuple_format_create` function. */
+	format->is_fixed_layout = is_fixed_layout;
+	format->fixed_data_size = 0;
 	format->exact_field_count = exact_field_count;
 	format->epoch = ++formats_epoch;
 	if (tuple_format_create(format, keys, key_count, space_fields,
@@ -1014,6 +1174,9 @@ tuple_format_free()
 		}
 	}
 	free(tuple_formats);
+	for (int i = 0; i < old_tuple_formats_count; i++)
+		free(old_tuple_formats[i]);
+	old_tuple_formats_count = 0;
 	mh_tuple_format_delete(tuple_formats_hash);
 }
 
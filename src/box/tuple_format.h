@@ -123,6 +123,11 @@ struct tuple_field {
 	uint32_t coll_id;
 	/** Type of compression for this field. */
 	enum compression_type compression_type;
+	/**
+	 * Offset of the field in tuple data. Only used if the
+	 * format has the fixed layout, see tuple_format::is_fixed_layout.
+	 */
+	uint32_t fixed_offset;
 	/**
 	 * Bitmap of fields that must be present in a tuple
 	 * conforming to the multikey subtree. Not NULL only
@@ -177,6 +182,13 @@ struct tuple_format {
 	 * in progress.
 	 */
 	bool is_temporary;
+	/**
+	 * Tuples of this format belong to a memtx space with the
+	 * iproto_read option so they may be accessed from iproto
+	 * threads and their deletion may have to be postponed,
+	 * see memtx_net_read.h.
+	 */
+	bool is_net_readable;
 	/**
 	 * True if this format may be reused instead of creating a new format.
 	 * Not all formats are reusable: a typical space format is mutable,
@@ -187,6 +199,17 @@ struct tuple_format {
 	bool is_reusable;
 	/** True if tuples of this format may contain compressed fields. */
 	bool is_compressed;
+	/**
+	 * True if tuples of this format have the fixed layout. All
+	 * fields of such a format are non-nullable scalars of types
+	 * that can be encoded in MsgPack of a constant size. Tuple data
+	 * is stored in this encoding (see tuple_format_fixed_encode())
+	 * so each field is located at a constant offset and can be
+	 * accessed without a field map or decoding preceding fields.
+	 */
+	bool is_fixed_layout;
+	/** Size of tuple data if the format has the fixed layout. */
+	uint32_t fixed_data_size;
 	/**
 	 * Size of minimal field map of tuple where each indexed
 	 * field has own offset slot (in bytes). The real tuple
@@ -326,6 +349,8 @@ tuple_format_unref(struct tuple_format *format)
  * @param exact_field_count Exact field count for format.
  * @param is_temporary Set if format belongs to temporary space.
  * @param is_reusable Set if format may be reused.
+ * @param is_fixed_layout Set if tuples must have the fixed layout,
+ *                        see tuple_format::is_fixed_layout.
  *
  * @retval not NULL Tuple format.
  * @retval     NULL Memory error.
@@ -336,7 +361,17 @@ tuple_format_new(struct tuple_format_vtab *vtab, void *engine,
 		 const struct field_def *space_fields,
 		 uint32_t space_field_count, uint32_t exact_field_count,
 		 struct tuple_dictionary *dict, bool is_temporary,
-		 bool is_reusable);
+		 bool is_reusable, bool is_fixed_layout);
+
+/**
+ * Encode tuple data in the fixed layout of @a format, see
+ * tuple_format::is_fixed_layout. The data must be valid for the
+ * format. @a buf must be at least tuple_format::fixed_data_size
+ * bytes long.
+ */
+void
+tuple_format_fixed_encode(struct tuple_format *format, const char *data,
+			  char *buf);
 
 /**
  * Check, if tuple @a format is compatible with @a key_def.
@@ -41,6 +41,7 @@
 #include "tt_static.h"
 
 struct universe universe;
+uint32_t user_access_version;
 static struct user users[BOX_USER_MAX];
 struct user *guest_user = users;
 struct user *admin_user = users + 1;
@@ -307,6 +308,7 @@ user_set_effective_access(struct user *user)
 		struct access *access = &object[user->auth_token];
 		access->effective = access->granted | priv->access;
 	}
+	user_access_version++;
 }
 
 /**
@@ -473,6 +475,7 @@ user_cache_replace(struct user_def *def)
 		free(user->def);
 	}
 	user->def = def;
+	user_access_version++;
 	return user;
 }
 
@@ -495,6 +498,7 @@ user_cache_delete(uint32_t uid)
 		 * all privileges from them first.
 		 */
 		mh_i32ptr_del(user_registry, k, NULL);
+		user_access_version++;
 	}
 }
 
@@ -781,6 +785,7 @@ priv_grant(struct user *grantee, struct priv_def *priv)
 	}
 	struct access *access = &object[grantee->auth_token];
 	access->granted = priv->access;
+	user_access_version++;
 	if (rebuild_effective_grants(grantee) != 0)
 		return -1;
 	return 0;
@@ -47,6 +47,14 @@ struct universe {
 /** A single instance of the universe. */
 extern struct universe universe;
 
+/**
+ * Incremented whenever effective access of any user changes or
+ * an authentication token is assigned to another user. Used to
+ * find out if access checks cached outside of the tx thread are
+ * outdated.
+ */
+extern uint32_t user_access_version;
+
 /** Bitmap type for used/unused authentication token map. */
 typedef unsigned int umap_int_t;
 enum {
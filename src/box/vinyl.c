@@ -590,6 +590,16 @@ vinyl_engine_check_space_def(struct space_def *def)
 			 def->name, "engine does not support temporary flag");
 		return -1;
 	}
+	if (def->opts.iproto_read) {
+		diag_set(ClientError, ER_ALTER_SPACE,
+			 def->name, "engine does not support iproto_read flag");
+		return -1;
+	}
+	if (def->opts.fixed_layout) {
+		diag_set(ClientError, ER_ALTER_SPACE,
+			 def->name, "engine does not support fixed_layout flag");
+		return -1;
+	}
 	return 0;
 }
 
@@ -684,6 +694,45 @@ vinyl_space_check_index_def(struct space *space, struct index_def *index_def)
 			 "functional index");
 		return -1;
 	}
+	if (index_def->opts.normalized_keys) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "normalized keys");
+		return -1;
+	}
+	if (index_def->opts.compact_pointers) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "compact pointers");
+		return -1;
+	}
+	if (index_def->opts.block_size != index_opts_default.block_size) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "block size");
+		return -1;
+	}
+	if (index_def->opts.inline_prefix) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "inline prefix");
+		return -1;
+	}
+	if (index_def->opts.ttl != 0) {
+		if (index_def->iid != 0) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space),
+				 "ttl can only be set for primary index");
+			return -1;
+		}
+		enum field_type type = key_def->parts[0].type;
+		if (type != FIELD_TYPE_UNSIGNED &&
+		    type != FIELD_TYPE_INTEGER &&
+		    type != FIELD_TYPE_NUMBER &&
+		    type != FIELD_TYPE_DOUBLE) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space),
+				 "ttl requires the first key part to be "
+				 "a number");
+			return -1;
+		}
+	}
 	return 0;
 }
 
@@ -2731,6 +2780,27 @@ vinyl_engine_set_timeout(struct engine *engine, double timeout)
 	env->timeout = timeout;
 }
 
+void
+vinyl_engine_set_max_subcompactions(struct engine *engine, int count)
+{
+	struct vy_env *env = vy_env(engine);
+	env->scheduler.max_subcompactions = count;
+}
+
+void
+vinyl_engine_set_direct_io(struct engine *engine, bool direct_io)
+{
+	struct vy_env *env = vy_env(engine);
+	env->run_env.direct_io = direct_io;
+}
+
+void
+vinyl_engine_set_readahead_pages(struct engine *engine, int pages)
+{
+	struct vy_env *env = vy_env(engine);
+	env->run_env.readahead_pages = pages;
+}
+
 void
 vinyl_engine_set_too_long_threshold(struct engine *engine,
 				    double too_long_threshold)
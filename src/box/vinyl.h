@@ -75,6 +75,26 @@ vinyl_engine_set_max_tuple_size(struct engine *engine, size_t max_size);
 void
 vinyl_engine_set_timeout(struct engine *engine, double timeout);
 
+/**
+ * Update the max number of parallel subcompactions
+ * a range compaction can be split into.
+ */
+void
+vinyl_engine_set_max_subcompactions(struct engine *engine, int count);
+
+/**
+ * Enable or disable direct I/O for run files. Must be called
+ * before recovery.
+ */
+void
+vinyl_engine_set_direct_io(struct engine *engine, bool direct_io);
+
+/**
+ * Update the number of pages to read ahead on sequential scans.
+ */
+void
+vinyl_engine_set_readahead_pages(struct engine *engine, int pages);
+
 /**
  * Update too_long_threshold.
  */
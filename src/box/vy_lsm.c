@@ -1126,32 +1126,36 @@ vy_lsm_find_range_intersection(struct vy_lsm *lsm,
 	return 0;
 }
 
-bool
-vy_lsm_split_range(struct vy_lsm *lsm, struct vy_range *range)
+/**
+ * Split a range into @key_count + 1 parts by the given keys, which
+ * must be sorted in ascending order and fall within the range.
+ * If @is_subcompaction is set, the new ranges are marked as parts
+ * of a compaction split, see vy_range::is_subcompaction.
+ * Returns 0 on success, -1 on failure.
+ */
+static int
+vy_lsm_split_range_by_keys(struct vy_lsm *lsm, struct vy_range *range,
+			   const char **split_keys_raw, int key_count,
+			   bool is_subcompaction)
 {
 	struct tuple_format *key_format = lsm->env->key_format;
 
-	const char *split_key_raw;
-	if (!vy_range_needs_split(range, vy_lsm_range_size(lsm),
-				  &split_key_raw))
-		return false;
-
-	/* Split a range in two parts. */
-	const int n_parts = 2;
-	struct vy_range *parts[2] = { NULL, NULL };
+	assert(key_count > 0 && key_count < VY_SUBCOMPACTION_MAX);
+	int n_parts = key_count + 1;
+	struct vy_range *parts[VY_SUBCOMPACTION_MAX] = {};
+	struct vy_entry keys[VY_SUBCOMPACTION_MAX + 1] = {};
 	/*
 	 * Determine new ranges' boundaries.
 	 */
-	struct vy_entry split_key;
-	split_key = vy_entry_key_from_msgpack(key_format, lsm->cmp_def,
-					      split_key_raw);
-	if (split_key.stmt == NULL)
-		goto fail;
-
-	struct vy_entry keys[3];
 	keys[0] = range->begin;
-	keys[1] = split_key;
-	keys[2] = range->end;
+	keys[n_parts] = range->end;
+	for (int i = 0; i < key_count; i++) {
+		keys[i + 1] = vy_entry_key_from_msgpack(key_format,
+							lsm->cmp_def,
+							split_keys_raw[i]);
+		if (keys[i + 1].stmt == NULL)
+			goto fail;
+	}
 
 	/*
 	 * Allocate new ranges and create slices of
@@ -1179,6 +1183,7 @@ vy_lsm_split_range(struct vy_lsm *lsm, struct vy_range *range)
 				vy_range_add_slice(part, new_slice);
 		}
 		part->needs_compaction = range->needs_compaction;
+		part->is_subcompaction = is_subcompaction;
 		vy_range_update_compaction_priority(part, &lsm->opts);
 		vy_range_update_dumps_per_compaction(part);
 	}
@@ -1216,26 +1221,58 @@ vy_lsm_split_range(struct vy_lsm *lsm, struct vy_range *range)
 	}
 	lsm->range_tree_version++;
 
-	say_info("%s: split range %s by key %s", vy_lsm_name(lsm),
-		 vy_range_str(range), tuple_str(split_key.stmt));
+	if (n_parts == 2) {
+		say_info("%s: split range %s by key %s", vy_lsm_name(lsm),
+			 vy_range_str(range), tuple_str(keys[1].stmt));
+	} else {
+		say_info("%s: split range %s in %d parts", vy_lsm_name(lsm),
+			 vy_range_str(range), n_parts);
+	}
 
 	rlist_foreach_entry(slice, &range->slices, in_range)
 		vy_slice_wait_pinned(slice);
 	vy_range_delete(range);
-	tuple_unref(split_key.stmt);
-	return true;
+	for (int i = 1; i < n_parts; i++)
+		tuple_unref(keys[i].stmt);
+	return 0;
 fail:
 	for (int i = 0; i < n_parts; i++) {
 		if (parts[i] != NULL)
 			vy_range_delete(parts[i]);
 	}
-	if (split_key.stmt != NULL)
-		tuple_unref(split_key.stmt);
-
+	for (int i = 1; i < n_parts; i++) {
+		if (keys[i].stmt != NULL)
+			tuple_unref(keys[i].stmt);
+	}
 	diag_log();
 	say_error("%s: failed to split range %s",
 		  vy_lsm_name(lsm), vy_range_str(range));
-	return false;
+	return -1;
+}
+
+bool
+vy_lsm_split_range(struct vy_lsm *lsm, struct vy_range *range)
+{
+	const char *split_key_raw;
+	if (!vy_range_needs_split(range, vy_lsm_range_size(lsm),
+				  &split_key_raw))
+		return false;
+	return vy_lsm_split_range_by_keys(lsm, range, &split_key_raw, 1,
+					  false) == 0;
+}
+
+bool
+vy_lsm_split_range_for_compaction(struct vy_lsm *lsm, struct vy_range *range,
+				  int max_parts)
+{
+	const char *split_keys_raw[VY_SUBCOMPACTION_MAX];
+	max_parts = MIN(max_parts, VY_SUBCOMPACTION_MAX);
+	int key_count = vy_range_subcompaction_split_keys(range, max_parts,
+				vy_lsm_range_size(lsm), split_keys_raw);
+	if (key_count == 0)
+		return false;
+	return vy_lsm_split_range_by_keys(lsm, range, split_keys_raw,
+					  key_count, true) == 0;
 }
 
 bool
@@ -1333,3 +1370,24 @@ vy_lsm_force_compaction(struct vy_lsm *lsm)
 
 	vy_range_heap_update_all(&lsm->range_heap);
 }
+
+void
+vy_lsm_check_expired(struct vy_lsm *lsm)
+{
+	assert(lsm->index_id == 0);
+	assert(lsm->opts.ttl > 0);
+
+	struct vy_range *range;
+	struct vy_range_tree_iterator it;
+
+	vy_range_tree_ifirst(&lsm->range_tree, &it);
+	while ((range = vy_range_tree_inext(&it)) != NULL) {
+		if (vy_range_is_scheduled(range))
+			continue;
+		vy_lsm_unacct_range(lsm, range);
+		vy_range_update_compaction_priority(range, &lsm->opts);
+		vy_lsm_acct_range(lsm, range);
+	}
+
+	vy_range_heap_update_all(&lsm->range_heap);
+}
@@ -571,6 +571,18 @@ vy_lsm_find_range_intersection(struct vy_lsm *lsm,
 bool
 vy_lsm_split_range(struct vy_lsm *lsm, struct vy_range *range);
 
+/**
+ * Split a range that is about to be compacted into several
+ * key-disjoint parts so that they can be compacted in parallel
+ * by different worker threads, return true if the range was split.
+ * The number of parts is limited by @max_parts and the amount of
+ * data to compact: each part gets at least the target range size
+ * so that the new ranges aren't coalesced back.
+ */
+bool
+vy_lsm_split_range_for_compaction(struct vy_lsm *lsm, struct vy_range *range,
+				  int max_parts);
+
 /**
  * Coalesce a range with one or more its neighbors if it is too small,
  * return true if the range was coalesced. We coalesce ranges by
@@ -590,6 +602,15 @@ vy_lsm_coalesce_range(struct vy_lsm *lsm, struct vy_range *range);
 void
 vy_lsm_force_compaction(struct vy_lsm *lsm);
 
+/**
+ * Recompute compaction priority of all ranges of an LSM tree with
+ * TTL so that ranges storing only expired statements get scheduled
+ * for compaction. Supposed to be called periodically, because
+ * statements expire as time goes by.
+ */
+void
+vy_lsm_check_expired(struct vy_lsm *lsm);
+
 /**
  * Insert a statement into the in-memory index of an LSM tree. If
  * the region_stmt is NULL and the statement is successfully inserted
@@ -41,6 +41,7 @@
 #include <small/rb.h>
 #include <small/rlist.h>
 
+#include "clock.h"
 #include "diag.h"
 #include "iterator_type.h"
 #include "key_def.h"
@@ -292,8 +293,23 @@ vy_range_update_compaction_priority(struct vy_range *range,
 	assert(opts->run_size_ratio > 1);
 
 	range->compaction_priority = 0;
+	range->is_expired = false;
 	vy_disk_stmt_counter_reset(&range->compaction_queue);
 
+	if (opts->ttl > 0 &&
+	    vy_range_is_expired(range, clock_realtime() - opts->ttl)) {
+		/*
+		 * All statements stored in the range have expired.
+		 * Compact all its runs to get rid of them. This is
+		 * cheap, because none of them is going to be read,
+		 * see vy_task_compaction_new().
+		 */
+		range->compaction_priority = range->slice_count;
+		range->compaction_queue = range->count;
+		range->is_expired = true;
+		return;
+	}
+
 	if (range->slice_count <= 1) {
 		/* Nothing to compact. */
 		range->needs_compaction = false;
@@ -425,6 +441,19 @@ vy_range_update_compaction_priority(struct vy_range *range,
 	}
 }
 
+bool
+vy_range_is_expired(struct vy_range *range, double expire_time)
+{
+	if (range->slice_count == 0)
+		return false;
+	struct vy_slice *slice;
+	rlist_foreach_entry(slice, &range->slices, in_range) {
+		if (!vy_slice_is_expired(slice, expire_time))
+			return false;
+	}
+	return true;
+}
+
 void
 vy_range_update_dumps_per_compaction(struct vy_range *range)
 {
@@ -515,6 +544,68 @@ vy_range_needs_split(struct vy_range *range, int64_t range_size,
 	return true;
 }
 
+int
+vy_range_subcompaction_split_keys(struct vy_range *range, int max_parts,
+				  int64_t min_part_size,
+				  const char **split_keys)
+{
+	assert(max_parts <= VY_SUBCOMPACTION_MAX);
+	assert(min_part_size > 0);
+
+	if (range->is_subcompaction)
+		return 0;
+
+	int n_parts = MIN(max_parts,
+			  range->compaction_queue.bytes / min_part_size);
+	if (n_parts < 2)
+		return 0;
+
+	/* Find the biggest slice among the slices to compact. */
+	struct vy_slice *slice, *max_slice = NULL;
+	int n = range->compaction_priority;
+	rlist_foreach_entry(slice, &range->slices, in_range) {
+		if (n-- == 0)
+			break;
+		if (max_slice == NULL ||
+		    slice->count.bytes > max_slice->count.bytes)
+			max_slice = slice;
+	}
+	if (max_slice == NULL)
+		return 0;
+
+	slice = max_slice;
+	uint32_t page_count = slice->last_page_no - slice->first_page_no + 1;
+	n_parts = MIN(n_parts, (int)page_count);
+	if (n_parts < 2)
+		return 0;
+
+	/*
+	 * Split the slice into parts consisting of the same number
+	 * of pages. As in vy_range_needs_split(), we use the min keys
+	 * of pages as split keys, skipping those that don't fall in
+	 * the slice or would result in an empty part.
+	 */
+	struct vy_page_info *prev_page = vy_run_page_info(slice->run,
+						slice->first_page_no);
+	int key_count = 0;
+	for (int i = 1; i < n_parts; i++) {
+		struct vy_page_info *page = vy_run_page_info(slice->run,
+				slice->first_page_no + page_count * i / n_parts);
+		if (key_compare(prev_page->min_key, prev_page->min_key_hint,
+				page->min_key, page->min_key_hint,
+				range->cmp_def) >= 0)
+			continue;
+		if (slice->begin.stmt != NULL &&
+		    vy_entry_compare_with_raw_key(slice->begin, page->min_key,
+						  page->min_key_hint,
+						  range->cmp_def) >= 0)
+			continue;
+		split_keys[key_count++] = page->min_key;
+		prev_page = page;
+	}
+	return key_count;
+}
+
 /**
  * Check if a range should be coalesced with one or more its neighbors.
  * If it should, return true and set @p_first and @p_last to the first
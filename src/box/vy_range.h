@@ -117,6 +117,20 @@ struct vy_range {
 	 * is scheduled for compaction.
 	 */
 	bool needs_compaction;
+	/**
+	 * Set if all statements stored in the range have expired,
+	 * see vy_range_is_expired(). Such a range is compacted even
+	 * if it consists of a single run. Updated along with
+	 * compaction_priority.
+	 */
+	bool is_expired;
+	/**
+	 * Set if the range was created by splitting a bigger range
+	 * for parallel compaction. Such a range isn't split again
+	 * until it is compacted. The flag is cleared on compaction
+	 * completion.
+	 */
+	bool is_subcompaction;
 	/** Number of times the range was compacted. */
 	int n_compactions;
 	/**
@@ -247,6 +261,13 @@ void
 vy_range_update_compaction_priority(struct vy_range *range,
 				    const struct index_opts *opts);
 
+/**
+ * Return true if all statements stored in a range have expired,
+ * see vy_slice_is_expired(). An empty range never expires.
+ */
+bool
+vy_range_is_expired(struct vy_range *range, double expire_time);
+
 /**
  * Update the value of range->dumps_per_compaction.
  */
@@ -266,6 +287,36 @@ bool
 vy_range_needs_split(struct vy_range *range, int64_t range_size,
 		     const char **p_split_key);
 
+/**
+ * Max number of key-disjoint parts a range can be split into
+ * before compaction so that the parts can be compacted in
+ * parallel by different worker threads.
+ */
+enum { VY_SUBCOMPACTION_MAX = 16 };
+
+/**
+ * Check if compaction of a range is big enough to be split into
+ * several key-disjoint subcompactions executed in parallel.
+ *
+ * Split keys are taken from the page index of the biggest slice
+ * that is going to be compacted so that each part gets roughly
+ * the same amount of data.
+ *
+ * @param range             The range.
+ * @param max_parts         Max number of parts, <= VY_SUBCOMPACTION_MAX.
+ * @param min_part_size     Min amount of compaction input per part.
+ * @param[out] split_keys   Keys to split the range by, sorted in
+ *                          ascending order. Must have room for at
+ *                          least @max_parts - 1 keys.
+ *
+ * @retval Number of keys stored in @split_keys. 0 means that the
+ *         range shouldn't be split.
+ */
+int
+vy_range_subcompaction_split_keys(struct vy_range *range, int max_parts,
+				  int64_t min_part_size,
+				  const char **split_keys);
+
 /**
  * Check if a range needs to be coalesced with adjacent
  * ranges in a range tree.
@@ -197,18 +197,42 @@ vy_read_iterator_is_exact_match(struct vy_read_iterator *itr,
 				struct vy_entry entry)
 {
 	enum iterator_type type = itr->iterator_type;
-	struct key_def *cmp_def = itr->lsm->cmp_def;
+	struct vy_lsm *lsm = itr->lsm;
+	struct key_def *cmp_def = lsm->cmp_def;
 
+	if (itr->last.stmt != NULL || entry.stmt == NULL)
+		return false;
 	/*
 	 * If the index is unique and the search key is full,
 	 * we can avoid disk accesses on the first iteration
 	 * in case the key is found in memory.
 	 */
-	return itr->last.stmt == NULL && entry.stmt != NULL &&
-		(type == ITER_EQ || type == ITER_REQ ||
-		 type == ITER_GE || type == ITER_LE) &&
-		vy_stmt_is_full_key(itr->key.stmt, cmp_def) &&
-		vy_entry_compare(entry, itr->key, cmp_def) == 0;
+	if ((type == ITER_EQ || type == ITER_REQ ||
+	     type == ITER_GE || type == ITER_LE) &&
+	    vy_stmt_is_full_key(itr->key.stmt, cmp_def))
+		return vy_entry_compare(entry, itr->key, cmp_def) == 0;
+	/*
+	 * A secondary index key doesn't include primary key parts
+	 * so an exact match lookup in a unique secondary index
+	 * must scan all sources, because older sources may store
+	 * stale tuples with the same secondary key, which haven't
+	 * been purged by deferred DELETEs yet. However, only one
+	 * tuple may match a full secondary key so if the newest
+	 * statement found for the key is a REPLACE, any older
+	 * matching statement must be stale and can be skipped.
+	 * The caller still checks the tuple against the primary
+	 * index, see vy_get_by_secondary_tuple(), and continues
+	 * the iteration if it was overwritten.
+	 *
+	 * This doesn't work for nullable indexes, because unique
+	 * constraint isn't checked for keys containing nulls.
+	 */
+	return lsm->index_id > 0 && lsm->opts.is_unique &&
+		!lsm->key_def->is_nullable &&
+		(type == ITER_EQ || type == ITER_REQ) &&
+		vy_stmt_type(entry.stmt) != IPROTO_DELETE &&
+		vy_stmt_is_full_key(itr->key.stmt, lsm->key_def) &&
+		vy_entry_compare(entry, itr->key, lsm->key_def) == 0;
 }
 
 /**
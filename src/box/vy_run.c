@@ -30,6 +30,7 @@
  */
 #include "vy_run.h"
 
+#include <fcntl.h>
 #include <zstd.h>
 
 #include "fiber.h"
@@ -74,6 +75,13 @@ const char *vy_file_suffix[] = {
 /* sync run and index files very 16 MB */
 #define VY_RUN_SYNC_INTERVAL (1 << 24)
 
+/**
+ * Alignment of file offsets, sizes, and memory buffers used for
+ * reading run files opened with O_DIRECT. Should be a multiple of
+ * the logical block size of any sane storage device.
+ */
+enum { VY_RUN_DIRECT_IO_ALIGN = 4096 };
+
 /**
  * We read runs in background threads so as not to stall tx.
  * This structure represents such a thread.
@@ -109,6 +117,13 @@ struct vy_page_read_task {
 	bool equal_found;
 	/** [out] resulting vinyl page */
 	struct vy_page *page;
+	/**
+	 * Region of the run file to read ahead after reading
+	 * the page, see vy_run_iterator_readahead(). If the size
+	 * is 0, there's nothing to read ahead.
+	 */
+	uint64_t readahead_offset;
+	uint64_t readahead_size;
 };
 
 /** Destructor for env->zdctx_key thread-local variable */
@@ -240,6 +255,31 @@ vy_run_env_coio_call(struct vy_run_env *env, struct cbus_call_msg *msg,
 	return 0;
 }
 
+/**
+ * Set the data file descriptor of a run. If direct I/O is enabled,
+ * switch the file to O_DIRECT mode so that page reads bypass the OS
+ * page cache. If the file system doesn't support direct I/O, fall
+ * back on buffered reads.
+ */
+static void
+vy_run_set_fd(struct vy_run *run, int fd)
+{
+	run->fd = fd;
+	run->is_direct = false;
+	if (!run->env->direct_io)
+		return;
+#ifdef O_DIRECT
+	int flags = fcntl(fd, F_GETFL);
+	if (flags < 0 || fcntl(fd, F_SETFL, flags | O_DIRECT) < 0) {
+		say_syserror("failed to enable direct I/O for run %lld, "
+			     "falling back on buffered I/O",
+			     (long long)run->id);
+		return;
+	}
+	run->is_direct = true;
+#endif /* O_DIRECT */
+}
+
 /**
  * Initialize page info struct
  *
@@ -527,6 +567,15 @@ vy_slice_cut(struct vy_slice *slice, int64_t id, struct vy_entry begin,
 	return 0;
 }
 
+bool
+vy_slice_is_expired(struct vy_slice *slice, double expire_time)
+{
+	const char *max_key = slice->run->info.max_key;
+	if (max_key == NULL || mp_decode_array(&max_key) == 0)
+		return false;
+	return vy_field_is_expired(max_key, expire_time);
+}
+
 /**
  * Decode page information from xrow.
  *
@@ -892,15 +941,29 @@ static int
 vy_page_read(struct vy_page *page, const struct vy_page_info *page_info,
 	     struct vy_run *run, ZSTD_DStream *zdctx)
 {
+	/*
+	 * If the file is opened with O_DIRECT, we have to read
+	 * whole blocks into an aligned buffer so we round the page
+	 * boundaries to the block size.
+	 */
+	uint64_t offset = page_info->offset;
+	size_t size = page_info->size;
+	size_t alignment = alignof(char);
+	if (run->is_direct) {
+		alignment = VY_RUN_DIRECT_IO_ALIGN;
+		offset = page_info->offset / alignment * alignment;
+		size = page_info->offset - offset + page_info->size;
+		size = DIV_ROUND_UP(size, alignment) * alignment;
+	}
 	/* read xlog tx from xlog file */
 	size_t region_svp = region_used(&fiber()->gc);
-	char *data = (char *)region_alloc(&fiber()->gc, page_info->size);
-	if (data == NULL) {
-		diag_set(OutOfMemory, page_info->size, "region gc", "page");
+	char *buf = (char *)region_aligned_alloc(&fiber()->gc, size,
+						 alignment);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region gc", "page");
 		return -1;
 	}
-	ssize_t readen = fio_pread(run->fd, data, page_info->size,
-				   page_info->offset);
+	ssize_t readen = fio_pread(run->fd, buf, size, offset);
 	ERROR_INJECT(ERRINJ_VYRUN_DATA_READ, {
 		readen = -1;
 		errno = EIO;});
@@ -908,11 +971,17 @@ vy_page_read(struct vy_page *page, const struct vy_page_info *page_info,
 		diag_set(SystemError, "failed to read from file");
 		goto error;
 	}
-	if (readen != (ssize_t)page_info->size) {
+	/*
+	 * With O_DIRECT, we may read less than requested if
+	 * the page is the last one in the file.
+	 */
+	char *data = buf + (page_info->offset - offset);
+	if (readen < (ssize_t)(data - buf + page_info->size)) {
 		diag_set(ClientError, ER_INVALID_RUN_FILE,
 			 "Unexpected end of file");
 		goto error;
 	}
+	readen = page_info->size;
 
 	struct errinj *inj = errinj(ERRINJ_VY_READ_PAGE_TIMEOUT, ERRINJ_DOUBLE);
 	if (inj != NULL && inj->dparam > 0)
@@ -975,6 +1044,26 @@ vy_env_get_zdctx(struct vy_run_env *env)
 	return zdctx;
 }
 
+/**
+ * Hint the OS that a region of a run file is going to be read
+ * soon so that it starts reading it in the background.
+ */
+static void
+vy_run_readahead(struct vy_run *run, uint64_t offset, uint64_t size)
+{
+	/* Reads bypass the page cache so there's no point in it. */
+	if (run->is_direct)
+		return;
+#ifdef HAVE_POSIX_FADVISE
+	if (posix_fadvise(run->fd, offset, size, POSIX_FADV_WILLNEED) != 0)
+		say_syserror("posix_fadvise, fd=%i", run->fd);
+#else
+	(void)run;
+	(void)offset;
+	(void)size;
+#endif /* HAVE_POSIX_FADVISE */
+}
+
 /**
  * vinyl read task callback
  */
@@ -987,6 +1076,10 @@ vy_page_read_cb(struct cbus_call_msg *base)
 		return -1;
 	if (vy_page_read(task->page, task->page_info, task->run, zdctx) != 0)
 		return -1;
+	if (task->readahead_size > 0) {
+		vy_run_readahead(task->run, task->readahead_offset,
+				 task->readahead_size);
+	}
 	if (task->key.stmt != NULL) {
 		task->pos_in_page = vy_page_find_key(task->page, task->key,
 						     task->cmp_def, task->format,
@@ -996,6 +1089,72 @@ vy_page_read_cb(struct cbus_call_msg *base)
 	return 0;
 }
 
+/**
+ * Min number of pages that must be read from disk in a row
+ * in the iterator direction for read-ahead to kick in.
+ */
+enum { VY_RUN_READAHEAD_MIN_SEQ_PAGES = 2 };
+
+/**
+ * Called before reading page @page_no from disk. Detects sequential
+ * scans and, if the iterator is scanning the run sequentially, returns
+ * the region of the run file that should be read ahead in @offset and
+ * @size. Pages are hinted in batches of half the read-ahead window so
+ * as not to issue a system call per each page read. If there's nothing
+ * to read ahead, @size is set to 0.
+ */
+static void
+vy_run_iterator_readahead(struct vy_run_iterator *itr, uint32_t page_no,
+			  uint64_t *offset, uint64_t *size)
+{
+	struct vy_slice *slice = itr->slice;
+	struct vy_run *run = slice->run;
+	int64_t window = run->env->readahead_pages;
+	int dir = iterator_direction(itr->iterator_type);
+
+	*offset = 0;
+	*size = 0;
+	if (itr->seq_read_count > 0 &&
+	    (int64_t)page_no == (int64_t)itr->last_read_page_no + dir) {
+		itr->seq_read_count++;
+	} else {
+		itr->seq_read_count = 1;
+		itr->readahead_page_no = (int64_t)page_no + dir;
+	}
+	itr->last_read_page_no = page_no;
+	if (window == 0 ||
+	    itr->seq_read_count < VY_RUN_READAHEAD_MIN_SEQ_PAGES)
+		return;
+
+	/* [first, last] is the range of pages to read ahead. */
+	int64_t first, last;
+	if (dir > 0) {
+		if (itr->readahead_page_no > (int64_t)page_no + window / 2)
+			return;
+		first = MAX((int64_t)page_no + 1, itr->readahead_page_no);
+		last = MIN((int64_t)page_no + window,
+			   (int64_t)slice->last_page_no);
+		itr->readahead_page_no = last + 1;
+	} else {
+		if (itr->readahead_page_no < (int64_t)page_no - window / 2)
+			return;
+		first = MAX((int64_t)page_no - window,
+			    (int64_t)slice->first_page_no);
+		last = MIN((int64_t)page_no - 1, itr->readahead_page_no);
+		itr->readahead_page_no = first - 1;
+	}
+	if (first > last)
+		return;
+#ifndef NDEBUG
+	errinj(ERRINJ_VY_READAHEAD_COUNT, ERRINJ_INT)->iparam +=
+		last - first + 1;
+#endif
+	struct vy_page_info *first_page = vy_run_page_info(run, first);
+	struct vy_page_info *last_page = vy_run_page_info(run, last);
+	*offset = first_page->offset;
+	*size = last_page->offset + last_page->size - first_page->offset;
+}
+
 /**
  * Read a page from disk given its number.
  * The function caches two most recently read pages.
@@ -1054,6 +1213,8 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 	task->format = itr->format;
 	task->pos_in_page = 0;
 	task->equal_found = false;
+	vy_run_iterator_readahead(itr, page_no, &task->readahead_offset,
+				  &task->readahead_size);
 
 	int rc = vy_run_env_coio_call(env, &task->base, vy_page_read_cb);
 
@@ -1483,6 +1644,9 @@ vy_run_iterator_open(struct vy_run_iterator *itr,
 	itr->curr_pos.page_no = slice->run->info.page_count;
 	itr->curr_page = NULL;
 	itr->prev_page = NULL;
+	itr->last_read_page_no = 0;
+	itr->seq_read_count = 0;
+	itr->readahead_page_no = 0;
 	itr->search_started = false;
 
 	/*
@@ -1767,7 +1931,7 @@ vy_run_recover(struct vy_run *run, const char *dir,
 			 XLOG_META_TYPE_RUN, meta->filetype);
 		goto fail_close;
 	}
-	run->fd = cursor.fd;
+	vy_run_set_fd(run, cursor.fd);
 	xlog_cursor_close(&cursor, true);
 	return 0;
 
@@ -2161,6 +2325,11 @@ vy_run_writer_create_xlog(struct vy_run_writer *writer)
 	opts.rate_limit = writer->run->env->snap_io_rate_limit;
 	opts.sync_interval = VY_RUN_SYNC_INTERVAL;
 	opts.no_compression = writer->no_compression;
+	/*
+	 * With direct I/O, run files are never read through the page
+	 * cache so there's no point in keeping written data there.
+	 */
+	opts.free_cache = writer->run->env->direct_io;
 	if (xlog_create(&writer->data_xlog, path, 0, &meta, &opts) != 0)
 		return -1;
 	return 0;
@@ -2371,8 +2540,9 @@ vy_run_writer_commit(struct vy_run_writer *writer)
 			       writer->space_id, writer->iid) != 0)
 		goto out;
 
-	run->fd = writer->data_xlog.fd;
+	int fd = writer->data_xlog.fd;
 	vy_run_writer_destroy(writer, true);
+	vy_run_set_fd(run, fd);
 	rc = 0;
 out:
 	region_truncate(&fiber()->gc, region_svp);
@@ -2506,7 +2676,7 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 		prev_tuple = NULL;
 	}
 	region_truncate(region, mem_used);
-	run->fd = cursor.fd;
+	vy_run_set_fd(run, cursor.fd);
 	xlog_cursor_close(&cursor, true);
 
 	if (bloom_builder != NULL) {
@@ -74,6 +74,17 @@ struct vy_run_env {
 	 * unconditionally remove unused runs' files in-place.
 	 */
 	bool initial_join;
+	/**
+	 * Number of pages to read ahead when a run iterator detects
+	 * a sequential scan. 0 disables read-ahead.
+	 */
+	uint32_t readahead_pages;
+	/**
+	 * If this flag is set, run data files are read with O_DIRECT
+	 * bypassing the OS page cache, and written run files are
+	 * evicted from the page cache after each sync.
+	 */
+	bool direct_io;
 };
 
 /**
@@ -128,6 +139,11 @@ struct vy_run {
 	struct vy_page_info *page_info;
 	/** Run data file. */
 	int fd;
+	/**
+	 * Set if @fd is opened with O_DIRECT, in which case pages
+	 * must be read with aligned offset, size, and buffer.
+	 */
+	bool is_direct;
 	/** Unique ID of this run. */
 	int64_t id;
 	/** Number of statements in this run. */
@@ -284,6 +300,19 @@ struct vy_run_iterator {
 	 */
 	struct vy_page *curr_page;
 	struct vy_page *prev_page;
+	/** Number of the page that was read from disk last time. */
+	uint32_t last_read_page_no;
+	/**
+	 * Number of pages read from disk in a row in the iterator
+	 * direction. Used for detecting sequential scans.
+	 */
+	uint32_t seq_read_count;
+	/**
+	 * Number of the next page to read ahead in the iterator
+	 * direction. Pages before it have already been hinted to
+	 * the OS, see vy_run_iterator_readahead().
+	 */
+	int64_t readahead_page_no;
 	/** Is false until first .._get or .._next_.. method is called */
 	bool search_started;
 };
@@ -515,6 +544,14 @@ vy_slice_cut(struct vy_slice *slice, int64_t id, struct vy_entry begin,
 	     struct vy_entry end, struct key_def *cmp_def,
 	     struct vy_slice **result);
 
+/**
+ * Return true if all statements stored in a slice have expired,
+ * i.e. the first part of the max key of the run stores a Unix time
+ * less than @expire_time, see index_opts::ttl.
+ */
+bool
+vy_slice_is_expired(struct vy_slice *slice, double expire_time);
+
 /**
  * Open an iterator over on-disk run.
  *
@@ -45,6 +45,7 @@
 #include "fiber.h"
 #include "fiber_cond.h"
 #include "cbus.h"
+#include "clock.h"
 #include "salad/stailq.h"
 #include "say.h"
 #include "txn.h"
@@ -56,6 +57,7 @@
 #include "vy_mem.h"
 #include "vy_quota.h"
 #include "vy_range.h"
+#include "vy_read_view.h"
 #include "vy_run.h"
 #include "vy_write_iterator.h"
 #include "trivia/util.h"
@@ -64,6 +66,9 @@
 #define VY_SCHEDULER_TIMEOUT_MIN	1
 #define VY_SCHEDULER_TIMEOUT_MAX	60
 
+/* How often to look for expired ranges in LSM trees with TTL. */
+#define VY_SCHEDULER_EXPIRE_CHECK_PERIOD	1
+
 static int vy_worker_f(va_list);
 static int vy_scheduler_f(va_list);
 static void vy_task_execute_f(struct cmsg *);
@@ -211,6 +216,15 @@ struct vy_task {
 	 * primary index compaction back to tx.
 	 */
 	struct vy_deferred_delete_handler deferred_delete_handler;
+	/**
+	 * Copies of key definitions of secondary indexes of the space,
+	 * taken when a primary index compaction task is created. Used
+	 * for filtering out deferred DELETEs that don't affect any of
+	 * secondary indexes without a round trip to tx.
+	 */
+	struct key_def **deferred_delete_key_defs;
+	/** Number of elements in @deferred_delete_key_defs. */
+	int deferred_delete_key_def_count;
 	/** Batch of deferred deletes generated by this task. */
 	struct vy_deferred_delete_batch *deferred_delete_batch;
 	/**
@@ -271,6 +285,9 @@ vy_task_delete(struct vy_task *task)
 {
 	assert(task->deferred_delete_batch == NULL);
 	assert(task->deferred_delete_in_progress == 0);
+	for (int i = 0; i < task->deferred_delete_key_def_count; i++)
+		key_def_delete(task->deferred_delete_key_defs[i]);
+	free(task->deferred_delete_key_defs);
 	key_def_delete(task->cmp_def);
 	key_def_delete(task->key_def);
 	vy_lsm_unref(task->lsm);
@@ -411,6 +428,19 @@ vy_worker_pool_get(struct vy_worker_pool *pool)
 	return worker;
 }
 
+/**
+ * Return the number of idle workers in a pool.
+ */
+static int
+vy_worker_pool_idle_count(struct vy_worker_pool *pool)
+{
+	int count = 0;
+	struct stailq_entry *item;
+	stailq_foreach(item, &pool->idle_workers)
+		count++;
+	return count;
+}
+
 /**
  * Put a worker back to the pool it was allocated from once
  * it's done its job.
@@ -434,6 +464,7 @@ vy_scheduler_create(struct vy_scheduler *scheduler, int write_threads,
 	scheduler->read_views = read_views;
 	scheduler->run_env = run_env;
 	scheduler->quota = quota;
+	scheduler->max_subcompactions = 1;
 
 	scheduler->scheduler_fiber = fiber_new("vinyl.scheduler",
 					       vy_scheduler_f);
@@ -639,6 +670,62 @@ vy_scheduler_force_compaction(struct vy_scheduler *scheduler,
 	fiber_cond_signal(&scheduler->scheduler_cond);
 }
 
+/**
+ * Recompute compaction priority of LSM trees with TTL so that
+ * ranges that have expired since the last check get compacted.
+ * Range compaction priority is normally updated only when its
+ * slices change, but a range may expire without being touched.
+ * Returns true if there is at least one LSM tree with TTL and
+ * hence the scheduler has to wake up periodically.
+ */
+static bool
+vy_scheduler_check_expired(struct vy_scheduler *scheduler)
+{
+	bool has_ttl = false;
+	bool is_time = ev_monotonic_now(loop()) -
+		scheduler->expire_check_time >=
+		VY_SCHEDULER_EXPIRE_CHECK_PERIOD;
+	struct vy_lsm *lsm;
+	struct heap_iterator it;
+	vy_compaction_heap_iterator_init(&scheduler->compaction_heap, &it);
+	while ((lsm = vy_compaction_heap_iterator_next(&it)) != NULL) {
+		if (lsm->index_id != 0 || lsm->opts.ttl <= 0 ||
+		    lsm->is_dropped)
+			continue;
+		has_ttl = true;
+		if (!is_time)
+			break;
+		vy_lsm_check_expired(lsm);
+	}
+	if (has_ttl && is_time) {
+		vy_compaction_heap_update_all(&scheduler->compaction_heap);
+		scheduler->expire_check_time = ev_monotonic_now(loop());
+	}
+	return has_ttl;
+}
+
+/**
+ * Return true if an open read view may see any statement stored
+ * in a range.
+ */
+static bool
+vy_scheduler_read_view_sees_range(struct vy_scheduler *scheduler,
+				  struct vy_range *range)
+{
+	if (rlist_empty(scheduler->read_views))
+		return false;
+	/* Read views are sorted by LSN, the newest one is the last. */
+	struct vy_read_view *rv = rlist_last_entry(scheduler->read_views,
+						   struct vy_read_view,
+						   in_read_views);
+	struct vy_slice *slice;
+	rlist_foreach_entry(slice, &range->slices, in_range) {
+		if (slice->run->info.min_lsn <= rv->vlsn)
+			return true;
+	}
+	return false;
+}
+
 /**
  * Check whether the current dump round is complete.
  * If it is, free memory and proceed to the next dump round.
@@ -990,6 +1077,72 @@ vy_task_deferred_delete_flush(struct vy_task *task)
 	cpipe_push(&worker->tx_pipe, &batch->cmsg);
 }
 
+/**
+ * Remember key definitions of secondary indexes of the space
+ * a primary index compaction task is created for so that the
+ * task can filter out redundant deferred DELETEs on its own,
+ * see vy_task_deferred_delete_is_redundant().
+ *
+ * Filtering is disabled if any of secondary indexes is multikey
+ * or functional, because comparing such keys requires extracting
+ * them, which can't be done in a worker thread.
+ */
+static int
+vy_task_deferred_delete_prepare(struct vy_task *task)
+{
+	struct vy_lsm *pk = task->lsm;
+	assert(pk->index_id == 0);
+	struct space *space = space_by_id(pk->space_id);
+	if (space == NULL || space->index_count <= 1 ||
+	    vy_lsm(space->index[0]) != pk)
+		return 0;
+	for (uint32_t i = 1; i < space->index_count; i++) {
+		struct key_def *key_def = space->index[i]->def->key_def;
+		if (key_def->is_multikey || key_def->for_func_index)
+			return 0;
+	}
+	int count = space->index_count - 1;
+	struct key_def **key_defs = calloc(count, sizeof(*key_defs));
+	if (key_defs == NULL) {
+		diag_set(OutOfMemory, count * sizeof(*key_defs),
+			 "calloc", "struct key_def *");
+		return -1;
+	}
+	task->deferred_delete_key_defs = key_defs;
+	for (int i = 0; i < count; i++) {
+		struct key_def *key_def = space->index[i + 1]->def->key_def;
+		key_defs[i] = key_def_dup(key_def);
+		if (key_defs[i] == NULL)
+			return -1;
+		task->deferred_delete_key_def_count++;
+	}
+	return 0;
+}
+
+/**
+ * Check if a deferred DELETE for a tuple overwritten by a REPLACE
+ * is redundant, i.e. the REPLACE doesn't update key parts of any
+ * secondary index. Such a DELETE would be discarded anyway when
+ * the secondary index is compacted, because it has the same key
+ * and LSN as the REPLACE, see heap_less() in vy_write_iterator.c,
+ * so there's no point in sending it to tx and writing it to WAL.
+ */
+static bool
+vy_task_deferred_delete_is_redundant(struct vy_task *task,
+				     struct tuple *old_stmt,
+				     struct tuple *new_stmt)
+{
+	if (task->deferred_delete_key_def_count == 0 ||
+	    vy_stmt_type(new_stmt) != IPROTO_REPLACE)
+		return false;
+	for (int i = 0; i < task->deferred_delete_key_def_count; i++) {
+		if (tuple_compare(old_stmt, HINT_NONE, new_stmt, HINT_NONE,
+				  task->deferred_delete_key_defs[i]) != 0)
+			return false;
+	}
+	return true;
+}
+
 /**
  * Add a deferred DELETE to a batch. Once the batch gets full,
  * submit it to tx where it will get processed.
@@ -1004,6 +1157,9 @@ vy_task_deferred_delete_process(struct vy_deferred_delete_handler *handler,
 					    deferred_delete_handler);
 	struct vy_deferred_delete_batch *batch = task->deferred_delete_batch;
 
+	if (vy_task_deferred_delete_is_redundant(task, old_stmt, new_stmt))
+		return 0;
+
 	/*
 	 * Throttle compaction task if there are too many batches
 	 * being processed so as to limit memory consumption.
@@ -1581,6 +1737,7 @@ vy_task_compaction_complete(struct vy_task *task)
 			break;
 	}
 	range->n_compactions++;
+	range->is_subcompaction = false;
 	vy_range_update_compaction_priority(range, &lsm->opts);
 	vy_range_update_dumps_per_compaction(range);
 	vy_lsm_acct_range(lsm, range);
@@ -1647,9 +1804,37 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 
 	struct vy_range *range = vy_range_heap_top(&lsm->range_heap);
 	assert(range != NULL);
-	assert(range->compaction_priority > 1);
+	assert(range->compaction_priority > 1 || range->is_expired);
 
+	/*
+	 * There's no point in rewriting the only run of an expired
+	 * range while an open read view sees it, because nothing can
+	 * be dropped then (see optimization #6 of the write iterator).
+	 * Postpone compaction until the next expiration check, see
+	 * vy_scheduler_check_expired().
+	 */
+	if (range->is_expired && range->slice_count == 1 &&
+	    vy_scheduler_read_view_sees_range(scheduler, range)) {
+		vy_lsm_unacct_range(lsm, range);
+		range->compaction_priority = 0;
+		range->is_expired = false;
+		vy_disk_stmt_counter_reset(&range->compaction_queue);
+		vy_lsm_acct_range(lsm, range);
+		vy_range_heap_update(&lsm->range_heap, range);
+		vy_scheduler_update_lsm(scheduler, lsm);
+		return 0;
+	}
+
+	/*
+	 * If there are idle workers, split a big range into key-disjoint
+	 * parts so that they can be compacted in parallel. Note, the
+	 * worker passed to this function has already been taken from
+	 * the pool so it isn't accounted as idle.
+	 */
+	int max_parts = MIN(scheduler->max_subcompactions,
+			    1 + vy_worker_pool_idle_count(worker->pool));
 	if (vy_lsm_split_range(lsm, range) ||
+	    vy_lsm_split_range_for_compaction(lsm, range, max_parts) ||
 	    vy_lsm_coalesce_range(lsm, range)) {
 		vy_scheduler_update_lsm(scheduler, lsm);
 		return 0;
@@ -1660,6 +1845,9 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	if (task == NULL)
 		goto err_task;
 
+	if (lsm->index_id == 0 && vy_task_deferred_delete_prepare(task) != 0)
+		goto err_run;
+
 	struct vy_run *new_run = vy_run_prepare(scheduler->run_env, lsm);
 	if (new_run == NULL)
 		goto err_run;
@@ -1673,13 +1861,47 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	if (wi == NULL)
 		goto err_wi;
 
+	/*
+	 * Drop expired statements on major compaction of a space
+	 * with TTL. The Unix time of a tuple is stored in the first
+	 * primary key part. Since secondary index statements store
+	 * all primary key parts, they can be expired, too.
+	 */
+	double expire_time = 0;
+	uint32_t expire_part_no = 0;
+	struct vy_lsm *pk = lsm->index_id == 0 ? lsm : lsm->pk;
+	if (is_last_level && pk->opts.ttl > 0) {
+		const struct key_part *part = key_def_find(lsm->cmp_def,
+						&pk->key_def->parts[0]);
+		assert(part != NULL);
+		expire_part_no = part - lsm->cmp_def->parts;
+		expire_time = clock_realtime() - pk->opts.ttl;
+		vy_write_iterator_set_expire(wi, expire_part_no, expire_time);
+	}
+
+	/*
+	 * No need to read a run if all its statements have expired.
+	 * We can only check this if the key is prefixed with the time
+	 * though. Besides, an open read view must not lose statements
+	 * it sees, neither may it make older statements visible to the
+	 * current read view, so no run can be skipped while a read
+	 * view sees any of the compacted runs.
+	 */
+	bool skip_expired = expire_time > 0 && expire_part_no == 0 &&
+		!vy_scheduler_read_view_sees_range(scheduler, range);
+
 	struct vy_slice *slice;
 	int32_t dump_count = 0;
 	int n = range->compaction_priority;
 	rlist_foreach_entry(slice, &range->slices, in_range) {
-		if (vy_write_iterator_new_slice(wi, slice,
-						lsm->disk_format) != 0)
+		if (skip_expired && vy_slice_is_expired(slice, expire_time)) {
+			say_verbose("%s: skipping expired run %lld",
+				    vy_lsm_name(lsm),
+				    (long long)slice->run->id);
+		} else if (vy_write_iterator_new_slice(wi, slice,
+						       lsm->disk_format) != 0) {
 			goto err_wi_sub;
+		}
 		new_run->dump_lsn = MAX(new_run->dump_lsn,
 					slice->run->dump_lsn);
 		dump_count += slice->run->dump_count;
@@ -1915,8 +2137,12 @@ retry:
 	struct vy_lsm *lsm = vy_compaction_heap_top(&scheduler->compaction_heap);
 	if (lsm == NULL)
 		goto no_task; /* nothing to do */
-	if (vy_lsm_compaction_priority(lsm) <= 1)
+	int priority = vy_lsm_compaction_priority(lsm);
+	if (priority == 0)
 		goto no_task; /* nothing to do */
+	/* Compacting a single run only makes sense if it's expired. */
+	if (priority == 1 && !vy_range_heap_top(&lsm->range_heap)->is_expired)
+		goto no_task;
 	if (worker == NULL) {
 		worker = vy_worker_pool_get(&scheduler->compaction_pool);
 		if (worker == NULL)
@@ -2039,13 +2265,21 @@ vy_scheduler_f(va_list va)
 		/* Throttle for a while if a task failed. */
 		if (tasks_failed > 0)
 			goto error;
+		/* Look for ranges that have expired by now. */
+		bool has_ttl = vy_scheduler_check_expired(scheduler);
 		/* Get a task to schedule. */
 		if (vy_schedule(scheduler, &task) != 0)
 			goto error;
 		/* Nothing to do or all workers are busy. */
 		if (task == NULL) {
 			/* Wait for changes. */
-			fiber_cond_wait(&scheduler->scheduler_cond);
+			if (has_ttl) {
+				fiber_cond_wait_timeout(
+					&scheduler->scheduler_cond,
+					VY_SCHEDULER_EXPIRE_CHECK_PERIOD);
+			} else {
+				fiber_cond_wait(&scheduler->scheduler_cond);
+			}
 			continue;
 		}
 
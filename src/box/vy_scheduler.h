@@ -99,6 +99,11 @@ struct vy_scheduler {
 	double timeout;
 	/** Set if the scheduler is throttled due to errors. */
 	bool is_throttled;
+	/**
+	 * Monotonic time of the last check of LSM trees with TTL
+	 * for expired ranges, see vy_scheduler_check_expired().
+	 */
+	double expire_check_time;
 	/** Set if checkpoint is in progress. */
 	bool checkpoint_in_progress;
 	/**
@@ -135,6 +140,12 @@ struct vy_scheduler {
 	 * at @dump_generation is called 'dump round'.
 	 */
 	int64_t dump_generation;
+	/**
+	 * Max number of key-disjoint parts a range can be split
+	 * into so that they are compacted in parallel. Set to 1
+	 * to disable parallel compaction of a range.
+	 */
+	int max_subcompactions;
 	/** Number of dump tasks that are currently in progress. */
 	int dump_task_count;
 	/** Time when the current dump round started. */
@@ -139,7 +139,7 @@ vy_stmt_format_new(struct vy_stmt_env *env, struct key_def *const *keys,
 {
 	return tuple_format_new(&env->tuple_format_vtab, env, keys, key_count,
 				fields, field_count, exact_field_count, dict,
-				false, false);
+				false, false, false);
 }
 
 /**
@@ -308,6 +308,51 @@ vy_stmt_is_empty_key(struct tuple *stmt)
 	return tuple_field_count(stmt) == 0;
 }
 
+/**
+ * Return true if the given MessagePack field stores a Unix time
+ * less than @expire_time, i.e. a statement it belongs to has
+ * expired, see index_opts::ttl. Fields that aren't numbers never
+ * expire.
+ */
+static inline bool
+vy_field_is_expired(const char *field, double expire_time)
+{
+	if (field == NULL)
+		return false;
+	switch (mp_typeof(*field)) {
+	case MP_UINT:
+		return (double)mp_decode_uint(&field) < expire_time;
+	case MP_INT:
+		return (double)mp_decode_int(&field) < expire_time;
+	case MP_FLOAT:
+		return mp_decode_float(&field) < expire_time;
+	case MP_DOUBLE:
+		return mp_decode_double(&field) < expire_time;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Return true if the key part number @part_no of the given vinyl
+ * statement has expired, see vy_field_is_expired().
+ */
+static inline bool
+vy_stmt_is_expired(struct tuple *stmt, struct key_def *cmp_def,
+		   uint32_t part_no, double expire_time)
+{
+	assert(part_no < cmp_def->part_count);
+	const char *field;
+	if (vy_stmt_is_key(stmt)) {
+		/* Key statements store key parts in order. */
+		field = tuple_field(stmt, part_no);
+	} else {
+		field = tuple_field_by_part(stmt, &cmp_def->parts[part_no],
+					    MULTIKEY_NONE);
+	}
+	return vy_field_is_expired(field, expire_time);
+}
+
 /**
  * Duplicate the statememnt.
  *
@@ -183,6 +183,14 @@ struct vy_write_iterator {
 	bool is_primary;
 	/** Deferred DELETE handler. */
 	struct vy_deferred_delete_handler *deferred_delete_handler;
+	/**
+	 * Keys storing Unix time less than this value in the key
+	 * part number @expire_part_no are dropped on the last level
+	 * (optimization #6). Zero if keys never expire.
+	 */
+	double expire_time;
+	/** Key part that stores the Unix time of a key. */
+	uint32_t expire_part_no;
 	/**
 	 * Last scanned REPLACE or DELETE statement that was
 	 * inserted into the primary index without deletion
@@ -469,6 +477,17 @@ vy_write_iterator_close(struct vy_stmt_stream *vstream)
 	free(stream);
 }
 
+void
+vy_write_iterator_set_expire(struct vy_stmt_stream *vstream,
+			     uint32_t part_no, double expire_time)
+{
+	assert(vstream->iface->close == vy_write_iterator_close);
+	struct vy_write_iterator *stream = (struct vy_write_iterator *)vstream;
+	assert(part_no < stream->cmp_def->part_count);
+	stream->expire_part_no = part_no;
+	stream->expire_time = expire_time;
+}
+
 /**
  * Add a mem as a source of iterator.
  * @return 0 on success or -1 on error (diag is set).
@@ -700,6 +719,14 @@ vy_write_iterator_build_history(struct vy_write_iterator *stream,
 		return rc;
 	}
 	vy_stmt_ref_if_possible(src->entry.stmt);
+	/*
+	 * Optimization 6: drop all statements for an expired key
+	 * unless any of them is visible to an open read view.
+	 */
+	bool is_expired = stream->is_last_level && stream->expire_time > 0 &&
+			  vy_stmt_is_expired(src->entry.stmt, stream->cmp_def,
+					     stream->expire_part_no,
+					     stream->expire_time);
 	/*
 	 * For each pair (merge_until_lsn, current_rv_lsn] build
 	 * a history in the corresponding read view.
@@ -772,6 +799,13 @@ vy_write_iterator_build_history(struct vy_write_iterator *stream,
 			goto next_lsn;
 		}
 
+		/*
+		 * Optimization 6: an open read view sees the key so
+		 * it can't be dropped until the read view is closed.
+		 */
+		if (current_rv_i > 0)
+			is_expired = false;
+
 		rc = vy_write_iterator_push_rv(stream, src->entry,
 					       current_rv_i);
 		if (rc != 0)
@@ -813,6 +847,16 @@ next_lsn:
 		stream->deferred_delete = vy_entry_none();
 	}
 
+	/*
+	 * Optimization 6: the expired key is only visible to the
+	 * current read view so we can drop its history.
+	 */
+	if (rc == 0 && is_expired && *count > 0) {
+		vy_write_history_destroy(stream->read_views[0].history);
+		stream->read_views[0].history = NULL;
+		*count = 0;
+	}
+
 	vy_source_heap_delete(&stream->src_heap, &end_of_key_src);
 	vy_stmt_unref_if_possible(end_of_key_src.entry.stmt);
 	return rc;
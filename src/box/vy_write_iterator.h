@@ -190,6 +190,26 @@
  * also turn the first INSERT in the resulting key's history to a
  * REPLACE in case the oldest statement among all sources is not
  * an INSERT.
+ *
+ * ---------------------------------------------------------------
+ * Optimization #6: when merging the last level of the LSM tree of
+ * a space with TTL, discard all statements for a key that stores
+ * an expired Unix time, see vy_write_iterator_set_expire().
+ * Since the time is stored in the key, all versions of the key
+ * expire simultaneously so we don't need to produce a DELETE for
+ * them. The key is kept though if any of its statements is visible
+ * to an open read view, because a transaction that has already
+ * seen the key must keep seeing it:
+ *
+ *                 ---------------------------
+ *                 EXPIRED KEY, MAJOR COMPACTION
+ *                 ---------------------------
+ *
+ * 0                          VLSN1          ...         INT64_MAX
+ * |                            |                            |
+ * |                            | LSNi   LSNi+1  ...  LSN_N  |
+ * \___________________________/ \___________________________/
+ *            empty                        discard
  */
 
 struct vy_write_iterator;
@@ -252,6 +272,17 @@ vy_write_iterator_new(struct key_def *cmp_def, bool is_primary,
 		      bool is_last_level, struct rlist *read_views,
 		      struct vy_deferred_delete_handler *handler);
 
+/**
+ * Make the write iterator drop all statements for keys that have
+ * expired (optimization #6). The key part number @part_no of the
+ * index key definition is supposed to store the Unix time of the
+ * key. Keys with time less than @expire_time are dropped. Only
+ * relevant to the last level compaction.
+ */
+void
+vy_write_iterator_set_expire(struct vy_stmt_stream *stream,
+			     uint32_t part_no, double expire_time);
+
 /**
  * Add a mem as a source to the iterator.
  * @return 0 on success, -1 on error (diag is set).
@@ -89,6 +89,39 @@ latency_collect(struct latency *latency, double value)
 	histogram_collect(latency->histogram, value_usec);
 }
 
+void
+latency_merge(struct latency *dst, struct latency *src)
+{
+	histogram_merge(dst->histogram, src->histogram);
+	/* Both counters have a zero observation, see latency_create(). */
+	histogram_discard(dst->histogram, 0);
+}
+
+size_t
+latency_count(struct latency *latency)
+{
+	return latency->histogram->total - 1;
+}
+
+int
+latency_bucket_count(struct latency *latency)
+{
+	return latency->histogram->n_buckets;
+}
+
+size_t
+latency_bucket_get(struct latency *latency, int i, double *bound)
+{
+	struct histogram *hist = latency->histogram;
+	assert(i >= 0 && (size_t)i < hist->n_buckets);
+	*bound = (double)hist->buckets[i].max / USEC_PER_SEC;
+	/* Don't count the zero observation, see latency_create(). */
+	size_t count = 0;
+	for (int j = 0; j <= i; j++)
+		count += hist->buckets[j].count;
+	return count - 1;
+}
+
 double
 latency_get(struct latency *latency, int pct)
 {
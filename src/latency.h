@@ -31,6 +31,12 @@
  * SUCH DAMAGE.
  */
 
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
 struct histogram;
 
 /**
@@ -70,6 +76,32 @@ latency_reset(struct latency *latency);
 void
 latency_collect(struct latency *latency, double value);
 
+/**
+ * Add all observations of latency counter @src to @dst.
+ */
+void
+latency_merge(struct latency *dst, struct latency *src);
+
+/**
+ * Return the number of observations of a latency counter.
+ */
+size_t
+latency_count(struct latency *latency);
+
+/**
+ * Return the number of histogram buckets of a latency counter.
+ */
+int
+latency_bucket_count(struct latency *latency);
+
+/**
+ * Get the upper bound of the @i-th histogram bucket of a latency
+ * counter, in seconds, and return the number of observations not
+ * greater than it.
+ */
+size_t
+latency_bucket_get(struct latency *latency, int i, double *bound);
+
 /**
  * Get accumulated latency value, in seconds.
  * Returns @pct-th percentile of all observations.
@@ -77,4 +109,8 @@ latency_collect(struct latency *latency, double value);
 double
 latency_get(struct latency *latency, int pct);
 
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
 #endif /* TARANTOOL_LATENCY_H_INCLUDED */
@@ -151,6 +151,30 @@ coll_icu_hint(const char *s, size_t s_len, char *buf, size_t buf_len,
 				    (uint8_t *)buf, buf_len, &status);
 }
 
+static size_t
+coll_icu_sort_key(const char *s, size_t s_len, char *buf, size_t buf_len,
+		  struct coll *coll)
+{
+	assert(coll->type == COLL_TYPE_ICU);
+	UCharIterator itr;
+	uiter_setUTF8(&itr, s, s_len);
+	uint32_t state[2] = {0, 0};
+	UErrorCode status = U_ZERO_ERROR;
+	size_t len = ucol_nextSortKeyPart(coll->collator, &itr, state,
+					  (uint8_t *)buf, buf_len, &status);
+	if (len < buf_len || U_FAILURE(status))
+		return len;
+	/* The buffer is full, count the rest of the sort key. */
+	uint8_t tail[64];
+	size_t tail_len;
+	do {
+		tail_len = ucol_nextSortKeyPart(coll->collator, &itr, state,
+						tail, sizeof(tail), &status);
+		len += tail_len;
+	} while (tail_len == sizeof(tail) && U_SUCCESS(status));
+	return len;
+}
+
 static size_t
 coll_bin_hint(const char *s, size_t s_len, char *buf, size_t buf_len,
 	      struct coll *coll)
@@ -162,6 +186,14 @@ coll_bin_hint(const char *s, size_t s_len, char *buf, size_t buf_len,
 	return len;
 }
 
+static size_t
+coll_bin_sort_key(const char *s, size_t s_len, char *buf, size_t buf_len,
+		  struct coll *coll)
+{
+	coll_bin_hint(s, s_len, buf, buf_len, coll);
+	return s_len;
+}
+
 /**
  * Set up ICU collator and init cmp and hash members of collation.
  * @param coll Collation to set up.
@@ -272,6 +304,7 @@ coll_icu_init_cmp(struct coll *coll, const struct coll_def *def)
 	coll->cmp = coll_icu_cmp;
 	coll->hash = coll_icu_hash;
 	coll->hint = coll_icu_hint;
+	coll->sort_key = coll_icu_sort_key;
 	return 0;
 }
 
@@ -387,6 +420,7 @@ coll_new(const struct coll_def *def)
 		coll->cmp = coll_bin_cmp;
 		coll->hash = coll_bin_hash;
 		coll->hint = coll_bin_hint;
+		coll->sort_key = coll_bin_sort_key;
 		break;
 	default:
 		unreachable();
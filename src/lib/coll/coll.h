@@ -51,6 +51,9 @@ typedef uint32_t (*coll_hash_f)(const char *s, size_t s_len, uint32_t *ph,
 typedef size_t (*coll_hint_f)(const char *s, size_t s_len, char *buf,
 			      size_t buf_len, struct coll *coll);
 
+typedef size_t (*coll_sort_key_f)(const char *s, size_t s_len, char *buf,
+				  size_t buf_len, struct coll *coll);
+
 struct UCollator;
 
 /** Default universal casemap for case transformations. */
@@ -79,6 +82,16 @@ struct coll {
 	 * copied. Sort keys may be compared using strcmp().
 	 */
 	coll_hint_f hint;
+	/**
+	 * String sort key.
+	 *
+	 * Similar to the hint function, but returns the length
+	 * of the full sort key, which may be greater than the
+	 * buffer size, in which case only a prefix of the sort
+	 * key is copied. Sort keys may be compared using memcmp().
+	 * ICU sort keys never contain zero bytes.
+	 */
+	coll_sort_key_f sort_key;
 	/** Reference counter. */
 	int refs;
 	/**
@@ -41,6 +41,17 @@
 #include "iostream.h"
 #include "uri/uri.h"
 
+/*
+ * Only Linux distributes incoming connections among sockets bound
+ * to the same address with SO_REUSEPORT. Other systems deliver all
+ * connections to one of them, so there's no point in using it there.
+ */
+#if defined(__linux__) && defined(SO_REUSEPORT)
+#define EVIO_USE_REUSEPORT 1
+#else
+#define EVIO_USE_REUSEPORT 0
+#endif
+
 struct evio_service_entry {
 	/** Bind URI */
 	struct uri uri;
@@ -54,6 +65,13 @@ struct evio_service_entry {
 	struct iostream_ctx io_ctx;
 	/** libev io object for the acceptor socket. */
 	struct ev_io ev;
+	/** Set if the acceptor socket is bound with SO_REUSEPORT. */
+	bool reuseport;
+	/**
+	 * Set if the acceptor socket was created by evio_service_attach()
+	 * for this entry and must be closed when the entry is detached.
+	 */
+	bool owns_fd;
 	/** Pointer to the root evio_service, which contains this object */
 	struct evio_service *service;
 };
@@ -242,6 +260,62 @@ err:
 	return -1;
 }
 
+/**
+ * Create a server socket and bind it to @a addr. If @a reuseport is set,
+ * try to set SO_REUSEPORT on the socket; the flag is cleared on failure.
+ * Returns the socket fd or -1 on error.
+ */
+static int
+evio_bind_addr(const struct sockaddr *addr, socklen_t addr_len,
+	       bool *reuseport)
+{
+	int fd = sio_socket(addr->sa_family, SOCK_STREAM, IPPROTO_TCP);
+	if (fd < 0)
+		return -1;
+	if (evio_setsockopt_server(fd, addr->sa_family, SOCK_STREAM) != 0)
+		goto error;
+#if EVIO_USE_REUSEPORT
+	if (*reuseport) {
+		int on = 1;
+		if (sio_setsockopt(fd, SOL_SOCKET, SO_REUSEPORT,
+				   &on, sizeof(on)) != 0) {
+			diag_log();
+			*reuseport = false;
+		}
+	}
+#else
+	*reuseport = false;
+#endif
+	if (sio_bind(fd, addr, addr_len) != 0)
+		goto error;
+	return fd;
+error:
+	close(fd);
+	return -1;
+}
+
+#if EVIO_USE_REUSEPORT
+/**
+ * Any process of the same user can bind a socket to an address
+ * that is used with SO_REUSEPORT and steal a share of incoming
+ * connections. Fail if some socket already listens on @a addr by
+ * binding to it without SO_REUSEPORT first. If the port is 0, it's
+ * replaced with the one chosen by the kernel, so that the address
+ * checked is the one bound afterwards.
+ */
+static int
+evio_check_addr_unused(struct sockaddr *addr, socklen_t *addr_len)
+{
+	bool reuseport = false;
+	int fd = evio_bind_addr(addr, *addr_len, &reuseport);
+	if (fd < 0)
+		return -1;
+	int rc = sio_getsockname(fd, addr, addr_len);
+	close(fd);
+	return rc;
+}
+#endif
+
 /**
  * Try to bind on the configured port.
  *
@@ -253,19 +327,18 @@ evio_service_entry_bind_addr(struct evio_service_entry *entry)
 	say_debug("%s: binding to %s...",
 		  evio_service_name(entry->service),
 		  sio_strfaddr(&entry->addr, entry->addr_len));
-	/* Create a socket. */
-	int fd = sio_socket(entry->addr.sa_family,
-			    SOCK_STREAM, IPPROTO_TCP);
+	entry->reuseport = entry->service->reuseport &&
+			   entry->addr.sa_family != AF_UNIX;
+#if EVIO_USE_REUSEPORT
+	if (entry->reuseport &&
+	    evio_check_addr_unused(&entry->addr, &entry->addr_len) != 0)
+		return -1;
+#endif
+	int fd = evio_bind_addr(&entry->addr, entry->addr_len,
+				&entry->reuseport);
 	if (fd < 0)
 		return -1;
 
-	if (evio_setsockopt_server(fd, entry->addr.sa_family,
-				   SOCK_STREAM) != 0)
-		goto error;
-
-	if (sio_bind(fd, &entry->addr, entry->addr_len) != 0)
-		goto error;
-
 	/*
 	 * After binding a result address may be different. For
 	 * example, if a port was 0.
@@ -311,6 +384,8 @@ evio_service_entry_create(struct evio_service_entry *entry,
 	uri_create(&entry->uri, NULL);
 	memset(&entry->addrstorage, 0, sizeof(entry->addrstorage));
 	entry->addr_len = 0;
+	entry->reuseport = false;
+	entry->owns_fd = false;
 	iostream_ctx_clear(&entry->io_ctx);
 	/*
 	 * Initialize libev objects to be able to detect if they
@@ -385,6 +460,9 @@ evio_service_entry_detach(struct evio_service_entry *entry)
 		ev_io_stop(entry->service->loop, &entry->ev);
 		entry->addr_len = 0;
 	}
+	if (entry->owns_fd && entry->ev.fd >= 0 && close(entry->ev.fd) < 0)
+		say_error("Failed to close socket: %s", strerror(errno));
+	entry->owns_fd = false;
 	ev_io_set(&entry->ev, -1, 0);
 	uri_destroy(&entry->uri);
 }
@@ -412,7 +490,7 @@ evio_service_entry_stop(struct evio_service_entry *entry)
 	}
 }
 
-static void
+static int
 evio_service_entry_attach(struct evio_service_entry *dst,
 			 const struct evio_service_entry *src)
 {
@@ -422,7 +500,21 @@ evio_service_entry_attach(struct evio_service_entry *dst,
 	dst->addrstorage = src->addrstorage;
 	dst->addr_len = src->addr_len;
 	dst->io_ctx = src->io_ctx;
-	ev_io_set(&dst->ev, src->ev.fd, EV_READ);
+	int fd = src->ev.fd;
+	if (src->reuseport) {
+		/*
+		 * Bind a socket of our own to the same address, so that
+		 * the kernel balances connections among the services.
+		 */
+		dst->reuseport = true;
+		fd = evio_bind_addr(&src->addr, src->addr_len,
+				    &dst->reuseport);
+		if (fd < 0)
+			return -1;
+		dst->owns_fd = true;
+	}
+	ev_io_set(&dst->ev, fd, EV_READ);
+	return 0;
 }
 
 static inline int
@@ -473,13 +565,17 @@ evio_service_create(struct ev_loop *loop, struct evio_service *service,
 	service->on_accept_param = on_accept_param;
 }
 
-void
+int
 evio_service_attach(struct evio_service *dst, const struct evio_service *src)
 {
 	assert(dst->entry_count == 0);
 	evio_service_create_entries(dst, src->entry_count);
-	for (int i = 0; i < src->entry_count; i++)
-		evio_service_entry_attach(&dst->entries[i], &src->entries[i]);
+	for (int i = 0; i < src->entry_count; i++) {
+		if (evio_service_entry_attach(&dst->entries[i],
+					      &src->entries[i]) != 0)
+			return -1;
+	}
+	return 0;
 }
 
 void
@@ -88,6 +88,15 @@ struct evio_service {
         evio_accept_f on_accept;
         void *on_accept_param;
         ev_loop *loop;
+        /**
+         * If set before evio_service_bind(), TCP sockets are bound
+         * with SO_REUSEPORT, so that evio_service_attach() creates
+         * a separate listening socket for each attached service and
+         * the kernel balances incoming connections among them.
+         * Ignored on systems that don't load-balance SO_REUSEPORT
+         * sockets.
+         */
+        bool reuseport;
 };
 
 /**
@@ -131,8 +140,10 @@ evio_service_stop(struct evio_service *service);
 
 /**
  * Updates @a dst evio_service socket settings according @a src evio service.
+ * Sockets bound with SO_REUSEPORT aren't shared: @a dst gets its own socket
+ * bound to the same address, which is closed by evio_service_detach().
  */
-void
+int
 evio_service_attach(struct evio_service *dst, const struct evio_service *src);
 
 bool
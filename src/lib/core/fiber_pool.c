@@ -29,6 +29,46 @@
  * SUCH DAMAGE.
  */
 #include "fiber_pool.h"
+
+/** Max number of fibers that may handle low priority messages. */
+static inline int
+fiber_pool_low_priority_max(struct fiber_pool *pool)
+{
+	return MAX(pool->max_size - pool->max_size / 4, 1);
+}
+
+/** Check if the pool has a message a fiber could start on now. */
+static inline bool
+fiber_pool_has_runnable(struct fiber_pool *pool)
+{
+	return !stailq_empty(&pool->output) ||
+	       (!stailq_empty(&pool->low_output) &&
+		pool->low_in_progress < fiber_pool_low_priority_max(pool));
+}
+
+/**
+ * Take the next message to handle, picking one low priority
+ * message per FIBER_POOL_LOW_PRIORITY_WEIGHT normal ones when
+ * both queues are non-empty.
+ */
+static struct cmsg *
+fiber_pool_shift(struct fiber_pool *pool, bool *is_low)
+{
+	assert(fiber_pool_has_runnable(pool));
+	bool low_runnable = !stailq_empty(&pool->low_output) &&
+		pool->low_in_progress < fiber_pool_low_priority_max(pool);
+	if (low_runnable && (stailq_empty(&pool->output) ||
+	    pool->normal_streak >= FIBER_POOL_LOW_PRIORITY_WEIGHT)) {
+		pool->normal_streak = 0;
+		*is_low = true;
+		return stailq_shift_entry(&pool->low_output, struct cmsg, fifo);
+	}
+	if (low_runnable)
+		pool->normal_streak++;
+	*is_low = false;
+	return stailq_shift_entry(&pool->output, struct cmsg, fifo);
+}
+
 /**
  * Main function of the fiber invoked to handle all outstanding
  * tasks in a queue.
@@ -40,16 +80,19 @@ fiber_pool_f(va_list ap)
 	struct cord *cord = cord();
 	struct fiber *f = fiber();
 	struct ev_loop *loop = pool->consumer;
-	struct stailq *output = &pool->output;
 	struct cmsg *msg;
+	bool is_low;
 	ev_tstamp last_active_at = ev_monotonic_now(loop);
 	pool->size++;
 restart:
 	msg = NULL;
-	while (!stailq_empty(output) && !fiber_is_cancelled()) {
-		 msg = stailq_shift_entry(output, struct cmsg, fifo);
+	while (fiber_pool_has_runnable(pool) && !fiber_is_cancelled()) {
+		msg = fiber_pool_shift(pool, &is_low);
+		if (is_low)
+			pool->low_in_progress++;
 
-		if (f->caller == &cord->sched && ! stailq_empty(output) &&
+		if (f->caller == &cord->sched &&
+		    fiber_pool_has_runnable(pool) &&
 		    ! rlist_empty(&pool->idle)) {
 			/*
 			 * Activate a "backup" fiber for the next
@@ -62,6 +105,8 @@ restart:
 			assert(f->caller->caller == &cord->sched);
 		}
 		cmsg_deliver(msg);
+		if (is_low)
+			pool->low_in_progress--;
 		/*
 		 * Normally fibers die after their function
 		 * returns, and they call on_stop() triggers. The
@@ -122,9 +167,9 @@ fiber_pool_cb(ev_loop *loop, struct ev_watcher *watcher, int events)
 	struct fiber_pool *pool = (struct fiber_pool *) watcher->data;
 	/** Fetch messages */
 	cbus_endpoint_fetch(&pool->endpoint, &pool->output);
+	cbus_endpoint_fetch(&pool->low_endpoint, &pool->low_output);
 
-	struct stailq *output = &pool->output;
-	while (! stailq_empty(output)) {
+	while (fiber_pool_has_runnable(pool)) {
 		struct fiber *f;
 		if (! rlist_empty(&pool->idle)) {
 			f = rlist_shift_entry(&pool->idle, struct fiber, state);
@@ -169,9 +214,16 @@ fiber_pool_create(struct fiber_pool *pool, const char *name, int max_pool_size,
 	pool->size = 0;
 	pool->max_size = max_pool_size;
 	stailq_create(&pool->output);
+	stailq_create(&pool->low_output);
+	pool->normal_streak = 0;
+	pool->low_in_progress = 0;
 	fiber_cond_create(&pool->worker_cond);
 	/* Join fiber pool to cbus */
 	cbus_endpoint_create(&pool->endpoint, name, fiber_pool_cb, pool);
+	char low_name[FIBER_NAME_MAX];
+	snprintf(low_name, sizeof(low_name), "%s_low", name);
+	cbus_endpoint_create(&pool->low_endpoint, low_name, fiber_pool_cb,
+			     pool);
 }
 
 void
@@ -179,6 +231,7 @@ fiber_pool_destroy(struct fiber_pool *pool)
 {
 	/** Endpoint has connected pipes or unfetched messages */
 	cbus_endpoint_destroy(&pool->endpoint, NULL);
+	cbus_endpoint_destroy(&pool->low_endpoint, NULL);
 	/**
 	 * At this point all messages are started to execution because last
 	 * cbus poison message was fired (endpoint_destroy condition).
@@ -44,9 +44,22 @@ extern "C" {
 /** Period after which an idle fiber in the pool is shut down. */
 enum { FIBER_POOL_IDLE_TIMEOUT = 1 };
 
+/**
+ * When both queues of a pool are non-empty, one low priority
+ * message is handled per this many normal priority messages.
+ */
+enum { FIBER_POOL_LOW_PRIORITY_WEIGHT = 8 };
+
 /**
  * A pool of worker fibers to handle messages,
  * so that each message is handled in its own fiber.
+ *
+ * The pool has two inputs: a normal priority endpoint named after
+ * the pool and a low priority one, with "_low" suffix. Low priority
+ * messages are handled only when there are no normal priority
+ * messages or once in FIBER_POOL_LOW_PRIORITY_WEIGHT messages, and
+ * can't occupy more than 3/4 of the pool fibers, so that a burst of
+ * slow low priority requests doesn't delay the rest.
  */
 struct fiber_pool {
 	struct {
@@ -63,6 +76,15 @@ struct fiber_pool {
 		float idle_timeout;
 		/** Staged messages (for fibers to work on) */
 		struct stailq output;
+		/** Staged low priority messages. */
+		struct stailq low_output;
+		/**
+		 * Number of normal priority messages taken from the
+		 * queue in a row while there were low priority ones.
+		 */
+		int normal_streak;
+		/** Number of low priority messages being handled. */
+		int low_in_progress;
 		/** Timer for idle workers */
 		struct ev_timer idle_timer;
 		/** Condition for worker exit signaling */
@@ -73,6 +95,8 @@ struct fiber_pool {
 		alignas(CACHELINE_SIZE) struct ev_loop *consumer;
 		/** cbus endpoint to fetch messages from */
 		struct cbus_endpoint endpoint;
+		/** cbus endpoint to fetch low priority messages from. */
+		struct cbus_endpoint low_endpoint;
 	};
 };
 
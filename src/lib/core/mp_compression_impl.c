@@ -0,0 +1,215 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2021, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "mp_compression.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zstd.h>
+
+#include "fiber.h"
+#include "msgpuck.h"
+#include "mp_extension_types.h"
+
+/**
+ * Compression level used for zstd. Fields are compressed on
+ * each write so we prefer speed to compression ratio here.
+ */
+enum { MP_COMPRESSION_ZSTD_LEVEL = 3 };
+
+/** Zstd compression context. Used only in the tx thread. */
+static ZSTD_CCtx *zstd_cctx;
+
+/**
+ * Zstd decompression context of the tx thread. Other threads
+ * (e.g. the one writing a snapshot) let zstd allocate a context
+ * on each call.
+ */
+static ZSTD_DCtx *zstd_dctx;
+
+/**
+ * Decode the header of MP_COMPRESSION payload [@a data,
+ * @a data + @a len). On success, return the compression type,
+ * the original value size, and the compressed data size and
+ * advance @a data to the compressed data.
+ */
+static int
+compression_unpack_header(const char **data, uint32_t len,
+			  enum compression_type *type, size_t *size,
+			  size_t *data_size)
+{
+	const char *pos = *data;
+	const char *end = pos + len;
+	if (pos == end || mp_typeof(*pos) != MP_UINT ||
+	    mp_check_uint(pos, end) > 0)
+		return -1;
+	uint64_t t = mp_decode_uint(&pos);
+	if (pos == end || mp_typeof(*pos) != MP_UINT ||
+	    mp_check_uint(pos, end) > 0)
+		return -1;
+	uint64_t s = mp_decode_uint(&pos);
+	if (t == COMPRESSION_TYPE_NONE || t >= compression_type_MAX ||
+	    s == 0 || s > UINT32_MAX)
+		return -1;
+	*type = t;
+	*size = s;
+	*data_size = end - pos;
+	*data = pos;
+	return 0;
+}
+
+char *
+mp_compress(char *dst, const char *src, size_t src_size,
+	    enum compression_type type)
+{
+	assert(cord_is_main());
+	assert(type == COMPRESSION_TYPE_ZSTD);
+	/*
+	 * We don't know the size of the MP_EXT header until we
+	 * compress the data so reserve space for the biggest one
+	 * and move the data after encoding the header.
+	 */
+	uint32_t header_size = mp_sizeof_extl(src_size) +
+			       mp_sizeof_uint(type) + mp_sizeof_uint(src_size);
+	if (src_size <= header_size)
+		return NULL;
+	if (zstd_cctx == NULL) {
+		zstd_cctx = ZSTD_createCCtx();
+		if (zstd_cctx == NULL)
+			return NULL;
+	}
+	char *data = dst + header_size;
+	size_t data_size = ZSTD_compressCCtx(zstd_cctx, data,
+					     src_size - header_size, src,
+					     src_size, MP_COMPRESSION_ZSTD_LEVEL);
+	if (ZSTD_isError(data_size))
+		return NULL;
+	uint32_t len = mp_sizeof_uint(type) + mp_sizeof_uint(src_size) +
+		       data_size;
+	char *pos = mp_encode_extl(dst, MP_COMPRESSION, len);
+	pos = mp_encode_uint(pos, type);
+	pos = mp_encode_uint(pos, src_size);
+	assert(pos <= data);
+	memmove(pos, data, data_size);
+	return pos + data_size;
+}
+
+bool
+mp_is_compression(const char *data)
+{
+	if (mp_typeof(*data) != MP_EXT)
+		return false;
+	int8_t type;
+	mp_decode_extl(&data, &type);
+	return type == MP_COMPRESSION;
+}
+
+size_t
+mp_decompressed_size(const char *data)
+{
+	int8_t ext_type;
+	uint32_t len = mp_decode_extl(&data, &ext_type);
+	assert(ext_type == MP_COMPRESSION);
+	enum compression_type type;
+	size_t size, data_size;
+	if (compression_unpack_header(&data, len, &type, &size,
+				      &data_size) != 0)
+		return 0;
+	return size;
+}
+
+/**
+ * Decompress MP_COMPRESSION payload [@a data, @a data + @a len)
+ * to @a dst. Returns the decompressed value size or 0 on error.
+ */
+static size_t
+compression_unpack(const char *data, uint32_t len, char *dst,
+		   size_t dst_size)
+{
+	enum compression_type type;
+	size_t size, data_size;
+	if (compression_unpack_header(&data, len, &type, &size,
+				      &data_size) != 0)
+		return 0;
+	if (size > dst_size)
+		return 0;
+	assert(type == COMPRESSION_TYPE_ZSTD);
+	size_t rc;
+	if (cord_is_main()) {
+		if (zstd_dctx == NULL) {
+			zstd_dctx = ZSTD_createDCtx();
+			if (zstd_dctx == NULL)
+				return 0;
+		}
+		rc = ZSTD_decompressDCtx(zstd_dctx, dst, size,
+					 data, data_size);
+	} else {
+		rc = ZSTD_decompress(dst, size, data, data_size);
+	}
+	if (ZSTD_isError(rc) || rc != size)
+		return 0;
+	return size;
+}
+
+size_t
+mp_decompress(const char **src, char *dst, size_t dst_size)
+{
+	const char *data = *src;
+	int8_t type;
+	uint32_t len = mp_decode_extl(&data, &type);
+	assert(type == MP_COMPRESSION);
+	size_t size = compression_unpack(data, len, dst, dst_size);
+	if (size == 0)
+		return 0;
+	*src = data + len;
+	return size;
+}
+
+/**
+ * Decompress MP_COMPRESSION payload to a buffer allocated with
+ * malloc(). Returns NULL on error.
+ */
+static char *
+compression_unpack_alloc(const char **data, uint32_t len)
+{
+	const char *pos = *data;
+	enum compression_type type;
+	size_t size, data_size;
+	if (compression_unpack_header(&pos, len, &type, &size,
+				      &data_size) != 0)
+		return NULL;
+	char *buf = malloc(size);
+	if (buf == NULL)
+		return NULL;
+	if (compression_unpack(*data, len, buf, size) == 0) {
+		free(buf);
+		return NULL;
+	}
+	*data += len;
+	return buf;
+}
+
+int
+mp_snprint_compression(char *buf, int size, const char **data, uint32_t len)
+{
+	char *value = compression_unpack_alloc(data, len);
+	if (value == NULL)
+		return -1;
+	int rc = mp_snprint(buf, size, value);
+	free(value);
+	return rc;
+}
+
+int
+mp_fprint_compression(FILE *file, const char **data, uint32_t len)
+{
+	char *value = compression_unpack_alloc(data, len);
+	if (value == NULL)
+		return -1;
+	int rc = mp_fprint(file, value);
+	free(value);
+	return rc;
+}
@@ -0,0 +1,93 @@
+#pragma once
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2021, Tarantool AUTHORS, please see AUTHORS file.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include "tt_compression.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * A compressed MsgPack value is stored as an MP_EXT of type
+ * MP_COMPRESSION with the following payload:
+ *
+ *   <compression type : MP_UINT> <original size : MP_UINT> <data>
+ *
+ * where <data> is the original MsgPack value compressed with
+ * the given algorithm.
+ */
+
+/**
+ * Compress the MsgPack value [@a src, @a src + @a src_size) and
+ * encode it as MP_COMPRESSION to @a dst. Compression is only
+ * performed if it reduces the value size so @a dst must have at
+ * least @a src_size bytes available.
+ *
+ * Must only be called from the tx thread.
+ *
+ * @retval NULL The value isn't worth compressing.
+ * @retval Pointer to the end of the encoded value.
+ */
+char *
+mp_compress(char *dst, const char *src, size_t src_size,
+	    enum compression_type type);
+
+/** Check if @a data points to an MP_COMPRESSION value. */
+bool
+mp_is_compression(const char *data);
+
+/**
+ * Return the size of the original value stored in the
+ * MP_COMPRESSION pointed to by @a data.
+ */
+size_t
+mp_decompressed_size(const char *data);
+
+/**
+ * Decompress the MP_COMPRESSION value pointed to by @a src
+ * to @a dst, which must have at least @a dst_size bytes.
+ *
+ * Safe to call from any thread.
+ *
+ * @retval 0 Data is corrupted or @a dst is too small.
+ * @retval Size of the decompressed value.
+ * @post *src points to the end of the MP_COMPRESSION value.
+ */
+size_t
+mp_decompress(const char **src, char *dst, size_t dst_size);
+
+/**
+ * Print the decompressed value into a given buffer.
+ * @param buf Target buffer to write string to.
+ * @param size Buffer size.
+ * @param data MP_COMPRESSION payload, without MP_EXT header.
+ * @param len Length of @a data.
+ * @retval <0 Error. Couldn't decompress the value.
+ * @retval >=0 How many bytes were written, or would have been
+ *        written, if there was enough buffer space.
+ */
+int
+mp_snprint_compression(char *buf, int size, const char **data, uint32_t len);
+
+/**
+ * Print the decompressed value into a stream.
+ * @param file Target stream to write string to.
+ * @param data MP_COMPRESSION payload, without MP_EXT header.
+ * @param len Length of @a data.
+ * @retval <0 Error. Couldn't decompress the value or write to
+ *        the stream.
+ * @retval >=0 How many bytes were written.
+ */
+int
+mp_fprint_compression(FILE *file, const char **data, uint32_t len);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
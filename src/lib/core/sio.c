@@ -110,6 +110,9 @@ sio_option_name(int option)
 	CASE_OPTION(SO_ERROR);
 	CASE_OPTION(SO_REUSEADDR);
 	CASE_OPTION(TCP_NODELAY);
+#ifdef SO_REUSEPORT
+	CASE_OPTION(SO_REUSEPORT);
+#endif
 #ifdef __linux__
 	CASE_OPTION(TCP_KEEPCNT);
 	CASE_OPTION(TCP_KEEPINTVL);
@@ -5,20 +5,69 @@
  */
 #include "ssl.h"
 
+#include <errno.h>
+#include <limits.h>
+#include <openssl/bio.h>
 #include <openssl/crypto.h>
 #include <openssl/err.h>
 #include <openssl/evp.h>
 #include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
 
 #include "diag.h"
 #include "iostream.h"
+#include "sio.h"
+#include "ssl_error.h"
 #include "trivia/config.h"
+#include "uri/uri.h"
 
 #if defined(ENABLE_SSL)
 # error unimplemented
 #endif
 
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+# define TLS_server_method SSLv23_server_method
+# define TLS_client_method SSLv23_client_method
+#endif
+
+/*
+ * Kernel TLS offload is available since OpenSSL 3.0. If the kernel
+ * supports it, OpenSSL moves the symmetric crypto of an established
+ * connection to the kernel, and then application data may be written
+ * to the socket directly, bypassing the SSL record layer.
+ */
+#if defined(SSL_OP_ENABLE_KTLS) && defined(BIO_get_ktls_send)
+# define SSL_USE_KTLS 1
+#else
+# define SSL_USE_KTLS 0
+#endif
+
+struct ssl_iostream_ctx {
+	/** OpenSSL context shared by all streams created with it. */
+	SSL_CTX *ssl_ctx;
+	/**
+	 * Server host name sent by a client in the SNI extension or
+	 * NULL if the URI host is an IP address or a Unix socket.
+	 */
+	char *server_name;
+};
+
+/** Implementation specific data of an SSL IO stream. */
+struct ssl_iostream {
+	/** OpenSSL connection object. */
+	SSL *ssl;
+	/**
+	 * Set if the last SSL_write() didn't complete. It must be
+	 * retried with the same data before anything else is written.
+	 */
+	bool write_pending;
+};
+
 void
 ssl_init(void)
 {
@@ -26,6 +75,8 @@ ssl_init(void)
 	OpenSSL_add_all_digests();
 	OpenSSL_add_all_ciphers();
 	ERR_load_crypto_strings();
+	SSL_library_init();
+	SSL_load_error_strings();
 #else
 	OPENSSL_init_crypto(0, NULL);
 	OPENSSL_init_ssl(0, NULL);
@@ -43,8 +94,307 @@ ssl_free(void)
 struct ssl_iostream_ctx *
 ssl_iostream_ctx_new(enum iostream_mode mode, const struct uri *uri)
 {
-	(void)mode;
-	(void)uri;
-	diag_set(IllegalParams, "SSL is not available in this build");
+	assert(mode == IOSTREAM_SERVER || mode == IOSTREAM_CLIENT);
+	const char *key_file = uri_param(uri, "ssl_key_file", 0);
+	const char *cert_file = uri_param(uri, "ssl_cert_file", 0);
+	const char *ca_file = uri_param(uri, "ssl_ca_file", 0);
+	const char *ciphers = uri_param(uri, "ssl_ciphers", 0);
+	if (mode == IOSTREAM_SERVER &&
+	    (key_file == NULL || cert_file == NULL)) {
+		diag_set(IllegalParams, "ssl_key_file and ssl_cert_file "
+			 "parameters are mandatory for a server");
+		return NULL;
+	}
+	if ((key_file == NULL) != (cert_file == NULL)) {
+		diag_set(IllegalParams, "ssl_key_file and ssl_cert_file "
+			 "parameters must be set together");
+		return NULL;
+	}
+	SSL_CTX *ssl_ctx = SSL_CTX_new(mode == IOSTREAM_SERVER ?
+				       TLS_server_method() :
+				       TLS_client_method());
+	if (ssl_ctx == NULL) {
+		diag_set(SSLError, "SSL_CTX_new failed");
+		return NULL;
+	}
+	SSL_CTX_set_options(ssl_ctx, SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3 |
+				     SSL_OP_NO_TLSv1 | SSL_OP_NO_TLSv1_1 |
+				     SSL_OP_NO_COMPRESSION);
+#ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+	/* Treat a connection closed without close_notify as EOF. */
+	SSL_CTX_set_options(ssl_ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+#endif
+#if SSL_USE_KTLS
+	SSL_CTX_set_options(ssl_ctx, SSL_OP_ENABLE_KTLS);
+#endif
+	/*
+	 * Output buffers may be reallocated and appended to between
+	 * retries of a write that returned IOSTREAM_WANT_WRITE.
+	 */
+	SSL_CTX_set_mode(ssl_ctx, SSL_MODE_ENABLE_PARTIAL_WRITE |
+				  SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+	if (cert_file != NULL &&
+	    SSL_CTX_use_certificate_chain_file(ssl_ctx, cert_file) != 1) {
+		diag_set(SSLError, "Failed to load SSL certificate file %s",
+			 cert_file);
+		goto err;
+	}
+	if (key_file != NULL &&
+	    SSL_CTX_use_PrivateKey_file(ssl_ctx, key_file,
+					SSL_FILETYPE_PEM) != 1) {
+		diag_set(SSLError, "Failed to load SSL private key file %s",
+			 key_file);
+		goto err;
+	}
+	if (key_file != NULL && SSL_CTX_check_private_key(ssl_ctx) != 1) {
+		diag_set(SSLError, "SSL private key doesn't match "
+			 "the certificate");
+		goto err;
+	}
+	if (ca_file != NULL) {
+		if (SSL_CTX_load_verify_locations(ssl_ctx, ca_file,
+						  NULL) != 1) {
+			diag_set(SSLError, "Failed to load SSL CA file %s",
+				 ca_file);
+			goto err;
+		}
+		SSL_CTX_set_verify(ssl_ctx, SSL_VERIFY_PEER |
+				   SSL_VERIFY_FAIL_IF_NO_PEER_CERT, NULL);
+	}
+	/*
+	 * A client checks that the server certificate was issued for
+	 * the host it connects to: a certificate signed by a trusted
+	 * CA for another host must not be accepted.
+	 */
+	const char *host = mode == IOSTREAM_CLIENT ? uri->host : NULL;
+	if (host != NULL && strcmp(host, URI_HOST_UNIX) == 0)
+		host = NULL;
+	bool host_is_ip = false;
+	if (host != NULL) {
+		X509_VERIFY_PARAM *param = SSL_CTX_get0_param(ssl_ctx);
+		host_is_ip = X509_VERIFY_PARAM_set1_ip_asc(param, host) == 1;
+		if (!host_is_ip &&
+		    X509_VERIFY_PARAM_set1_host(param, host, 0) != 1) {
+			diag_set(SSLError, "Failed to set SSL host name %s",
+				 host);
+			goto err;
+		}
+	}
+	if (ciphers != NULL && SSL_CTX_set_cipher_list(ssl_ctx, ciphers) != 1) {
+		diag_set(SSLError, "Failed to set SSL ciphers to %s", ciphers);
+		goto err;
+	}
+	struct ssl_iostream_ctx *ctx = malloc(sizeof(*ctx));
+	if (ctx == NULL) {
+		diag_set(OutOfMemory, sizeof(*ctx), "malloc",
+			 "struct ssl_iostream_ctx");
+		goto err;
+	}
+	ctx->ssl_ctx = ssl_ctx;
+	ctx->server_name = NULL;
+	/* SNI must not be an IP address, see RFC 6066. */
+	if (host != NULL && !host_is_ip) {
+		ctx->server_name = strdup(host);
+		if (ctx->server_name == NULL) {
+			diag_set(OutOfMemory, strlen(host) + 1, "strdup",
+				 "server_name");
+			free(ctx);
+			goto err;
+		}
+	}
+	return ctx;
+err:
+	SSL_CTX_free(ssl_ctx);
 	return NULL;
 }
+
+void
+ssl_iostream_ctx_delete(struct ssl_iostream_ctx *ctx)
+{
+	SSL_CTX_free(ctx->ssl_ctx);
+	free(ctx->server_name);
+	free(ctx);
+}
+
+static const struct iostream_vtab ssl_iostream_vtab;
+
+int
+ssl_iostream_create(struct iostream *io, int fd, enum iostream_mode mode,
+		    const struct ssl_iostream_ctx *ctx)
+{
+	assert(fd >= 0);
+	assert(mode == IOSTREAM_SERVER || mode == IOSTREAM_CLIENT);
+	struct ssl_iostream *stream = malloc(sizeof(*stream));
+	if (stream == NULL) {
+		diag_set(OutOfMemory, sizeof(*stream), "malloc",
+			 "struct ssl_iostream");
+		return -1;
+	}
+	stream->write_pending = false;
+	stream->ssl = SSL_new(ctx->ssl_ctx);
+	if (stream->ssl == NULL) {
+		diag_set(SSLError, "SSL_new failed");
+		goto err;
+	}
+	if (SSL_set_fd(stream->ssl, fd) != 1) {
+		diag_set(SSLError, "SSL_set_fd failed");
+		goto err;
+	}
+	if (ctx->server_name != NULL &&
+	    SSL_set_tlsext_host_name(stream->ssl, ctx->server_name) != 1) {
+		diag_set(SSLError, "SSL_set_tlsext_host_name failed");
+		goto err;
+	}
+	if (mode == IOSTREAM_SERVER)
+		SSL_set_accept_state(stream->ssl);
+	else
+		SSL_set_connect_state(stream->ssl);
+	iostream_clear(io);
+	io->vtab = &ssl_iostream_vtab;
+	io->data = stream;
+	io->fd = fd;
+	return 0;
+err:
+	SSL_free(stream->ssl);
+	free(stream);
+	return -1;
+}
+
+static void
+ssl_iostream_destroy(struct iostream *io)
+{
+	struct ssl_iostream *stream = io->data;
+	SSL_free(stream->ssl);
+	free(stream);
+}
+
+/**
+ * Converts the result of a failed SSL_read() or SSL_write() to
+ * iostream_status. A closed connection is reported as EOF (0) for
+ * reads and as an error for writes.
+ */
+static ssize_t
+ssl_iostream_status(struct iostream *io, int ret, bool is_read,
+		    const char *func)
+{
+	struct ssl_iostream *stream = io->data;
+	switch (SSL_get_error(stream->ssl, ret)) {
+	case SSL_ERROR_WANT_READ:
+		return IOSTREAM_WANT_READ;
+	case SSL_ERROR_WANT_WRITE:
+		return IOSTREAM_WANT_WRITE;
+	case SSL_ERROR_ZERO_RETURN:
+		if (is_read)
+			return 0;
+		errno = EPIPE;
+		diag_set(SocketError, sio_socketname(io->fd), "%s", func);
+		return IOSTREAM_ERROR;
+	case SSL_ERROR_SYSCALL:
+		if (errno == 0) {
+			/* The peer closed the socket without close_notify. */
+			if (is_read)
+				return 0;
+			errno = EPIPE;
+		}
+		if (sio_wouldblock(errno))
+			return is_read ? IOSTREAM_WANT_READ :
+					 IOSTREAM_WANT_WRITE;
+		diag_set(SocketError, sio_socketname(io->fd), "%s", func);
+		return IOSTREAM_ERROR;
+	default:
+		diag_set(SSLError, "%s failed", func);
+		return IOSTREAM_ERROR;
+	}
+}
+
+static ssize_t
+ssl_iostream_read(struct iostream *io, void *buf, size_t count)
+{
+	struct ssl_iostream *stream = io->data;
+	assert(io->fd >= 0);
+	if (count > INT_MAX)
+		count = INT_MAX;
+	ERR_clear_error();
+	errno = 0;
+	int ret = SSL_read(stream->ssl, buf, (int)count);
+	if (ret > 0)
+		return ret;
+	return ssl_iostream_status(io, ret, true, "SSL_read");
+}
+
+static ssize_t
+ssl_iostream_write(struct iostream *io, const void *buf, size_t count)
+{
+	struct ssl_iostream *stream = io->data;
+	assert(io->fd >= 0);
+	if (count > INT_MAX)
+		count = INT_MAX;
+	ERR_clear_error();
+	errno = 0;
+	int ret = SSL_write(stream->ssl, buf, (int)count);
+	if (ret > 0) {
+		stream->write_pending = false;
+		return ret;
+	}
+	ssize_t rc = ssl_iostream_status(io, ret, false, "SSL_write");
+	stream->write_pending = rc != IOSTREAM_ERROR;
+	return rc;
+}
+
+#if SSL_USE_KTLS
+/**
+ * Returns true if the kernel encrypts the output of the connection
+ * so that application data may be written to the socket directly.
+ */
+static inline bool
+ssl_iostream_ktls_send(struct ssl_iostream *stream)
+{
+	return !stream->write_pending && SSL_is_init_finished(stream->ssl) &&
+	       BIO_get_ktls_send(SSL_get_wbio(stream->ssl));
+}
+#endif
+
+static ssize_t
+ssl_iostream_writev(struct iostream *io, const struct iovec *iov, int iovcnt)
+{
+	assert(io->fd >= 0);
+#if SSL_USE_KTLS
+	struct ssl_iostream *stream = io->data;
+	if (ssl_iostream_ktls_send(stream)) {
+		/*
+		 * The kernel splits the data into TLS records, so write
+		 * all buffers with one system call and without copying
+		 * them to the SSL write buffer.
+		 */
+		ssize_t ret = sio_writev(io->fd, iov, iovcnt);
+		if (ret >= 0)
+			return ret;
+		if (sio_wouldblock(errno))
+			return IOSTREAM_WANT_WRITE;
+		return IOSTREAM_ERROR;
+	}
+#endif
+	/* SSL has no writev(), so write the buffers one by one. */
+	ssize_t total = 0;
+	for (int i = 0; i < iovcnt; i++) {
+		const char *data = iov[i].iov_base;
+		size_t len = iov[i].iov_len;
+		while (len > 0) {
+			ssize_t rc = ssl_iostream_write(io, data, len);
+			if (rc < 0)
+				return total > 0 && rc != IOSTREAM_ERROR ?
+				       total : rc;
+			total += rc;
+			data += rc;
+			len -= rc;
+		}
+	}
+	return total;
+}
+
+static const struct iostream_vtab ssl_iostream_vtab = {
+	/* .destroy = */ ssl_iostream_destroy,
+	/* .read = */ ssl_iostream_read,
+	/* .write = */ ssl_iostream_write,
+	/* .writev = */ ssl_iostream_writev,
+};
@@ -27,27 +27,32 @@ ssl_init(void);
 void
 ssl_free(void);
 
+/**
+ * Creates a context for SSL IO streams. The following URI parameters
+ * are supported:
+ *  - ssl_key_file: private key file (PEM), required for servers;
+ *  - ssl_cert_file: certificate chain file (PEM), required for servers;
+ *  - ssl_ca_file: trusted CA file (PEM); if set, the peer certificate
+ *    is required and verified, and a client checks that the server
+ *    certificate matches the URI host; if not set, the peer isn't
+ *    verified at all;
+ *  - ssl_ciphers: colon-separated list of TLSv1.2 ciphers.
+ * Returns NULL and sets diag on error.
+ */
 struct ssl_iostream_ctx *
 ssl_iostream_ctx_new(enum iostream_mode mode, const struct uri *uri);
 
-static inline void
-ssl_iostream_ctx_delete(struct ssl_iostream_ctx *ctx)
-{
-	(void)ctx;
-	unreachable();
-}
+void
+ssl_iostream_ctx_delete(struct ssl_iostream_ctx *ctx);
 
-static inline int
+/**
+ * Creates an SSL IO stream for the given fd. The TLS handshake isn't
+ * done here: it's performed by the first read or write, i.e. in the
+ * thread that does IO on the stream. Returns -1 and sets diag on error.
+ */
+int
 ssl_iostream_create(struct iostream *io, int fd, enum iostream_mode mode,
-		    const struct ssl_iostream_ctx *ctx)
-{
-	(void)io;
-	(void)fd;
-	(void)mode;
-	(void)ctx;
-	unreachable();
-	return 0;
-}
+		    const struct ssl_iostream_ctx *ctx);
 
 #if defined(__cplusplus)
 } /* extern "C" */
@@ -5,7 +5,11 @@
  */
 #include "ssl_error.h"
 
+#include <openssl/err.h>
+#include <stdarg.h>
 #include <stddef.h>
+#include <stdlib.h>
+#include <new>
 
 #include "reflection.h"
 #include "trivia/config.h"
@@ -15,3 +19,26 @@
 #endif
 
 const struct type_info type_SSLError = make_type("SSLError", NULL);
+
+struct error *
+BuildSSLError(const char *file, unsigned line, const char *format, ...)
+{
+	void *p = malloc(sizeof(SSLError));
+	if (p == NULL) {
+		return BuildOutOfMemory(file, line, sizeof(SSLError),
+					"malloc", "SSLError");
+	}
+	SSLError *e = new (p) SSLError(file, line);
+	va_list ap;
+	va_start(ap, format);
+	error_vformat_msg(e, format, ap);
+	va_end(ap);
+	unsigned long code = ERR_peek_last_error();
+	if (code != 0) {
+		char buf[256];
+		ERR_error_string_n(code, buf, sizeof(buf));
+		error_append_msg(e, ": %s", buf);
+	}
+	ERR_clear_error();
+	return e;
+}
@@ -22,11 +22,20 @@ extern "C" {
 
 extern const struct type_info type_SSLError;
 
+/**
+ * Builds an SSLError. The message is followed by the description of
+ * the last error in the OpenSSL error queue, and the queue is cleared.
+ */
+struct error *
+BuildSSLError(const char *file, unsigned line, const char *format, ...);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 
 class SSLError: public Exception {
 public:
+	SSLError(const char *file, unsigned line)
+		: Exception(&type_SSLError, file, line) {}
 	SSLError(): Exception(&type_SSLError, NULL, 0) {}
 	virtual void raise() { throw this; }
 };
@@ -0,0 +1,11 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2021, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "tt_compression.h"
+
+const char *compression_type_strs[] = {
+	"none",
+	"zstd",
+};
@@ -0,0 +1,1170 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2021, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "art.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trivia/util.h"
+
+enum art_node_type {
+	ART_NODE4,
+	ART_NODE16,
+	ART_NODE48,
+	ART_NODE256,
+};
+
+/**
+ * Number of compressed path bytes stored in a node. If a path
+ * is longer, the rest is read from the key of any value stored
+ * in the node's subtree (all of them share the path).
+ */
+enum { ART_PREFIX_MAX = 8 };
+
+/** Common header of all inner nodes. */
+struct art_node {
+	/** Node type, see enum art_node_type. */
+	uint8_t type;
+	/** Number of children. */
+	uint16_t child_count;
+	/** Length of the compressed path. */
+	uint32_t prefix_len;
+	/** First bytes of the compressed path. */
+	unsigned char prefix[ART_PREFIX_MAX];
+	/** Version of the tree at the time of creation, see art::version. */
+	uint32_t version;
+};
+
+/** Node with up to 4 children, keys are sorted. */
+struct art_node4 {
+	struct art_node base;
+	unsigned char keys[4];
+	void *children[4];
+};
+
+/** Node with up to 16 children, keys are sorted. */
+struct art_node16 {
+	struct art_node base;
+	unsigned char keys[16];
+	void *children[16];
+};
+
+/**
+ * Node with up to 48 children. A key byte is mapped to a child
+ * slot number plus one, zero means there's no child.
+ */
+struct art_node48 {
+	struct art_node base;
+	unsigned char index[256];
+	void *children[48];
+};
+
+/** Node with up to 256 children indexed by key byte. */
+struct art_node256 {
+	struct art_node base;
+	void *children[256];
+};
+
+static const size_t art_node_sizes[] = {
+	[ART_NODE4] = sizeof(struct art_node4),
+	[ART_NODE16] = sizeof(struct art_node16),
+	[ART_NODE48] = sizeof(struct art_node48),
+	[ART_NODE256] = sizeof(struct art_node256),
+};
+
+static_assert(lengthof(art_node_sizes) == ART_NODE_TYPE_COUNT,
+	      "ART_NODE_TYPE_COUNT must match the number of node types");
+
+size_t
+art_node_size(unsigned type)
+{
+	assert(type < ART_NODE_TYPE_COUNT);
+	return art_node_sizes[type];
+}
+
+static inline bool
+art_is_leaf(const void *ptr)
+{
+	return ((uintptr_t)ptr & 1) != 0;
+}
+
+static inline void *
+art_leaf_new(void *value)
+{
+	assert(((uintptr_t)value & 1) == 0);
+	return (void *)((uintptr_t)value | 1);
+}
+
+static inline void *
+art_leaf_value(const void *ptr)
+{
+	assert(art_is_leaf(ptr));
+	return (void *)((uintptr_t)ptr & ~(uintptr_t)1);
+}
+
+/**
+ * Compare the key of a value with the given key. A key that is
+ * a prefix of another key is less than it.
+ */
+static inline int
+art_value_compare(const struct art *tree, const void *value,
+		  const unsigned char *key, uint32_t len)
+{
+	uint32_t value_len;
+	const unsigned char *value_key = tree->key(value, &value_len);
+	int rc = memcmp(value_key, key, MIN(value_len, len));
+	if (rc != 0)
+		return rc;
+	return value_len < len ? -1 : value_len > len;
+}
+
+/**
+ * Compare the key of a value with the given key, considering
+ * the two equal if the former starts with the latter.
+ */
+static inline int
+art_value_compare_prefix(const struct art *tree, const void *value,
+			 const unsigned char *key, uint32_t len)
+{
+	uint32_t value_len;
+	const unsigned char *value_key = tree->key(value, &value_len);
+	int rc = memcmp(value_key, key, MIN(value_len, len));
+	if (rc != 0)
+		return rc;
+	return value_len < len ? -1 : 0;
+}
+
+static struct art_node *
+art_node_new(struct art *tree, enum art_node_type type)
+{
+	size_t size = art_node_sizes[type];
+	struct art_node *node = tree->alloc(tree->alloc_ctx, size);
+	if (node == NULL)
+		return NULL;
+	memset(node, 0, size);
+	node->type = type;
+	node->version = tree->version;
+	tree->mem_used += size;
+	return node;
+}
+
+/** Check if a node may be shared with a view and so can't be modified. */
+static inline bool
+art_node_is_frozen(const struct art *tree, const struct art_node *node)
+{
+	return tree->view_count > 0 && node->version != tree->version;
+}
+
+static void
+art_node_free(struct art *tree, struct art_node *node)
+{
+	size_t size = art_node_sizes[node->type];
+	assert(tree->mem_used >= size);
+	tree->mem_used -= size;
+	tree->free(tree->alloc_ctx, node, size);
+}
+
+/**
+ * Make sure a node shared with views can be deleted without
+ * allocating memory. Returns -1 on memory allocation error.
+ */
+static int
+art_reserve_garbage(struct art *tree)
+{
+	if (tree->garbage_count < tree->garbage_capacity)
+		return 0;
+	size_t capacity = MAX(tree->garbage_capacity * 2, 64);
+	void **garbage = realloc(tree->garbage, capacity * sizeof(*garbage));
+	if (garbage == NULL)
+		return -1;
+	tree->garbage = garbage;
+	tree->garbage_capacity = capacity;
+	return 0;
+}
+
+/**
+ * Delete a node that was removed from the tree. A node shared with
+ * views is freed only when the last view is closed. Such a node may
+ * only be deleted by art_node_make_mutable(), which reserves space
+ * for it in the garbage array.
+ */
+static void
+art_node_delete(struct art *tree, struct art_node *node)
+{
+	if (!art_node_is_frozen(tree, node)) {
+		art_node_free(tree, node);
+		return;
+	}
+	assert(tree->garbage_count < tree->garbage_capacity);
+	tree->garbage[tree->garbage_count++] = node;
+}
+
+/**
+ * Replace a node referenced by @a slot with a copy if it's shared
+ * with views so that it can be modified. The slot itself must be
+ * writable. Returns -1 on memory allocation error.
+ */
+static int
+art_node_make_mutable(struct art *tree, void **slot)
+{
+	struct art_node *node = *slot;
+	if (!art_node_is_frozen(tree, node))
+		return 0;
+	if (art_reserve_garbage(tree) != 0)
+		return -1;
+	size_t size = art_node_sizes[node->type];
+	struct art_node *copy = tree->alloc(tree->alloc_ctx, size);
+	if (copy == NULL)
+		return -1;
+	memcpy(copy, node, size);
+	copy->version = tree->version;
+	tree->mem_used += size;
+	art_node_delete(tree, node);
+	*slot = copy;
+	return 0;
+}
+
+/** Copy the header of @a src to @a dst, which is of another type. */
+static void
+art_node_copy_header(struct art_node *dst, const struct art_node *src)
+{
+	dst->child_count = src->child_count;
+	dst->prefix_len = src->prefix_len;
+	memcpy(dst->prefix, src->prefix, sizeof(dst->prefix));
+}
+
+static void
+art_node_set_prefix(struct art_node *node, const unsigned char *prefix,
+		    uint32_t len)
+{
+	node->prefix_len = len;
+	memcpy(node->prefix, prefix, MIN(len, (uint32_t)ART_PREFIX_MAX));
+}
+
+/**
+ * Return the child slot of a node for the given key byte or NULL
+ * if there's no such child.
+ */
+static void **
+art_node_find_child(struct art_node *node, unsigned char c)
+{
+	switch (node->type) {
+	case ART_NODE4: {
+		struct art_node4 *n = (struct art_node4 *)node;
+		for (int i = 0; i < node->child_count; i++) {
+			if (n->keys[i] == c)
+				return &n->children[i];
+		}
+		return NULL;
+	}
+	case ART_NODE16: {
+		struct art_node16 *n = (struct art_node16 *)node;
+		for (int i = 0; i < node->child_count; i++) {
+			if (n->keys[i] == c)
+				return &n->children[i];
+		}
+		return NULL;
+	}
+	case ART_NODE48: {
+		struct art_node48 *n = (struct art_node48 *)node;
+		int i = n->index[c];
+		return i != 0 ? &n->children[i - 1] : NULL;
+	}
+	case ART_NODE256: {
+		struct art_node256 *n = (struct art_node256 *)node;
+		return n->children[c] != NULL ? &n->children[c] : NULL;
+	}
+	default:
+		unreachable();
+		return NULL;
+	}
+}
+
+/**
+ * Return the child of a node with the least key byte greater
+ * than @a c, which may be -1, or NULL if there's no such child.
+ * The key byte of the child is returned in @a key.
+ */
+static void *
+art_node_next_child(const struct art_node *node, int c, int *key)
+{
+	switch (node->type) {
+	case ART_NODE4: {
+		const struct art_node4 *n = (const struct art_node4 *)node;
+		for (int i = 0; i < node->child_count; i++) {
+			if (n->keys[i] > c) {
+				*key = n->keys[i];
+				return n->children[i];
+			}
+		}
+		return NULL;
+	}
+	case ART_NODE16: {
+		const struct art_node16 *n = (const struct art_node16 *)node;
+		for (int i = 0; i < node->child_count; i++) {
+			if (n->keys[i] > c) {
+				*key = n->keys[i];
+				return n->children[i];
+			}
+		}
+		return NULL;
+	}
+	case ART_NODE48: {
+		const struct art_node48 *n = (const struct art_node48 *)node;
+		for (int i = c + 1; i < 256; i++) {
+			if (n->index[i] != 0) {
+				*key = i;
+				return n->children[n->index[i] - 1];
+			}
+		}
+		return NULL;
+	}
+	case ART_NODE256: {
+		const struct art_node256 *n = (const struct art_node256 *)node;
+		for (int i = c + 1; i < 256; i++) {
+			if (n->children[i] != NULL) {
+				*key = i;
+				return n->children[i];
+			}
+		}
+		return NULL;
+	}
+	default:
+		unreachable();
+		return NULL;
+	}
+}
+
+/**
+ * Return the child of a node with the greatest key byte less
+ * than @a c, which may be 256, or NULL if there's no such child.
+ */
+static void *
+art_node_prev_child(const struct art_node *node, int c)
+{
+	switch (node->type) {
+	case ART_NODE4: {
+		const struct art_node4 *n = (const struct art_node4 *)node;
+		for (int i = node->child_count - 1; i >= 0; i--) {
+			if (n->keys[i] < c)
+				return n->children[i];
+		}
+		return NULL;
+	}
+	case ART_NODE16: {
+		const struct art_node16 *n = (const struct art_node16 *)node;
+		for (int i = node->child_count - 1; i >= 0; i--) {
+			if (n->keys[i] < c)
+				return n->children[i];
+		}
+		return NULL;
+	}
+	case ART_NODE48: {
+		const struct art_node48 *n = (const struct art_node48 *)node;
+		for (int i = c - 1; i >= 0; i--) {
+			if (n->index[i] != 0)
+				return n->children[n->index[i] - 1];
+		}
+		return NULL;
+	}
+	case ART_NODE256: {
+		const struct art_node256 *n = (const struct art_node256 *)node;
+		for (int i = c - 1; i >= 0; i--) {
+			if (n->children[i] != NULL)
+				return n->children[i];
+		}
+		return NULL;
+	}
+	default:
+		unreachable();
+		return NULL;
+	}
+}
+
+/** Return the value with the least key in a subtree. */
+static void *
+art_subtree_first(const void *ptr)
+{
+	int c;
+	while (!art_is_leaf(ptr))
+		ptr = art_node_next_child((const struct art_node *)ptr, -1, &c);
+	return art_leaf_value(ptr);
+}
+
+/** Return the value with the greatest key in a subtree. */
+static void *
+art_subtree_last(const void *ptr)
+{
+	while (!art_is_leaf(ptr))
+		ptr = art_node_prev_child((const struct art_node *)ptr, 256);
+	return art_leaf_value(ptr);
+}
+
+/**
+ * Return the full compressed path of a node located at @a depth.
+ * If the path is too long to be stored in the node, it's taken
+ * from the key of a value stored in the subtree.
+ */
+static const unsigned char *
+art_node_prefix(const struct art *tree, const struct art_node *node,
+		uint32_t depth)
+{
+	if (node->prefix_len <= ART_PREFIX_MAX)
+		return node->prefix;
+	uint32_t len;
+	const unsigned char *key = tree->key(art_subtree_first(node), &len);
+	assert(len > depth + node->prefix_len);
+	return key + depth;
+}
+
+/**
+ * Add a child to a node that doesn't have a child with the same
+ * key byte. The node is replaced with a bigger one if it's full,
+ * so it's passed by the slot pointing to it. Returns -1 on
+ * memory allocation error, in which case the node is unchanged.
+ */
+static int
+art_node_add_child(struct art *tree, void **slot, unsigned char c,
+		   void *child)
+{
+	struct art_node *node = *slot;
+	switch (node->type) {
+	case ART_NODE4: {
+		struct art_node4 *n = (struct art_node4 *)node;
+		if (node->child_count < 4) {
+			int i = node->child_count;
+			for (; i > 0 && n->keys[i - 1] > c; i--) {
+				n->keys[i] = n->keys[i - 1];
+				n->children[i] = n->children[i - 1];
+			}
+			n->keys[i] = c;
+			n->children[i] = child;
+			node->child_count++;
+			return 0;
+		}
+		struct art_node16 *new_node = (struct art_node16 *)
+			art_node_new(tree, ART_NODE16);
+		if (new_node == NULL)
+			return -1;
+		art_node_copy_header(&new_node->base, node);
+		memcpy(new_node->keys, n->keys, sizeof(n->keys));
+		memcpy(new_node->children, n->children, sizeof(n->children));
+		art_node_delete(tree, node);
+		*slot = new_node;
+		return art_node_add_child(tree, slot, c, child);
+	}
+	case ART_NODE16: {
+		struct art_node16 *n = (struct art_node16 *)node;
+		if (node->child_count < 16) {
+			int i = node->child_count;
+			for (; i > 0 && n->keys[i - 1] > c; i--) {
+				n->keys[i] = n->keys[i - 1];
+				n->children[i] = n->children[i - 1];
+			}
+			n->keys[i] = c;
+			n->children[i] = child;
+			node->child_count++;
+			return 0;
+		}
+		struct art_node48 *new_node = (struct art_node48 *)
+			art_node_new(tree, ART_NODE48);
+		if (new_node == NULL)
+			return -1;
+		art_node_copy_header(&new_node->base, node);
+		for (int i = 0; i < 16; i++) {
+			new_node->index[n->keys[i]] = i + 1;
+			new_node->children[i] = n->children[i];
+		}
+		art_node_delete(tree, node);
+		*slot = new_node;
+		return art_node_add_child(tree, slot, c, child);
+	}
+	case ART_NODE48: {
+		struct art_node48 *n = (struct art_node48 *)node;
+		if (node->child_count < 48) {
+			int i = 0;
+			while (n->children[i] != NULL)
+				i++;
+			n->children[i] = child;
+			n->index[c] = i + 1;
+			node->child_count++;
+			return 0;
+		}
+		struct art_node256 *new_node = (struct art_node256 *)
+			art_node_new(tree, ART_NODE256);
+		if (new_node == NULL)
+			return -1;
+		art_node_copy_header(&new_node->base, node);
+		for (int i = 0; i < 256; i++) {
+			if (n->index[i] != 0)
+				new_node->children[i] = n->children[n->index[i] - 1];
+		}
+		art_node_delete(tree, node);
+		*slot = new_node;
+		return art_node_add_child(tree, slot, c, child);
+	}
+	case ART_NODE256: {
+		struct art_node256 *n = (struct art_node256 *)node;
+		assert(n->children[c] == NULL);
+		n->children[c] = child;
+		node->child_count++;
+		return 0;
+	}
+	default:
+		unreachable();
+		return -1;
+	}
+}
+
+/**
+ * Replace a node that has the only child with the child, merging
+ * their compressed paths.
+ */
+static void
+art_node_collapse(struct art *tree, void **slot)
+{
+	struct art_node *node = *slot;
+	assert(node->child_count == 1);
+	int c;
+	void *child = art_node_next_child(node, -1, &c);
+	if (!art_is_leaf(child)) {
+		/*
+		 * The child's path is extended so it must be writable.
+		 * If it can't be copied, leave the node as is: a node
+		 * with one child is valid, just suboptimal.
+		 */
+		void **child_slot = art_node_find_child(node, c);
+		if (art_node_make_mutable(tree, child_slot) != 0)
+			return;
+		child = *child_slot;
+		struct art_node *n = child;
+		unsigned char prefix[ART_PREFIX_MAX];
+		uint32_t len = MIN(node->prefix_len, (uint32_t)ART_PREFIX_MAX);
+		memcpy(prefix, node->prefix, len);
+		if (len < ART_PREFIX_MAX)
+			prefix[len++] = c;
+		if (len < ART_PREFIX_MAX) {
+			uint32_t child_len = MIN(n->prefix_len,
+						 ART_PREFIX_MAX - len);
+			memcpy(prefix + len, n->prefix, child_len);
+			len += child_len;
+		}
+		n->prefix_len += node->prefix_len + 1;
+		memcpy(n->prefix, prefix, len);
+	}
+	art_node_delete(tree, node);
+	*slot = child;
+}
+
+/**
+ * Replace a node with a smaller one if it has few children left.
+ * Failure to allocate the new node is ignored, because a node
+ * is valid regardless of the number of its children.
+ */
+static void
+art_node_shrink(struct art *tree, void **slot)
+{
+	struct art_node *node = *slot;
+	switch (node->type) {
+	case ART_NODE4:
+		return;
+	case ART_NODE16: {
+		if (node->child_count > 3)
+			return;
+		struct art_node16 *n = (struct art_node16 *)node;
+		struct art_node4 *new_node = (struct art_node4 *)
+			art_node_new(tree, ART_NODE4);
+		if (new_node == NULL)
+			return;
+		art_node_copy_header(&new_node->base, node);
+		memcpy(new_node->keys, n->keys, node->child_count);
+		memcpy(new_node->children, n->children,
+		       node->child_count * sizeof(n->children[0]));
+		art_node_delete(tree, node);
+		*slot = new_node;
+		return;
+	}
+	case ART_NODE48: {
+		if (node->child_count > 12)
+			return;
+		struct art_node48 *n = (struct art_node48 *)node;
+		struct art_node16 *new_node = (struct art_node16 *)
+			art_node_new(tree, ART_NODE16);
+		if (new_node == NULL)
+			return;
+		art_node_copy_header(&new_node->base, node);
+		int j = 0;
+		for (int i = 0; i < 256; i++) {
+			if (n->index[i] == 0)
+				continue;
+			new_node->keys[j] = i;
+			new_node->children[j] = n->children[n->index[i] - 1];
+			j++;
+		}
+		art_node_delete(tree, node);
+		*slot = new_node;
+		return;
+	}
+	case ART_NODE256: {
+		if (node->child_count > 37)
+			return;
+		struct art_node256 *n = (struct art_node256 *)node;
+		struct art_node48 *new_node = (struct art_node48 *)
+			art_node_new(tree, ART_NODE48);
+		if (new_node == NULL)
+			return;
+		art_node_copy_header(&new_node->base, node);
+		int j = 0;
+		for (int i = 0; i < 256; i++) {
+			if (n->children[i] == NULL)
+				continue;
+			new_node->index[i] = j + 1;
+			new_node->children[j] = n->children[i];
+			j++;
+		}
+		art_node_delete(tree, node);
+		*slot = new_node;
+		return;
+	}
+	default:
+		unreachable();
+	}
+}
+
+/**
+ * Remove the child stored in @a child_slot with key byte @a c
+ * from a node referenced by @a slot. If it was the last child,
+ * the node is deleted and the slot is cleared.
+ */
+static void
+art_node_remove_child(struct art *tree, void **slot, unsigned char c,
+		      void **child_slot)
+{
+	struct art_node *node = *slot;
+	switch (node->type) {
+	case ART_NODE4: {
+		struct art_node4 *n = (struct art_node4 *)node;
+		int i = child_slot - n->children;
+		memmove(n->keys + i, n->keys + i + 1,
+			node->child_count - i - 1);
+		memmove(n->children + i, n->children + i + 1,
+			(node->child_count - i - 1) * sizeof(n->children[0]));
+		break;
+	}
+	case ART_NODE16: {
+		struct art_node16 *n = (struct art_node16 *)node;
+		int i = child_slot - n->children;
+		memmove(n->keys + i, n->keys + i + 1,
+			node->child_count - i - 1);
+		memmove(n->children + i, n->children + i + 1,
+			(node->child_count - i - 1) * sizeof(n->children[0]));
+		break;
+	}
+	case ART_NODE48: {
+		struct art_node48 *n = (struct art_node48 *)node;
+		n->index[c] = 0;
+		*child_slot = NULL;
+		break;
+	}
+	case ART_NODE256: {
+		*child_slot = NULL;
+		break;
+	}
+	default:
+		unreachable();
+	}
+	node->child_count--;
+	if (node->child_count == 0) {
+		/* Possible only if the node failed to collapse. */
+		art_node_delete(tree, node);
+		*slot = NULL;
+	} else if (node->child_count == 1) {
+		art_node_collapse(tree, slot);
+	} else {
+		art_node_shrink(tree, slot);
+	}
+}
+
+void
+art_create(struct art *tree, art_key_f key, art_alloc_f alloc,
+	   art_free_f free, void *alloc_ctx)
+{
+	tree->root = NULL;
+	tree->size = 0;
+	tree->mem_used = 0;
+	tree->key = key;
+	tree->alloc = alloc;
+	tree->free = free;
+	tree->alloc_ctx = alloc_ctx;
+	tree->version = 0;
+	tree->view_count = 0;
+	tree->garbage = NULL;
+	tree->garbage_count = 0;
+	tree->garbage_capacity = 0;
+}
+
+static void
+art_subtree_destroy(struct art *tree, void *ptr)
+{
+	if (art_is_leaf(ptr))
+		return;
+	struct art_node *node = ptr;
+	int c = -1;
+	void *child;
+	while ((child = art_node_next_child(node, c, &c)) != NULL)
+		art_subtree_destroy(tree, child);
+	art_node_delete(tree, node);
+}
+
+void
+art_destroy(struct art *tree)
+{
+	assert(tree->view_count == 0);
+	assert(tree->garbage_count == 0);
+	free(tree->garbage);
+	tree->garbage = NULL;
+	tree->garbage_capacity = 0;
+	if (tree->root != NULL)
+		art_subtree_destroy(tree, tree->root);
+	tree->root = NULL;
+	tree->size = 0;
+}
+
+static int
+art_insert_impl(struct art *tree, void **slot, const unsigned char *key,
+		uint32_t len, uint32_t depth, void *value, void **replaced)
+{
+	void *ptr = *slot;
+	if (art_is_leaf(ptr)) {
+		void *old_value = art_leaf_value(ptr);
+		uint32_t old_len;
+		const unsigned char *old_key = tree->key(old_value, &old_len);
+		if (old_len == len && memcmp(old_key, key, len) == 0) {
+			*slot = art_leaf_new(value);
+			*replaced = old_value;
+			return 0;
+		}
+		/* Split the leaf. */
+		uint32_t i = depth;
+		uint32_t limit = MIN(len, old_len);
+		while (i < limit && key[i] == old_key[i])
+			i++;
+		/* Stored keys must be prefix-free. */
+		assert(i < limit);
+		struct art_node *node = art_node_new(tree, ART_NODE4);
+		if (node == NULL)
+			return -1;
+		art_node_set_prefix(node, key + depth, i - depth);
+		/* Adding to a new node never fails. */
+		void *new_slot = node;
+		art_node_add_child(tree, &new_slot, old_key[i], ptr);
+		art_node_add_child(tree, &new_slot, key[i],
+				   art_leaf_new(value));
+		*slot = node;
+		return 0;
+	}
+	if (art_node_make_mutable(tree, slot) != 0)
+		return -1;
+	struct art_node *node = *slot;
+	if (node->prefix_len > 0) {
+		const unsigned char *prefix = art_node_prefix(tree, node,
+							      depth);
+		uint32_t i = 0;
+		while (i < node->prefix_len && depth + i < len &&
+		       key[depth + i] == prefix[i])
+			i++;
+		if (i < node->prefix_len) {
+			/* Split the compressed path. */
+			assert(depth + i < len);
+			struct art_node *parent = art_node_new(tree, ART_NODE4);
+			if (parent == NULL)
+				return -1;
+			art_node_set_prefix(parent, key + depth, i);
+			unsigned char c = prefix[i];
+			uint32_t rest = node->prefix_len - i - 1;
+			memmove(node->prefix, prefix + i + 1,
+				MIN(rest, (uint32_t)ART_PREFIX_MAX));
+			node->prefix_len = rest;
+			void *new_slot = parent;
+			art_node_add_child(tree, &new_slot, c, node);
+			art_node_add_child(tree, &new_slot, key[depth + i],
+					   art_leaf_new(value));
+			*slot = parent;
+			return 0;
+		}
+		depth += node->prefix_len;
+	}
+	assert(depth < len);
+	void **child = art_node_find_child(node, key[depth]);
+	if (child != NULL) {
+		return art_insert_impl(tree, child, key, len, depth + 1,
+				       value, replaced);
+	}
+	return art_node_add_child(tree, slot, key[depth], art_leaf_new(value));
+}
+
+int
+art_insert(struct art *tree, void *value, void **replaced)
+{
+	*replaced = NULL;
+	if (tree->root == NULL) {
+		tree->root = art_leaf_new(value);
+		tree->size++;
+		return 0;
+	}
+	uint32_t len;
+	const unsigned char *key = tree->key(value, &len);
+	if (art_insert_impl(tree, &tree->root, key, len, 0,
+			    value, replaced) != 0)
+		return -1;
+	if (*replaced == NULL)
+		tree->size++;
+	return 0;
+}
+
+/**
+ * Check the compressed path of a node against a key, starting at
+ * @a depth. Only bytes stored in the node are compared so the key
+ * of the found value must be checked in the end.
+ */
+static inline bool
+art_node_prefix_matches(const struct art_node *node, const unsigned char *key,
+			uint32_t len, uint32_t depth)
+{
+	if (depth + node->prefix_len >= len)
+		return false;
+	return memcmp(node->prefix, key + depth,
+		      MIN(node->prefix_len, (uint32_t)ART_PREFIX_MAX)) == 0;
+}
+
+/**
+ * Delete the value with the given key from a subtree referenced by
+ * @a slot located at @a depth. Returns the deleted value or NULL.
+ */
+static void *
+art_delete_impl(struct art *tree, void **slot, const unsigned char *key,
+		uint32_t len, uint32_t depth)
+{
+	struct art_node *node = *slot;
+	assert(!art_is_leaf(node));
+	if (!art_node_prefix_matches(node, key, len, depth))
+		return NULL;
+	depth += node->prefix_len;
+	void **child = art_node_find_child(node, key[depth]);
+	if (child == NULL)
+		return NULL;
+	/* See art_prepare_delete(). */
+	assert(!art_node_is_frozen(tree, node));
+	void *value;
+	if (art_is_leaf(*child)) {
+		value = art_leaf_value(*child);
+		if (art_value_compare(tree, value, key, len) != 0)
+			return NULL;
+	} else {
+		value = art_delete_impl(tree, child, key, len, depth + 1);
+		/* Remove the child unless it's still not empty. */
+		if (value == NULL || *child != NULL)
+			return value;
+	}
+	art_node_remove_child(tree, slot, key[depth], child);
+	return value;
+}
+
+void *
+art_delete(struct art *tree, const unsigned char *key, uint32_t len)
+{
+	void *value;
+	if (tree->root == NULL)
+		return NULL;
+	if (art_is_leaf(tree->root)) {
+		value = art_leaf_value(tree->root);
+		if (art_value_compare(tree, value, key, len) != 0)
+			return NULL;
+		tree->root = NULL;
+	} else {
+		value = art_delete_impl(tree, &tree->root, key, len, 0);
+		if (value == NULL)
+			return NULL;
+	}
+	tree->size--;
+	return value;
+}
+
+/**
+ * Make the nodes on the path to the value with the given key in
+ * a subtree referenced by @a slot located at @a depth writable,
+ * see art_prepare_delete(). Sets @a is_emptied if the subtree is
+ * going to become empty after the value is deleted.
+ */
+static int
+art_prepare_delete_impl(struct art *tree, void **slot,
+			const unsigned char *key, uint32_t len,
+			uint32_t depth, bool *is_emptied)
+{
+	*is_emptied = false;
+	struct art_node *node = *slot;
+	assert(!art_is_leaf(node));
+	if (!art_node_prefix_matches(node, key, len, depth))
+		return 0;
+	depth += node->prefix_len;
+	if (art_node_find_child(node, key[depth]) == NULL)
+		return 0;
+	if (art_node_make_mutable(tree, slot) != 0)
+		return -1;
+	node = *slot;
+	void **child = art_node_find_child(node, key[depth]);
+	if (art_is_leaf(*child)) {
+		if (art_value_compare(tree, art_leaf_value(*child),
+				      key, len) != 0)
+			return 0;
+	} else {
+		bool is_child_emptied;
+		if (art_prepare_delete_impl(tree, child, key, len, depth + 1,
+					    &is_child_emptied) != 0)
+			return -1;
+		if (!is_child_emptied)
+			return 0;
+	}
+	if (node->child_count == 1) {
+		*is_emptied = true;
+		return 0;
+	}
+	if (node->child_count == 2) {
+		/* The node will be collapsed into the other child. */
+		int c = -1;
+		do {
+			art_node_next_child(node, c, &c);
+		} while (c == key[depth]);
+		void **other = art_node_find_child(node, c);
+		assert(other != NULL);
+		if (!art_is_leaf(*other))
+			return art_node_make_mutable(tree, other);
+	}
+	return 0;
+}
+
+int
+art_prepare_delete(struct art *tree, const unsigned char *key, uint32_t len)
+{
+	if (tree->view_count == 0 || tree->root == NULL ||
+	    art_is_leaf(tree->root))
+		return 0;
+	bool is_emptied;
+	return art_prepare_delete_impl(tree, &tree->root, key, len, 0,
+				       &is_emptied);
+}
+
+void *
+art_find(const struct art *tree, const unsigned char *key, uint32_t len)
+{
+	const void *ptr = tree->root;
+	uint32_t depth = 0;
+	if (ptr == NULL)
+		return NULL;
+	while (!art_is_leaf(ptr)) {
+		struct art_node *node = (struct art_node *)ptr;
+		if (!art_node_prefix_matches(node, key, len, depth))
+			return NULL;
+		depth += node->prefix_len;
+		void **child = art_node_find_child(node, key[depth]);
+		if (child == NULL)
+			return NULL;
+		ptr = *child;
+		depth++;
+	}
+	void *value = art_leaf_value(ptr);
+	return art_value_compare(tree, value, key, len) == 0 ? value : NULL;
+}
+
+void *
+art_first(const struct art *tree)
+{
+	return tree->root != NULL ? art_subtree_first(tree->root) : NULL;
+}
+
+void *
+art_last(const struct art *tree)
+{
+	return tree->root != NULL ? art_subtree_last(tree->root) : NULL;
+}
+
+static int
+art_subtree_foreach(const void *ptr, art_visit_f visit, void *arg)
+{
+	if (art_is_leaf(ptr))
+		return visit(art_leaf_value(ptr), arg);
+	const struct art_node *node = (const struct art_node *)ptr;
+	int c = -1;
+	const void *child;
+	while ((child = art_node_next_child(node, c, &c)) != NULL) {
+		int rc = art_subtree_foreach(child, visit, arg);
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
+}
+
+int
+art_foreach(const struct art *tree, art_visit_f visit, void *arg)
+{
+	if (tree->root == NULL)
+		return 0;
+	return art_subtree_foreach(tree->root, visit, arg);
+}
+
+void *
+art_random(const struct art *tree, uint32_t rnd)
+{
+	const void *ptr = tree->root;
+	if (ptr == NULL)
+		return NULL;
+	while (!art_is_leaf(ptr)) {
+		const struct art_node *node = (const struct art_node *)ptr;
+		uint32_t n = rnd % node->child_count;
+		rnd = rnd / node->child_count + rnd * 2654435761u;
+		int c = -1;
+		ptr = art_node_next_child(node, c, &c);
+		while (n-- > 0)
+			ptr = art_node_next_child(node, c, &c);
+	}
+	return art_leaf_value(ptr);
+}
+
+static void *
+art_succ_impl(const struct art *tree, const void *ptr,
+	      const unsigned char *key, uint32_t len, uint32_t depth,
+	      bool inclusive)
+{
+	if (art_is_leaf(ptr)) {
+		void *value = art_leaf_value(ptr);
+		int rc = art_value_compare_prefix(tree, value, key, len);
+		return rc > 0 || (rc == 0 && inclusive) ? value : NULL;
+	}
+	struct art_node *node = (struct art_node *)ptr;
+	if (node->prefix_len > 0) {
+		const unsigned char *prefix = art_node_prefix(tree, node,
+							      depth);
+		for (uint32_t i = 0; i < node->prefix_len; i++) {
+			/* All keys in the subtree start with the key. */
+			if (depth + i == len)
+				return inclusive ? art_subtree_first(node) : NULL;
+			if (prefix[i] != key[depth + i]) {
+				return prefix[i] > key[depth + i] ?
+				       art_subtree_first(node) : NULL;
+			}
+		}
+		depth += node->prefix_len;
+	}
+	if (depth == len)
+		return inclusive ? art_subtree_first(node) : NULL;
+	unsigned char c = key[depth];
+	void **child = art_node_find_child(node, c);
+	if (child != NULL) {
+		void *value = art_succ_impl(tree, *child, key, len,
+					    depth + 1, inclusive);
+		if (value != NULL)
+			return value;
+	}
+	int next_c;
+	void *next = art_node_next_child(node, c, &next_c);
+	return next != NULL ? art_subtree_first(next) : NULL;
+}
+
+void *
+art_succ(const struct art *tree, const unsigned char *key, uint32_t len,
+	 bool inclusive)
+{
+	if (tree->root == NULL)
+		return NULL;
+	return art_succ_impl(tree, tree->root, key, len, 0, inclusive);
+}
+
+static void *
+art_pred_impl(const struct art *tree, const void *ptr,
+	      const unsigned char *key, uint32_t len, uint32_t depth,
+	      bool inclusive)
+{
+	if (art_is_leaf(ptr)) {
+		void *value = art_leaf_value(ptr);
+		int rc = art_value_compare_prefix(tree, value, key, len);
+		return rc < 0 || (rc == 0 && inclusive) ? value : NULL;
+	}
+	struct art_node *node = (struct art_node *)ptr;
+	if (node->prefix_len > 0) {
+		const unsigned char *prefix = art_node_prefix(tree, node,
+							      depth);
+		for (uint32_t i = 0; i < node->prefix_len; i++) {
+			/* All keys in the subtree start with the key. */
+			if (depth + i == len)
+				return inclusive ? art_subtree_last(node) : NULL;
+			if (prefix[i] != key[depth + i]) {
+				return prefix[i] < key[depth + i] ?
+				       art_subtree_last(node) : NULL;
+			}
+		}
+		depth += node->prefix_len;
+	}
+	if (depth == len)
+		return inclusive ? art_subtree_last(node) : NULL;
+	unsigned char c = key[depth];
+	void **child = art_node_find_child(node, c);
+	if (child != NULL) {
+		void *value = art_pred_impl(tree, *child, key, len,
+					    depth + 1, inclusive);
+		if (value != NULL)
+			return value;
+	}
+	void *prev = art_node_prev_child(node, c);
+	return prev != NULL ? art_subtree_last(prev) : NULL;
+}
+
+void *
+art_pred(const struct art *tree, const unsigned char *key, uint32_t len,
+	 bool inclusive)
+{
+	if (tree->root == NULL)
+		return NULL;
+	return art_pred_impl(tree, tree->root, key, len, 0, inclusive);
+}
+
+void
+art_view_create(struct art *tree, struct art_view *view)
+{
+	view->root = tree->root;
+	view->size = tree->size;
+	/* All existing nodes are shared with the view now. */
+	tree->version++;
+	tree->view_count++;
+}
+
+void
+art_view_destroy(struct art *tree, struct art_view *view)
+{
+	(void)view;
+	assert(tree->view_count > 0);
+	if (--tree->view_count > 0)
+		return;
+	for (size_t i = 0; i < tree->garbage_count; i++)
+		art_node_free(tree, tree->garbage[i]);
+	tree->garbage_count = 0;
+}
+
+void *
+art_view_first(const struct art *tree, const struct art_view *view)
+{
+	(void)tree;
+	return view->root != NULL ? art_subtree_first(view->root) : NULL;
+}
+
+void *
+art_view_succ(const struct art *tree, const struct art_view *view,
+	      const unsigned char *key, uint32_t len)
+{
+	if (view->root == NULL)
+		return NULL;
+	return art_succ_impl(tree, view->root, key, len, 0, false);
+}
@@ -0,0 +1,245 @@
+#pragma once
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2021, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Adaptive radix tree, see "The Adaptive Radix Tree: ARTful
+ * Indexing for Main-Memory Databases" by V. Leis et al.
+ *
+ * The tree stores opaque values. Each value has a binary key,
+ * which is returned by a user callback. Values are ordered by
+ * their keys compared lexicographically, with a key that is a
+ * prefix of another key being less than it. The set of keys
+ * stored in a tree must be prefix-free, i.e. no key may be
+ * a proper prefix of another key. Keys used for lookups don't
+ * have this limitation.
+ *
+ * Inner nodes come in four sizes (4, 16, 48, and 256 children)
+ * and use path compression. Leaves are not allocated: a value
+ * pointer is stored in its parent node directly, tagged with
+ * the lowest bit, so values must be at least 2-byte aligned.
+ *
+ * A tree may be frozen in a view, see art_view_create(). Nodes
+ * shared with views are copied on write, so a view can be read
+ * from another thread while the tree is being modified.
+ */
+
+/** Return the key of a value stored in a tree. */
+typedef const unsigned char *
+(*art_key_f)(const void *value, uint32_t *len);
+
+/** Allocate a tree node of @a size bytes. */
+typedef void *
+(*art_alloc_f)(void *ctx, size_t size);
+
+/** Free a tree node of @a size bytes. */
+typedef void
+(*art_free_f)(void *ctx, void *ptr, size_t size);
+
+/** Number of distinct node types. */
+enum { ART_NODE_TYPE_COUNT = 4 };
+
+/**
+ * Return the size of a node of the given type, which is less
+ * than ART_NODE_TYPE_COUNT. The tree never allocates nodes of
+ * other sizes so this can be used to set up allocators.
+ */
+size_t
+art_node_size(unsigned type);
+
+struct art {
+	/** Root node or a tagged value or NULL if the tree is empty. */
+	void *root;
+	/** Number of values stored in the tree. */
+	size_t size;
+	/** Memory used by tree nodes, in bytes. */
+	size_t mem_used;
+	/** Value key getter. */
+	art_key_f key;
+	/** Node allocator. */
+	art_alloc_f alloc;
+	art_free_f free;
+	void *alloc_ctx;
+	/**
+	 * Version of the tree, incremented on each view creation.
+	 * A node created before the last view has a lesser version.
+	 * While there are open views, such nodes are copied on write.
+	 */
+	uint32_t version;
+	/** Number of open views. */
+	uint32_t view_count;
+	/**
+	 * Nodes deleted from the tree while there were open views.
+	 * They are freed when the last view is closed.
+	 */
+	void **garbage;
+	/** Number of nodes in the garbage array. */
+	size_t garbage_count;
+	/** Capacity of the garbage array. */
+	size_t garbage_capacity;
+};
+
+/** Frozen state of a tree, see art_view_create(). */
+struct art_view {
+	/** Root of the tree at the time of the view creation. */
+	void *root;
+	/** Number of values in the view. */
+	size_t size;
+};
+
+/** Create an empty tree. */
+void
+art_create(struct art *tree, art_key_f key, art_alloc_f alloc,
+	   art_free_f free, void *alloc_ctx);
+
+/** Free all tree nodes. Values aren't touched. */
+void
+art_destroy(struct art *tree);
+
+/** Return the number of values stored in a tree. */
+static inline size_t
+art_size(const struct art *tree)
+{
+	return tree->size;
+}
+
+/** Return the memory used by tree nodes. */
+static inline size_t
+art_mem_used(const struct art *tree)
+{
+	return tree->mem_used;
+}
+
+/**
+ * Insert a value into a tree. If there's a value with the same
+ * key, it's replaced and returned in @a replaced, otherwise
+ * @a replaced is set to NULL. Returns -1 if failed to allocate
+ * a node, in which case the tree is left unchanged.
+ */
+int
+art_insert(struct art *tree, void *value, void **replaced);
+
+/**
+ * Delete the value with the given key from a tree and return
+ * it. Returns NULL if there's no such value. Never fails.
+ *
+ * If the tree has open views, the nodes on the path to the value
+ * must be made writable with art_prepare_delete() first, unless
+ * the value was inserted after the last view had been created.
+ */
+void *
+art_delete(struct art *tree, const unsigned char *key, uint32_t len);
+
+/**
+ * Copy the nodes on the path to the value with the given key that
+ * are shared with views so that the value can be deleted without
+ * allocating memory. Returns -1 on memory allocation error, in
+ * which case the tree is left unchanged.
+ */
+int
+art_prepare_delete(struct art *tree, const unsigned char *key, uint32_t len);
+
+/** Find the value with the given key. Returns NULL if not found. */
+void *
+art_find(const struct art *tree, const unsigned char *key, uint32_t len);
+
+/** Return the value with the least key or NULL if the tree is empty. */
+void *
+art_first(const struct art *tree);
+
+/** Return the value with the greatest key or NULL if the tree is empty. */
+void *
+art_last(const struct art *tree);
+
+/** Callback for art_foreach(). Returns non-zero to stop. */
+typedef int
+(*art_visit_f)(void *value, void *arg);
+
+/**
+ * Call @a visit for each value stored in a tree in the key order.
+ * Stops and returns the callback's return value if it's not zero.
+ * The tree must not be modified while it's being iterated.
+ */
+int
+art_foreach(const struct art *tree, art_visit_f visit, void *arg);
+
+/**
+ * Return a value chosen by a random number @a rnd or NULL if
+ * the tree is empty. The value is looked up by descending from
+ * the root, picking a child by @a rnd at each level, so the
+ * distribution isn't uniform.
+ */
+void *
+art_random(const struct art *tree, uint32_t rnd);
+
+/**
+ * Return the value with the least key that is greater than
+ * (or equal to, if @a inclusive is set) the given key. Returns
+ * NULL if there's no such value.
+ *
+ * Here and in art_pred() a key is considered equal to the given
+ * key if it starts with it. Since stored keys are prefix-free,
+ * this makes no difference for full keys, but allows to use
+ * a prefix as a partial key.
+ */
+void *
+art_succ(const struct art *tree, const unsigned char *key, uint32_t len,
+	 bool inclusive);
+
+/**
+ * Return the value with the greatest key that is less than
+ * (or equal to, if @a inclusive is set) the given key. Returns
+ * NULL if there's no such value.
+ */
+void *
+art_pred(const struct art *tree, const unsigned char *key, uint32_t len,
+	 bool inclusive);
+
+/**
+ * Freeze the current state of a tree in a view. The view isn't
+ * affected by further modifications of the tree and may be read
+ * from another thread until it's destroyed. Values deleted from
+ * the tree must not be freed while there are open views.
+ */
+void
+art_view_create(struct art *tree, struct art_view *view);
+
+/**
+ * Destroy a view. If it's the last open view of the tree, nodes
+ * replaced since the first view creation are freed.
+ */
+void
+art_view_destroy(struct art *tree, struct art_view *view);
+
+/** Return the number of open views of a tree. */
+static inline uint32_t
+art_view_count(const struct art *tree)
+{
+	return tree->view_count;
+}
+
+/** Return the value with the least key in a view or NULL. */
+void *
+art_view_first(const struct art *tree, const struct art_view *view);
+
+/**
+ * Return the value with the least key that is greater than the
+ * given key in a view or NULL, see art_succ().
+ */
+void *
+art_view_succ(const struct art *tree, const struct art_view *view,
+	      const unsigned char *key, uint32_t len);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
@@ -170,6 +170,23 @@ struct LIGHT(iterator) {
 	struct matras_view view;
 };
 
+/**
+ * Read view of a hash table. Unlike a frozen iterator, it may be
+ * used for key lookups while the hash table is being modified.
+ * Lookups in a read view only read memory that is not changed
+ * after the view creation so they may be done from a thread other
+ * than the one that owns the hash table (provided the view is
+ * created and destroyed by the owner).
+ */
+struct LIGHT(view) {
+	/* count of values in the hash table at the view creation */
+	uint32_t count;
+	/* cover mask of the hash table at the view creation */
+	uint32_t cover_mask;
+	/* Version of matras memory for MVCC */
+	struct matras_view mtable_view;
+};
+
 /**
  * Type of functions for memory allocation and deallocation
  */
@@ -334,6 +351,38 @@ LIGHT(iterator_freeze)(struct LIGHT(core) *ht, struct LIGHT(iterator) *itr);
 static inline void
 LIGHT(iterator_destroy)(struct LIGHT(core) *ht, struct LIGHT(iterator) *itr);
 
+/**
+ * @brief Create a read view of the hash table. All following hash table
+ * modifications will not be visible in the view. The view must be
+ * destroyed with a light_view_destroy call after usage.
+ * @param ht - pointer to a hash table struct
+ * @param view - view to create
+ */
+static inline void
+LIGHT(view_create)(struct LIGHT(core) *ht, struct LIGHT(view) *view);
+
+/**
+ * @brief Destroy a read view.
+ * @param ht - pointer to a hash table struct
+ * @param view - view to destroy
+ */
+static inline void
+LIGHT(view_destroy)(struct LIGHT(core) *ht, struct LIGHT(view) *view);
+
+/**
+ * @brief Find a record with given hash and key in a read view
+ * @param ht - pointer to a hash table struct
+ * @param view - read view to look up in
+ * @param hash - hash to find
+ * @param key - key to find
+ * @param arg - parameter for data comparison, used instead of ht->arg
+ * @return pointer to the found value or NULL if nothing found
+ */
+static inline LIGHT_DATA_TYPE *
+LIGHT(view_find_key)(const struct LIGHT(core) *ht,
+		     const struct LIGHT(view) *view, uint32_t hash,
+		     LIGHT_KEY_TYPE key, LIGHT_CMP_ARG_TYPE arg);
+
 /* Functions definition */
 
 /**
@@ -377,15 +426,19 @@ LIGHT(destroy)(struct LIGHT(core) *ht)
  * given hash should be placed.
  */
 static inline uint32_t
-LIGHT(slot)(const struct LIGHT(core) *ht, uint32_t hash)
+LIGHT(slot_impl)(uint32_t cover_mask, uint32_t table_size, uint32_t hash)
 {
-	uint32_t cover_mask = ht->cover_mask;
 	uint32_t res = hash & cover_mask;
-	uint32_t probe = (ht->table_size - res - 1) >> 31;
+	uint32_t probe = (table_size - res - 1) >> 31;
 	uint32_t shift = __builtin_ctz(~(cover_mask >> 1));
 	res ^= (probe << shift);
 	return res;
+}
 
+static inline uint32_t
+LIGHT(slot)(const struct LIGHT(core) *ht, uint32_t hash)
+{
+	return LIGHT(slot_impl)(ht->cover_mask, ht->table_size, hash);
 }
 
 /**
@@ -1056,6 +1109,68 @@ LIGHT(iterator_destroy)(struct LIGHT(core) *ht, struct LIGHT(iterator) *itr)
 	matras_destroy_read_view(&ht->mtable, &itr->view);
 }
 
+/**
+ * @brief Create a read view of the hash table.
+ * @param ht - pointer to a hash table struct
+ * @param view - view to create
+ */
+static inline void
+LIGHT(view_create)(struct LIGHT(core) *ht, struct LIGHT(view) *view)
+{
+	view->count = ht->count;
+	view->cover_mask = ht->cover_mask;
+	matras_create_read_view(&ht->mtable, &view->mtable_view);
+}
+
+/**
+ * @brief Destroy a read view.
+ * @param ht - pointer to a hash table struct
+ * @param view - view to destroy
+ */
+static inline void
+LIGHT(view_destroy)(struct LIGHT(core) *ht, struct LIGHT(view) *view)
+{
+	matras_destroy_read_view(&ht->mtable, &view->mtable_view);
+}
+
+/**
+ * @brief Find a record with given hash and key in a read view
+ * @param ht - pointer to a hash table struct
+ * @param view - read view to look up in
+ * @param hash - hash to find
+ * @param key - key to find
+ * @param arg - parameter for data comparison, used instead of ht->arg
+ * @return pointer to the found value or NULL if nothing found
+ */
+static inline LIGHT_DATA_TYPE *
+LIGHT(view_find_key)(const struct LIGHT(core) *ht,
+		     const struct LIGHT(view) *view, uint32_t hash,
+		     LIGHT_KEY_TYPE key, LIGHT_CMP_ARG_TYPE arg)
+{
+	(void)arg;
+	if (view->count == 0)
+		return NULL;
+	const struct matras_view *mview = &view->mtable_view;
+	uint32_t slot = LIGHT(slot_impl)(view->cover_mask,
+					 mview->block_count, hash);
+	struct LIGHT(record) *record = (struct LIGHT(record) *)
+		matras_view_get(&ht->mtable, mview, slot);
+	if (record->next == slot)
+		return NULL;
+	while (1) {
+		if (record->hash == hash &&
+		    LIGHT_EQUAL_KEY((record->value), (key), (arg)))
+			return &record->value;
+		slot = record->next;
+		if (slot == LIGHT(end))
+			return NULL;
+		record = (struct LIGHT(record) *)
+			matras_view_get(&ht->mtable, mview, slot);
+	}
+	/* unreachable */
+	return NULL;
+}
+
 /*
  * Selfcheck of the internal state of hash table. Used only for debugging.
  * That means that you should not use this function.
@@ -0,0 +1,163 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+
+local g = t.group('index_aggregate', t.helpers.matrix({
+    engine = {'memtx', 'vinyl'},
+}))
+
+g.before_all(function(cg)
+    cg.server = server:new({alias = 'master'})
+    cg.server:start()
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.before_each(function(cg)
+    cg.server:exec(function(engine)
+        local s = box.schema.space.create('test', {
+            engine = engine,
+            format = {
+                {'id', 'unsigned'},
+                {'grp', 'unsigned'},
+                {'val', 'number', is_nullable = true},
+                {'str', 'string', is_nullable = true},
+            },
+        })
+        s:create_index('pk')
+        s:create_index('grp', {parts = {'grp'}, unique = false})
+    end, {cg.params.engine})
+end)
+
+g.after_each(function(cg)
+    cg.server:exec(function()
+        box.space.test:drop()
+    end)
+end)
+
+g.test_invalid = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        s:insert({1, 1, 1, 'a'})
+        t.assert_error_msg_content_equals(
+            "Illegal parameters, field should be a positive number or " ..
+            "a string",
+            s.aggregate, s, 0)
+        t.assert_error_msg_content_equals(
+            "Field 'foo' was not found in space 'test' format",
+            s.aggregate, s, 'foo')
+        t.assert_error_msg_content_equals(
+            "Tuple field 4 type does not match one required by " ..
+            "operation: expected number, got string",
+            s.aggregate, s, 'str')
+        t.assert_error_msg_content_equals(
+            "Unknown iterator type 'foo'",
+            s.aggregate, s, 'val', nil, {iterator = 'foo'})
+    end)
+end
+
+g.test_aggregate = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        t.assert_equals(s:aggregate('val'), {count = 0})
+        box.begin()
+        for i = 1, 1000 do
+            s:insert({i, i % 10, i % 7 == 0 and box.NULL or i - 500})
+        end
+        box.commit()
+        s:insert({1001, 0})
+        -- Compute the expected result in Lua.
+        local function expected(index, key, opts)
+            local res = {count = 0}
+            for _, tuple in index:pairs(key, opts) do
+                local v = tuple.val
+                if v ~= nil then
+                    res.count = res.count + 1
+                    res.sum = (res.sum or 0) + v
+                    res.min = math.min(res.min or v, v)
+                    res.max = math.max(res.max or v, v)
+                end
+            end
+            return res
+        end
+        t.assert_equals(s:aggregate('val'), expected(s.index.pk))
+        t.assert_equals(s:aggregate(3), expected(s.index.pk))
+        t.assert_equals(s:aggregate('val').count, 858)
+        t.assert_equals(s:aggregate('id'),
+                        {count = 1001, sum = 501501, min = 1, max = 1001})
+        for grp = 0, 9 do
+            t.assert_equals(s.index.grp:aggregate('val', grp),
+                            expected(s.index.grp, grp))
+        end
+        t.assert_equals(s:aggregate('val', 600, {iterator = 'ge'}),
+                        expected(s.index.pk, 600, {iterator = 'ge'}))
+        t.assert_equals(s:aggregate('val', {10}, {iterator = 'lt'}),
+                        {count = 8, sum = -3962, min = -499, max = -491})
+    end)
+end
+
+g.test_types = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        s:insert({1, 0, 18446744073709551615ULL})
+        s:insert({2, 0, 10})
+        local res = s:aggregate('val')
+        t.assert_almost_equals(res.sum, 2 ^ 64, 2 ^ 12)
+        t.assert_equals(res.min, 10)
+        t.assert_equals(res.max, 18446744073709551615ULL)
+        s:replace({2, 0, -10})
+        res = s:aggregate('val')
+        t.assert_equals(res.sum, 18446744073709551605ULL)
+        t.assert_equals(res.min, -10)
+        s:replace({1, 0, 2.5})
+        s:insert({3, 1, -9223372036854775807LL})
+        s:insert({4, 1, -9223372036854775807LL})
+        res = s:aggregate('val')
+        t.assert_equals(res.count, 4)
+        t.assert_almost_equals(res.sum, -2 ^ 64, 2 ^ 12)
+        t.assert_equals(res.min, -9223372036854775807LL)
+        t.assert_equals(res.max, 2.5)
+    end)
+end
+
+g.test_mp_int = function(cg)
+    cg.server:exec(function()
+        local ffi = require('ffi')
+        local t = require('luatest')
+        pcall(ffi.cdef, [[
+            int
+            box_insert(uint32_t space_id, const char *tuple,
+                       const char *tuple_end, box_tuple_t **result);
+        ]])
+        local s = box.space.test
+        -- Insert tuple {id, 0, val} with val encoded as MP_INT (0xd3).
+        local function insert_mp_int(id, val)
+            local data = '\x93' .. string.char(id) .. '\0\xd3\0\0\0\0\0\0' ..
+                         string.char(bit.band(bit.rshift(val, 8), 0xff),
+                                     bit.band(val, 0xff))
+            local p = ffi.cast('const char *', data)
+            t.assert_equals(ffi.C.box_insert(s.id, p, p + #data, nil), 0)
+        end
+        s:insert({1, 0, 5})
+        insert_mp_int(2, 1000)
+        insert_mp_int(3, 1)
+        s:insert({4, 0, 7})
+        t.assert_equals(s:aggregate('val'),
+                        {count = 4, sum = 1013, min = 1, max = 1000})
+    end)
+end
+
+g.test_stat = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        s:insert({1, 0, 1})
+        local select_count = box.stat().SELECT.total
+        t.assert_equals(s:aggregate('val').count, 1)
+        t.assert_equals(box.stat().SELECT.total, select_count)
+    end)
+end
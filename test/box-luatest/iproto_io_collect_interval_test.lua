@@ -0,0 +1,87 @@
+local clock = require('clock')
+local net = require('net.box')
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({
+        alias = 'master',
+        box_cfg = {iproto_threads = 2},
+    })
+    g.server:start()
+    g.server:exec(function()
+        local s = box.schema.space.create('test', {iproto_read = true})
+        s:create_index('pk', {type = 'hash'})
+        s:insert({1})
+        box.schema.user.grant('guest', 'read', 'space', 'test')
+    end)
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+local function selects_in_net()
+    return g.server:exec(function()
+        return box.stat.net().SELECTS_IN_NET.total
+    end)
+end
+
+-- Lookups in a space with the iproto_read option are served in the
+-- iproto thread without a round trip to tx, so they can only be
+-- slowed down by the iproto thread sleeping between polls.
+g.test_reconfigure = function()
+    local INTERVAL = 0.1
+    local COUNT = 10
+    local conn = net.connect(g.server.net_box_uri)
+    local s = conn.space.test
+    t.helpers.retrying({}, function()
+        local count = selects_in_net()
+        t.assert_equals(s:get(1), {1})
+        t.assert_gt(selects_in_net(), count)
+    end)
+    local function run()
+        local count = selects_in_net()
+        local time = clock.monotonic()
+        for _ = 1, COUNT do
+            t.assert_equals(s:get(1), {1})
+        end
+        time = clock.monotonic() - time
+        t.assert_equals(selects_in_net(), count + COUNT)
+        return time
+    end
+    t.assert_equals(g.server:exec(function()
+        return box.cfg.iproto_io_collect_interval
+    end), 0)
+    -- io_collect_interval applies to the tx thread only.
+    g.server:exec(function(interval)
+        box.cfg{io_collect_interval = interval}
+    end, {INTERVAL})
+    t.assert_lt(run(), COUNT * INTERVAL / 2)
+    g.server:exec(function(interval)
+        box.cfg{io_collect_interval = 0}
+        box.cfg{iproto_io_collect_interval = interval}
+    end, {INTERVAL})
+    t.assert_ge(run(), COUNT * INTERVAL / 2)
+    g.server:exec(function()
+        box.cfg{iproto_io_collect_interval = 0}
+    end)
+    t.assert_lt(run(), COUNT * INTERVAL / 2)
+    conn:close()
+end
+
+g.test_invalid = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        t.assert_error_msg_content_equals(
+            "Incorrect value for option 'iproto_io_collect_interval': " ..
+            "the value must be greater than or equal to 0",
+            box.cfg, {iproto_io_collect_interval = -1})
+        t.assert_error_msg_content_equals(
+            "Incorrect value for option 'iproto_io_collect_interval': " ..
+            "should be of type number",
+            box.cfg, {iproto_io_collect_interval = 'x'})
+        t.assert_equals(box.cfg.iproto_io_collect_interval, 0)
+    end)
+end
@@ -0,0 +1,75 @@
+local net = require('net.box')
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group('iproto_latency', t.helpers.matrix({
+    iproto_threads = {1, 2},
+}))
+
+g.before_all(function(cg)
+    cg.server = server:new({
+        alias = 'master',
+        box_cfg = {iproto_threads = cg.params.iproto_threads},
+    })
+    cg.server:start()
+    cg.server:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        box.schema.user.grant('guest', 'super')
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.test_latency = function(cg)
+    cg.server:exec(function() box.stat.reset() end)
+    local conns = {}
+    for i = 1, 4 do
+        conns[i] = net.connect(cg.server.net_box_uri)
+    end
+    for i = 1, 100 do
+        local conn = conns[i % #conns + 1]
+        conn.space.test:insert({i})
+        conn.space.test:select({i})
+        conn:call('box.session.id')
+    end
+    for _, conn in ipairs(conns) do
+        conn:close()
+    end
+    local latency = cg.server:exec(function()
+        return box.stat.latency()
+    end)
+    t.assert_equals(latency.INSERT.total.count, 100)
+    t.assert_equals(latency.CALL.total.count, 100)
+    t.assert_ge(latency.SELECT.total.count, 100)
+    t.assert_equals(latency.DELETE, nil)
+    for _, type in ipairs({'INSERT', 'SELECT', 'CALL'}) do
+        for _, phase in ipairs({'wait', 'execute', 'total'}) do
+            local l = latency[type][phase]
+            t.assert_le(l.p50, l.p90)
+            t.assert_le(l.p90, l.p99)
+            local prev = 0
+            for _, bucket in ipairs(l.buckets) do
+                t.assert_gt(bucket.le, 0)
+                t.assert_ge(bucket.count, prev)
+                prev = bucket.count
+            end
+            t.assert_le(prev, l.count)
+        end
+        -- Selects processed in the iproto thread are only accounted
+        -- in the total latency.
+        t.assert_equals(latency[type].wait.count,
+                        latency[type].execute.count)
+        t.assert_ge(latency[type].total.count, latency[type].execute.count)
+        t.assert_le(latency[type].execute.p50, latency[type].total.p99)
+    end
+    -- Reset clears latency of all threads.
+    t.assert_equals(cg.server:exec(function()
+        box.stat.reset()
+        return box.stat.latency()
+    end), {})
+    t.assert_equals(cg.server:exec(function()
+        return box.stat.latency().EVAL.total.count
+    end), 1)
+end
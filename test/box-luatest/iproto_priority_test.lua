@@ -0,0 +1,79 @@
+local net = require('net.box')
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+local NET_MSG_MAX = 8
+
+g.before_all(function()
+    g.server = server:new({
+        alias = 'master',
+        box_cfg = {net_msg_max = NET_MSG_MAX},
+    })
+    g.server:start()
+    g.server:exec(function()
+        local fiber = require('fiber')
+        box.schema.user.grant('guest', 'super')
+        rawset(_G, 'cond', fiber.cond())
+        rawset(_G, 'wait', function() _G.cond:wait() end)
+    end)
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.test_session_priority = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        t.assert_equals(box.session.priority(), 'normal')
+        t.assert_error_msg_equals(
+            "session.set_priority(): unknown priority 'foo'",
+            box.session.set_priority, 'foo')
+        t.assert_error_msg_equals(
+            "session.set_priority(priority): bad arguments",
+            box.session.set_priority)
+    end)
+    local conn = net.connect(g.server.net_box_uri)
+    t.assert_equals(conn:call('box.session.priority'), 'normal')
+    local total = g.server:exec(function()
+        return box.stat.net().REQUESTS_LOW_PRIORITY.total
+    end)
+    conn:call('box.session.set_priority', {'low'})
+    t.assert_equals(conn:call('box.session.priority'), 'low')
+    t.assert_equals(conn:ping(), true)
+    t.assert_equals(g.server:exec(function()
+        return box.stat.net().REQUESTS_LOW_PRIORITY.total
+    end), total + 2)
+    conn:call('box.session.set_priority', {'normal'})
+    t.assert_equals(conn:call('box.session.priority'), 'normal')
+    conn:close()
+end
+
+g.test_low_priority_burst = function()
+    -- A burst of low priority requests can't use up all net_msg_max
+    -- messages, so normal priority requests are still served.
+    local low = net.connect(g.server.net_box_uri)
+    low:call('box.session.set_priority', {'low'})
+    local futures = {}
+    for i = 1, NET_MSG_MAX * 2 do
+        futures[i] = low:call('wait', {}, {is_async = true})
+    end
+    t.helpers.retrying({}, function()
+        t.assert_equals(g.server:exec(function()
+            return box.stat.net().REQUESTS_IN_PROGRESS.current
+        end), NET_MSG_MAX - NET_MSG_MAX / 4 + 1)
+    end)
+    local conn = net.connect(g.server.net_box_uri)
+    t.assert_equals(conn:call('box.session.priority'), 'normal')
+    t.assert_equals(conn:ping(), true)
+    conn:close()
+    -- Stopped low priority requests are resumed once others complete.
+    t.helpers.retrying({}, function()
+        g.server:exec(function() _G.cond:broadcast() end)
+        for _, future in ipairs(futures) do
+            t.assert(future:is_ready())
+        end
+    end)
+    low:close()
+end
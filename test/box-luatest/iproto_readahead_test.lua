@@ -0,0 +1,64 @@
+local net = require('net.box')
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({alias = 'master'})
+    g.server:start()
+    g.server:exec(function()
+        box.schema.user.grant('guest', 'execute', 'universe')
+    end)
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+local function input_buffers()
+    return g.server:exec(function()
+        return box.stat.net().INPUT_BUFFERS
+    end)
+end
+
+local function readahead_resizes()
+    return g.server:exec(function()
+        return box.stat.net().READAHEAD_RESIZES
+    end)
+end
+
+g.test_readahead = function()
+    local stat = input_buffers()
+    t.assert_type(stat.current, 'number')
+    t.assert_equals(stat.total, nil)
+    t.assert_equals(stat.rps, nil)
+    stat = g.server:exec(function()
+        return box.stat.net.INPUT_BUFFERS
+    end)
+    t.assert_type(stat.current, 'number')
+    t.assert_equals(stat.total, nil)
+    stat = readahead_resizes()
+    t.assert_equals(stat.current, nil)
+    local total = stat.total
+    local conn = net.connect(g.server.net_box_uri)
+    local arg = string.rep('x', 200 * 1024)
+    for _ = 1, 3 do
+        t.assert_equals(conn:eval('return #...', {arg}), #arg)
+    end
+    -- The readahead of the connection has grown to fit the requests.
+    t.assert_gt(readahead_resizes().total, total)
+    t.assert_ge(input_buffers().current, #arg)
+    t.assert_ge(g.server:exec(function()
+        return box.stat.net.thread[1].INPUT_BUFFERS.current
+    end), #arg)
+    t.assert_gt(g.server:exec(function()
+        return box.stat.net.thread[1].READAHEAD_RESIZES.total
+    end), 0)
+    -- Input buffers of the idle connection are released.
+    t.helpers.retrying({timeout = 30}, function()
+        t.assert_lt(input_buffers().current, #arg)
+    end)
+    -- The connection is still usable.
+    t.assert_equals(conn:eval('return #...', {arg}), #arg)
+    conn:close()
+end
@@ -0,0 +1,89 @@
+local jit = require('jit')
+local net = require('net.box')
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+local IPROTO_THREADS = 4
+
+g.before_all(function()
+    t.skip_if(jit.os ~= 'Linux', 'SO_REUSEPORT balancing is Linux-only')
+    g.server = server:new({
+        alias = 'master',
+        box_cfg = {iproto_threads = IPROTO_THREADS},
+    })
+    g.server:start()
+    g.uri = g.server:exec(function()
+        box.cfg{listen = {box.cfg.listen, '127.0.0.1:0'}}
+        return box.info.listen[2]
+    end)
+end)
+
+g.after_all(function()
+    if g.server ~= nil then
+        g.server:drop()
+    end
+end)
+
+g.test_accept_distribution = function()
+    -- Connections coming from different ports are hashed to different
+    -- listening sockets so every iproto thread accepts some of them.
+    local conns = {}
+    for i = 1, 100 do
+        conns[i] = net.connect(g.uri)
+        t.assert_equals(conns[i]:ping(), true)
+    end
+    local totals = g.server:exec(function(count)
+        local totals = {}
+        for i = 1, count do
+            totals[i] = box.stat.net.thread[i].CONNECTIONS.total
+        end
+        return totals
+    end, {IPROTO_THREADS})
+    for i = 1, IPROTO_THREADS do
+        t.assert_gt(totals[i], 0, ('thread %d accepted nothing'):format(i))
+    end
+    for _, conn in ipairs(conns) do
+        conn:close()
+    end
+    -- Sockets are rebound on reconfiguration.
+    g.server:exec(function(uri)
+        box.cfg{listen = box.cfg.listen[1]}
+        box.cfg{listen = {box.cfg.listen, uri}}
+    end, {g.uri})
+    local conn = net.connect(g.uri)
+    t.assert_equals(conn:ping(), true)
+    conn:close()
+end
+
+g.test_address_in_use = function()
+    -- A socket listening with SO_REUSEPORT on the address would get a
+    -- share of connections, so binding to it must fail.
+    local ffi = require('ffi')
+    local socket = require('socket')
+    pcall(ffi.cdef, [[
+        int setsockopt(int sockfd, int level, int optname,
+                       const void *optval, unsigned int optlen);
+    ]])
+    local SOL_SOCKET = 1
+    local SO_REUSEPORT = 15
+    local s = socket('AF_INET', 'SOCK_STREAM', 'tcp')
+    local on = ffi.new('int[1]', 1)
+    t.assert_equals(ffi.C.setsockopt(s:fd(), SOL_SOCKET, SO_REUSEPORT,
+                                     on, ffi.sizeof('int')), 0)
+    t.assert(s:bind('127.0.0.1', 0))
+    t.assert(s:listen())
+    local uri = '127.0.0.1:' .. s:name().port
+    g.server:exec(function(uri)
+        local t = require('luatest')
+        t.assert_error_msg_contains('Address already in use',
+                                    box.cfg, {listen = uri})
+    end, {uri})
+    s:close()
+    g.server:exec(function(uri)
+        box.cfg{listen = uri}
+    end, {uri})
+    local conn = net.connect(uri)
+    t.assert_equals(conn:ping(), true)
+    conn:close()
+end
@@ -0,0 +1,79 @@
+local net = require('net.box')
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group('iproto_select', t.helpers.matrix({
+    engine = {'memtx', 'vinyl'},
+}))
+
+g.before_all(function(cg)
+    cg.server = server:new({alias = 'master'})
+    cg.server:start()
+    cg.server:exec(function(engine)
+        local s = box.schema.space.create('test', {engine = engine})
+        s:create_index('pk')
+        s:create_index('sk', {parts = {2, 'string'}, unique = false})
+        for i = 1, 1000 do
+            s:insert({i, 'k' .. (i % 10), string.rep('x', i)})
+        end
+        box.schema.user.grant('guest', 'read', 'space', 'test')
+    end, {cg.params.engine})
+    cg.conn = net.connect(cg.server.net_box_uri)
+end)
+
+g.after_all(function(cg)
+    cg.conn:close()
+    cg.server:drop()
+end)
+
+g.test_select = function(cg)
+    local s = cg.conn.space.test
+    local function row(i)
+        return {i, 'k' .. (i % 10), string.rep('x', i)}
+    end
+    t.assert_equals(s:select(5), {row(5)})
+    t.assert_equals(s:select(1001), {})
+    t.assert_equals(#s:select(), 1000)
+    t.assert_equals(s:select({}, {offset = 997}), {row(998), row(999),
+                                                   row(1000)})
+    t.assert_equals(s:select({10}, {iterator = 'lt', limit = 2}),
+                    {row(9), row(8)})
+    t.assert_equals(s:select({990}, {iterator = 'gt', offset = 5,
+                                     limit = 3}),
+                    {row(996), row(997), row(998)})
+    t.assert_equals(s.index.sk:select('k3', {limit = 3}),
+                    {row(3), row(13), row(23)})
+    t.assert_equals(s:select({}, {limit = 0}), {})
+end
+
+g.test_select_errors = function(cg)
+    local s = cg.conn.space.test
+    t.assert_error_msg_content_equals(
+        "Supplied key type of part 0 does not match index part type: " ..
+        "expected unsigned", s.select, s, {'a'})
+    cg.server:exec(function()
+        box.schema.user.revoke('guest', 'read', 'space', 'test')
+    end)
+    t.assert_error_msg_content_equals(
+        "Read access to space 'test' is denied for user 'guest'",
+        s.select, s, {1})
+    cg.server:exec(function()
+        box.schema.user.grant('guest', 'read', 'space', 'test')
+    end)
+    t.assert_equals(s:select(1), {{1, 'k1', 'x'}})
+end
+
+g.test_select_dump_error = function(cg)
+    t.skip_if(cg.server:exec(function()
+        return next(box.error.injection.info()) == nil
+    end), 'error injections are disabled in release builds')
+    -- The reply isn't corrupted by a failure in the middle of a select.
+    local s = cg.conn.space.test
+    cg.server:exec(function()
+        box.error.injection.set('ERRINJ_PORT_DUMP', true)
+    end)
+    t.assert_error_msg_contains('Failed to allocate', s.select, s)
+    cg.server:exec(function()
+        box.error.injection.set('ERRINJ_PORT_DUMP', false)
+    end)
+    t.assert_equals(#s:select({}, {limit = 10}), 10)
+end
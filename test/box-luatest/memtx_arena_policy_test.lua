@@ -0,0 +1,69 @@
+local fio = require('fio')
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({
+        alias = 'master',
+        box_cfg = {
+            memtx_use_hugepages = true,
+            -- There's no such NUMA node, but it isn't fatal.
+            memtx_numa_node = 1023,
+        },
+    })
+    g.server:start()
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.test_cfg = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        t.assert_equals(box.cfg.memtx_use_hugepages, true)
+        t.assert_equals(box.cfg.memtx_numa_node, 1023)
+        t.assert_error_msg_content_equals(
+            "Incorrect value for option 'memtx_use_hugepages': " ..
+            "should be of type boolean",
+            box.cfg, {memtx_use_hugepages = 1})
+        t.assert_error_msg_content_equals(
+            "Incorrect value for option 'memtx_numa_node': " ..
+            "should be of type number",
+            box.cfg, {memtx_numa_node = 'foo'})
+        t.assert_error_msg_content_equals(
+            "Can't set option 'memtx_use_hugepages' dynamically",
+            box.cfg, {memtx_use_hugepages = false})
+        t.assert_error_msg_content_equals(
+            "Can't set option 'memtx_numa_node' dynamically",
+            box.cfg, {memtx_numa_node = 0})
+        -- The arena works even if the policy wasn't applied.
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        for i = 1, 1000 do
+            s:insert({i, string.rep('x', 100)})
+        end
+        t.assert_equals(s:count(), 1000)
+        s:drop()
+    end)
+    t.assert(g.server:grep_log('failed to bind the memtx arena to ' ..
+                               'NUMA node 1023') or
+             g.server:grep_log("NUMA memory policy isn't supported"))
+end
+
+g.test_invalid_numa_node = function()
+    local dir = fio.tempdir()
+    for _, node in ipairs({-2, 1024}) do
+        local cmd = string.format(
+            "%s -e \"box.cfg{work_dir = '%s', memtx_numa_node = %d}\" 2>&1",
+            arg[-1], dir, node)
+        local f = io.popen(cmd)
+        local output = f:read('*a')
+        f:close()
+        t.assert_str_contains(
+            output, "Incorrect value for option 'memtx_numa_node': " ..
+                    "specified value is out of bounds")
+    end
+    fio.rmtree(dir)
+end
@@ -0,0 +1,173 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({alias = 'master'})
+    g.server:start()
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.after_each(function()
+    g.server:exec(function()
+        if box.space.test ~= nil then
+            box.space.test:drop()
+        end
+    end)
+end)
+
+g.test_invalid = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        t.assert_error_msg_content_equals(
+            "Can't create or modify index 'sk' in space 'test': " ..
+            "field type 'number' is not supported by ART index",
+            s.create_index, s, 'sk', {type = 'art', parts = {2, 'number'}})
+        t.assert_error_msg_content_equals(
+            "Can't create or modify index 'sk' in space 'test': " ..
+            "ART index cannot be multikey",
+            s.create_index, s, 'sk',
+            {type = 'art', parts = {{2, 'unsigned', path = '[*]'}}})
+        t.assert_error_msg_content_equals(
+            "Index 'sk' (ART) of space 'test' (memtx) does not support " ..
+            "requested iterator type",
+            function()
+                s:create_index('sk', {type = 'art', parts = {2, 'string'}})
+                s.index.sk:select({'a'}, {iterator = 'BITS_ALL_SET'})
+            end)
+        s:drop()
+        s = box.schema.space.create('test', {engine = 'vinyl'})
+        t.assert_error_msg_contains(
+            "Unsupported index type supplied for index 'pk'",
+            s.create_index, s, 'pk', {type = 'art'})
+    end)
+end
+
+--
+-- Checks that an ART index returns the same results as a TREE index.
+--
+g.test_select = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test')
+        s:create_index('pk', {type = 'art'})
+        local parts = {
+            {2, 'string', collation = 'unicode_ci'},
+            {3, 'integer', is_nullable = true},
+            {4, 'unsigned'},
+        }
+        s:create_index('tree', {unique = false, parts = parts})
+        s:create_index('art', {type = 'art', unique = false, parts = parts})
+        t.assert_equals(s.index.art.type, 'ART')
+        local strs = {'', 'a', 'A', 'ab', 'b', 'a\0', 'Ё', 'е'}
+        local ints = {box.NULL, -9223372036854775808LL, -1, 0, 1,
+                      18446744073709551615ULL}
+        local uints = {0, 1, 255, 256, 18446744073709551615ULL}
+        local id = 0
+        for _, str in ipairs(strs) do
+            for _, int in ipairs(ints) do
+                for _, uint in ipairs(uints) do
+                    id = id + 1
+                    s:insert({id, str, int, uint})
+                end
+            end
+        end
+        local function ids(index, key, opts)
+            local result = {}
+            for _, tuple in index:pairs(key, opts) do
+                table.insert(result, tuple[1])
+            end
+            return result
+        end
+        for _, it in ipairs({'EQ', 'REQ', 'GE', 'GT', 'LE', 'LT'}) do
+            for _, key in ipairs({{}, {'a'}, {'B'}, {'a', box.NULL},
+                                  {'a', -1}, {'a', 0, 256}}) do
+                local opts = {iterator = it}
+                t.assert_equals(ids(s.index.art, key, opts),
+                                ids(s.index.tree, key, opts),
+                                it .. ' ' .. require('json').encode(key))
+            end
+        end
+        t.assert_equals(s.index.pk:get(10), s:get(10))
+        t.assert_equals(s.index.pk:min(), s:get(1))
+        t.assert_equals(s.index.pk:max(), s:get(id))
+        t.assert_equals(s.index.art:count({'a'}), s.index.tree:count({'a'}))
+        t.assert_equals(s.index.art:len(), id)
+        t.assert_not_equals(s.index.pk:random(42), nil)
+        -- Iterators survive index changes.
+        local gen, param, state = s.index.pk:pairs({}, {iterator = 'GE'})
+        local _, tuple = gen(param, state)
+        t.assert_equals(tuple[1], 1)
+        s:delete(2)
+        s:delete(3)
+        _, tuple = gen(param, state)
+        t.assert_equals(tuple[1], 4)
+        local bsize = s.index.art:bsize()
+        t.assert_gt(bsize, 0)
+        for i = 1, id do
+            s:delete(i)
+        end
+        t.assert_lt(s.index.art:bsize(), bsize)
+        t.assert_equals(s.index.art:len(), 0)
+    end)
+end
+
+g.test_unique = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        s:create_index('sk', {
+            type = 'art',
+            parts = {{2, 'string', collation = 'unicode_ci'},
+                     {3, 'unsigned', is_nullable = true}},
+        })
+        s:insert({1, 'abc', 1})
+        t.assert_error_msg_contains(
+            'Duplicate key exists in unique index "sk"',
+            s.insert, s, {2, 'ABC', 1})
+        t.assert_equals(s:select(), {{1, 'abc', 1}})
+        -- Unique nullable index may store multiple NULLs.
+        s:insert({2, 'abc'})
+        s:insert({3, 'ABC'})
+        t.assert_equals(s.index.sk:get({'Abc', 1}), {1, 'abc', 1})
+        t.assert_equals(s.index.sk:select({'aBc', box.NULL}),
+                        {{2, 'abc'}, {3, 'ABC'}})
+        s:replace({1, 'xyz', 1})
+        t.assert_equals(s.index.sk:get({'abc', 1}), nil)
+        t.assert_equals(s.index.sk:get({'XYZ', 1}), {1, 'xyz', 1})
+    end)
+end
+
+--
+-- Checks that an ART index is built from existing data, written to
+-- a snapshot, and rebuilt on recovery.
+--
+g.test_build_and_recovery = function()
+    g.server:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk', {type = 'art'})
+        for i = 1, 100 do
+            s:insert({i, string.format('key%03d', 100 - i)})
+        end
+        s:create_index('sk', {type = 'art', parts = {2, 'string'}})
+        box.snapshot()
+    end)
+    g.server:restart()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        t.assert_equals(s.index.pk.type, 'ART')
+        t.assert_equals(s:count(), 100)
+        t.assert_equals(s.index.sk:select({}, {limit = 2}),
+                        {{100, 'key000'}, {99, 'key001'}})
+        t.assert_equals(s.index.sk:get({'key050'}), {50, 'key050'})
+        t.assert_equals(s.index.pk:select({}, {iterator = 'LT', limit = 1}),
+                        {{100, 'key000'}})
+    end)
+end
@@ -0,0 +1,190 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({alias = 'master'})
+    g.server:start()
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.after_each(function()
+    g.server:exec(function()
+        if box.space.test ~= nil then
+            box.space.test:drop()
+        end
+    end)
+end)
+
+g.test_invalid = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test', {engine = 'vinyl'})
+        t.assert_error_msg_content_equals(
+            "vinyl does not support bulk load", s.bulk_load, s, {})
+        s:drop()
+        s = box.schema.space.create('test')
+        s:create_index('pk')
+        t.assert_error_msg_content_equals(
+            "Illegal parameters, tuples should be a table or an " ..
+            "iterator function",
+            s.bulk_load, s, 1)
+        s:create_index('mk', {parts = {{2, 'unsigned', path = '[*]'}}})
+        t.assert_error_msg_content_equals(
+            "Bulk load does not support multikey and functional indexes",
+            s.bulk_load, s, {})
+        s.index.mk:drop()
+        s:insert({1})
+        t.assert_error_msg_content_equals(
+            "Can't modify space 'test': the space isn't empty",
+            s.bulk_load, s, {})
+        s:delete(1)
+        local function trigger() end
+        s:on_replace(trigger)
+        t.assert_error_msg_content_equals(
+            "Bulk load does not support spaces with triggers",
+            s.bulk_load, s, {})
+        s:on_replace(nil, trigger)
+        s:before_replace(trigger)
+        t.assert_error_msg_content_equals(
+            "Bulk load does not support spaces with triggers",
+            s.bulk_load, s, {})
+        s:before_replace(nil, trigger)
+        box.schema.sequence.create('seq')
+        s.index.pk:alter({sequence = 'seq'})
+        t.assert_error_msg_content_equals(
+            "Bulk load does not support spaces with a sequence",
+            s.bulk_load, s, {})
+        s.index.pk:alter({sequence = false})
+        box.sequence.seq:drop()
+        s:bulk_load({})
+        box.begin()
+        t.assert_error_msg_content_equals(
+            "Operation is not permitted when there is an active transaction ",
+            s.bulk_load, s, {})
+        box.rollback()
+    end)
+end
+
+g.test_load = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test', {format = {
+            {'id', 'unsigned'},
+            {'name', 'string'},
+            {'val', 'unsigned', is_nullable = true},
+        }})
+        s:create_index('pk')
+        s:create_index('name', {parts = {'name'}, type = 'hash'})
+        s:create_index('val', {parts = {{'val', is_nullable = true}},
+                               unique = false})
+        s:create_index('uval', {parts = {{'val', is_nullable = true}}})
+        -- Make sure the indexes have been modified before the load.
+        s:insert({1, 'a'})
+        s:delete(1)
+        local n = 10000
+        local i = n
+        s:bulk_load(function()
+            i = i - 1
+            if i < 0 then
+                return nil
+            end
+            return {i, 'name' .. i, i % 2 == 0 and i or nil}
+        end)
+        t.assert_equals(s:count(), n)
+        t.assert_equals(s.index.name:count(), n)
+        t.assert_equals(s.index.uval:count(), n)
+        t.assert_equals(s:get(42), {42, 'name42', 42})
+        t.assert_equals(s:get(43), {43, 'name43'})
+        t.assert_equals(s.index.name:get('name7'), {7, 'name7'})
+        t.assert_equals(s.index.val:select(8), {{8, 'name8', 8}})
+        t.assert_equals(s.index.uval:select({box.NULL}, {limit = 2,
+                                                         iterator = 'gt'}),
+                        {{0, 'name0', 0}, {2, 'name2', 2}})
+        t.assert_equals(s.index.pk:min(), {0, 'name0', 0})
+        t.assert_equals(s.index.pk:max(), {n - 1, 'name' .. (n - 1)})
+        t.assert_gt(s:bsize(), 0)
+        -- The space is writable after the load.
+        s:insert({n, 'x', n})
+        s:replace({0, 'y'})
+        t.assert_equals(s.index.name:get('y'), {0, 'y'})
+        t.assert_equals(s.index.uval:get(0), nil)
+    end)
+    -- The loaded data is in the snapshot.
+    g.server:restart()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        t.assert_equals(s:count(), 10001)
+        t.assert_equals(s:get(42), {42, 'name42', 42})
+        t.assert_equals(s.index.name:get('y'), {0, 'y'})
+    end)
+end
+
+g.test_errors = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test', {format = {
+            {'id', 'unsigned'},
+            {'name', 'string'},
+        }})
+        s:create_index('pk')
+        s:create_index('name', {parts = {'name'}})
+        t.assert_error_msg_contains(
+            'Duplicate key exists in unique index "name" in space "test"',
+            s.bulk_load, s, {{1, 'a'}, {2, 'a'}, {3, 'b'}})
+        t.assert_equals(s:select(), {})
+        t.assert_error_msg_content_equals(
+            "Tuple field 2 (name) type does not match one required by " ..
+            "operation: expected string, got unsigned",
+            s.bulk_load, s, {{1, 'a'}, {2, 3}})
+        t.assert_equals(s:select(), {})
+        t.assert_error_msg_content_equals(
+            "Can't modify space 'test': the space is being bulk loaded",
+            s.bulk_load, s, function()
+                s:insert({10, 'x'})
+            end)
+        t.assert_error_msg_content_equals(
+            "Bulk load does not support spaces with triggers",
+            s.bulk_load, s, function()
+                s:on_replace(function() end)
+            end)
+        s:on_replace(nil, s:on_replace()[1])
+        t.assert_error_msg_content_equals(
+            "foo", s.bulk_load, s, function()
+                error('foo', 0)
+            end)
+        -- The space is unlocked after a failure.
+        s:bulk_load({{1, 'a'}, box.tuple.new({2, 'b'})})
+        t.assert_equals(s:select(), {{1, 'a'}, {2, 'b'}})
+        s:truncate()
+        s:bulk_load({})
+        t.assert_equals(s:select(), {})
+    end)
+end
+
+g.test_snapshot_error = function()
+    t.skip_if(g.server:exec(function()
+        return next(box.error.injection.info()) == nil
+    end), 'error injections are disabled in release builds')
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        box.error.injection.set('ERRINJ_SNAP_COMMIT_FAIL', true)
+        local ok = pcall(s.bulk_load, s, {{1}, {2}})
+        box.error.injection.set('ERRINJ_SNAP_COMMIT_FAIL', false)
+        t.assert_not(ok)
+        -- The tuples aren't durable so they are removed.
+        t.assert_equals(s:select(), {})
+        s:insert({3})
+    end)
+    g.server:restart()
+    g.server:exec(function()
+        local t = require('luatest')
+        t.assert_equals(box.space.test:select(), {{3}})
+    end)
+end
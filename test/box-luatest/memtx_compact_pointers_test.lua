@@ -0,0 +1,213 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({
+        alias = 'master',
+        box_cfg = {memtx_max_tuple_size = 10 * 1024 * 1024},
+    })
+    g.server:start()
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.after_each(function()
+    g.server:exec(function()
+        if box.space.test ~= nil then
+            box.space.test:drop()
+        end
+    end)
+end)
+
+g.test_invalid = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        t.assert_error_msg_content_equals(
+            "Illegal parameters, options parameter 'compact_pointers' " ..
+            "should be of type boolean",
+            s.create_index, s, 'sk', {compact_pointers = 1})
+        t.assert_error_msg_content_equals(
+            "Can't create or modify index 'sk' in space 'test': " ..
+            "compact pointers are only supported by TREE index",
+            s.create_index, s, 'sk',
+            {type = 'hash', parts = {2, 'unsigned'}, compact_pointers = true})
+        t.assert_error_msg_content_equals(
+            "Can't create or modify index 'sk' in space 'test': " ..
+            "index with compact pointers can't use hints",
+            s.create_index, s, 'sk',
+            {parts = {2, 'unsigned'}, hint = true, compact_pointers = true})
+        t.assert_error_msg_content_equals(
+            "Can't create or modify index 'sk' in space 'test': " ..
+            "multikey index can't use compact pointers",
+            s.create_index, s, 'sk',
+            {parts = {{2, 'unsigned', path = '[*]'}},
+             compact_pointers = true})
+        t.assert_error_msg_content_equals(
+            "Can't create or modify index 'sk' in space 'test': " ..
+            "index with normalized keys can't use compact pointers",
+            s.create_index, s, 'sk',
+            {parts = {2, 'unsigned'}, normalized_keys = true,
+             compact_pointers = true})
+        s:drop()
+        s = box.schema.space.create('test', {engine = 'vinyl'})
+        t.assert_error_msg_content_equals(
+            "Vinyl does not support compact pointers",
+            s.create_index, s, 'pk', {compact_pointers = true})
+    end)
+end
+
+--
+-- Checks that an index with compact pointers returns the same
+-- results as an index without them.
+--
+g.test_select = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test')
+        s:create_index('pk', {compact_pointers = true})
+        t.assert(s.index.pk.compact_pointers)
+        t.assert_equals(s.index.pk.hint, false)
+        s:create_index('plain', {unique = false, parts = {2, 'string'}})
+        s:create_index('compact', {unique = false, parts = {2, 'string'},
+                                   compact_pointers = true})
+        t.assert_equals(s.index.plain.compact_pointers, nil)
+        for i = 1, 1000 do
+            s:insert({i, tostring(i % 100), string.rep('x', i % 50)})
+        end
+        for i = 1, 1000, 2 do
+            s:delete(i)
+        end
+        for i = 1, 1000, 3 do
+            s:replace({i, tostring(i % 7)})
+        end
+        t.assert_equals(s.index.pk:count(), s:count())
+        t.assert_equals(s:get(3), {3, '3'})
+        t.assert_equals(s:get(5), nil)
+        t.assert_equals(s.index.pk:min(), {1, '1'})
+        t.assert_equals(s.index.pk:max(), s:select({}, {iterator = 'le',
+                                                        limit = 1})[1])
+        for _, key in ipairs({'', '1', '3', '42', '6', '99', 'z'}) do
+            for _, it in ipairs({'eq', 'req', 'ge', 'gt', 'le', 'lt'}) do
+                t.assert_equals(s.index.compact:select(key, {iterator = it}),
+                                s.index.plain:select(key, {iterator = it}),
+                                string.format('key %q, iterator %s', key, it))
+            end
+        end
+        t.assert_equals(s.index.compact:select({}, {iterator = 'all'}),
+                        s.index.plain:select({}, {iterator = 'all'}))
+        t.assert_equals(s.index.pk:select({100}, {iterator = 'ge',
+                                                  limit = 5}),
+                        s:select({100}, {iterator = 'ge', limit = 5}))
+        -- Rebuild the index with and without compact pointers.
+        s.index.compact:alter({compact_pointers = false})
+        t.assert_equals(s.index.compact.compact_pointers, nil)
+        t.assert_equals(s.index.compact:select(),
+                        s.index.plain:select())
+        s.index.plain:alter({compact_pointers = true})
+        t.assert(s.index.plain.compact_pointers)
+        t.assert_equals(s.index.compact:select(),
+                        s.index.plain:select())
+    end)
+end
+
+--
+-- Checks that an index with compact pointers is smaller than
+-- an index without them.
+--
+g.test_bsize = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        s:create_index('hinted', {parts = {1, 'unsigned'}, hint = true})
+        s:create_index('plain', {parts = {1, 'unsigned'}, hint = false})
+        s:create_index('compact', {parts = {1, 'unsigned'},
+                                   compact_pointers = true})
+        box.begin()
+        for i = 1, 100000 do
+            s:insert({i})
+        end
+        box.commit()
+        t.assert_lt(s.index.compact:bsize(), s.index.plain:bsize())
+        t.assert_lt(s.index.plain:bsize(), s.index.hinted:bsize())
+    end)
+end
+
+--
+-- Checks that tuples allocated outside of the memtx arena can be
+-- stored in an index with compact pointers.
+--
+g.test_big_tuple = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        local big = string.rep('x', 5 * 1024 * 1024)
+        s:insert({1, big})
+        s:insert({2, 'x'})
+        s:create_index('sk', {parts = {1, 'unsigned'},
+                              compact_pointers = true})
+        s:create_index('sk2', {parts = {2, 'string'}, unique = false,
+                               compact_pointers = true})
+        s:create_index('plain', {parts = {2, 'string'}, unique = false})
+        t.assert_equals(s.index.sk:get(1), {1, big})
+        for i = 3, 10 do
+            s:insert({i, i % 2 == 0 and big .. i or 'x'})
+        end
+        t.assert_equals(s.index.sk:select(), s.index.pk:select())
+        t.assert_equals(s.index.sk2:select(), s.index.plain:select())
+        for i = 1, 10, 2 do
+            s:delete(i)
+        end
+        for i = 1, 10, 3 do
+            s:replace({i, big .. 'y'})
+        end
+        t.assert_equals(s.index.sk:select(), s.index.pk:select())
+        t.assert_equals(s.index.sk2:select(), s.index.plain:select())
+        t.assert_equals(s.index.sk:get(4), {4, big .. 'y'})
+    end)
+end
+
+local g_memory = t.group('memtx_compact_pointers_memory')
+
+g_memory.before_all(function(cg)
+    cg.server = server:new({alias = 'master'})
+    cg.server:start()
+end)
+
+g_memory.after_all(function(cg)
+    cg.server:drop()
+end)
+
+--
+-- Checks that memtx_memory can't be increased while there are indexes
+-- with compact pointers and that such indexes can't be created after
+-- it was increased.
+--
+g_memory.test_memtx_memory = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test')
+        s:create_index('pk', {compact_pointers = true})
+        local memory = box.cfg.memtx_memory
+        t.assert_error_msg_content_equals(
+            "Incorrect value for option 'memtx_memory': cannot increase " ..
+            "memory size at runtime while there are indexes with " ..
+            "compact pointers",
+            box.cfg, {memtx_memory = memory * 2})
+        t.assert_equals(box.cfg.memtx_memory, memory)
+        s.index.pk:alter({compact_pointers = false})
+        box.cfg({memtx_memory = memory * 2})
+        t.assert_error_msg_content_equals(
+            "Can't create or modify index 'sk' in space 'test': " ..
+            "compact pointers require memtx_memory to be addressable " ..
+            "by 32-bit offsets",
+            s.create_index, s, 'sk', {parts = {1, 'unsigned'},
+                                      compact_pointers = true})
+    end)
+end
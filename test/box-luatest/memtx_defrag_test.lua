@@ -0,0 +1,93 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({alias = 'master'})
+    g.server:start()
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.after_each(function()
+    g.server:exec(function()
+        box.cfg{memtx_defrag_threshold = 0, memtx_defrag_rate = 10000}
+        if box.space.test ~= nil then
+            box.space.test:drop()
+        end
+    end)
+end)
+
+g.test_cfg = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        t.assert_equals(box.cfg.memtx_defrag_threshold, 0)
+        t.assert_equals(box.cfg.memtx_defrag_rate, 10000)
+        t.assert_error_msg_content_equals(
+            "Incorrect value for option 'memtx_defrag_threshold': " ..
+            "the value must be >= 0 and < 1",
+            box.cfg, {memtx_defrag_threshold = 1})
+        t.assert_error_msg_content_equals(
+            "Incorrect value for option 'memtx_defrag_threshold': " ..
+            "the value must be >= 0 and < 1",
+            box.cfg, {memtx_defrag_threshold = -0.5})
+        t.assert_error_msg_content_equals(
+            "Incorrect value for option 'memtx_defrag_rate': " ..
+            "the value must be greater than 0",
+            box.cfg, {memtx_defrag_rate = 0})
+        t.assert_equals(box.slab.defrag_info(), {
+            in_progress = false, passes = 0, moved = 0,
+        })
+    end)
+end
+
+g.test_defrag = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+        local n = 20000
+        local payload = string.rep('x', 100)
+        box.begin()
+        for i = 1, n do
+            s:insert({i, i % 100, payload})
+        end
+        box.commit()
+        -- Leave every tenth tuple so that the slabs become sparse.
+        box.begin()
+        for i = 1, n do
+            if i % 10 ~= 0 then
+                s:delete(i)
+            end
+        end
+        box.commit()
+        -- A tuple referenced from Lua must stay intact.
+        local held = s:get(10)
+        local items_size = box.slab.info().items_size
+        box.cfg{memtx_defrag_threshold = 0.1, memtx_defrag_rate = 1000000}
+        t.helpers.retrying({timeout = 60}, function()
+            t.assert_ge(box.slab.defrag_info().passes, 1)
+        end)
+        local info = box.slab.defrag_info()
+        t.assert_gt(info.moved, 0)
+        t.assert_le(info.moved, n / 10)
+        t.assert_lt(box.slab.info().items_size, items_size)
+        t.assert_equals(held, {10, 10, payload})
+        t.assert_equals(s:count(), n / 10)
+        t.assert_equals(s.index.sk:count(), n / 10)
+        for i = 10, n, 10 do
+            t.assert_equals(s:get(i), {i, i % 100, payload})
+        end
+        t.assert_equals(s.index.sk:select(20, {limit = 3}),
+                        {{20, 20, payload}, {120, 20, payload},
+                         {220, 20, payload}})
+        -- The space is writable after the defragmentation.
+        s:replace({10, 11, 'y'})
+        t.assert_equals(s.index.sk:select(11, {limit = 1}),
+                        {{10, 11, 'y'}})
+        t.assert_equals(s.index.sk:count(10), n / 100 - 1)
+    end)
+end
@@ -0,0 +1,210 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({alias = 'master'})
+    g.server:start()
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.after_each(function()
+    g.server:exec(function()
+        if box.space.test ~= nil then
+            box.space.test:drop()
+        end
+    end)
+end)
+
+local format = {
+    {'id', 'unsigned'},
+    {'a', 'integer'},
+    {'b', 'double'},
+    {'c', 'boolean'},
+    {'d', 'uuid'},
+}
+
+g.test_invalid = function()
+    g.server:exec(function(format)
+        local t = require('luatest')
+        t.assert_error_msg_content_equals(
+            "Illegal parameters, options parameter 'fixed_layout' should " ..
+            "be of type boolean",
+            box.schema.space.create, 'test', {fixed_layout = 1})
+        t.assert_error_msg_content_equals(
+            "Can't modify space 'test': engine does not support " ..
+            "fixed_layout flag",
+            box.schema.space.create, 'test',
+            {engine = 'vinyl', fixed_layout = true, format = format})
+        t.assert_error_msg_content_equals(
+            "Fixed tuple layout does not support spaces without format",
+            box.schema.space.create, 'test', {fixed_layout = true})
+        local s = box.schema.space.create('test', {
+            fixed_layout = true, format = {{'id', 'unsigned'}},
+        })
+        t.assert_equals(s.fixed_layout, true)
+        t.assert_error_msg_content_equals(
+            "Fixed tuple layout does not support field type 'string'",
+            s.format, s, {{'id', 'unsigned'}, {'s', 'string'}})
+        t.assert_error_msg_content_equals(
+            "Fixed tuple layout does not support nullable fields",
+            s.format, s, {{'id', 'unsigned'},
+                          {'a', 'unsigned', is_nullable = true}})
+        s:format(format)
+        t.assert_error_msg_content_equals(
+            "Can't modify space 'test': fixed_layout can't be used " ..
+            "with HASH index",
+            s.create_index, s, 'pk', {type = 'hash'})
+        s:create_index('pk')
+        t.assert_error_msg_content_equals(
+            "Fixed tuple layout does not support indexed fields missing " ..
+            "in space format",
+            s.create_index, s, 'sk', {parts = {6, 'unsigned'}})
+        t.assert_error_msg_content_equals(
+            "Tuple field count 6 does not match space field count 5",
+            s.insert, s, {1, 1, 1.5, true, require('uuid').new(), 1})
+        t.assert_error_msg_content_equals(
+            "Tuple field 2 (a) type does not match one required by " ..
+            "operation: expected integer, got string",
+            s.insert, s, {1, 'x', 1.5, true, require('uuid').new()})
+        s:drop()
+        s = box.schema.space.create('test', {format = format})
+        s:create_index('pk', {type = 'hash'})
+        t.assert_error_msg_content_equals(
+            "Can't modify space 'test': fixed_layout can't be used " ..
+            "with HASH index",
+            s.alter, s, {fixed_layout = true})
+    end, {format})
+end
+
+g.test_dml = function()
+    g.server:exec(function(format)
+        local t = require('luatest')
+        local uuid = require('uuid')
+        local u1 = uuid.fromstr('11111111-1111-1111-1111-111111111111')
+        local u2 = uuid.fromstr('22222222-2222-2222-2222-222222222222')
+        local s = box.schema.space.create('test', {fixed_layout = true,
+                                                   format = format})
+        s:create_index('pk')
+        s:create_index('a', {parts = {'a'}, unique = false})
+        s:create_index('cd', {parts = {'c', 'd'}, unique = false})
+        s:insert({1, -1, 1.5, true, u1})
+        s:insert({2, 100, -2.5, false, u2})
+        s:insert({3, -9223372036854775807LL, 0.5, true, u2})
+        s:insert({4, 18446744073709551615ULL, 1e100, false, u1})
+        -- All tuples have the same size: 1 + 9 * 3 + 1 + 18.
+        for _, tuple in s:pairs() do
+            t.assert_equals(tuple:bsize(), 47)
+        end
+        t.assert_equals(s:get(1), {1, -1, 1.5, true, u1})
+        t.assert_equals(s:get(1).a, -1)
+        t.assert_equals(s:get(4).a, 18446744073709551615ULL)
+        t.assert_equals(s:get(2).d, u2)
+        local function ids(index, key)
+            return index:pairs(key):map(function(tuple)
+                return tuple.id
+            end):totable()
+        end
+        t.assert_equals(ids(s.index.a), {3, 1, 2, 4})
+        t.assert_equals(s.index.a:select({100}), {{2, 100, -2.5, false, u2}})
+        t.assert_equals(ids(s.index.cd, {true}), {1, 3})
+        s:update(1, {{'+', 'a', 10}, {'=', 'c', false}})
+        t.assert_equals(s:get(1), {1, 9, 1.5, false, u1})
+        s:upsert({5, 5, 5.5, true, u1}, {{'+', 'a', 1}})
+        s:upsert({5, 5, 5.5, true, u1}, {{'+', 'a', 1}})
+        t.assert_equals(s:get(5), {5, 6, 5.5, true, u1})
+        s:replace({5, 7, 7.5, true, u2})
+        t.assert_equals(s.index.a:select(6), {})
+        t.assert_equals(s.index.a:select(7), {{5, 7, 7.5, true, u2}})
+        s:delete(5)
+        t.assert_equals(s:count(), 4)
+        t.assert_equals(s:get(5), nil)
+    end, {format})
+end
+
+--
+-- Checks that a non-negative integer encoded as MP_INT is stored
+-- as MP_UINT.
+--
+g.test_positive_mp_int = function()
+    g.server:exec(function(format)
+        local ffi = require('ffi')
+        local msgpack = require('msgpack')
+        local t = require('luatest')
+        local u = require('uuid').fromstr(
+            '11111111-1111-1111-1111-111111111111')
+        pcall(ffi.cdef, [[
+            int
+            box_insert(uint32_t space_id, const char *tuple,
+                       const char *tuple_end, box_tuple_t **result);
+        ]])
+        local s = box.schema.space.create('test', {fixed_layout = true,
+                                                   format = format})
+        s:create_index('pk')
+        s:create_index('a', {parts = {'a'}, unique = false})
+        s:insert({1, 5, 1.5, true, u})
+        s:insert({3, 20, 1.5, true, u})
+        s:insert({4, -1, 1.5, true, u})
+        -- Tuple {2, 10, 1.5, true, u} with field 'a' encoded as MP_INT.
+        local data = '\x95' .. msgpack.encode(2) ..
+                     '\xd3\0\0\0\0\0\0\0\x0a' ..
+                     msgpack.encode(1.5) .. msgpack.encode(true) ..
+                     msgpack.encode(u)
+        local p = ffi.cast('const char *', data)
+        t.assert_equals(ffi.C.box_insert(s.id, p, p + #data, nil), 0)
+        local raw = msgpack.encode(s:get(2))
+        -- Field 'a' follows the array header and the 9-byte field 'id'.
+        t.assert_equals(raw:byte(11), 0xcf)
+        t.assert_equals(s:get(2).a, 10)
+        t.assert_equals(s.index.a:select({}, {iterator = 'ge'}),
+                        {{4, -1, 1.5, true, u}, {1, 5, 1.5, true, u},
+                         {2, 10, 1.5, true, u}, {3, 20, 1.5, true, u}})
+        t.assert_equals(s.index.a:select(10), {{2, 10, 1.5, true, u}})
+        t.assert_equals(s.index.a:select(10, {iterator = 'gt'}),
+                        {{3, 20, 1.5, true, u}})
+    end, {format})
+end
+
+g.test_alter_and_recovery = function()
+    g.server:exec(function(format)
+        local uuid = require('uuid')
+        local u = uuid.fromstr('11111111-1111-1111-1111-111111111111')
+        local s = box.schema.space.create('test', {format = format})
+        s:create_index('pk')
+        s:create_index('a', {parts = {'a'}})
+        for i = 1, 10 do
+            s:insert({i, -i, i + 0.5, i % 2 == 0, u})
+        end
+        s:alter({fixed_layout = true})
+        for i = 11, 20 do
+            s:insert({i, -i, i + 0.5, i % 2 == 0, u})
+        end
+        box.snapshot()
+        for i = 21, 30 do
+            s:insert({i, -i, i + 0.5, i % 2 == 0, u})
+        end
+    end, {format})
+    g.server:restart()
+    g.server:exec(function()
+        local t = require('luatest')
+        local uuid = require('uuid')
+        local u = uuid.fromstr('11111111-1111-1111-1111-111111111111')
+        local s = box.space.test
+        t.assert_equals(s.fixed_layout, true)
+        t.assert_equals(s:count(), 30)
+        for i = 1, 30 do
+            t.assert_equals(s:get(i), {i, -i, i + 0.5, i % 2 == 0, u})
+            t.assert_equals(s.index.a:get(-i).id, i)
+            t.assert_equals(s:get(i):bsize(), 47)
+        end
+        s:alter({fixed_layout = false})
+        s:insert({31, 1, 1.5, true, u})
+        t.assert_lt(s:get(31):bsize(), 47)
+        t.assert_equals(s.index.a:select({1}, {iterator = 'le',
+                                               limit = 2}),
+                        {{31, 1, 1.5, true, u}, {1, -1, 1.5, false, u}})
+    end)
+end
@@ -0,0 +1,184 @@
+local net = require('net.box')
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({alias = 'master'})
+    g.server:start()
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.after_each(function()
+    g.server:exec(function()
+        for _, name in ipairs({'test', 'test2'}) do
+            if box.space[name] ~= nil then
+                box.space[name]:drop()
+            end
+        end
+    end)
+end)
+
+local function selects_in_net()
+    return g.server:exec(function()
+        return box.stat.net().SELECTS_IN_NET.total
+    end)
+end
+
+g.test_invalid = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        t.assert_error_msg_content_equals(
+            "Illegal parameters, options parameter 'iproto_read' should " ..
+            "be of type boolean",
+            box.schema.space.create, 'test', {iproto_read = 1})
+        t.assert_error_msg_content_equals(
+            "Can't modify space 'test': engine does not support " ..
+            "iproto_read flag",
+            box.schema.space.create, 'test',
+            {engine = 'vinyl', iproto_read = true})
+        local s = box.schema.space.create('test', {iproto_read = true})
+        t.assert_equals(s.iproto_read, true)
+        s:alter({iproto_read = false})
+        t.assert_equals(s.iproto_read, false)
+        s:create_index('pk', {type = 'hash'})
+        s:insert({1})
+        t.assert_error_msg_content_equals(
+            "Can't modify space 'test': can not enable iproto_read " ..
+            "on a non-empty space",
+            s.alter, s, {iproto_read = true})
+        s:truncate()
+        s:alter({iproto_read = true})
+        t.assert_equals(s.iproto_read, true)
+    end)
+end
+
+g.test_get = function()
+    g.server:exec(function()
+        local s = box.schema.space.create('test', {iproto_read = true})
+        s:create_index('pk', {type = 'hash', parts = {1, 'unsigned'}})
+        box.schema.user.grant('guest', 'read,write', 'space', 'test')
+    end)
+    local conn = net.connect(g.server.net_box_uri)
+    local s = conn.space.test
+    for i = 1, 10 do
+        s:insert({i, 'v' .. i})
+    end
+    -- The first lookup may be forwarded to tx while the space is
+    -- being published.
+    t.helpers.retrying({}, function()
+        local count = selects_in_net()
+        t.assert_equals(s:get(5), {5, 'v5'})
+        t.assert_gt(selects_in_net(), count)
+    end)
+    local count = selects_in_net()
+    for i = 1, 10 do
+        t.assert_equals(s:get(i), {i, 'v' .. i})
+    end
+    t.assert_equals(s:get(11), nil)
+    t.assert_ge(selects_in_net(), count + 11)
+    -- A connection sees results of its own requests.
+    s:replace({5, 'new'})
+    t.assert_equals(s:get(5), {5, 'new'})
+    s:delete(6)
+    t.assert_equals(s:get(6), nil)
+    s:update(7, {{'=', 2, 'upd'}})
+    t.assert_equals(s:get(7), {7, 'upd'})
+    -- Invalid keys are reported by tx.
+    t.assert_error_msg_content_equals(
+        "Supplied key type of part 0 does not match index part type: " ..
+        "expected unsigned",
+        s.get, s, 'foo')
+    t.assert_error_msg_content_equals(
+        "Invalid key part count in an exact match (expected 1, got 2)",
+        s.get, s, {1, 2})
+    conn:close()
+end
+
+g.test_fallback = function()
+    g.server:exec(function()
+        local s = box.schema.space.create('test', {iproto_read = true})
+        s:create_index('pk', {type = 'tree'})
+        s:insert({1, 'a'})
+        s = box.schema.space.create('test2')
+        s:create_index('pk', {type = 'hash'})
+        s:insert({1, 'b'})
+        box.schema.user.grant('guest', 'read', 'space', 'test')
+        box.schema.user.grant('guest', 'read', 'space', 'test2')
+    end)
+    local conn = net.connect(g.server.net_box_uri)
+    local count = selects_in_net()
+    for _ = 1, 10 do
+        t.assert_equals(conn.space.test:get(1), {1, 'a'})
+        t.assert_equals(conn.space.test2:get(1), {1, 'b'})
+        t.assert_equals(conn.space.test:select({1}), {{1, 'a'}})
+    end
+    t.assert_equals(selects_in_net(), count)
+    conn:close()
+end
+
+g.test_access = function()
+    g.server:exec(function()
+        local s = box.schema.space.create('test', {iproto_read = true})
+        s:create_index('pk', {type = 'hash'})
+        s:insert({1, 'a'})
+        -- Make the space visible to the user.
+        box.schema.user.grant('guest', 'write', 'space', 'test')
+    end)
+    local conn = net.connect(g.server.net_box_uri)
+    local count = selects_in_net()
+    for _ = 1, 10 do
+        t.assert_error_msg_content_equals(
+            "Read access to space 'test' is denied for user 'guest'",
+            conn.space.test.get, conn.space.test, 1)
+    end
+    t.assert_equals(selects_in_net(), count)
+    g.server:exec(function()
+        box.schema.user.grant('guest', 'read', 'space', 'test')
+    end)
+    t.helpers.retrying({}, function()
+        t.assert_equals(conn.space.test:get(1), {1, 'a'})
+        t.assert_gt(selects_in_net(), count)
+    end)
+    g.server:exec(function()
+        box.schema.user.revoke('guest', 'read', 'space', 'test')
+    end)
+    t.helpers.retrying({}, function()
+        t.assert_error_msg_content_equals(
+            "Read access to space 'test' is denied for user 'guest'",
+            conn.space.test.get, conn.space.test, 1)
+    end)
+    conn:close()
+end
+
+g.test_many_spaces = function()
+    g.server:exec(function()
+        for _, name in ipairs({'test', 'test2'}) do
+            local s = box.schema.space.create(name, {iproto_read = true})
+            s:create_index('pk', {type = 'hash'})
+            box.schema.user.grant('guest', 'read,write', 'space', name)
+        end
+    end)
+    local conn = net.connect(g.server.net_box_uri)
+    local s1 = conn.space.test
+    local s2 = conn.space.test2
+    s1:insert({1, 'a'})
+    s2:insert({1, 'b'})
+    t.helpers.retrying({}, function()
+        local count = selects_in_net()
+        t.assert_equals(s2:get(1), {1, 'b'})
+        t.assert_gt(selects_in_net(), count)
+    end)
+    -- Changes of one space don't affect lookups in another one.
+    local count = selects_in_net()
+    for i = 2, 10 do
+        s1:replace({1, 'a' .. i})
+        t.assert_equals(s1:get(1), {1, 'a' .. i})
+        t.assert_equals(s2:get(1), {1, 'b'})
+    end
+    t.assert_gt(selects_in_net(), count)
+    conn:close()
+end
@@ -0,0 +1,225 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({alias = 'master'})
+    g.server:start()
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.after_each(function()
+    g.server:exec(function()
+        if box.space.test ~= nil then
+            box.space.test:drop()
+        end
+    end)
+end)
+
+g.test_invalid = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        t.assert_error_msg_content_equals(
+            "Can't create or modify index 'sk' in space 'test': " ..
+            "normalized keys are only supported by TREE index",
+            s.create_index, s, 'sk',
+            {type = 'hash', parts = {2, 'unsigned'}, normalized_keys = true})
+        t.assert_error_msg_content_equals(
+            "Can't create or modify index 'sk' in space 'test': " ..
+            "field type 'number' is not supported by normalized keys",
+            s.create_index, s, 'sk',
+            {parts = {2, 'number'}, normalized_keys = true})
+        t.assert_error_msg_content_equals(
+            "Can't create or modify index 'sk' in space 'test': " ..
+            "multikey index can't use normalized keys",
+            s.create_index, s, 'sk',
+            {parts = {{2, 'unsigned', path = '[*]'}},
+             normalized_keys = true})
+        s:drop()
+        s = box.schema.space.create('test', {engine = 'vinyl'})
+        t.assert_error_msg_content_equals(
+            "Vinyl does not support normalized keys",
+            s.create_index, s, 'pk', {normalized_keys = true})
+    end)
+end
+
+--
+-- Checks that an index with normalized keys returns the same
+-- results as an index without them.
+--
+g.test_select = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test')
+        s:create_index('pk', {normalized_keys = true})
+        local parts = {
+            {2, 'string', collation = 'unicode_ci'},
+            {3, 'integer', is_nullable = true},
+            {4, 'unsigned'},
+            {5, 'boolean'},
+        }
+        s:create_index('plain', {unique = false, parts = parts})
+        s:create_index('norm', {unique = false, parts = parts,
+                                normalized_keys = true})
+        t.assert(s.index.norm.normalized_keys)
+        t.assert_equals(s.index.plain.normalized_keys, nil)
+        local strs = {'', 'a', 'A', 'ab', 'b', 'a\0', 'a\0b', 'Ё', 'е'}
+        local ints = {box.NULL, -9223372036854775808LL, -1, 0, 1,
+                      9223372036854775808ULL, 18446744073709551615ULL}
+        local uints = {0, 1, 255, 256, 18446744073709551615ULL}
+        local id = 0
+        for _, str in ipairs(strs) do
+            for _, int in ipairs(ints) do
+                for _, uint in ipairs(uints) do
+                    id = id + 1
+                    s:insert({id, str, int, uint, id % 2 == 0})
+                end
+            end
+        end
+        local function ids(index, key, opts)
+            local result = {}
+            for _, tuple in index:pairs(key, opts) do
+                table.insert(result, tuple[1])
+            end
+            return result
+        end
+        for _, it in ipairs({'EQ', 'REQ', 'GE', 'GT', 'LE', 'LT'}) do
+            for _, key in ipairs({{}, {'a'}, {'B'}, {'a', box.NULL},
+                                  {'a', -1}, {'ab', 9223372036854775808ULL},
+                                  {'a', 0, 256}}) do
+                local opts = {iterator = it}
+                t.assert_equals(ids(s.index.norm, key, opts),
+                                ids(s.index.plain, key, opts),
+                                it .. ' ' .. require('json').encode(key))
+            end
+        end
+        t.assert_equals(s.index.pk:get(10), s:get(10))
+        -- Keys are freed on delete.
+        local bsize = s.index.norm:bsize()
+        t.assert_gt(bsize, s.index.plain:bsize())
+        for i = 1, id do
+            s:delete(i)
+        end
+        t.assert_lt(s.index.norm:bsize(), bsize)
+    end)
+end
+
+g.test_unique = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        s:create_index('sk', {
+            parts = {{2, 'string', collation = 'unicode_ci'},
+                     {3, 'unsigned', is_nullable = true}},
+            normalized_keys = true,
+        })
+        s:insert({1, 'abc', 1})
+        t.assert_error_msg_contains(
+            'Duplicate key exists in unique index "sk"',
+            s.insert, s, {2, 'ABC', 1})
+        -- Unique nullable index may store multiple NULLs.
+        s:insert({2, 'abc'})
+        s:insert({3, 'ABC'})
+        t.assert_equals(s.index.sk:get({'Abc', 1}), {1, 'abc', 1})
+        t.assert_equals(s.index.sk:select({'aBc', box.NULL}),
+                        {{2, 'abc'}, {3, 'ABC'}})
+        s:replace({1, 'xyz', 1})
+        t.assert_equals(s.index.sk:get({'abc', 1}), nil)
+        t.assert_equals(s.index.sk:get({'XYZ', 1}), {1, 'xyz', 1})
+    end)
+end
+
+--
+-- Checks that an index with normalized keys is built from existing
+-- data and rebuilt on recovery.
+--
+g.test_build_and_recovery = function()
+    g.server:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        for i = 1, 100 do
+            s:insert({i, string.format('key%03d', 100 - i)})
+        end
+        s:create_index('sk', {parts = {2, 'string'}, normalized_keys = true})
+        box.snapshot()
+    end)
+    g.server:restart()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        t.assert(s.index.sk.normalized_keys)
+        t.assert_equals(s.index.sk:select({}, {limit = 2}),
+                        {{100, 'key000'}, {99, 'key001'}})
+        t.assert_equals(s.index.sk:get({'key050'}), {50, 'key050'})
+        s.index.sk:alter({normalized_keys = false})
+        t.assert_equals(s.index.sk.normalized_keys, nil)
+        t.assert_equals(s.index.sk:get({'key050'}), {50, 'key050'})
+    end)
+end
+
+--
+-- Checks that a non-negative integer encoded as MP_INT is ordered
+-- and looked up by its value.
+--
+g.test_positive_mp_int = function()
+    g.server:exec(function()
+        local ffi = require('ffi')
+        local t = require('luatest')
+        pcall(ffi.cdef, [[
+            int
+            box_insert(uint32_t space_id, const char *tuple,
+                       const char *tuple_end, box_tuple_t **result);
+        ]])
+        -- Encode a small non-negative number as MP_INT (0xd3).
+        local function mp_int(n)
+            return '\xd3\0\0\0\0' .. string.char(
+                bit.band(bit.rshift(n, 24), 0xff),
+                bit.band(bit.rshift(n, 16), 0xff),
+                bit.band(bit.rshift(n, 8), 0xff),
+                bit.band(n, 0xff))
+        end
+        local function insert_raw(space, data)
+            local p = ffi.cast('const char *', data)
+            return ffi.C.box_insert(space.id, p, p + #data, nil)
+        end
+        local function get_raw(index, key)
+            local p = ffi.cast('const char *', key)
+            local result = ffi.new('box_tuple_t *[1]')
+            t.assert_equals(ffi.C.box_index_get(index.space_id, index.id,
+                                                p, p + #key, result), 0)
+            return result[0] ~= nil
+        end
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        s:create_index('plain', {parts = {2, 'integer'}, unique = false})
+        s:create_index('norm', {parts = {2, 'integer'},
+                                normalized_keys = true})
+        for i = 1, 10 do
+            if i % 2 == 0 then
+                -- Tuple {i, i * 100} with the second field as MP_INT.
+                t.assert_equals(insert_raw(s, '\x92' .. string.char(i) ..
+                                              mp_int(i * 100)), 0)
+            else
+                s:insert({i, i * 100})
+            end
+        end
+        s:insert({11, -100})
+        t.assert_equals(s.index.norm:select(), s.index.plain:select())
+        t.assert_equals(s.index.norm:get(400), {4, 400})
+        t.assert_equals(s.index.norm:select({500}, {iterator = 'ge'}),
+                        s.index.plain:select({500}, {iterator = 'ge'}))
+        -- Lookup by an MP_INT key finds a tuple with an MP_UINT field.
+        t.assert(get_raw(s.index.norm, '\x91' .. mp_int(300)))
+        t.assert_not(get_raw(s.index.norm, '\x91' .. mp_int(350)))
+        -- A duplicate is detected whatever the encoding.
+        t.assert_equals(insert_raw(s, '\x92\x0c' .. mp_int(700)), -1)
+        t.assert_str_contains(tostring(box.error.last()),
+                              'Duplicate key exists in unique index "norm"')
+    end)
+end
@@ -0,0 +1,161 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({alias = 'master'})
+    g.server:start()
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.after_each(function()
+    g.server:exec(function()
+        if box.space.test ~= nil then
+            box.space.test:drop()
+        end
+    end)
+end)
+
+g.test_invalid = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        t.assert_error_msg_content_equals(
+            "Illegal parameters, options parameter 'block_size' " ..
+            "should be of type number",
+            s.create_index, s, 'sk', {block_size = '1024'})
+        t.assert_error_msg_content_equals(
+            "Illegal parameters, options parameter 'inline_prefix' " ..
+            "should be of type boolean",
+            s.create_index, s, 'sk', {inline_prefix = 1})
+        t.assert_error_msg_content_equals(
+            "Can't create or modify index 'sk' in space 'test': " ..
+            "block size must be 512, 1024 or 2048",
+            s.create_index, s, 'sk',
+            {parts = {2, 'unsigned'}, block_size = 4096})
+        t.assert_error_msg_content_equals(
+            "Can't create or modify index 'sk' in space 'test': " ..
+            "block size is only supported by TREE index",
+            s.create_index, s, 'sk',
+            {type = 'hash', parts = {2, 'unsigned'}, block_size = 1024})
+        t.assert_error_msg_content_equals(
+            "Can't create or modify index 'sk' in space 'test': " ..
+            "multikey index can't change block size",
+            s.create_index, s, 'sk',
+            {parts = {{2, 'unsigned', path = '[*]'}}, block_size = 1024})
+        t.assert_error_msg_content_equals(
+            "Can't create or modify index 'sk' in space 'test': " ..
+            "inline prefix requires normalized keys",
+            s.create_index, s, 'sk',
+            {parts = {2, 'unsigned'}, inline_prefix = true})
+        s:drop()
+        s = box.schema.space.create('test', {engine = 'vinyl'})
+        t.assert_error_msg_content_equals(
+            "Vinyl does not support block size",
+            s.create_index, s, 'pk', {block_size = 1024})
+        t.assert_error_msg_content_equals(
+            "Vinyl does not support inline prefix",
+            s.create_index, s, 'pk', {inline_prefix = true})
+    end)
+end
+
+--
+-- Checks that indexes with different block sizes and with inline
+-- prefixes return the same results as a plain index.
+--
+g.test_select = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test')
+        s:create_index('pk', {block_size = 2048})
+        t.assert_equals(s.index.pk.block_size, 2048)
+        s:create_index('plain', {unique = false, parts = {2, 'string'}})
+        t.assert_equals(s.index.plain.block_size, nil)
+        t.assert_equals(s.index.plain.inline_prefix, nil)
+        s:create_index('big', {unique = false, parts = {2, 'string'},
+                               block_size = 1024})
+        s:create_index('prefix', {unique = false, parts = {2, 'string'},
+                                  normalized_keys = true,
+                                  inline_prefix = true})
+        t.assert(s.index.prefix.inline_prefix)
+        s:create_index('both', {unique = false, parts = {2, 'string'},
+                                normalized_keys = true,
+                                inline_prefix = true, block_size = 2048})
+        -- Keys both shorter and longer than the inline prefix.
+        local function key(i)
+            return string.rep('k', i % 40) .. tostring(i % 100)
+        end
+        for i = 1, 2000 do
+            s:insert({i, key(i)})
+        end
+        for i = 1, 2000, 2 do
+            s:delete(i)
+        end
+        for i = 1, 2000, 3 do
+            s:replace({i, key(i * 7)})
+        end
+        local keys = {'', 'k', 'kk', key(1), key(42), key(77), key(139),
+                      string.rep('k', 39), 'z'}
+        for _, name in ipairs({'big', 'prefix', 'both'}) do
+            local index = s.index[name]
+            for _, k in ipairs(keys) do
+                for _, it in ipairs({'eq', 'req', 'ge', 'gt', 'le', 'lt'}) do
+                    t.assert_equals(
+                        index:select(k, {iterator = it}),
+                        s.index.plain:select(k, {iterator = it}),
+                        string.format('index %s, key %q, iterator %s',
+                                      name, k, it))
+                end
+                t.assert_equals(index:count(k), s.index.plain:count(k))
+            end
+            t.assert_equals(index:select(), s.index.plain:select())
+        end
+        t.assert_equals(s.index.pk:select({100}, {iterator = 'ge',
+                                                  limit = 5}),
+                        s:select({100}, {iterator = 'ge', limit = 5}))
+        -- Changing the layout rebuilds the index.
+        s.index.prefix:alter({inline_prefix = false, block_size = 1024})
+        t.assert_equals(s.index.prefix.inline_prefix, nil)
+        t.assert_equals(s.index.prefix.block_size, 1024)
+        t.assert_equals(s.index.prefix:select(), s.index.plain:select())
+        s.index.big:alter({block_size = 512})
+        t.assert_equals(s.index.big.block_size, nil)
+        t.assert_equals(s.index.big:select(), s.index.plain:select())
+    end)
+end
+
+--
+-- Checks that the layout options survive recovery.
+--
+g.test_recovery = function()
+    g.server:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk', {block_size = 1024})
+        s:create_index('sk', {unique = false, parts = {2, 'string'},
+                              normalized_keys = true, inline_prefix = true,
+                              block_size = 2048})
+        for i = 1, 100 do
+            s:insert({i, string.rep('x', i % 30) .. i})
+        end
+        box.snapshot()
+        for i = 101, 200 do
+            s:insert({i, string.rep('x', i % 30) .. i})
+        end
+    end)
+    g.server:restart()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        t.assert_equals(s.index.pk.block_size, 1024)
+        t.assert_equals(s.index.sk.block_size, 2048)
+        t.assert(s.index.sk.inline_prefix)
+        t.assert_equals(s:count(), 200)
+        t.assert_equals(s.index.sk:select(string.rep('x', 5) .. 5),
+                        {{5, string.rep('x', 5) .. 5}})
+        t.assert_equals(#s.index.sk:select(), 200)
+    end)
+end
@@ -0,0 +1,116 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({alias = 'master'})
+    g.server:start()
+    local ok = g.server:exec(function()
+        local format = {{name = 'x', compression = 'zstd'}}
+        local ok = pcall(box.schema.space.create, 'test', {format = format})
+        if ok then
+            box.space.test:drop()
+        end
+        return ok
+    end)
+    t.skip_if(not ok, 'tuple compression is disabled')
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.after_each(function()
+    g.server:exec(function()
+        if box.space.test ~= nil then
+            box.space.test:drop()
+        end
+    end)
+end)
+
+g.test_invalid = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local format = {
+            {name = 'id', type = 'unsigned'},
+            {name = 'data', type = 'string', compression = 'zstd'},
+        }
+        t.assert_error_msg_content_equals(
+            "Vinyl does not support compression",
+            box.schema.space.create, 'test',
+            {engine = 'vinyl', format = format})
+        local s = box.schema.space.create('test', {format = format})
+        s:create_index('pk')
+        t.assert_error_msg_content_equals(
+            "Indexed field does not support compression",
+            s.create_index, s, 'sk', {parts = {'data'}})
+    end)
+end
+
+g.test_compression = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('test', {format = {
+            {name = 'id', type = 'unsigned'},
+            {name = 'data', type = 'map', compression = 'zstd'},
+            {name = 'tag', type = 'string', compression = 'zstd'},
+        }})
+        s:create_index('pk')
+        local data = {}
+        for i = 1, 100 do
+            data['key' .. i] = string.rep('value', 10)
+        end
+        local tuples = {}
+        for i = 1, 100 do
+            tuples[i] = {i, data, 'x'}
+            t.assert_equals(s:insert(tuples[i]), tuples[i])
+        end
+        -- Compressed tuples take less memory.
+        local raw_bsize = box.tuple.new(tuples[1]):bsize() * 100
+        t.assert_lt(s:bsize(), raw_bsize / 2)
+        -- Compressed fields are transparently decompressed on read.
+        t.assert_equals(s:get(1), tuples[1])
+        t.assert_equals(s:get(1).data, data)
+        t.assert_equals(s:select({}, {limit = 3}),
+                        {tuples[1], tuples[2], tuples[3]})
+        t.assert_equals(s:count(), 100)
+        -- Old tuples are decompressed for update and delete.
+        t.assert_equals(s:replace({1, {a = 1}, 'y'}), {1, {a = 1}, 'y'})
+        t.assert_equals(s:update(2, {{'=', 'tag', 'z'}}), {2, data, 'z'})
+        t.assert_equals(s:delete(3), tuples[3])
+        t.assert_equals(s:get(1), {1, {a = 1}, 'y'})
+        t.assert_equals(s:get(2), {2, data, 'z'})
+        t.assert_equals(s:get(3), nil)
+        -- Tuples stored before compression is disabled are still
+        -- readable.
+        s:format({{name = 'id', type = 'unsigned'}})
+        t.assert_equals(s:get(4), tuples[4])
+        s:replace({5, 'raw'})
+        t.assert_equals(s:get(5), {5, 'raw'})
+    end)
+end
+
+g.test_snapshot = function()
+    g.server:exec(function()
+        local s = box.schema.space.create('test', {format = {
+            {name = 'id', type = 'unsigned'},
+            {name = 'data', type = 'string', compression = 'zstd'},
+        }})
+        s:create_index('pk')
+        for i = 1, 10 do
+            s:insert({i, string.rep('x', 1000)})
+        end
+        box.snapshot()
+        -- Tuples are stored decompressed in snapshots.
+        s:format({{name = 'id', type = 'unsigned'}})
+        box.snapshot()
+    end)
+    g.server:restart()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        t.assert_equals(s:count(), 10)
+        t.assert_equals(s:get(1), {1, string.rep('x', 1000)})
+        t.assert_equals(s:format(), {{name = 'id', type = 'unsigned'}})
+    end)
+end
@@ -1,6 +1,6 @@
+local fio = require('fio')
 local net = require('net.box')
 local server = require('test.luatest_helpers.server')
-local tarantool = require('tarantool')
 local t = require('luatest')
 local g = t.group()
 
@@ -47,31 +47,102 @@ g.test_net_box = function()
         net.connect, {g.server.net_box_uri, params = {transport = 'foo'}})
 end
 
--- Check that SSL isn't available in open-source builds.
-if tarantool.package ~= 'Tarantool Enterprise' then
+local cert_dir = fio.pathjoin(fio.abspath(debug.sourcedir()), 'ssl_cert')
+local key_file = fio.pathjoin(cert_dir, 'server.key')
+local cert_file = fio.pathjoin(cert_dir, 'server.crt')
 
-g.test_listen_ssl = function()
-    g.server:exec(function()
+g.test_listen_ssl_invalid = function()
+    g.server:exec(function(cert_file)
         local t = require('luatest')
         t.assert_error_msg_equals(
-            'SSL is not available in this build',
+            'ssl_key_file and ssl_cert_file parameters are mandatory ' ..
+            'for a server',
             box.cfg, {listen = 'localhost:0?transport=ssl'})
-    end)
+        t.assert_error_msg_contains(
+            'Failed to load SSL private key file /no/such/file',
+            box.cfg, {listen = {'localhost:0', params = {
+                transport = 'ssl',
+                ssl_key_file = '/no/such/file',
+                ssl_cert_file = cert_file,
+            }}})
+    end, {cert_file})
 end
 
-g.test_replication_ssl = function()
-    g.server:exec(function()
+g.test_replication_ssl_invalid = function()
+    g.server:exec(function(key_file)
         local t = require('luatest')
         t.assert_error_msg_equals(
-            'SSL is not available in this build',
-            box.cfg, {replication = 'localhost:0?transport=ssl'})
-    end)
+            'ssl_key_file and ssl_cert_file parameters must be set together',
+            box.cfg, {replication = {'localhost:0', params = {
+                transport = 'ssl',
+                ssl_key_file = key_file,
+            }}})
+    end, {key_file})
 end
 
 g.test_net_box_ssl = function()
-    t.assert_error_msg_equals(
-        'SSL is not available in this build',
-        net.connect, {g.server.net_box_uri, params = {transport = 'ssl'}})
+    local uri = g.server:exec(function(key_file, cert_file)
+        box.cfg{listen = {box.cfg.listen, {'localhost:0', params = {
+            transport = 'ssl',
+            ssl_key_file = key_file,
+            ssl_cert_file = cert_file,
+        }}}}
+        box.schema.user.grant('guest', 'execute', 'universe',
+                              nil, {if_not_exists = true})
+        return box.info.listen[2]
+    end, {key_file, cert_file})
+    local c = net.connect({uri, params = {
+        transport = 'ssl',
+        ssl_ca_file = cert_file,
+    }})
+    t.assert_equals(c.state, 'active')
+    t.assert(c:ping())
+    -- Big requests and responses take many TLS records.
+    local arg = string.rep('x', 1024 * 1024)
+    t.assert_equals(c:eval('return ...', {arg}), arg)
+    c:close()
+    -- A plain client can't talk to an SSL server.
+    c = net.connect(uri, {connect_timeout = 1})
+    t.assert_not_equals(c.state, 'active')
+    c:close()
+    g.server:exec(function()
+        box.cfg{listen = box.cfg.listen[1]}
+    end)
 end
 
-end -- tarantool.package ~= 'Tarantool Enterprise'
+g.test_net_box_ssl_verify_host = function()
+    t.skip_if(jit.os ~= 'Linux', '127.0.0.2 is not up on this system')
+    local port = g.server:exec(function(key_file, cert_file)
+        box.cfg{listen = {box.cfg.listen, {'0.0.0.0:0', params = {
+            transport = 'ssl',
+            ssl_key_file = key_file,
+            ssl_cert_file = cert_file,
+        }}}}
+        box.schema.user.grant('guest', 'execute', 'universe',
+                              nil, {if_not_exists = true})
+        return box.info.listen[2]:match(':(%d+)$')
+    end, {key_file, cert_file})
+    -- The certificate is issued for localhost and 127.0.0.1.
+    for _, host in ipairs({'localhost', '127.0.0.1'}) do
+        local c = net.connect({host .. ':' .. port, params = {
+            transport = 'ssl',
+            ssl_ca_file = cert_file,
+        }})
+        t.assert_equals(c.state, 'active', host)
+        c:close()
+    end
+    local c = net.connect({'127.0.0.2:' .. port, params = {
+        transport = 'ssl',
+        ssl_ca_file = cert_file,
+    }}, {connect_timeout = 1})
+    t.assert_not_equals(c.state, 'active')
+    t.assert_str_contains(tostring(c.error), 'certificate verify failed')
+    c:close()
+    -- Without a CA file the server certificate isn't verified.
+    c = net.connect({'127.0.0.2:' .. port, params = {transport = 'ssl'}})
+    t.assert_equals(c.state, 'active')
+    c:close()
+    g.server:exec(function()
+        box.cfg{listen = box.cfg.listen[1]}
+    end)
+end
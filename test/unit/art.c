@@ -0,0 +1,338 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "unit.h"
+#include "salad/art.h"
+#include "trivia/util.h"
+
+/*
+ * A test key is either 0x00 followed by a 32-bit hash of a number
+ * or 0x01 followed by a decimal number terminated with zero, so
+ * that the set of keys is prefix-free. The former are used to get
+ * nodes of all sizes, the latter to get long compressed paths.
+ */
+struct test_value {
+	uint32_t len;
+	unsigned char key[16];
+};
+
+static const unsigned char *
+test_value_key(const void *value, uint32_t *len)
+{
+	const struct test_value *v = value;
+	*len = v->len;
+	return v->key;
+}
+
+static size_t alloc_count;
+
+static void *
+test_alloc(void *ctx, size_t size)
+{
+	(void)ctx;
+	alloc_count++;
+	return malloc(size);
+}
+
+static void
+test_free(void *ctx, void *ptr, size_t size)
+{
+	(void)ctx;
+	(void)size;
+	alloc_count--;
+	free(ptr);
+}
+
+enum { VALUE_COUNT = 10000 };
+
+static struct test_value values[VALUE_COUNT];
+static bool is_inserted[VALUE_COUNT];
+
+static void
+test_value_create(struct test_value *value, unsigned n)
+{
+	if (n % 2 == 0) {
+		uint32_t h = n * 2654435761u;
+		value->key[0] = 0;
+		memcpy(value->key + 1, &h, sizeof(h));
+		value->len = 1 + sizeof(h);
+		return;
+	}
+	value->key[0] = 1;
+	int len = snprintf((char *)value->key + 1, sizeof(value->key) - 1,
+			   n % 3 == 0 ? "%u" : "%012u", n);
+	value->len = len + 2;
+}
+
+static int
+test_key_compare(const unsigned char *a, uint32_t a_len,
+		 const unsigned char *b, uint32_t b_len)
+{
+	int rc = memcmp(a, b, MIN(a_len, b_len));
+	if (rc != 0)
+		return rc;
+	return a_len < b_len ? -1 : a_len > b_len;
+}
+
+/** Find the expected result of art_succ() or art_pred() by brute force. */
+static struct test_value *
+test_lookup(const unsigned char *key, uint32_t len, bool is_succ,
+	    bool inclusive)
+{
+	struct test_value *result = NULL;
+	for (int i = 0; i < VALUE_COUNT; i++) {
+		if (!is_inserted[i])
+			continue;
+		struct test_value *v = &values[i];
+		/* A key is equal to its prefix. */
+		int rc = test_key_compare(v->key, MIN(v->len, len), key, len);
+		if (!is_succ)
+			rc = -rc;
+		if (rc < 0 || (rc == 0 && !inclusive))
+			continue;
+		if (result != NULL &&
+		    (test_key_compare(v->key, v->len, result->key,
+				      result->len) < 0) == is_succ)
+			result = v;
+		else if (result == NULL)
+			result = v;
+	}
+	return result;
+}
+
+static bool
+test_check_lookups(struct art *tree)
+{
+	for (int i = 0; i < 300; i++) {
+		/* Use partial keys as well as full keys. */
+		const struct test_value *v = &values[rand() % VALUE_COUNT];
+		uint32_t len = rand() % (v->len + 1);
+		for (int j = 0; j < 4; j++) {
+			bool is_succ = j & 1;
+			bool inclusive = j & 2;
+			void *expected = test_lookup(v->key, len, is_succ,
+						     inclusive);
+			void *found = is_succ ?
+				art_succ(tree, v->key, len, inclusive) :
+				art_pred(tree, v->key, len, inclusive);
+			if (found != expected)
+				return false;
+		}
+	}
+	return true;
+}
+
+static void
+test_insert_delete(void)
+{
+	plan(9);
+	header();
+
+	struct art tree;
+	art_create(&tree, test_value_key, test_alloc, test_free, NULL);
+	for (unsigned i = 0; i < VALUE_COUNT; i++)
+		test_value_create(&values[i], i * 7919 % 100003);
+
+	bool ok = true;
+	for (int i = 0; i < VALUE_COUNT; i++) {
+		void *replaced;
+		if (art_insert(&tree, &values[i], &replaced) != 0 ||
+		    replaced != NULL)
+			ok = false;
+		is_inserted[i] = true;
+	}
+	ok(ok, "insert");
+	is(art_size(&tree), VALUE_COUNT, "size after insert");
+
+	ok = true;
+	for (int i = 0; i < VALUE_COUNT; i++) {
+		if (art_find(&tree, values[i].key, values[i].len) != &values[i])
+			ok = false;
+	}
+	ok(ok, "find");
+	ok(test_check_lookups(&tree), "lookups after insert");
+
+	struct test_value copy = values[42];
+	void *replaced;
+	ok(art_insert(&tree, &copy, &replaced) == 0 && replaced == &values[42] &&
+	   art_find(&tree, copy.key, copy.len) == &copy, "replace");
+	art_insert(&tree, &values[42], &replaced);
+
+	/* Delete every other value. */
+	ok = true;
+	for (int i = 0; i < VALUE_COUNT; i += 2) {
+		if (art_delete(&tree, values[i].key, values[i].len) !=
+		    &values[i])
+			ok = false;
+		is_inserted[i] = false;
+		if (art_find(&tree, values[i].key, values[i].len) != NULL)
+			ok = false;
+	}
+	ok(ok, "delete");
+	ok(test_check_lookups(&tree), "lookups after delete");
+
+	for (int i = 1; i < VALUE_COUNT; i += 2) {
+		art_delete(&tree, values[i].key, values[i].len);
+		is_inserted[i] = false;
+	}
+	ok(art_size(&tree) == 0 && art_first(&tree) == NULL &&
+	   art_last(&tree) == NULL, "empty after delete");
+	ok(art_mem_used(&tree) == 0 && alloc_count == 0,
+	   "all nodes are freed");
+	art_destroy(&tree);
+
+	footer();
+	check_plan();
+}
+
+struct test_foreach_arg {
+	const struct test_value *prev;
+	size_t count;
+	bool is_sorted;
+};
+
+static int
+test_foreach_cb(void *value, void *arg)
+{
+	struct test_foreach_arg *a = arg;
+	const struct test_value *v = value;
+	if (a->prev != NULL &&
+	    test_key_compare(a->prev->key, a->prev->len, v->key, v->len) >= 0)
+		a->is_sorted = false;
+	a->prev = v;
+	a->count++;
+	return 0;
+}
+
+static void
+test_first_last(void)
+{
+	plan(5);
+	header();
+
+	struct art tree;
+	art_create(&tree, test_value_key, test_alloc, test_free, NULL);
+	unsigned min = 0, max = 0;
+	for (unsigned i = 0; i < VALUE_COUNT; i++) {
+		test_value_create(&values[i], i);
+		void *replaced;
+		art_insert(&tree, &values[i], &replaced);
+		if (test_key_compare(values[i].key, values[i].len,
+				     values[min].key, values[min].len) < 0)
+			min = i;
+		if (test_key_compare(values[i].key, values[i].len,
+				     values[max].key, values[max].len) > 0)
+			max = i;
+	}
+	is(art_first(&tree), &values[min], "first");
+	is(art_last(&tree), &values[max], "last");
+	bool ok = true;
+	for (uint32_t rnd = 0; rnd < 1000; rnd++) {
+		const struct test_value *v = art_random(&tree, rnd * 7919);
+		if (v == NULL || art_find(&tree, v->key, v->len) != v)
+			ok = false;
+	}
+	ok(ok, "random");
+	struct test_foreach_arg arg = {NULL, 0, true};
+	art_foreach(&tree, test_foreach_cb, &arg);
+	ok(arg.count == VALUE_COUNT && arg.is_sorted, "foreach");
+	art_destroy(&tree);
+	is(alloc_count, 0, "destroy frees all nodes");
+
+	footer();
+	check_plan();
+}
+
+/** Check that a view contains exactly the values marked in @a in_view. */
+static bool
+test_check_view(struct art *tree, struct art_view *view, const bool *in_view)
+{
+	size_t count = 0;
+	const struct test_value *prev = NULL;
+	const struct test_value *v = art_view_first(tree, view);
+	while (v != NULL) {
+		if (prev != NULL &&
+		    test_key_compare(prev->key, prev->len, v->key, v->len) >= 0)
+			return false;
+		if (v < values || v >= values + VALUE_COUNT ||
+		    !in_view[v - values])
+			return false;
+		count++;
+		prev = v;
+		v = art_view_succ(tree, view, v->key, v->len);
+	}
+	return count == view->size;
+}
+
+static void
+test_view(void)
+{
+	plan(8);
+	header();
+
+	static bool in_view[VALUE_COUNT];
+	struct art tree;
+	art_create(&tree, test_value_key, test_alloc, test_free, NULL);
+	for (unsigned i = 0; i < VALUE_COUNT; i++) {
+		test_value_create(&values[i], i * 7919 % 100003);
+		is_inserted[i] = in_view[i] = i % 2 == 0;
+		void *replaced;
+		if (is_inserted[i])
+			art_insert(&tree, &values[i], &replaced);
+	}
+	struct art_view view;
+	art_view_create(&tree, &view);
+	is(view.size, VALUE_COUNT / 2, "view size");
+
+	/* Delete a half of the values and insert the others. */
+	bool ok = true;
+	for (int i = 0; i < VALUE_COUNT; i++) {
+		void *replaced;
+		if (is_inserted[i] && i % 4 == 0) {
+			if (art_prepare_delete(&tree, values[i].key,
+					       values[i].len) != 0 ||
+			    art_delete(&tree, values[i].key,
+				       values[i].len) != &values[i])
+				ok = false;
+			is_inserted[i] = false;
+		} else if (!is_inserted[i]) {
+			if (art_insert(&tree, &values[i], &replaced) != 0)
+				ok = false;
+			is_inserted[i] = true;
+		}
+	}
+	ok(ok, "modify tree with view");
+	is(art_size(&tree), VALUE_COUNT * 3 / 4, "tree size");
+	ok(test_check_lookups(&tree), "lookups in tree");
+	ok(test_check_view(&tree, &view, in_view), "view is unchanged");
+
+	/* A value inserted after the view creation can be deleted as is. */
+	art_delete(&tree, values[1].key, values[1].len);
+	is_inserted[1] = false;
+	ok(test_check_lookups(&tree), "delete without prepare");
+
+	art_view_destroy(&tree, &view);
+	for (int i = 0; i < VALUE_COUNT; i++) {
+		if (is_inserted[i])
+			art_delete(&tree, values[i].key, values[i].len);
+		is_inserted[i] = false;
+	}
+	is(art_size(&tree), 0, "empty after delete");
+	ok(art_mem_used(&tree) == 0 && alloc_count == 0,
+	   "all nodes are freed");
+	art_destroy(&tree);
+
+	footer();
+	check_plan();
+}
+
+int
+main(void)
+{
+	plan(3);
+	srand(0);
+	test_insert_delete();
+	test_first_last();
+	test_view();
+	return check_plan();
+}
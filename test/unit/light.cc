@@ -317,6 +317,54 @@ iterator_freeze_check()
 	footer();
 }
 
+static void
+view_check()
+{
+	header();
+
+	const int test_data_size = 1000;
+	const int test_data_mod = 2000;
+	bool in_view[test_data_mod];
+	struct light_core ht;
+
+	for (int i = 0; i < 10; i++) {
+		light_create(&ht, light_extent_size,
+			     my_light_alloc, my_light_free, &extents_count, 0);
+		for (int j = 0; j < test_data_size; j++) {
+			hash_value_t val = rand() % test_data_mod;
+			hash_t h = hash(val);
+			if (light_find(&ht, h, val) == light_end)
+				light_insert(&ht, h, val);
+		}
+		for (int j = 0; j < test_data_mod; j++)
+			in_view[j] = light_find(&ht, hash(j), j) != light_end;
+		struct light_view view;
+		light_view_create(&ht, &view);
+		/* Modify the table so that it grows and chains change. */
+		for (int j = 0; j < test_data_size * 4; j++) {
+			hash_value_t val = rand() % (test_data_mod * 4);
+			hash_t h = hash(val);
+			hash_t pos = light_find(&ht, h, val);
+			if (pos != light_end)
+				light_delete(&ht, pos);
+			else
+				light_insert(&ht, h, val);
+		}
+		for (int j = 0; j < test_data_mod; j++) {
+			hash_value_t *e = light_view_find_key(&ht, &view,
+							      hash(j), j, 0);
+			if ((e != NULL) != in_view[j])
+				fail("view lookup failed (1)", "true");
+			if (e != NULL && *e != (hash_value_t)j)
+				fail("view lookup failed (2)", "true");
+		}
+		light_view_destroy(&ht, &view);
+		light_destroy(&ht);
+	}
+
+	footer();
+}
+
 int
 main(int, const char**)
 {
@@ -325,6 +373,7 @@ main(int, const char**)
 	collision_test();
 	iterator_test();
 	iterator_freeze_check();
+	view_check();
 	if (extents_count != 0)
 		fail("memory leak!", "true");
 }
@@ -0,0 +1,91 @@
+local common = require('test.vinyl-luatest.common')
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({
+        alias = 'master',
+        box_cfg = common.default_box_cfg(),
+    })
+    g.server:start()
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.after_each(function()
+    g.server:exec(function()
+        if box.space.test ~= nil then
+            box.space.test:drop()
+        end
+    end)
+end)
+
+-- Deferred DELETEs are written to the local _vinyl_deferred_delete
+-- space so we count them by the local vclock component.
+local function deferred_delete_count(f)
+    return g.server:exec(function(f)
+        local t = require('luatest')
+        local s = box.space.test
+        local before = box.info.vclock[0] or 0
+        loadstring(f)()
+        box.snapshot()
+        s.index.pk:compact()
+        t.helpers.retrying({}, function()
+            t.assert_equals(s.index.pk:stat().disk.compaction.queue.rows, 0)
+            t.assert_equals(box.stat.vinyl().scheduler.tasks_inprogress, 0)
+        end)
+        return (box.info.vclock[0] or 0) - before
+    end, {f})
+end
+
+g.test_filter = function()
+    g.server:exec(function()
+        local s = box.schema.create_space('test', {engine = 'vinyl'})
+        s:create_index('pk')
+        s:create_index('sk', {parts = {2, 'unsigned'}})
+        s:create_index('nk', {parts = {3, 'string', is_nullable = true},
+                              unique = false})
+        for i = 1, 10 do
+            s:replace{i, i, box.NULL, 0}
+        end
+        box.snapshot()
+    end)
+    -- Non-indexed fields are updated: no deferred DELETEs.
+    t.assert_equals(deferred_delete_count([[
+        for i = 1, 10 do box.space.test:replace{i, i, box.NULL, 1} end
+    ]]), 0)
+    -- One of secondary keys is updated: deferred DELETEs are sent.
+    t.assert_equals(deferred_delete_count([[
+        for i = 1, 10, 2 do box.space.test:replace{i, i, 'x', 2} end
+    ]]), 5)
+    t.assert_equals(deferred_delete_count([[
+        for i = 2, 10, 2 do box.space.test:replace{i, i * 10, box.NULL, 3} end
+    ]]), 5)
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        box.snapshot()
+        s.index.sk:compact()
+        s.index.nk:compact()
+        t.helpers.retrying({}, function()
+            t.assert_equals(box.stat.vinyl().scheduler.compaction_queue, 0)
+            t.assert_equals(box.stat.vinyl().scheduler.tasks_inprogress, 0)
+        end)
+        local expected = {}
+        for i = 1, 10 do
+            if i % 2 == 1 then
+                table.insert(expected, {i, i, 'x', 2})
+            else
+                table.insert(expected, {i, i * 10, box.NULL, 3})
+            end
+        end
+        t.assert_equals(s.index.pk:select(), expected)
+        t.assert_equals(s.index.sk:count(), 10)
+        t.assert_equals(s.index.nk:count({'x'}), 5)
+        t.assert_equals(s.index.nk:count(), 10)
+        t.assert_equals(s.index.sk:stat().rows, 10)
+    end)
+end
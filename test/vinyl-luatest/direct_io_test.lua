@@ -0,0 +1,72 @@
+local common = require('test.vinyl-luatest.common')
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    local box_cfg = common.default_box_cfg()
+    box_cfg.vinyl_direct_io = true
+    g.server = server:new({
+        alias = 'master',
+        box_cfg = box_cfg,
+    })
+    g.server:start()
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.test_cfg_is_static = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        t.assert_equals(box.cfg.vinyl_direct_io, true)
+        t.assert_error_msg_contains("Can't set option 'vinyl_direct_io' " ..
+                                    "dynamically",
+                                    box.cfg, {vinyl_direct_io = false})
+    end)
+end
+
+g.test_read_write = function()
+    g.server:exec(function()
+        local s = box.schema.create_space('test', {engine = 'vinyl'})
+        s:create_index('pk', {page_size = 100})
+        for i = 1, 100 do
+            -- Use tuples of different sizes so that pages
+            -- aren't aligned to the file system block size.
+            s:replace{i, string.rep('x', i * 7)}
+        end
+        box.snapshot()
+        for i = 101, 200 do
+            s:replace{i, string.rep('y', i * 3)}
+        end
+        box.snapshot()
+    end)
+    local function check()
+        g.server:exec(function()
+            local t = require('luatest')
+            local s = box.space.test
+            box.cfg{vinyl_cache = 0}
+            t.assert_equals(s:count(), 200)
+            t.assert_equals(s:get(1), {1, string.rep('x', 7)})
+            t.assert_equals(s:get(100), {100, string.rep('x', 700)})
+            t.assert_equals(s:get(200), {200, string.rep('y', 600)})
+            local res = s:select({150}, {iterator = 'LE', limit = 60})
+            t.assert_equals(#res, 60)
+            t.assert_equals(res[1][1], 150)
+            t.assert_equals(res[60][1], 91)
+            box.cfg{vinyl_cache = 10240}
+        end)
+    end
+    check()
+    g.server:restart()
+    check()
+    g.server:exec(function()
+        box.space.test.index.pk:compact()
+        local t = require('luatest')
+        t.helpers.retrying({}, function()
+            t.assert_equals(box.space.test.index.pk:stat().run_count, 1)
+        end)
+    end)
+    check()
+end
@@ -0,0 +1,75 @@
+local common = require('test.vinyl-luatest.common')
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    local box_cfg = common.default_box_cfg()
+    box_cfg.vinyl_max_subcompactions = 2
+    g.server = server:new({
+        alias = 'master',
+        box_cfg = box_cfg,
+    })
+    g.server:start()
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.after_each(function()
+    g.server:exec(function()
+        if box.space.test ~= nil then
+            box.space.test:drop()
+        end
+        box.cfg{vinyl_max_subcompactions = 2}
+    end)
+end)
+
+g.test_invalid_cfg = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        t.assert_error_msg_content_equals(
+            "Incorrect value for option 'vinyl_max_subcompactions': " ..
+            "must be greater than or equal to 1",
+            box.cfg, {vinyl_max_subcompactions = 0})
+        t.assert_equals(box.cfg.vinyl_max_subcompactions, 2)
+    end)
+end
+
+local function compact_and_check(expected_range_count)
+    g.server:exec(function(expected_range_count)
+        local t = require('luatest')
+        local s = box.schema.create_space('test', {engine = 'vinyl'})
+        s:create_index('pk', {run_count_per_level = 10})
+        for _ = 1, 2 do
+            for i = 1, 500 do
+                s:replace{i, string.rep('x', 1000)}
+            end
+            box.snapshot()
+        end
+        t.assert_equals(s.index.pk:stat().range_count, 1)
+        t.assert_equals(s.index.pk:stat().run_count, 2)
+        s.index.pk:compact()
+        t.helpers.retrying({}, function()
+            local stat = s.index.pk:stat()
+            t.assert_equals(stat.disk.compaction.queue.rows, 0)
+            t.assert_equals(box.stat.vinyl().scheduler.tasks_inprogress, 0)
+            t.assert_equals(stat.run_count, stat.range_count)
+        end)
+        t.assert_equals(s.index.pk:stat().range_count, expected_range_count)
+        t.assert_equals(s:count(), 500)
+        t.assert_equals(s:get(250), {250, string.rep('x', 1000)})
+    end, {expected_range_count})
+end
+
+g.test_subcompaction_disabled = function()
+    g.server:exec(function()
+        box.cfg{vinyl_max_subcompactions = 1}
+    end)
+    compact_and_check(1)
+end
+
+g.test_subcompaction = function()
+    compact_and_check(2)
+end
@@ -0,0 +1,106 @@
+local common = require('test.vinyl-luatest.common')
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    local box_cfg = common.default_box_cfg()
+    box_cfg.vinyl_readahead_pages = 4
+    g.server = server:new({
+        alias = 'master',
+        box_cfg = box_cfg,
+    })
+    g.server:start()
+    g.server:exec(function()
+        local s = box.schema.create_space('test', {engine = 'vinyl'})
+        s:create_index('pk', {page_size = 256, range_size = 1024 * 1024})
+        for i = 1, 1000 do
+            s:replace{i, string.rep('x', 100)}
+        end
+        box.snapshot()
+    end)
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.test_invalid_cfg = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        t.assert_error_msg_content_equals(
+            "Incorrect value for option 'vinyl_readahead_pages': " ..
+            "must be greater than or equal to 0",
+            box.cfg, {vinyl_readahead_pages = -1})
+        t.assert_equals(box.cfg.vinyl_readahead_pages, 4)
+    end)
+end
+
+g.test_scan = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local errinj = box.error.injection
+        local s = box.space.test
+        local pages = s.index.pk:stat().disk.pages
+        t.assert_gt(pages, 100)
+        -- Returns the number of pages read from disk and the number
+        -- of pages read ahead by a function.
+        local function count_reads(f)
+            -- Make sure pages are read from disk.
+            box.cfg{vinyl_cache = 0}
+            box.cfg{vinyl_cache = 10240}
+            errinj.set('ERRINJ_VY_READAHEAD_COUNT', 0)
+            local read = s.index.pk:stat().disk.iterator.read.pages
+            f()
+            return s.index.pk:stat().disk.iterator.read.pages - read,
+                   errinj.get('ERRINJ_VY_READAHEAD_COUNT')
+        end
+        local function check(readahead_pages)
+            box.cfg{vinyl_readahead_pages = readahead_pages}
+            local read, readahead = count_reads(function()
+                local keys = {}
+                for _, tuple in s:pairs({}, {iterator = 'GE'}) do
+                    table.insert(keys, tuple[1])
+                end
+                t.assert_equals(#keys, 1000)
+                t.assert_equals(keys[1], 1)
+                t.assert_equals(keys[1000], 1000)
+            end)
+            t.assert_ge(read, pages)
+            if readahead_pages == 0 then
+                t.assert_equals(readahead, 0)
+            else
+                t.assert_gt(readahead, 0)
+                t.assert_le(readahead, pages)
+            end
+            read, readahead = count_reads(function()
+                local keys = {}
+                for _, tuple in s:pairs({500}, {iterator = 'LT'}) do
+                    table.insert(keys, tuple[1])
+                end
+                t.assert_equals(#keys, 499)
+                t.assert_equals(keys[1], 499)
+                t.assert_equals(keys[499], 1)
+            end)
+            t.assert_ge(read, pages / 3)
+            if readahead_pages == 0 then
+                t.assert_equals(readahead, 0)
+            else
+                t.assert_gt(readahead, 0)
+                t.assert_le(readahead, pages)
+            end
+            -- Point lookups never trigger read-ahead.
+            read, readahead = count_reads(function()
+                for i = 1, 1000, 10 do
+                    t.assert_equals(s:get(i)[1], i)
+                end
+            end)
+            t.assert_gt(read, 0)
+            t.assert_equals(readahead, 0)
+        end
+        for _, readahead_pages in ipairs({0, 1, 4, pages * 2}) do
+            check(readahead_pages)
+        end
+        box.cfg{vinyl_readahead_pages = 4}
+    end)
+end
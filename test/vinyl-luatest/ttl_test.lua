@@ -0,0 +1,183 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({alias = 'master'})
+    g.server:start()
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.after_each(function()
+    g.server:exec(function()
+        if box.space.test ~= nil then
+            box.space.test:drop()
+        end
+    end)
+end)
+
+g.test_invalid_opts = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.create_space('test', {engine = 'memtx'})
+        t.assert_error_msg_contains(
+            'ttl is only supported by vinyl',
+            s.create_index, s, 'pk', {ttl = 10})
+        s:drop()
+        s = box.schema.create_space('test', {engine = 'vinyl'})
+        t.assert_error_msg_contains(
+            'ttl must be greater than or equal to 0',
+            s.create_index, s, 'pk', {ttl = -1})
+        t.assert_error_msg_contains(
+            'ttl requires the first key part to be a number',
+            s.create_index, s, 'pk', {parts = {1, 'string'}, ttl = 10})
+        s:create_index('pk')
+        t.assert_error_msg_contains(
+            'ttl can only be set for primary index',
+            s.create_index, s, 'sk', {parts = {2, 'unsigned'}, ttl = 10})
+        s.index.pk:alter({ttl = 10})
+        t.assert_equals(s.index.pk.options.ttl, 10)
+    end)
+end
+
+g.test_compaction = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local clock = require('clock')
+        local s = box.schema.create_space('test', {engine = 'vinyl'})
+        s:create_index('pk', {
+            parts = {{1, 'number'}, {2, 'unsigned'}},
+            ttl = 3600,
+        })
+        s:create_index('sk', {parts = {3, 'string'}})
+        local now = clock.time()
+        -- Force compaction only compacts ranges with two runs or more.
+        s:insert{now, 3, 'c'}
+        s:insert{now + 7200, 4, 'd'}
+        box.snapshot()
+        s:insert{now - 7200, 1, 'a'}
+        s:insert{now - 7200, 2, 'b'}
+        box.snapshot()
+        -- Expired tuples are visible until compaction.
+        t.assert_equals(s:count(), 4)
+        s.index.pk:compact()
+        s.index.sk:compact()
+        t.helpers.retrying({}, function()
+            t.assert_equals(s.index.pk:stat().disk.compaction.queue.rows, 0)
+            t.assert_equals(s.index.sk:stat().disk.compaction.queue.rows, 0)
+        end)
+        t.assert_equals(s.index.pk:stat().disk.rows, 2)
+        t.assert_equals(s.index.sk:stat().disk.rows, 2)
+        t.assert_equals(s.index.pk:select({}, {iterator = 'ALL'}),
+                        {{now, 3, 'c'}, {now + 7200, 4, 'd'}})
+        t.assert_equals(s.index.sk:select({}, {iterator = 'ALL'}),
+                        {{now, 3, 'c'}, {now + 7200, 4, 'd'}})
+    end)
+end
+
+g.test_auto_compaction = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local clock = require('clock')
+        local s = box.schema.create_space('test', {engine = 'vinyl'})
+        s:create_index('pk', {parts = {1, 'double'}, ttl = 1})
+        local now = clock.time()
+        for i = 1, 10 do
+            s:insert{now + i / 10}
+        end
+        box.snapshot()
+        t.assert_equals(s.index.pk:stat().disk.rows, 10)
+        -- A range whose tuples have all expired is compacted without
+        -- an explicit request.
+        t.helpers.retrying({timeout = 10}, function()
+            t.assert_equals(s.index.pk:stat().disk.rows, 0)
+        end)
+        t.assert_equals(s:select(), {})
+    end)
+end
+
+g.test_read_view = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local clock = require('clock')
+        local fiber = require('fiber')
+        local s = box.schema.create_space('test', {engine = 'vinyl'})
+        s:create_index('pk', {parts = {1, 'double'}, ttl = 3600})
+        local now = clock.time()
+        s:insert{now, 1}
+        s:insert{now + 7200, 2}
+        box.snapshot()
+        s:insert{now - 7200, 3}
+        -- The reader is sent to a read view by a concurrent write
+        -- so it must keep seeing the expired tuple.
+        local cond = fiber.cond()
+        local result
+        local reader = fiber.new(function()
+            box.begin()
+            s:select()
+            cond:wait()
+            result = s:select()
+            box.commit()
+        end)
+        reader:set_joinable(true)
+        fiber.yield()
+        s:replace{now + 7200, 4}
+        box.snapshot()
+        s.index.pk:compact()
+        t.helpers.retrying({}, function()
+            t.assert_equals(s.index.pk:stat().disk.compaction.queue.rows, 0)
+        end)
+        t.assert_equals(s.index.pk:stat().disk.rows, 4)
+        cond:signal()
+        t.assert_equals({reader:join()}, {true})
+        t.assert_equals(result, {{now - 7200, 3}, {now, 1}, {now + 7200, 2}})
+        -- Once the read view is closed, the tuple can be dropped.
+        s:replace{now + 7200, 5}
+        box.snapshot()
+        s.index.pk:compact()
+        t.helpers.retrying({}, function()
+            t.assert_equals(s.index.pk:stat().disk.compaction.queue.rows, 0)
+        end)
+        t.assert_equals(s.index.pk:stat().disk.rows, 2)
+        t.assert_equals(s:select(), {{now, 1}, {now + 7200, 5}})
+    end)
+end
+
+g.test_expired_range_read_view = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local clock = require('clock')
+        local fiber = require('fiber')
+        local s = box.schema.create_space('test', {engine = 'vinyl'})
+        s:create_index('pk', {parts = {1, 'double'}, ttl = 3600})
+        local now = clock.time()
+        s:insert{now - 7200, 1}
+        local cond = fiber.cond()
+        local result
+        local reader = fiber.new(function()
+            box.begin()
+            s:select()
+            cond:wait()
+            result = s:select()
+            box.commit()
+        end)
+        reader:set_joinable(true)
+        fiber.yield()
+        s:replace{now - 7200, 2}
+        box.snapshot()
+        -- The range has expired, but it isn't compacted while a read
+        -- view sees it.
+        fiber.sleep(1.5)
+        t.assert_equals(s.index.pk:stat().disk.rows, 2)
+        cond:signal()
+        t.assert_equals({reader:join()}, {true})
+        t.assert_equals(result, {{now - 7200, 1}})
+        t.helpers.retrying({timeout = 10}, function()
+            t.assert_equals(s.index.pk:stat().disk.rows, 0)
+        end)
+        t.assert_equals(s:select(), {})
+    end)
+end
@@ -0,0 +1,88 @@
+local common = require('test.vinyl-luatest.common')
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    local box_cfg = common.default_box_cfg()
+    box_cfg.vinyl_cache = 0
+    g.server = server:new({
+        alias = 'master',
+        box_cfg = box_cfg,
+    })
+    g.server:start()
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.after_each(function()
+    g.server:exec(function()
+        if box.space.test ~= nil then
+            box.space.test:drop()
+        end
+    end)
+end)
+
+g.test_skip_disk = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.create_space('test', {engine = 'vinyl'})
+        s:create_index('pk')
+        local sk = s:create_index('sk', {parts = {2, 'unsigned'}})
+        local nk = s:create_index('nk', {
+            parts = {3, 'unsigned', is_nullable = true},
+        })
+        s:insert{1, 10, 100}
+        box.snapshot()
+        s:replace{1, 10, 100, 'x'}
+        local function disk_lookups(index)
+            return index:stat().disk.iterator.lookup
+        end
+        -- The key is found in memory: disk isn't accessed.
+        local lookups = disk_lookups(sk)
+        t.assert_equals(sk:get({10}), {1, 10, 100, 'x'})
+        t.assert_equals(sk:select({10}), {{1, 10, 100, 'x'}})
+        t.assert_equals(disk_lookups(sk), lookups)
+        -- Nullable unique index must look up all sources.
+        lookups = disk_lookups(nk)
+        t.assert_equals(nk:get({100}), {1, 10, 100, 'x'})
+        t.assert_gt(disk_lookups(nk), lookups)
+        -- The key isn't found in memory.
+        lookups = disk_lookups(sk)
+        t.assert_equals(sk:get({20}), nil)
+        t.assert_gt(disk_lookups(sk), lookups)
+    end)
+end
+
+g.test_stale = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.create_space('test', {engine = 'vinyl'})
+        s:create_index('pk')
+        local sk = s:create_index('sk', {parts = {2, 'unsigned'}})
+        s:insert{1, 10}
+        s:insert{3, 30}
+        box.snapshot()
+        -- Leave stale tuples [10, 1] and [30, 3] in the secondary index.
+        s:replace{1, 20}
+        s:replace{3, 40}
+        s:insert{2, 10}
+        t.assert_equals(sk:get({10}), {2, 10})
+        t.assert_equals(sk:get({30}), nil)
+        t.assert_equals(sk:select({10}), {{2, 10}})
+        box.begin()
+        s:delete{2}
+        t.assert_equals(sk:get({10}), nil)
+        s:replace{4, 10}
+        t.assert_equals(sk:get({10}), {4, 10})
+        box.rollback()
+        s:delete{2}
+        t.assert_equals(sk:get({10}), nil)
+        s:insert{4, 10}
+        t.assert_equals(sk:get({10}), {4, 10})
+        t.assert_equals(sk:select({}, {iterator = 'ALL'}),
+                        {{4, 10}, {1, 20}, {3, 40}})
+    end)
+end